@@ -8,9 +8,97 @@
  */
 
 #include <plist/plist.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <string.h>
 #include <stdlib.h>
 
+/*
+ * The *_ptr accessors hand out pointers their callers never free, as
+ * libplist 2.3+ does. Older releases only offer copying getters, so each
+ * node's copy is kept here and handed out again on later calls. A copy is
+ * replaced (and the old one freed) only when the node's value no longer
+ * matches it, i.e. the node was changed or freed and its address reused;
+ * either way a 2.3+ pointer would have been invalidated too. Memory stays
+ * bounded by the number of distinct nodes rather than growing per call.
+ */
+struct plist_compat_entry {
+    plist_t node;
+    char *copy;
+    uint64_t length;
+};
+
+static pthread_mutex_t plist_compat_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct plist_compat_entry *plist_compat_entries;
+static size_t plist_compat_capacity;  /* Power of two */
+static size_t plist_compat_count;
+
+static size_t plist_compat_hash(plist_t node)
+{
+    uintptr_t h = (uintptr_t)node;
+    h ^= h >> 17;
+    h *= (uintptr_t)0x9E3779B97F4A7C15ULL;
+    return (size_t)(h ^ (h >> 29));
+}
+
+/* Returns the node's slot, creating it (empty) if needed; NULL on ENOMEM */
+static struct plist_compat_entry *plist_compat_slot(plist_t node)
+{
+    if ((plist_compat_count + 1) * 4 > plist_compat_capacity * 3) {
+        size_t capacity = plist_compat_capacity ? plist_compat_capacity * 2 : 64;
+        struct plist_compat_entry *entries = calloc(capacity, sizeof(*entries));
+        if (!entries) return NULL;
+        for (size_t i = 0; i < plist_compat_capacity; i++) {
+            struct plist_compat_entry *old = &plist_compat_entries[i];
+            if (!old->node) continue;
+            size_t j = plist_compat_hash(old->node) & (capacity - 1);
+            while (entries[j].node) j = (j + 1) & (capacity - 1);
+            entries[j] = *old;
+        }
+        free(plist_compat_entries);
+        plist_compat_entries = entries;
+        plist_compat_capacity = capacity;
+    }
+
+    size_t i = plist_compat_hash(node) & (plist_compat_capacity - 1);
+    while (plist_compat_entries[i].node && plist_compat_entries[i].node != node) {
+        i = (i + 1) & (plist_compat_capacity - 1);
+    }
+    if (!plist_compat_entries[i].node) {
+        plist_compat_entries[i].node = node;
+        plist_compat_count++;
+    }
+    return &plist_compat_entries[i];
+}
+
+/*
+ * Takes ownership of `fresh` (a copy of the node's value just made) and
+ * returns the node's cached copy, which stays valid until the node changes
+ */
+static const char *plist_compat_intern(plist_t node, char *fresh, uint64_t length)
+{
+    if (!fresh) return NULL;
+
+    pthread_mutex_lock(&plist_compat_lock);
+    struct plist_compat_entry *entry = plist_compat_slot(node);
+    if (!entry) {
+        /* Out of memory: hand out the copy itself rather than nothing */
+        pthread_mutex_unlock(&plist_compat_lock);
+        return fresh;
+    }
+    if (entry->copy && entry->length == length &&
+        memcmp(entry->copy, fresh, (size_t)length) == 0) {
+        free(fresh);
+    } else {
+        free(entry->copy);
+        entry->copy = fresh;
+        entry->length = length;
+    }
+    const char *copy = entry->copy;
+    pthread_mutex_unlock(&plist_compat_lock);
+    return copy;
+}
+
 /*
  * plist_bool_val_is_true - Check if a boolean plist node is true
  * Available in libplist 2.3+, not in older versions
@@ -28,7 +116,7 @@ int plist_bool_val_is_true(plist_t node)
 /*
  * plist_get_data_ptr - Get pointer to data without copying
  * Available in libplist 2.3+, provides direct access to internal buffer
- * This implementation returns a copy (caller must free) for compatibility
+ * The pointer stays owned by the compat layer (see above); don't free it.
  */
 const char* plist_get_data_ptr(plist_t node, uint64_t *length)
 {
@@ -36,14 +124,17 @@ const char* plist_get_data_ptr(plist_t node, uint64_t *length)
     if (plist_get_node_type(node) != PLIST_DATA) return NULL;
     
     char *data = NULL;
-    plist_get_data_val(node, &data, length);
-    return data;
+    uint64_t size = 0;
+    plist_get_data_val(node, &data, &size);
+    const char *ptr = plist_compat_intern(node, data, size);
+    if (ptr) *length = size;
+    return ptr;
 }
 
 /*
  * plist_get_string_ptr - Get pointer to string without copying
  * Available in libplist 2.3+
- * This implementation returns a copy (caller must free) for compatibility
+ * The pointer stays owned by the compat layer; see plist_get_data_ptr
  */
 const char* plist_get_string_ptr(plist_t node, uint64_t *length)
 {
@@ -52,10 +143,13 @@ const char* plist_get_string_ptr(plist_t node, uint64_t *length)
     
     char *str = NULL;
     plist_get_string_val(node, &str);
-    if (str && length) {
-        *length = strlen(str);
+    if (!str) return NULL;
+    uint64_t size = strlen(str);
+    const char *ptr = plist_compat_intern(node, str, size + 1);
+    if (ptr && length) {
+        *length = size;
     }
-    return str;
+    return ptr;
 }
 
 /*
@@ -68,12 +162,9 @@ int plist_string_val_compare(plist_t node, const char *cmpval)
     if (!node || !cmpval) return -1;
     if (plist_get_node_type(node) != PLIST_STRING) return -1;
     
-    char *str = NULL;
-    plist_get_string_val(node, &str);
+    const char *str = plist_get_string_ptr(node, NULL);
     if (!str) return -1;
     
-    int result = strcmp(str, cmpval);
-    free(str);
-    return result;
+    return strcmp(str, cmpval);
 }
 
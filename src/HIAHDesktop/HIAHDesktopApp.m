@@ -8,15 +8,20 @@
 #import "HIAHAppLauncher.h"
 #import "HIAHAppWindowSession.h"
 #import "HIAHCarPlayController.h"
+#import "HIAHDeltaUpdate.h"
 #import "HIAHFilesystem.h"
 #import "HIAHFloatingWindow.h"
 #import "HIAHKernel.h"
 #import "HIAHLogging.h"
 #import "HIAHMachOUtils.h"
+#import "HIAHPlistReader.h"
 #import "HIAHProcess.h"
 #import "HIAHStateMachine.h"
 #import "HIAHTopViewController.h"
 #import "HIAHWindowServer.h"
+#import "HIAHLazyBundle.h"
+#import "HIAHMachOPrepare.h"
+#import "HIAHZipArchive.h"
 #import "HIAHeDisplayMode.h"
 #import "../HIAHLoginWindow/Signing/HIAHSignatureBypass.h"
 #import "../HIAHLoginWindow/VPN/HIAHVPNStateMachine.h"
@@ -28,7 +33,6 @@
 #import <spawn.h>
 #import <sys/stat.h>
 #import <sys/wait.h>
-#import <zlib.h>
 
 // Forward declaration for Swift bridge
 @class HIAHSwiftBridge;
@@ -210,122 +214,33 @@
   return [[HIAHFilesystem shared] appsPath];
 }
 
-// Pure native zip extraction using minizip-style implementation
+// Streaming extraction (see HIAHZipArchive): memory use is bounded by its
+// buffers, not by the size of the largest entry. Binaries are thinned,
+// patched and signed on the way to disk (see HIAHMachOPrepare), so first
+// launch has no preparation left to do.
 + (BOOL)unzipFileSync:(NSString *)zipPath toDirectory:(NSString *)destPath {
-  NSFileManager *fm = [NSFileManager defaultManager];
-  [fm createDirectoryAtPath:destPath
-      withIntermediateDirectories:YES
-                       attributes:nil
-                            error:nil];
-
-  // Open zip file
-  FILE *zipFile = fopen([zipPath UTF8String], "rb");
-  if (!zipFile)
+  HIAHZipStats stats;
+  HIAHMachOPrepareStats prepareStats = {0};
+  HIAHZipFilter prepare = HIAHMachOPrepareFilter(&prepareStats);
+  int error = HIAHZipExtract(zipPath.fileSystemRepresentation,
+                             destPath.fileSystemRepresentation, 0, &prepare,
+                             &stats);
+  if (error != 0) {
+    NSLog(@"[Unzip] Extraction failed after %llu files: %s", stats.files,
+          strerror(error));
     return NO;
-
-  // Find end of central directory (scan from end)
-  fseek(zipFile, -22, SEEK_END);
-  uint8_t eocd[22];
-  fread(eocd, 1, 22, zipFile);
-
-  // Extract central directory offset (bytes 16-19 in little-endian)
-  uint32_t cdOffset =
-      eocd[16] | (eocd[17] << 8) | (eocd[18] << 16) | (eocd[19] << 24);
-  uint16_t numEntries = eocd[10] | (eocd[11] << 8);
-
-  // Process each entry in central directory
-  fseek(zipFile, cdOffset, SEEK_SET);
-
-  for (int i = 0; i < numEntries; i++) {
-    uint8_t cdHeader[46];
-    fread(cdHeader, 1, 46, zipFile);
-
-    uint16_t fileNameLen = cdHeader[28] | (cdHeader[29] << 8);
-    uint16_t extraLen = cdHeader[30] | (cdHeader[31] << 8);
-    uint16_t commentLen = cdHeader[32] | (cdHeader[33] << 8);
-    uint32_t localHeaderOffset = cdHeader[42] | (cdHeader[43] << 8) |
-                                 (cdHeader[44] << 16) | (cdHeader[45] << 24);
-    uint32_t compressedSize = cdHeader[20] | (cdHeader[21] << 8) |
-                              (cdHeader[22] << 16) | (cdHeader[23] << 24);
-    uint32_t uncompressedSize = cdHeader[24] | (cdHeader[25] << 8) |
-                                (cdHeader[26] << 16) | (cdHeader[27] << 24);
-    uint16_t compressionMethod = cdHeader[10] | (cdHeader[11] << 8);
-
-    char *fileName = malloc(fileNameLen + 1);
-    fread(fileName, 1, fileNameLen, zipFile);
-    fileName[fileNameLen] = '\0';
-
-    // Skip extra and comment
-    fseek(zipFile, extraLen + commentLen, SEEK_CUR);
-
-    NSString *filePath = [destPath
-        stringByAppendingPathComponent:[NSString
-                                           stringWithUTF8String:fileName]];
-
-    // Check if directory (ends with /)
-    if (fileName[fileNameLen - 1] == '/') {
-      [fm createDirectoryAtPath:filePath
-          withIntermediateDirectories:YES
-                           attributes:nil
-                                error:nil];
-      free(fileName);
-      continue;
-    }
-
-    // Create parent directory
-    [fm createDirectoryAtPath:[filePath stringByDeletingLastPathComponent]
-        withIntermediateDirectories:YES
-                         attributes:nil
-                              error:nil];
-
-    // Save current position and jump to local header
-    long currentPos = ftell(zipFile);
-    fseek(zipFile, localHeaderOffset, SEEK_SET);
-
-    uint8_t localHeader[30];
-    fread(localHeader, 1, 30, zipFile);
-    uint16_t localFileNameLen = localHeader[26] | (localHeader[27] << 8);
-    uint16_t localExtraLen = localHeader[28] | (localHeader[29] << 8);
-
-    // Skip to file data
-    fseek(zipFile, localFileNameLen + localExtraLen, SEEK_CUR);
-
-    // Read compressed data
-    uint8_t *compressedData = malloc(compressedSize);
-    fread(compressedData, 1, compressedSize, zipFile);
-
-    if (compressionMethod == 0) {
-      // Stored (uncompressed)
-      [[NSData dataWithBytes:compressedData
-                      length:compressedSize] writeToFile:filePath
-                                              atomically:YES];
-    } else if (compressionMethod == 8) {
-      // Deflate
-      uint8_t *uncompressedData = malloc(uncompressedSize);
-      z_stream strm = {0};
-      strm.next_in = compressedData;
-      strm.avail_in = compressedSize;
-      strm.next_out = uncompressedData;
-      strm.avail_out = uncompressedSize;
-
-      inflateInit2(&strm, -MAX_WBITS);
-      inflate(&strm, Z_FINISH);
-      inflateEnd(&strm);
-
-      [[NSData dataWithBytes:uncompressedData
-                      length:uncompressedSize] writeToFile:filePath
-                                                atomically:YES];
-      free(uncompressedData);
-    }
-
-    free(compressedData);
-    free(fileName);
-
-    // Restore position
-    fseek(zipFile, currentPos, SEEK_SET);
   }
 
-  fclose(zipFile);
+  double seconds = stats.wallNs / 1e9;
+  NSLog(@"[Unzip] Extracted %llu files (%.1f MB) in %.2f s, %.1f MB/s on %u "
+        @"threads",
+        stats.files, stats.bytesWritten / 1048576.0, seconds,
+        seconds > 0 ? stats.bytesWritten / 1048576.0 / seconds : 0,
+        stats.threads);
+  NSLog(@"[Unzip] %llu Mach-O files: %llu thinned (%.1f MB dropped), %llu "
+        @"executables prepared for launch",
+        prepareStats.binaries, prepareStats.thinned,
+        prepareStats.thinnedBytes / 1048576.0, prepareStats.prepared);
   return YES;
 }
 
@@ -345,6 +260,14 @@
   HIAHKernel *kernel = [HIAHKernel sharedKernel];
   HIAHFilesystem *fs = [HIAHFilesystem shared];
 
+  // /usr/bin is populated in the background at launch
+  if (!fs.bundledContentReady) {
+    [fs notifyWhenBundledContentReady:^{
+      [self unzipFile:zipPath toDirectory:destPath completion:completion];
+    }];
+    return;
+  }
+
   // Use virtual filesystem paths
   NSString *unzipPath = [fs.usrBinPath stringByAppendingPathComponent:@"unzip"];
 
@@ -388,6 +311,132 @@
                        }];
 }
 
+// Sets executable permissions on the bundle's main binary and patches it
+// for dynamic loading
++ (void)prepareExecutableInBundle:(NSString *)bundlePath {
+  NSString *plist = [bundlePath stringByAppendingPathComponent:@"Info.plist"];
+  HIAHPlist *info = HIAHPlistOpen(plist.fileSystemRepresentation);
+  HIAHPlistValue execValue;
+  NSString *exec = HIAHPlistGet(info, "CFBundleExecutable", &execValue)
+                       ? HIAHPlistValueString(&execValue)
+                       : nil;
+  HIAHPlistClose(info);
+  if (!exec) {
+    return;
+  }
+
+  NSString *execPath = [bundlePath stringByAppendingPathComponent:exec];
+  [[NSFileManager defaultManager]
+      setAttributes:@{NSFilePosixPermissions : @0755}
+       ofItemAtPath:execPath
+              error:nil];
+
+  // Patch to a dlopen-compatible Mach-O type (see HIAHMachOUtils)
+  if ([HIAHMachOUtils patchBinaryToDylib:execPath]) {
+    NSLog(@"[Installer] Patched %@ for dynamic loading", exec);
+  }
+}
+
+// Installs an .ipa without extracting it: only what dyld and the desktop
+// read directly is written out, the rest is served from the archive on
+// demand in the guest process (see HIAHLazyBundle)
+- (BOOL)installArchiveLazily:(NSURL *)fileURL toDirectory:(NSString *)appsDir {
+  char bundlePath[PATH_MAX];
+  HIAHLazyInstallStats stats;
+
+  // The bundle name is only known once the archive has been read; the
+  // install goes to a fresh directory and replaces any existing bundle
+  // only when it succeeds
+  NSFileManager *fm = [NSFileManager defaultManager];
+  NSString *stagingDir = [appsDir
+      stringByAppendingPathComponent:
+          [NSString stringWithFormat:@".install-%@", [NSUUID UUID].UUIDString]];
+  [fm createDirectoryAtPath:stagingDir
+      withIntermediateDirectories:YES
+                       attributes:nil
+                            error:nil];
+
+  HIAHZipFilter prepare = HIAHMachOPrepareFilter(NULL);
+  int error = HIAHLazyBundleInstall(fileURL.fileSystemRepresentation,
+                                    stagingDir.fileSystemRepresentation,
+                                    &prepare, bundlePath, sizeof(bundlePath),
+                                    &stats);
+  if (error != 0) {
+    NSLog(@"[Installer] Lazy install failed: %s", strerror(error));
+    [fm removeItemAtPath:stagingDir error:nil];
+    [self showResult:NO
+             message:error == ENOENT ? @"Invalid .ipa - no app bundle found"
+                                     : @"Failed to install .ipa"];
+    return NO;
+  }
+
+  NSString *appBundle =
+      [[NSString stringWithUTF8String:bundlePath] lastPathComponent];
+  NSString *destPath = [appsDir stringByAppendingPathComponent:appBundle];
+  [fm removeItemAtPath:destPath error:nil];
+  NSError *moveError = nil;
+  [fm moveItemAtPath:[NSString stringWithUTF8String:bundlePath]
+              toPath:destPath
+               error:&moveError];
+  [fm removeItemAtPath:stagingDir error:nil];
+  if (moveError) {
+    NSLog(@"[Installer] Move error: %@", moveError);
+    [self showResult:NO
+             message:[NSString stringWithFormat:@"Failed: %@",
+                                                moveError.localizedDescription]];
+    return NO;
+  }
+
+  [[self class] prepareExecutableInBundle:destPath];
+  [[HIAHFilesystem shared] addAppToBlobStore:destPath];
+  NSLog(@"[Installer] Lazily installed %@ in %.2f s: %llu files (%.1f MB) "
+        @"extracted, %llu files (%.1f MB) left in the archive",
+        appBundle, stats.wallNs / 1e9, stats.eagerFiles,
+        stats.eagerBytes / 1048576.0, stats.lazyFiles,
+        stats.lazyBytes / 1048576.0);
+  [self showResult:YES
+           message:[NSString stringWithFormat:
+                                 @"✓ %@ installed from .ipa",
+                                 [appBundle stringByDeletingPathExtension]]];
+  return YES;
+}
+
+// Installs a new version of an already installed app by extracting only
+// the files whose archive entries changed (see HIAHDeltaUpdate). Returns NO
+// if the app has to be installed in full: not installed yet, installed
+// before manifests were recorded, or the update failed
+- (BOOL)updateInstalledAppFromArchive:(NSURL *)fileURL
+                          toDirectory:(NSString *)appsDir {
+  char bundlePath[PATH_MAX];
+  HIAHDeltaStats stats;
+  HIAHZipFilter prepare = HIAHMachOPrepareFilter(NULL);
+  int error = HIAHDeltaUpdate(fileURL.fileSystemRepresentation,
+                              appsDir.fileSystemRepresentation, &prepare,
+                              bundlePath, sizeof(bundlePath), &stats);
+  if (error != 0) {
+    if (error != ESRCH) {
+      NSLog(@"[Installer] Delta update failed (%s), installing in full",
+            strerror(error));
+    }
+    return NO;
+  }
+
+  NSString *destPath = [NSString stringWithUTF8String:bundlePath];
+  NSString *appBundle = destPath.lastPathComponent;
+  [[self class] prepareExecutableInBundle:destPath];
+  [[HIAHFilesystem shared] addAppToBlobStore:destPath];
+  NSLog(@"[Installer] Updated %@ in %.2f s: %llu of %llu files extracted, "
+        @"%llu kept, %llu removed; %.1f MB written instead of %.1f MB",
+        appBundle, stats.wallNs / 1e9, stats.extracted, stats.files,
+        stats.unchanged, stats.removed, stats.bytesWritten / 1048576.0,
+        stats.fullBytes / 1048576.0);
+  [self showResult:YES
+           message:[NSString stringWithFormat:
+                                 @"✓ %@ updated from .ipa",
+                                 [appBundle stringByDeletingPathExtension]]];
+  return YES;
+}
+
 - (void)installApp:(NSURL *)fileURL {
   NSFileManager *fm = [NSFileManager defaultManager];
   NSString *appsDir = [[self class] applicationsPath];
@@ -465,22 +514,8 @@
                                                   error.localizedDescription]];
       } else {
         NSLog(@"[Installer] Install successful");
-        // Set executable permissions and patch for dynamic loading
-        NSString *plist =
-            [destPath stringByAppendingPathComponent:@"Info.plist"];
-        NSDictionary *info = [NSDictionary dictionaryWithContentsOfFile:plist];
-        NSString *exec = info[@"CFBundleExecutable"];
-        if (exec) {
-          NSString *execPath = [destPath stringByAppendingPathComponent:exec];
-          [fm setAttributes:@{NSFilePosixPermissions : @0755}
-               ofItemAtPath:execPath
-                      error:nil];
-
-          // Patch to a dlopen-compatible Mach-O type (see HIAHMachOUtils)
-          if ([HIAHMachOUtils patchBinaryToDylib:execPath]) {
-            NSLog(@"[Installer] Patched %@ for dynamic loading", exec);
-          }
-        }
+        [[self class] prepareExecutableInBundle:destPath];
+        [[HIAHFilesystem shared] addAppToBlobStore:destPath];
         [self
             showResult:YES
                message:[NSString stringWithFormat:
@@ -492,12 +527,23 @@
   } else if ([ext isEqualToString:@"ipa"] || [ext isEqualToString:@"zip"]) {
     // .ipa file - extract and install
     NSString *ipaName = fileURL.lastPathComponent;
+    if ([[NSUserDefaults standardUserDefaults]
+            boolForKey:@"HIAH_LazyInstall"]) {
+      NSLog(@"[Installer] Installing .ipa lazily: %@", ipaName);
+      [self installArchiveLazily:fileURL toDirectory:appsDir];
+      return;
+    }
+    if ([self updateInstalledAppFromArchive:fileURL toDirectory:appsDir]) {
+      return;
+    }
     NSLog(@"[Installer] Extracting .ipa: %@", ipaName);
 
-    // Create temp extraction directory in virtual filesystem tmp
-    HIAHFilesystem *fs = [HIAHFilesystem shared];
-    NSString *tempDir =
-        [fs.tmpPath stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    // Extract next to the installed apps, so the bundle is moved into
+    // place rather than copied: every file is written once
+    NSString *tempDir = [appsDir
+        stringByAppendingPathComponent:
+            [NSString
+                stringWithFormat:@".install-%@", [NSUUID UUID].UUIDString]];
     NSLog(@"[Installer] Temp dir: %@", tempDir);
     [fm createDirectoryAtPath:tempDir
         withIntermediateDirectories:YES
@@ -537,7 +583,7 @@
 
       NSLog(@"[Installer] Found app: %@", appBundle);
 
-      // Copy to Applications folder
+      // Move to Applications folder
       NSString *sourcePath =
           [payloadDir stringByAppendingPathComponent:appBundle];
       NSString *destPath = [appsDir stringByAppendingPathComponent:appBundle];
@@ -545,9 +591,9 @@
       // Remove existing
       [fm removeItemAtPath:destPath error:nil];
 
-      // Copy
+      // Move (same volume, so a rename)
       NSError *copyError = nil;
-      [fm copyItemAtPath:sourcePath toPath:destPath error:&copyError];
+      [fm moveItemAtPath:sourcePath toPath:destPath error:&copyError];
 
       if (copyError) {
         NSLog(@"[Installer] Copy error: %@", copyError);
@@ -556,22 +602,15 @@
                              stringWithFormat:@"Failed: %@",
                                               copyError.localizedDescription]];
       } else {
-        // Set executable permissions and patch for dynamic loading
-        NSString *plist =
-            [destPath stringByAppendingPathComponent:@"Info.plist"];
-        NSDictionary *info = [NSDictionary dictionaryWithContentsOfFile:plist];
-        NSString *exec = info[@"CFBundleExecutable"];
-        if (exec) {
-          NSString *execPath = [destPath stringByAppendingPathComponent:exec];
-          [fm setAttributes:@{NSFilePosixPermissions : @0755}
-               ofItemAtPath:execPath
-                      error:nil];
-
-          // Patch to a dlopen-compatible Mach-O type (see HIAHMachOUtils)
-          if ([HIAHMachOUtils patchBinaryToDylib:execPath]) {
-            NSLog(@"[Installer] Patched %@ for dynamic loading", exec);
-          }
+        [[self class] prepareExecutableInBundle:destPath];
+        // Lets the next version of the app install as a delta update
+        int manifestError = HIAHDeltaRecordManifest(
+            fileURL.fileSystemRepresentation, destPath.fileSystemRepresentation);
+        if (manifestError != 0) {
+          NSLog(@"[Installer] Could not record archive manifest: %s",
+                strerror(manifestError));
         }
+        [[HIAHFilesystem shared] addAppToBlobStore:destPath];
         NSLog(@"[Installer] .ipa installed successfully");
         [self showResult:YES
                  message:[NSString
@@ -1167,6 +1206,8 @@
                              if (error) {
                                NSLog(@"[Desktop] Failed to spawn %@: %@", name,
                                      error);
+                               [[HIAHFilesystem shared]
+                                   releaseStagedApp:stagedAppPath];
                                // Show error in window
                                UIViewController *errorVC =
                                    [[UIViewController alloc] init];
@@ -1204,6 +1245,9 @@
                                NSLog(@"[Desktop] Process spawned with PID %d, "
                                      @"setting up window capture...",
                                      spawnedPID);
+                               [[HIAHFilesystem shared]
+                                   releaseStagedApp:stagedAppPath
+                                   whenProcessExits:spawnedPID];
 
                                // Use HIAHAppWindowSession to capture the app's
                                // UI
@@ -1826,6 +1870,13 @@
   // Initialize Filesystem & Kernel
   [[HIAHFilesystem shared] initialize];
   [HIAHKernel sharedKernel];
+
+  // Bundled apps may still be installing (first launch of a new build)
+  [[HIAHFilesystem shared] notifyWhenBundledContentReady:^{
+    [[NSNotificationCenter defaultCenter]
+        postNotificationName:@"HIAHDesktopRefreshApps"
+                      object:nil];
+  }];
   
   // Initialize RefreshService for automatic certificate refresh
   // This handles the 7-day renewal and expiration notifications
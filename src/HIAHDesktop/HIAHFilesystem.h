@@ -15,6 +15,9 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+/// Posted on the main queue once bundled tools and apps are installed
+extern NSNotificationName const HIAHFilesystemBundledContentReadyNotification;
+
 @interface HIAHFilesystem : NSObject
 
 /// Shared filesystem instance
@@ -34,10 +37,26 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nonatomic, readonly) NSString *appsPath;     // /Applications
 
 /// Initialize the virtual filesystem (creates all directories)
+/// Bundled tools (/bin, /usr/bin) and apps are installed in the background;
+/// only items that changed since the last launch are copied
 - (void)initialize;
 
+#pragma mark - Bundled Content
+
+/// YES once bundled tools and apps are installed (or found up to date)
+@property (nonatomic, readonly, getter=isBundledContentReady) BOOL bundledContentReady;
+
+/// Run `block` on the main queue once bundled content is ready (at once if it is)
+- (void)notifyWhenBundledContentReady:(dispatch_block_t)block;
+
+/// Block until bundled content is ready, for callers that need /bin or
+/// /usr/bin right away. Returns NO on timeout. Never call on the main thread.
+- (BOOL)waitForBundledContentWithTimeout:(NSTimeInterval)timeout;
+
 /// Resolve a virtual path to actual filesystem path
 /// e.g., "/bin/bash" -> "<Documents>/bin/bash"
+/// Mounted directories are translated through the mount table (see
+/// HIAHMountTable.h): /usr and /etc fall back to the host's, read-only
 - (nullable NSString *)resolveVirtualPath:(NSString *)virtualPath;
 
 /// Check if a path is within the virtual filesystem
@@ -49,12 +68,34 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nonatomic, readonly, nullable) NSString *stagingPath;
 
 /// Stage an app from Documents to App Group for extension access
+/// The staged tree is kept between launches and only changed files are
+/// re-cloned (see HIAHStaging.h). Each successful call takes a reference
+/// that must be released with one of the methods below.
 /// Returns the staged path, or nil on failure
 - (nullable NSString *)stageAppForExtension:(NSString *)appPath;
 
-/// Clean up all staged apps
+/// Drop a reference taken by stageAppForExtension:
+- (void)releaseStagedApp:(NSString *)stagedPath;
+
+/// Drop a reference taken by stageAppForExtension: once the virtual process
+/// `pid` has exited
+- (void)releaseStagedApp:(NSString *)stagedPath whenProcessExits:(pid_t)pid;
+
+/// Clean up staged apps no longer referenced by a running process
 - (void)cleanupStagedApps;
 
+#pragma mark - Shared App Storage
+
+/// Content-addressed store the installed apps' files are deduplicated into
+@property (nonatomic, readonly) NSString *blobStorePath;
+
+/// Deduplicate a freshly installed bundle against the other installed apps
+/// (see HIAHBlobStore.h), then drop blobs no longer used by any app
+- (void)addAppToBlobStore:(NSString *)bundlePath;
+
+/// Drop blobs no longer used by any installed app and log the space saved
+- (void)collectUnusedBlobs;
+
 @end
 
 NS_ASSUME_NONNULL_END
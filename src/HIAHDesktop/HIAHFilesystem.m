@@ -9,14 +9,35 @@
  */
 
 #import "HIAHFilesystem.h"
+#import "HIAHBlobStore.h"
+#import "HIAHKernel.h"
 #import "HIAHMachOUtils.h"
 #import "HIAHLogging.h"
+#import "HIAHMountTable.h"
+#import "HIAHProcess.h"
+#import "HIAHStaging.h"
+#import <CommonCrypto/CommonDigest.h>
+#import <errno.h>
+#import <fcntl.h>
 #import <sys/stat.h>
+#import <unistd.h>
 
 static NSString * const kHIAHAppGroupIdentifier = @"group.com.aspauldingcode.HIAHDesktop";
 
+NSNotificationName const HIAHFilesystemBundledContentReadyNotification = @"HIAHFilesystemBundledContentReadyNotification";
+
+// Bumped when the layout of the bundled content manifest changes
+static const NSInteger kHIAHBundledManifestVersion = 1;
+
 @interface HIAHFilesystem ()
 @property (nonatomic, strong) NSString *appGroupPath;
+// Staged trees in use, and the virtual processes that release them on exit (guarded by stagingLock)
+@property (nonatomic, strong) NSCountedSet<NSString *> *stagedReferences;
+@property (nonatomic, strong) NSMutableDictionary<NSNumber *, NSString *> *stagedProcesses;
+@property (nonatomic, strong) NSLock *stagingLock;
+@property (nonatomic, strong) dispatch_group_t bundledContentGroup;
+@property (nonatomic, assign, readwrite, getter=isBundledContentReady) BOOL bundledContentReady;
+@property (nonatomic, assign) BOOL initialized;
 @end
 
 @implementation HIAHFilesystem
@@ -44,17 +65,33 @@ static NSString * const kHIAHAppGroupIdentifier = @"group.com.aspauldingcode.HIA
             HIAHLogError(HIAHLogFilesystem, "App Group not available - .ipa loading will not work");
             _appGroupPath = nil;
         }
+        
+        _stagedReferences = [NSCountedSet set];
+        _stagedProcesses = [NSMutableDictionary dictionary];
+        _stagingLock = [[NSLock alloc] init];
+        _bundledContentGroup = dispatch_group_create();
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(stagedProcessExited:)
+                                                     name:HIAHKernelProcessExitedNotification
+                                                   object:nil];
     }
     return self;
 }
 
 - (void)initialize {
+    // +shared initializes, and launch code may call this again
+    @synchronized (self) {
+        if (self.initialized) return;
+        self.initialized = YES;
+    }
+    
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
     NSFileManager *fm = [NSFileManager defaultManager];
     
     NSArray *directories = @[
         @"bin", @"sbin", @"usr/bin", @"usr/sbin", @"usr/lib", @"usr/share",
         @"usr/local/bin", @"usr/local/lib", @"lib", @"etc", @"tmp",
-        @"var/tmp", @"var/log", @"home", @"Applications", @"dev", @"proc"
+        @"var/tmp", @"var/log", @"var/db", @"home", @"Applications", @"dev", @"proc"
     ];
     
     for (NSString *dir in directories) {
@@ -68,6 +105,8 @@ static NSString * const kHIAHAppGroupIdentifier = @"group.com.aspauldingcode.HIA
         }
     }
     
+    [self mountVirtualDirectories];
+    
     if (self.appGroupPath) {
         NSString *stagingPath = [self.appGroupPath stringByAppendingPathComponent:@"staging"];
         if (![fm fileExistsAtPath:stagingPath]) {
@@ -75,81 +114,243 @@ static NSString * const kHIAHAppGroupIdentifier = @"group.com.aspauldingcode.HIA
         }
     }
     
-    [self installBundledBinaries];
-    [self installBundledApps];
+    // The desktop doesn't wait for bundled content; spawns of anything under
+    // the virtual root do, since that may be a tool still being installed
+    __weak HIAHFilesystem *weakSelf = self;
+    [HIAHKernel sharedKernel].spawnReadinessHandler = ^(NSString *path, dispatch_block_t proceed) {
+        HIAHFilesystem *fs = weakSelf;
+        if (!fs || fs.bundledContentReady || ![fs isVirtualPath:path]) {
+            proceed();
+            return;
+        }
+        HIAHLogInfo(HIAHLogFilesystem, "Holding spawn of %s until bundled content is installed", path.UTF8String);
+        [fs notifyWhenBundledContentReady:proceed];
+    };
+    
+    dispatch_group_enter(self.bundledContentGroup);
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        [self installBundledContent];
+        self.bundledContentReady = YES;
+        dispatch_group_leave(self.bundledContentGroup);
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [[NSNotificationCenter defaultCenter] postNotificationName:HIAHFilesystemBundledContentReadyNotification object:self];
+        });
+        
+        // Apps deleted in Files.app leave their blobs behind
+        [self collectUnusedBlobs];
+    });
     
-    HIAHLogInfo(HIAHLogFilesystem, "Virtual filesystem initialized at %s", [self.rootPath UTF8String]);
+    HIAHLogInfo(HIAHLogFilesystem, "Virtual filesystem initialized at %s in %.1f ms", [self.rootPath UTF8String],
+                (CFAbsoluteTimeGetCurrent() - start) * 1000.0);
 }
 
-- (void)installBundledBinaries {
-    @try {
-        NSFileManager *fm = [NSFileManager defaultManager];
-        NSString *bundledBinPath = [[NSBundle mainBundle].bundlePath stringByAppendingPathComponent:@"bin"];
-        NSString *bundledUsrBinPath = [[NSBundle mainBundle].bundlePath stringByAppendingPathComponent:@"usr/bin"];
-        
-        if ([fm fileExistsAtPath:bundledBinPath]) {
-            NSArray *binaries = [fm contentsOfDirectoryAtPath:bundledBinPath error:nil];
-            for (NSString *binary in binaries) {
-                NSString *source = [bundledBinPath stringByAppendingPathComponent:binary];
-                NSString *dest = [self.binPath stringByAppendingPathComponent:binary];
-                
-                if (![fm fileExistsAtPath:dest]) {
-                    [fm copyItemAtPath:source toPath:dest error:nil];
-                    chmod([dest UTF8String], 0755);
-                    [HIAHMachOUtils patchBinaryToDylib:dest];
-                }
-            }
+#pragma mark - Mounts
+
+- (void)mountVirtualDirectories {
+    // Not all of /var: the app's own container lives under it
+    NSArray<NSString *> *mountPoints = @[
+        @"/bin", @"/sbin", @"/usr", @"/lib", @"/etc", @"/tmp",
+        @"/var/tmp", @"/var/log", @"/var/db", @"/home", @"/Applications"
+    ];
+    // Read-only overlays over the host's directories, so guests still find
+    // the system files the virtual tree doesn't replace
+    NSSet<NSString *> *overlays = [NSSet setWithObjects:@"/usr", @"/etc", nil];
+    
+    for (NSString *mountPoint in mountPoints) {
+        NSString *backingPath = [self.rootPath stringByAppendingString:mountPoint];
+        const char *lowerPath = [overlays containsObject:mountPoint] ? mountPoint.fileSystemRepresentation : NULL;
+        int error = HIAHMountAdd(mountPoint.fileSystemRepresentation, backingPath.fileSystemRepresentation, lowerPath, 0);
+        if (error) {
+            HIAHLogError(HIAHLogFilesystem, "Failed to mount %s: %s", mountPoint.UTF8String, strerror(error));
         }
-        
-        if ([fm fileExistsAtPath:bundledUsrBinPath]) {
-            NSArray *binaries = [fm contentsOfDirectoryAtPath:bundledUsrBinPath error:nil];
-            for (NSString *binary in binaries) {
-                NSString *source = [bundledUsrBinPath stringByAppendingPathComponent:binary];
-                NSString *dest = [self.usrBinPath stringByAppendingPathComponent:binary];
-                
-                if (![fm fileExistsAtPath:dest]) {
-                    [fm copyItemAtPath:source toPath:dest error:nil];
-                    chmod([dest UTF8String], 0755);
-                }
-            }
+    }
+    
+    // The extension runs guests in its own process and mounts the same table
+    if (self.appGroupPath) {
+        NSString *tablePath = [self.appGroupPath stringByAppendingPathComponent:@HIAH_MOUNT_TABLE_FILE];
+        int error = HIAHMountSave(tablePath.fileSystemRepresentation);
+        if (error) {
+            HIAHLogError(HIAHLogFilesystem, "Failed to save the mount table: %s", strerror(error));
         }
-    } @catch (NSException *exception) {
-        HIAHLogError(HIAHLogFilesystem, "Exception during binary installation: %s", [[exception description] UTF8String]);
     }
+    
+    // Bundled apps run on guest threads of this process; only their file
+    // calls go through the table, not UIKit's or Foundation's
+    HIAHMountSetScope(HIAHMountScopeGuestThreads);
+    HIAHMountInstallHooks();
 }
 
-- (void)installBundledApps {
-    @try {
-        NSFileManager *fm = [NSFileManager defaultManager];
-        NSString *bundledAppsPath = [[NSBundle mainBundle].bundlePath stringByAppendingPathComponent:@"BundledApps"];
-        
-        if (![fm fileExistsAtPath:bundledAppsPath]) {
-            return;
+#pragma mark - Bundled Content
+
+- (void)notifyWhenBundledContentReady:(dispatch_block_t)block {
+    dispatch_group_notify(self.bundledContentGroup, dispatch_get_main_queue(), block);
+}
+
+- (BOOL)waitForBundledContentWithTimeout:(NSTimeInterval)timeout {
+    return dispatch_group_wait(self.bundledContentGroup, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(timeout * NSEC_PER_SEC))) == 0;
+}
+
+// Bundled tools (bin, usr/bin) and apps (BundledApps), keyed by where they
+// are installed relative to the root
+- (NSDictionary<NSString *, NSString *> *)bundledItems {
+    NSFileManager *fm = [[NSFileManager alloc] init];
+    NSString *bundlePath = [NSBundle mainBundle].bundlePath;
+    NSMutableDictionary<NSString *, NSString *> *items = [NSMutableDictionary dictionary];
+    
+    for (NSString *dir in @[@"bin", @"usr/bin"]) {
+        NSString *source = [bundlePath stringByAppendingPathComponent:dir];
+        for (NSString *name in [fm contentsOfDirectoryAtPath:source error:nil]) {
+            items[[dir stringByAppendingPathComponent:name]] = [source stringByAppendingPathComponent:name];
         }
-        
-        NSArray *apps = [fm contentsOfDirectoryAtPath:bundledAppsPath error:nil];
-        for (NSString *appName in apps) {
-            if (![appName hasSuffix:@".app"]) {
-                continue;
-            }
-            
-            NSString *sourcePath = [bundledAppsPath stringByAppendingPathComponent:appName];
-            NSString *destPath = [self.appsPath stringByAppendingPathComponent:appName];
-            
-            if ([fm fileExistsAtPath:destPath]) {
-                [fm removeItemAtPath:destPath error:nil];
-            }
+    }
+    
+    NSString *bundledAppsPath = [bundlePath stringByAppendingPathComponent:@"BundledApps"];
+    for (NSString *appName in [fm contentsOfDirectoryAtPath:bundledAppsPath error:nil]) {
+        if (![appName hasSuffix:@".app"]) continue;
+        items[[@"Applications" stringByAppendingPathComponent:appName]] = [bundledAppsPath stringByAppendingPathComponent:appName];
+    }
+    return items;
+}
+
+static BOOL HIAHHashFile(NSString *path, unsigned char digest[CC_SHA256_DIGEST_LENGTH]) {
+    int fd = open([path fileSystemRepresentation], O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return NO;
+    
+    CC_SHA256_CTX sha;
+    CC_SHA256_Init(&sha);
+    static const size_t bufferSize = 256 * 1024;
+    uint8_t *buffer = malloc(bufferSize);
+    ssize_t got = buffer ? 0 : -1;
+    while (buffer) {
+        got = read(fd, buffer, bufferSize);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) break;
+        CC_SHA256_Update(&sha, buffer, (CC_LONG)got);
+    }
+    free(buffer);
+    close(fd);
+    CC_SHA256_Final(digest, &sha);
+    return got == 0;
+}
+
+// SHA-256 of a file, or of a bundle's sorted paths and their contents
+static NSString *HIAHHashBundledItem(NSString *path) {
+    BOOL isDirectory = NO;
+    if (![[NSFileManager defaultManager] fileExistsAtPath:path isDirectory:&isDirectory]) return nil;
+    
+    unsigned char digest[CC_SHA256_DIGEST_LENGTH];
+    if (!isDirectory) {
+        if (!HIAHHashFile(path, digest)) return nil;
+    } else {
+        CC_SHA256_CTX sha;
+        CC_SHA256_Init(&sha);
+        NSArray *subpaths = [[[NSFileManager alloc] init] subpathsOfDirectoryAtPath:path error:nil];
+        for (NSString *subpath in [subpaths sortedArrayUsingSelector:@selector(compare:)]) {
+            NSString *itemPath = [path stringByAppendingPathComponent:subpath];
+            struct stat st;
+            if (lstat([itemPath fileSystemRepresentation], &st) != 0) return nil;
             
-            NSError *error = nil;
-            if ([fm copyItemAtPath:sourcePath toPath:destPath error:&error]) {
-                HIAHLogDebug(HIAHLogFilesystem, "Installed app: %s", [appName UTF8String]);
-            } else {
-                HIAHLogError(HIAHLogFilesystem, "Failed to install %s: %s", [appName UTF8String], error ? [[error description] UTF8String] : "(null)");
+            const char *name = [subpath fileSystemRepresentation];
+            CC_SHA256_Update(&sha, name, (CC_LONG)strlen(name) + 1);
+            unsigned char fileDigest[CC_SHA256_DIGEST_LENGTH];
+            if (S_ISREG(st.st_mode)) {
+                if (!HIAHHashFile(itemPath, fileDigest)) return nil;
+                CC_SHA256_Update(&sha, fileDigest, sizeof(fileDigest));
+            } else if (S_ISLNK(st.st_mode)) {
+                char target[PATH_MAX];
+                ssize_t length = readlink([itemPath fileSystemRepresentation], target, sizeof(target));
+                if (length < 0) return nil;
+                CC_SHA256_Update(&sha, target, (CC_LONG)length);
             }
         }
-    } @catch (NSException *exception) {
-        HIAHLogError(HIAHLogFilesystem, "Exception during app installation: %s", [[exception description] UTF8String]);
+        CC_SHA256_Final(digest, &sha);
+    }
+    
+    NSMutableString *hex = [NSMutableString stringWithCapacity:CC_SHA256_DIGEST_LENGTH * 2];
+    for (size_t i = 0; i < CC_SHA256_DIGEST_LENGTH; i++) {
+        [hex appendFormat:@"%02x", digest[i]];
+    }
+    return hex;
+}
+
+// Copies a bundled item next to its destination, then renames it into place
+- (BOOL)installBundledItem:(NSString *)source atPath:(NSString *)destination {
+    NSFileManager *fm = [[NSFileManager alloc] init];
+    NSString *temporary = [[destination stringByDeletingLastPathComponent] stringByAppendingPathComponent:
+                           [NSString stringWithFormat:@".bundled-%@", [NSUUID UUID].UUIDString]];
+    
+    NSError *error = nil;
+    if (![fm copyItemAtPath:source toPath:temporary error:&error]) {
+        HIAHLogError(HIAHLogFilesystem, "Failed to install %s: %s", [[destination lastPathComponent] UTF8String], error ? [[error description] UTF8String] : "(null)");
+        return NO;
+    }
+    
+    BOOL isDirectory = NO;
+    [fm fileExistsAtPath:temporary isDirectory:&isDirectory];
+    if (!isDirectory) {
+        chmod([temporary UTF8String], 0755);
+        // Tools in /bin are loaded with dlopen (see HIAHMachOUtils)
+        if ([[destination stringByDeletingLastPathComponent] isEqualToString:self.binPath]) {
+            [HIAHMachOUtils patchBinaryToDylib:temporary];
+        }
+    } else {
+        [fm removeItemAtPath:destination error:nil];
+    }
+    
+    if (rename([temporary fileSystemRepresentation], [destination fileSystemRepresentation]) != 0) {
+        HIAHLogError(HIAHLogFilesystem, "Failed to install %s: %s", [[destination lastPathComponent] UTF8String], strerror(errno));
+        [fm removeItemAtPath:temporary error:nil];
+        return NO;
+    }
+    return YES;
+}
+
+// Installs the bundled items whose content differs from what was installed
+// last time. The manifest (var/db/bundled.plist) records each item's hash
+// and the build they were hashed in; within one build the bundle cannot
+// change, so a warm launch hashes nothing and only checks that every item
+// is still installed.
+- (void)installBundledContent {
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    NSString *manifestPath = [self.rootPath stringByAppendingPathComponent:@"var/db/bundled.plist"];
+    NSDictionary *manifest = [NSDictionary dictionaryWithContentsOfFile:manifestPath];
+    
+    NSBundle *mainBundle = [NSBundle mainBundle];
+    NSDate *built = [[NSFileManager defaultManager] attributesOfItemAtPath:mainBundle.executablePath error:nil].fileModificationDate;
+    NSString *build = [NSString stringWithFormat:@"%@-%.0f", [mainBundle objectForInfoDictionaryKey:@"CFBundleVersion"], built.timeIntervalSince1970];
+    BOOL sameBuild = [manifest[@"version"] isEqual:@(kHIAHBundledManifestVersion)] && [manifest[@"build"] isEqual:build];
+    NSDictionary<NSString *, NSString *> *installed = [manifest[@"items"] isKindOfClass:[NSDictionary class]] ? manifest[@"items"] : @{};
+    
+    NSDictionary<NSString *, NSString *> *items = [self bundledItems];
+    NSArray<NSString *> *keys = items.allKeys;
+    NSMutableDictionary<NSString *, NSString *> *hashes = [NSMutableDictionary dictionaryWithCapacity:keys.count];
+    NSLock *lock = [[NSLock alloc] init];
+    __block NSUInteger copied = 0;
+    
+    dispatch_apply(keys.count, DISPATCH_APPLY_AUTO, ^(size_t i) {
+        NSString *key = keys[i];
+        NSString *destination = [self.rootPath stringByAppendingPathComponent:key];
+        NSString *hash = sameBuild ? installed[key] : nil;
+        if (!hash) hash = HIAHHashBundledItem(items[key]);
+        if (!hash) return;
+        
+        BOOL current = [installed[key] isEqualToString:hash] && access([destination fileSystemRepresentation], F_OK) == 0;
+        BOOL installedNow = !current && [self installBundledItem:items[key] atPath:destination];
+        
+        [lock lock];
+        if (current || installedNow) hashes[key] = hash;
+        if (installedNow) copied++;
+        [lock unlock];
+    });
+    
+    NSDictionary *updated = @{@"version" : @(kHIAHBundledManifestVersion), @"build" : build, @"items" : hashes};
+    if (![updated isEqual:manifest]) {
+        [updated writeToFile:manifestPath atomically:YES];
     }
+    
+    HIAHLogInfo(HIAHLogFilesystem, "Bundled content ready in %.1f ms (%s start): %lu of %lu items copied",
+                (CFAbsoluteTimeGetCurrent() - start) * 1000.0, sameBuild ? "warm" : "cold",
+                (unsigned long)copied, (unsigned long)keys.count);
 }
 
 #pragma mark - Path Accessors
@@ -162,6 +363,7 @@ static NSString * const kHIAHAppGroupIdentifier = @"group.com.aspauldingcode.HIA
 - (NSString *)tmpPath { return [self.rootPath stringByAppendingPathComponent:@"tmp"]; }
 - (NSString *)homePath { return [self.rootPath stringByAppendingPathComponent:@"home"]; }
 - (NSString *)appsPath { return [self.rootPath stringByAppendingPathComponent:@"Applications"]; }
+- (NSString *)blobStorePath { return [self.rootPath stringByAppendingPathComponent:@"var/db/blobs"]; }
 
 #pragma mark - Extension Staging
 
@@ -176,21 +378,66 @@ static NSString * const kHIAHAppGroupIdentifier = @"group.com.aspauldingcode.HIA
         return nil;
     }
     
-    NSFileManager *fm = [NSFileManager defaultManager];
     NSString *appName = [appPath lastPathComponent];
     NSString *stagingDir = [self stagingPath];
     NSString *stagedPath = [stagingDir stringByAppendingPathComponent:appName];
     
-    [fm removeItemAtPath:stagedPath error:nil];
+    // Files gone from the source are only pruned once no instance runs from the tree
+    HIAHStagingStats stats;
+    [self.stagingLock lock];
+    BOOL inUse = [self.stagedReferences countForObject:stagedPath] > 0;
+    int result = HIAHStagingSync([appPath fileSystemRepresentation], [stagedPath fileSystemRepresentation], !inUse, &stats);
+    if (result == 0) {
+        [self.stagedReferences addObject:stagedPath];
+    }
+    [self.stagingLock unlock];
     
-    NSError *error = nil;
-    if ([fm copyItemAtPath:appPath toPath:stagedPath error:&error]) {
-        HIAHLogDebug(HIAHLogFilesystem, "Staged app: %s", [appName UTF8String]);
-        return stagedPath;
-    } else {
-        HIAHLogError(HIAHLogFilesystem, "Failed to stage app %s: %s", [appName UTF8String], error ? [[error description] UTF8String] : "(null)");
+    if (result != 0) {
+        HIAHLogError(HIAHLogFilesystem, "Failed to stage app %s: %s", [appName UTF8String], strerror(result));
         return nil;
     }
+    
+    HIAHLogInfo(HIAHLogFilesystem, "Staged app %s in %.1f ms: %llu files, %llu unchanged, %llu cloned, %llu linked, %llu copied (%llu bytes), %llu removed",
+                [appName UTF8String], stats.wallNs / 1e6, stats.files, stats.unchanged, stats.cloned, stats.linked,
+                stats.copied, stats.copiedBytes, stats.removed);
+    return stagedPath;
+}
+
+- (void)releaseStagedApp:(NSString *)stagedPath {
+    [self.stagingLock lock];
+    [self.stagedReferences removeObject:stagedPath];
+    [self.stagingLock unlock];
+}
+
+- (void)releaseStagedApp:(NSString *)stagedPath whenProcessExits:(pid_t)pid {
+    // The process may already be gone by the time its spawn completes
+    HIAHProcess *process = [[HIAHKernel sharedKernel] processForPID:pid];
+    if (!process || process.isExited) {
+        [self releaseStagedApp:stagedPath];
+        return;
+    }
+    
+    [self.stagingLock lock];
+    NSString *previous = self.stagedProcesses[@(pid)];
+    if (previous) {
+        [self.stagedReferences removeObject:previous];
+    }
+    self.stagedProcesses[@(pid)] = stagedPath;
+    [self.stagingLock unlock];
+}
+
+// Posted once by the exit handler and again on unregistration; the first one releases
+- (void)stagedProcessExited:(NSNotification *)notification {
+    HIAHProcess *process = notification.userInfo[@"process"];
+    if (!process) return;
+    
+    [self.stagingLock lock];
+    NSString *stagedPath = self.stagedProcesses[@(process.pid)];
+    if (stagedPath) {
+        [self.stagedProcesses removeObjectForKey:@(process.pid)];
+        [self.stagedReferences removeObject:stagedPath];
+    }
+    [self.stagingLock unlock];
 }
 
 - (void)cleanupStagedApps {
@@ -206,10 +453,43 @@ static NSString * const kHIAHAppGroupIdentifier = @"group.com.aspauldingcode.HIA
         return;
     }
     
+    [self.stagingLock lock];
     for (NSString *item in contents) {
         NSString *itemPath = [stagingDir stringByAppendingPathComponent:item];
+        if ([self.stagedReferences countForObject:itemPath] > 0) continue;
         [fm removeItemAtPath:itemPath error:nil];
     }
+    [self.stagingLock unlock];
+}
+
+#pragma mark - Shared App Storage
+
+- (void)addAppToBlobStore:(NSString *)bundlePath {
+    HIAHBlobAddStats stats;
+    int result = HIAHBlobStoreAdd([self.blobStorePath fileSystemRepresentation], [bundlePath fileSystemRepresentation], &stats);
+    if (result != 0) {
+        HIAHLogError(HIAHLogFilesystem, "Blob store: %s only partly deduplicated: %s", [[bundlePath lastPathComponent] UTF8String], strerror(result));
+    }
+    HIAHLogInfo(HIAHLogFilesystem, "Blob store: %s hashed in %.1f ms, %llu of %llu files shared (%.1f MB saved), %llu new blobs",
+                [[bundlePath lastPathComponent] UTF8String], stats.wallNs / 1e6, stats.shared, stats.files,
+                stats.sharedBytes / 1048576.0, stats.stored);
+    
+    // The bundle may have replaced an older install of the same app
+    [self collectUnusedBlobs];
+}
+
+- (void)collectUnusedBlobs {
+    HIAHBlobStoreReport report;
+    int result = HIAHBlobStoreCollect([self.blobStorePath fileSystemRepresentation], [self.appsPath fileSystemRepresentation], &report);
+    if (result != 0) {
+        HIAHLogError(HIAHLogFilesystem, "Blob store collection failed: %s", strerror(result));
+        return;
+    }
+    
+    uint64_t saved = report.referencedBytes > report.blobBytes ? report.referencedBytes - report.blobBytes : 0;
+    HIAHLogInfo(HIAHLogFilesystem, "Blob store: %llu blobs (%.1f MB) used by %llu apps, %.1f MB saved; removed %llu unused (%.1f MB)",
+                report.blobs, report.blobBytes / 1048576.0, report.apps, saved / 1048576.0,
+                report.removed, report.removedBytes / 1048576.0);
 }
 
 #pragma mark - Path Resolution
@@ -222,6 +502,11 @@ static NSString * const kHIAHAppGroupIdentifier = @"group.com.aspauldingcode.HIA
     }
     
     if ([virtualPath hasPrefix:@"/"]) {
+        // Mounted directories, through overlays and symlinks (see HIAHMountTable.h)
+        char resolved[PATH_MAX];
+        if (HIAHMountResolve(virtualPath.fileSystemRepresentation, 0, resolved, sizeof(resolved)) > 0) {
+            return [[NSFileManager defaultManager] stringWithFileSystemRepresentation:resolved length:strlen(resolved)];
+        }
         NSString *relativePath = [virtualPath substringFromIndex:1];
         return [self.rootPath stringByAppendingPathComponent:relativePath];
     }
@@ -230,16 +515,11 @@ static NSString * const kHIAHAppGroupIdentifier = @"group.com.aspauldingcode.HIA
 }
 
 - (BOOL)isVirtualPath:(NSString *)path {
-    if (!path) return NO;
-    
-    NSArray *virtualPrefixes = @[@"/bin", @"/usr", @"/lib", @"/etc", @"/tmp", @"/var", @"/home", @"/Applications"];
-    for (NSString *prefix in virtualPrefixes) {
-        if ([path hasPrefix:prefix]) {
-            return YES;
-        }
-    }
+    if (path.length == 0) return NO;
+    if ([path hasPrefix:self.rootPath]) return YES;
     
-    return [path hasPrefix:self.rootPath];
+    char resolved[PATH_MAX];
+    return HIAHMountResolve(path.fileSystemRepresentation, 0, resolved, sizeof(resolved)) > 0;
 }
 
 @end
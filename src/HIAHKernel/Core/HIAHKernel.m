@@ -9,6 +9,11 @@
  */
 
 #import "HIAHKernel.h"
+#import "HIAHChildTable.h"
+#import "HIAHExtensionRegistry.h"
+#import "HIAHGuestLauncher.h"
+#import "HIAHHookStats.h"
+#import "HIAHLaunchMetadata.h"
 #import "HIAHLogging.h"
 #import "HIAHMachOUtils.h"
 #import <CoreFoundation/CoreFoundation.h>
@@ -19,64 +24,127 @@
 #import <sys/un.h>
 #import <unistd.h>
 
+// Runs a guest body block handed to HIAHGuestThreadLaunch
+static void *HIAHKernelGuestThreadMain(void *context) {
+  void (^body)(void) = (__bridge_transfer void (^)(void))context;
+  body();
+  return NULL;
+}
+
+// Maps the extension registry of `kernel`'s App Group, remapping if the
+// group changes
+static HIAHExtensionRegistry *HIAHKernelExtensionRegistry(HIAHKernel *kernel) {
+  static HIAHExtensionRegistry *registry = NULL;
+  static NSString *registryGroup = nil;
+
+  @synchronized(kernel) {
+    NSString *group = kernel.appGroupIdentifier;
+    if (registry && [group isEqualToString:registryGroup]) {
+      return registry;
+    }
+
+    NSURL *groupURL = [[NSFileManager defaultManager]
+        containerURLForSecurityApplicationGroupIdentifier:group];
+    if (!groupURL) {
+      return NULL;
+    }
+    NSURL *registryURL = [groupURL
+        URLByAppendingPathComponent:@HIAH_EXTENSION_REGISTRY_FILE];
+    HIAHExtensionRegistry *mapped =
+        HIAHExtensionRegistryMap(registryURL.fileSystemRepresentation);
+    if (mapped) {
+      registry = mapped;
+      registryGroup = [group copy];
+    }
+    return mapped;
+  }
+}
+
+// How long a hookstats request waits for extensions to publish
+#define HIAH_HOOK_STATS_IMPORT_TIMEOUT_MS 100
+
+// Directory in `kernel`'s App Group where extensions export hook stats
+static NSString *HIAHKernelHookStatsExportDirectory(HIAHKernel *kernel) {
+  NSURL *groupURL = [[NSFileManager defaultManager]
+      containerURLForSecurityApplicationGroupIdentifier:kernel
+                                                            .appGroupIdentifier];
+  return [groupURL URLByAppendingPathComponent:@HIAH_HOOK_STATS_EXPORT_DIR]
+      .path;
+}
+
+// Per-hook counters and histogram, as reported by the hookstats command
+static NSDictionary *HIAHHookStatsDictionary(
+    const HIAHHookStatsEntry entries[HIAHHookStatCount]) {
+  NSMutableDictionary *hooks = [NSMutableDictionary dictionary];
+  for (int s = 0; s < HIAHHookStatCount; s++) {
+    const HIAHHookStatsEntry *entry = &entries[s];
+    NSMutableArray *histogram =
+        [NSMutableArray arrayWithCapacity:HIAH_HOOK_STATS_BUCKETS];
+    for (int b = 0; b < HIAH_HOOK_STATS_BUCKETS; b++) {
+      [histogram addObject:@(entry->histogram[b])];
+    }
+    hooks[@(HIAHHookStatName((HIAHHookStat)s))] = @{
+      @"calls" : @(entry->counters[HIAHHookCounterCalls]),
+      @"reentrant" : @(entry->counters[HIAHHookCounterReentrant]),
+      @"disabled" : @(entry->counters[HIAHHookCounterDisabled]),
+      @"failures" : @(entry->counters[HIAHHookCounterFailures]),
+      @"totalNs" : @(entry->totalNs),
+      @"maxNs" : @(entry->maxNs),
+      @"histogram" : histogram
+    };
+  }
+  return hooks;
+}
+
 // Callback for extension started notifications
 static void extensionStartedCallback(CFNotificationCenterRef center,
                                      void *observer, CFStringRef name,
                                      const void *object,
                                      CFDictionaryRef userInfo) {
   HIAHKernel *kernel = (__bridge HIAHKernel *)observer;
-  if (kernel) {
-    // Read PIDs from App Group storage
-    // CRITICAL: Read both the shared PID file AND all unique PID files
-    // This ensures we enable JIT for ALL extension processes, not just the last
-    // one
-    NSFileManager *fm = [NSFileManager defaultManager];
-    NSURL *groupURL = [fm containerURLForSecurityApplicationGroupIdentifier:
-                              kernel.appGroupIdentifier];
-    if (groupURL) {
-      // Read shared PID file (may contain the latest extension PID)
-      NSString *pidFile =
-          [[groupURL.path stringByAppendingPathComponent:@"extension.pid"]
-              stringByStandardizingPath];
-      NSString *pidStr = [NSString stringWithContentsOfFile:pidFile
-                                                   encoding:NSUTF8StringEncoding
-                                                      error:nil];
-      if (pidStr) {
-        pid_t pid = pidStr.intValue;
-        HIAHLogEx(HIAH_LOG_INFO, @"Kernel",
-                  @"Extension started notification received (PID: %d from "
-                  @"shared file) - enabling JIT immediately",
-                  pid);
-        [kernel enableJITForExtensionProcessWithRetries:pid];
-      }
+  if (!kernel) {
+    return;
+  }
 
-      // CRITICAL: Also scan for all unique PID files (extension.PID.pid)
-      // This catches ALL extension processes, not just the one that wrote to
-      // the shared file
-      NSError *error = nil;
-      NSArray<NSString *> *files = [fm contentsOfDirectoryAtPath:groupURL.path
-                                                           error:&error];
-      if (files) {
-        for (NSString *filename in files) {
-          if ([filename hasPrefix:@"extension."] &&
-              [filename hasSuffix:@".pid"] &&
-              ![filename isEqualToString:@"extension.pid"]) {
-            // Extract PID from filename (extension.PID.pid)
-            NSString *pidPart = [[filename stringByDeletingPathExtension]
-                stringByReplacingOccurrencesOfString:@"extension."
-                                          withString:@""];
-            pid_t pid = pidPart.intValue;
-            if (pid > 0) {
-              HIAHLogEx(
-                  HIAH_LOG_INFO, @"Kernel",
-                  @"Found extension PID file: %@ (PID: %d) - enabling JIT",
-                  filename, pid);
-              [kernel enableJITForExtensionProcessWithRetries:pid];
-            }
-          }
-        }
-      }
+  HIAHExtensionRegistry *registry = HIAHKernelExtensionRegistry(kernel);
+  if (!registry) {
+    // Registry unavailable - fall back to the PID the extension last wrote
+    NSURL *groupURL = [[NSFileManager defaultManager]
+        containerURLForSecurityApplicationGroupIdentifier:
+            kernel.appGroupIdentifier];
+    NSString *pidFile =
+        [[groupURL.path stringByAppendingPathComponent:@"extension.pid"]
+            stringByStandardizingPath];
+    NSString *pidStr = pidFile ? [NSString
+                                     stringWithContentsOfFile:pidFile
+                                                     encoding:NSUTF8StringEncoding
+                                                        error:nil]
+                               : nil;
+    if (pidStr.intValue > 0) {
+      HIAHLogEx(HIAH_LOG_INFO, @"Kernel",
+                @"Extension started notification received (PID: %d from "
+                @"shared file) - enabling JIT immediately",
+                pidStr.intValue);
+      [kernel enableJITForExtensionProcessWithRetries:pidStr.intValue];
     }
+    return;
+  }
+
+  // Reclaim slots of extensions that have died, then start JIT only for the
+  // ones no earlier notification has handled
+  size_t collected = HIAHExtensionRegistryCollect(registry);
+  HIAHExtensionRecord pending[HIAH_EXTENSION_REGISTRY_CAPACITY];
+  size_t count = HIAHExtensionRegistryClaimPendingJIT(
+      registry, pending, HIAH_EXTENSION_REGISTRY_CAPACITY);
+
+  HIAHLogEx(HIAH_LOG_INFO, @"Kernel",
+            @"Extension started notification received: %zu new extension(s), "
+            @"%zu dead entr%s collected",
+            count, collected, collected == 1 ? "y" : "ies");
+  for (size_t i = 0; i < count; i++) {
+    HIAHLogEx(HIAH_LOG_INFO, @"Kernel",
+              @"Enabling JIT for extension PID %d", pending[i].pid);
+    [kernel enableJITForExtensionProcessWithRetries:pending[i].pid];
   }
 }
 
@@ -226,17 +294,24 @@ NSErrorDomain const HIAHKernelErrorDomain = @"HIAHKernelErrorDomain";
 
         while ((n = read(sock, buffer, sizeof(buffer))) > 0) {
           [data appendBytes:buffer length:n];
-          // Simple newline-delimited JSON protocol
-          if (buffer[n - 1] == '\n') {
-            NSError *err;
-            NSDictionary *req = [NSJSONSerialization JSONObjectWithData:data
-                                                                options:0
-                                                                  error:&err];
-            if (req) {
-              [self processControlRequest:req socket:sock];
+          // Newline-delimited JSON: one read may hold several requests (the
+          // socket log sink batches them) or part of one
+          const char *bytes = data.bytes;
+          NSUInteger start = 0;
+          for (NSUInteger i = 0; i < data.length; i++) {
+            if (bytes[i] != '\n') continue;
+            if (i > start) {
+              NSData *line = [data subdataWithRange:NSMakeRange(start, i - start)];
+              NSDictionary *req = [NSJSONSerialization JSONObjectWithData:line
+                                                                  options:0
+                                                                    error:nil];
+              if ([req isKindOfClass:[NSDictionary class]]) {
+                [self processControlRequest:req socket:sock];
+              }
             }
-            [data setLength:0];
+            start = i + 1;
           }
+          [data replaceBytesInRange:NSMakeRange(0, start) withBytes:NULL length:0];
         }
         close(sock);
       });
@@ -287,6 +362,65 @@ NSErrorDomain const HIAHKernelErrorDomain = @"HIAHKernelErrorDomain";
                                                          error:nil];
     write(sock, respData.bytes, respData.length);
     write(sock, "\n", 1);
+  } else if ([command isEqualToString:@"hookstats"]) {
+    if (req[@"enable"]) {
+      HIAHHookStatsSetEnabled([req[@"enable"] boolValue]);
+    }
+
+    // Extensions publish their own totals on request; they are reported
+    // separately from the kernel process's
+    NSString *exportDir = HIAHKernelHookStatsExportDirectory(self);
+    if (exportDir) {
+      HIAHHookStatsRequestPublish(exportDir.fileSystemRepresentation,
+                                  req[@"enable"] ? [req[@"enable"] boolValue] : -1,
+                                  [req[@"reset"] boolValue]);
+      CFNotificationCenterPostNotification(
+          CFNotificationCenterGetDarwinNotifyCenter(),
+          CFSTR(HIAH_HOOK_STATS_PUBLISH_NOTIFICATION), NULL, NULL, true);
+    }
+
+    HIAHHookStatsEntry entries[HIAHHookStatCount];
+    HIAHHookStatsSnapshot(entries);
+    NSDictionary *hooks = HIAHHookStatsDictionary(entries);
+
+    HIAHHookStatsEntry extensionEntries[HIAHHookStatCount];
+    size_t extensionCount = 0;
+    if (exportDir) {
+      extensionCount = HIAHHookStatsImport(exportDir.fileSystemRepresentation,
+                                           HIAH_HOOK_STATS_IMPORT_TIMEOUT_MS,
+                                           extensionEntries);
+    }
+
+    HIAHHookGuestSpawns top[16];
+    size_t topCount = HIAHHookStatsGuestSpawns(top, 16);
+    NSMutableArray *guests = [NSMutableArray arrayWithCapacity:topCount];
+    for (size_t i = 0; i < topCount; i++) {
+      [guests addObject:@{@"vpid" : @(top[i].vpid),
+                          @"spawns" : @(top[i].spawns)}];
+    }
+
+    // Reset after reading so a poller gets per-interval deltas
+    if ([req[@"reset"] boolValue]) {
+      HIAHHookStatsReset();
+    }
+
+    NSMutableDictionary *resp = [@{
+      @"status" : @"ok",
+      @"enabled" : @(HIAHHookStatsEnabled()),
+      @"hooks" : hooks,
+      @"guests" : guests
+    } mutableCopy];
+    if (extensionCount > 0) {
+      resp[@"extensions"] = @{
+        @"processes" : @(extensionCount),
+        @"hooks" : HIAHHookStatsDictionary(extensionEntries)
+      };
+    }
+    NSData *respData = [NSJSONSerialization dataWithJSONObject:resp
+                                                       options:0
+                                                         error:nil];
+    write(sock, respData.bytes, respData.length);
+    write(sock, "\n", 1);
   }
 }
 
@@ -369,6 +503,48 @@ NSErrorDomain const HIAHKernelErrorDomain = @"HIAHKernelErrorDomain";
   }
 }
 
+#pragma mark - JIT Enablement
+
+- (void)enableJITForExtensionProcessWithRetries:(pid_t)pid {
+  // HIAHJITManager lives in the host app, not the framework. Its queue
+  // coalesces repeat requests for a PID and owns the retry policy.
+  Class jitManagerClass = NSClassFromString(@"HIAHJITManager");
+  SEL sharedSel = NSSelectorFromString(@"sharedManager");
+  SEL enableSel = NSSelectorFromString(@"enableJITForPID:completion:");
+  if (![jitManagerClass respondsToSelector:sharedSel]) {
+    HIAHLogEx(HIAH_LOG_WARNING, @"Kernel",
+              @"HIAHJITManager not available - cannot enable JIT for PID %d",
+              pid);
+    return;
+  }
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Warc-performSelector-leaks"
+  id jitManager = [jitManagerClass performSelector:sharedSel];
+#pragma clang diagnostic pop
+  if (![jitManager respondsToSelector:enableSel]) {
+    return;
+  }
+
+  void (^completion)(BOOL, NSError *) = ^(BOOL success, NSError *error) {
+    if (success) {
+      HIAHLogEx(HIAH_LOG_INFO, @"Kernel",
+                @"JIT request for extension PID %d finished", pid);
+    } else {
+      HIAHLogEx(HIAH_LOG_WARNING, @"Kernel",
+                @"JIT request for extension PID %d failed: %@", pid, error);
+    }
+  };
+
+  NSMethodSignature *sig = [jitManager methodSignatureForSelector:enableSel];
+  NSInvocation *inv = [NSInvocation invocationWithMethodSignature:sig];
+  [inv setTarget:jitManager];
+  [inv setSelector:enableSel];
+  [inv setArgument:&pid atIndex:2];
+  [inv setArgument:&completion atIndex:3];
+  [inv invoke];
+}
+
 #pragma mark - Process Spawning
 
 - (void)spawnVirtualProcessWithPath:(NSString *)path
@@ -391,101 +567,56 @@ NSErrorDomain const HIAHKernelErrorDomain = @"HIAHKernelErrorDomain";
     return;
   }
 
-  NSFileManager *fm = [NSFileManager defaultManager];
-  NSString *actualExecutablePath = path;
-
-  // Handle .app bundle paths
-  // If the path points to a .app bundle, we need to find the executable inside
-  // it
-  BOOL isDirectory = NO;
-  if ([fm fileExistsAtPath:path isDirectory:&isDirectory] && isDirectory &&
-      [path hasSuffix:@".app"]) {
-    NSLog(@"[HIAHKernel] Received .app bundle path, locating executable...");
-
-    NSString *infoPlistPath =
-        [path stringByAppendingPathComponent:@"Info.plist"];
-    NSDictionary *infoPlist =
-        [NSDictionary dictionaryWithContentsOfFile:infoPlistPath];
-    NSString *executableName = infoPlist[@"CFBundleExecutable"];
-
-    if (executableName) {
-      // Try direct path: App.app/ExecutableName
-      NSString *candidatePath =
-          [path stringByAppendingPathComponent:executableName];
-      if ([fm fileExistsAtPath:candidatePath]) {
-        actualExecutablePath = candidatePath;
-        NSLog(@"[HIAHKernel] Found executable at: %@", actualExecutablePath);
-      } else {
-        // Try Contents/MacOS path (rare on iOS but possible)
-        candidatePath = [[path stringByAppendingPathComponent:@"Contents/MacOS"]
-            stringByAppendingPathComponent:executableName];
-        if ([fm fileExistsAtPath:candidatePath]) {
-          actualExecutablePath = candidatePath;
-          NSLog(@"[HIAHKernel] Found executable at: %@", actualExecutablePath);
-        } else {
-          NSLog(@"[HIAHKernel] ERROR: Could not find executable '%@' in bundle",
-                executableName);
-          if (completion) {
-            NSError *error = [NSError
-                errorWithDomain:HIAHKernelErrorDomain
-                           code:HIAHKernelErrorInvalidPath
-                       userInfo:@{
-                         NSLocalizedDescriptionKey : [NSString
-                             stringWithFormat:
-                                 @"Executable '%@' not found in bundle",
-                                 executableName]
-                       }];
-            completion(-1, error);
-          }
-          return;
-        }
-      }
-    } else {
-      NSLog(@"[HIAHKernel] ERROR: No CFBundleExecutable in Info.plist");
-      if (completion) {
-        NSError *error =
-            [NSError errorWithDomain:HIAHKernelErrorDomain
-                                code:HIAHKernelErrorInvalidPath
-                            userInfo:@{
-                              NSLocalizedDescriptionKey :
-                                  @"No CFBundleExecutable in Info.plist"
-                            }];
-        completion(-1, error);
-      }
-      return;
-    }
+  void (^readiness)(NSString *, dispatch_block_t) = self.spawnReadinessHandler;
+  if (readiness) {
+    readiness(path, ^{
+      [self spawnReadyVirtualProcessWithPath:path
+                                   arguments:arguments
+                                 environment:environment
+                                  completion:completion];
+    });
+    return;
   }
+  [self spawnReadyVirtualProcessWithPath:path
+                               arguments:arguments
+                             environment:environment
+                              completion:completion];
+}
 
-  // Update path to actual executable
-  path = actualExecutablePath;
-  NSLog(@"[HIAHKernel] Final executable path: %@", path);
-
-  // Verify the executable exists
-  if (![fm fileExistsAtPath:path]) {
-    NSLog(@"[HIAHKernel] ERROR: Executable not found at: %@", path);
+// The spawn itself, once the host says its files are in place
+- (void)spawnReadyVirtualProcessWithPath:(NSString *)path
+                               arguments:(NSArray<NSString *> *)arguments
+                             environment:
+                                 (NSDictionary<NSString *, NSString *> *)environment
+                              completion:(void (^)(pid_t pid, NSError *error))
+                                             completion {
+  // Resolve .app bundle paths to the executable inside them. Bundle
+  // metadata is cached per Info.plist version and shared with the extension,
+  // which also fixes up the executable's permissions when needed.
+  NSError *resolveError = nil;
+  HIAHLaunchMetadata *metadata =
+      [HIAHLaunchMetadata metadataForPath:path
+                       appGroupIdentifier:self.appGroupIdentifier
+                                    error:&resolveError];
+  if (!metadata) {
+    NSLog(@"[HIAHKernel] ERROR: %@", resolveError.localizedDescription);
     if (completion) {
       NSError *error = [NSError
           errorWithDomain:HIAHKernelErrorDomain
                      code:HIAHKernelErrorInvalidPath
                  userInfo:@{
-                   NSLocalizedDescriptionKey : [NSString
-                       stringWithFormat:@"Executable not found: %@", path]
+                   NSLocalizedDescriptionKey :
+                       resolveError.localizedDescription ?: @"Invalid path"
                  }];
       completion(-1, error);
     }
     return;
   }
 
-  // CRITICAL: Ensure executable has correct permissions
-  NSDictionary *attrs = @{NSFilePosixPermissions : @0755};
-  NSError *permError = nil;
-  [fm setAttributes:attrs ofItemAtPath:path error:&permError];
-  if (permError) {
-    NSLog(@"[HIAHKernel] Warning: Could not set executable permissions: %@",
-          permError);
-  } else {
-    NSLog(@"[HIAHKernel] Set executable permissions for: %@", path);
-  }
+  // Update path to actual executable
+  path = metadata.executablePath;
+  NSLog(@"[HIAHKernel] Final executable path: %@ (%@)", path,
+        metadata.cached ? @"cached" : @"resolved");
 
   NSError *error = nil;
 
@@ -682,41 +813,47 @@ NSErrorDomain const HIAHKernelErrorDomain = @"HIAHKernelErrorDomain";
   }
   
   if (main_func) {
-    HIAHLogInfo(HIAHLogKernel, "Found entry point, executing in background thread...");
+    HIAHLogInfo(HIAHLogKernel, "Found entry point, executing on guest thread...");
     
-    // Execute main() in a background thread
-    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
-      // Prepare argc/argv
-      int argc = (int)(arguments.count + 1);
-      char **argv = malloc(sizeof(char *) * (argc + 1));
-      argv[0] = strdup([path UTF8String]);
-      for (int i = 0; i < arguments.count; i++) {
-        argv[i + 1] = strdup([arguments[i] UTF8String]);
-      }
-      argv[argc] = NULL;
-      
-      // Prepare envp
-      NSMutableDictionary *fullEnv = environment ? [environment mutableCopy] : [NSMutableDictionary dictionary];
-      fullEnv[@"HIAH_STDOUT_SOCKET"] = socketPath;
-      if (self.controlSocketPath) {
-        fullEnv[@"HIAH_KERNEL_SOCKET"] = self.controlSocketPath;
-      }
-      
-      int envCount = (int)fullEnv.count;
-      char **envp = malloc(sizeof(char *) * (envCount + 1));
-      int envIdx = 0;
-      for (NSString *key in fullEnv) {
-        NSString *value = fullEnv[key];
-        NSString *envStr = [NSString stringWithFormat:@"%@=%@", key, value];
-        envp[envIdx++] = strdup([envStr UTF8String]);
-      }
-      envp[envCount] = NULL;
+    // Prepare argc/argv
+    int argc = (int)(arguments.count + 1);
+    char **argv = malloc(sizeof(char *) * (argc + 1));
+    argv[0] = strdup([path UTF8String]);
+    for (int i = 0; i < arguments.count; i++) {
+      argv[i + 1] = strdup([arguments[i] UTF8String]);
+    }
+    argv[argc] = NULL;
+    
+    // Prepare envp
+    NSMutableDictionary *fullEnv = environment ? [environment mutableCopy] : [NSMutableDictionary dictionary];
+    fullEnv[@"HIAH_STDOUT_SOCKET"] = socketPath;
+    if (self.controlSocketPath) {
+      fullEnv[@"HIAH_KERNEL_SOCKET"] = self.controlSocketPath;
+    }
+    
+    int envCount = (int)fullEnv.count;
+    char **envp = malloc(sizeof(char *) * (envCount + 1));
+    int envIdx = 0;
+    for (NSString *key in fullEnv) {
+      NSString *value = fullEnv[key];
+      NSString *envStr = [NSString stringWithFormat:@"%@=%@", key, value];
+      envp[envIdx++] = strdup([envStr UTF8String]);
+    }
+    envp[envCount] = NULL;
+    
+    void (^guestBody)(void) = ^{
+      // Marks the thread as the guest's, for hooks scoped to guest threads
+      HIAHChildTableAttachThread(vproc.pid);
       
       // Call main()
       HIAHLogInfo(HIAHLogKernel, "Calling main() with %d arguments", argc);
       int exitCode = main_func(argc, argv, envp);
       HIAHLogInfo(HIAHLogKernel, "main() returned with exit code: %d", exitCode);
       
+      // Kernel guests are roots of the child table: nothing waits for them,
+      // but the children they spawned must be orphaned
+      HIAHChildTableExit(vproc.pid, exitCode);
+      
       // Clean up
       for (int i = 0; i < argc; i++) {
         free(argv[i]);
@@ -729,7 +866,41 @@ NSErrorDomain const HIAHKernelErrorDomain = @"HIAHKernelErrorDomain";
       
       // Mark process as exited
       [self handleExitForPID:vproc.pid exitCode:exitCode];
-    });
+    };
+    
+    // Run main() on a dedicated thread rather than a GCD worker: guests may
+    // run for the whole session and need a main-thread-sized stack
+    HIAHGuestThreadAttributes attrs;
+    HIAHGuestThreadAttributesInit(&attrs, vproc.pid, argv[0]);
+    HIAHGuestThreadAttributesApplyEnvironment(&attrs, envp);
+    
+    void *context = (__bridge_retained void *)[guestBody copy];
+    int rc = HIAHGuestThreadLaunch(&attrs, HIAHKernelGuestThreadMain, context);
+    if (rc != 0) {
+      HIAHLogError(HIAHLogKernel, "Failed to create guest thread: %s", strerror(rc));
+      // Never run the guest inline: it could block the caller (often the
+      // main thread) for as long as the guest runs
+      (void)(__bridge_transfer id)context;
+      for (int i = 0; i < argc; i++) {
+        free(argv[i]);
+      }
+      free(argv);
+      for (int i = 0; i < envCount; i++) {
+        free(envp[i]);
+      }
+      free(envp);
+      [self handleExitForPID:vproc.pid exitCode:127];
+      
+      if (completion) {
+        NSError *err = [NSError errorWithDomain:HIAHKernelErrorDomain
+                                           code:HIAHKernelErrorSpawnFailed
+                                       userInfo:@{NSLocalizedDescriptionKey:
+                                         [NSString stringWithFormat:@"Failed to create guest thread: %s",
+                                          strerror(rc)]}];
+        completion(-1, err);
+      }
+      return;
+    }
     
     // Return success immediately (execution is async)
     if (completion) {
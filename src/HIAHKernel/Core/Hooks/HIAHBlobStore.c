@@ -0,0 +1,391 @@
+/**
+ * HIAHBlobStore.c
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Content-addressed app storage implementation.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#include "HIAHBlobStore.h"
+#include "HIAHSHA256.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __APPLE__
+#include <sys/clonefile.h>
+#else
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
+
+#define HIAH_BLOB_DIGEST_SIZE HIAH_SHA256_DIGEST_SIZE
+#define HIAH_BLOB_READ_BUFFER (256 * 1024)
+
+typedef struct {
+    char store[PATH_MAX];
+    char bundle[PATH_MAX];
+    FILE *manifest;
+    uint8_t *buffer;
+    uint32_t temporaryCounter;
+    int firstError;
+    HIAHBlobAddStats stats;
+} HIAHBlobAddContext;
+
+// Adding and collecting must not interleave: a blob added but not yet in a
+// manifest would look unreferenced
+static pthread_mutex_t g_storeLock = PTHREAD_MUTEX_INITIALIZER;
+
+#pragma mark - Helpers
+
+static uint64_t HIAHBlobNowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void HIAHBlobHex(const uint8_t *digest, char *hex) {
+    static const char digits[] = "0123456789abcdef";
+    for (size_t i = 0; i < HIAH_BLOB_DIGEST_SIZE; i++) {
+        hex[i * 2] = digits[digest[i] >> 4];
+        hex[i * 2 + 1] = digits[digest[i] & 0xf];
+    }
+    hex[HIAH_BLOB_DIGEST_SIZE * 2] = '\0';
+}
+
+static int HIAHBlobNibble(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// `hex` holds exactly 2 * HIAH_BLOB_DIGEST_SIZE digits
+static bool HIAHBlobParseHex(const char *hex, uint8_t *digest) {
+    for (size_t i = 0; i < HIAH_BLOB_DIGEST_SIZE; i++) {
+        int high = HIAHBlobNibble(hex[i * 2]);
+        int low = HIAHBlobNibble(hex[i * 2 + 1]);
+        if (high < 0 || low < 0) return false;
+        digest[i] = (uint8_t)(high << 4 | low);
+    }
+    return true;
+}
+
+// "<store>/ab/cdef…": 256 fan-out directories keep each one small
+static void HIAHBlobPath(const char *store, const char *hex, char *path, size_t size) {
+    snprintf(path, size, "%s/%.2s/%s", store, hex, hex + 2);
+}
+
+// Clones `source` as the new file `destination`. Never a copy: that would
+// cost exactly the space the store is meant to save
+static int HIAHBlobClone(const char *source, const char *destination) {
+#ifdef __APPLE__
+    return clonefile(source, destination, CLONE_NOFOLLOW) == 0 ? 0 : errno;
+#else
+    int in = open(source, O_RDONLY | O_CLOEXEC);
+    if (in < 0) return errno;
+    int out = open(destination, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (out < 0) {
+        int error = errno;
+        close(in);
+        return error;
+    }
+    int cloned = ioctl(out, FICLONE, in);
+    close(in);
+    close(out);
+    if (cloned == 0) return 0;
+    unlink(destination);
+
+    // Filesystems without reflinks (test builds only): the blob and the
+    // bundle's file become one inode
+    return link(source, destination) == 0 ? 0 : errno;
+#endif
+}
+
+static int HIAHBlobHash(HIAHBlobAddContext *context, const char *path, uint8_t *digest) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return errno;
+
+    HIAHSHA256Context sha;
+    HIAHSHA256Init(&sha);
+    int error = 0;
+    for (;;) {
+        ssize_t got = read(fd, context->buffer, HIAH_BLOB_READ_BUFFER);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) {
+            error = got < 0 ? errno : 0;
+            break;
+        }
+        HIAHSHA256Update(&sha, context->buffer, (size_t)got);
+        context->stats.hashedBytes += (uint64_t)got;
+    }
+    close(fd);
+    HIAHSHA256Final(&sha, digest);
+    return error;
+}
+
+#pragma mark - Add
+
+static int HIAHBlobAddFile(HIAHBlobAddContext *context, const char *relative, const struct stat *st) {
+    char path[PATH_MAX], blob[PATH_MAX], temporary[PATH_MAX], hex[HIAH_BLOB_DIGEST_SIZE * 2 + 1];
+    if (snprintf(path, sizeof(path), "%s/%s", context->bundle, relative) >= (int)sizeof(path) ||
+        snprintf(temporary, sizeof(temporary), "%s.hiah-blob", path) >= (int)sizeof(temporary)) {
+        return ENAMETOOLONG;
+    }
+
+    uint8_t digest[HIAH_BLOB_DIGEST_SIZE];
+    int error = HIAHBlobHash(context, path, digest);
+    if (error) return error;
+    context->stats.files++;
+    HIAHBlobHex(digest, hex);
+    HIAHBlobPath(context->store, hex, blob, sizeof(blob));
+
+    struct stat existing;
+    if (lstat(blob, &existing) == 0 && S_ISREG(existing.st_mode) && existing.st_size == st->st_size) {
+        // Already this blob (added before, or a hardlinked test build)
+        if (existing.st_ino == st->st_ino && existing.st_dev == st->st_dev) {
+            return fprintf(context->manifest, "%s %llu %s\n", hex, (unsigned long long)st->st_size,
+                           relative) < 0 ? EIO : 0;
+        }
+
+        // Replaced by a clone of the blob; the rename keeps the swap atomic
+        unlink(temporary);
+        error = HIAHBlobClone(blob, temporary);
+        if (!error && chmod(temporary, st->st_mode & 07777) != 0) error = errno;
+        if (!error && rename(temporary, path) != 0) error = errno;
+        if (error) {
+            unlink(temporary);
+            return error;
+        }
+        context->stats.shared++;
+        context->stats.sharedBytes += (uint64_t)st->st_size;
+    } else {
+        // New content: the bundle's file becomes the blob. Cloned into a
+        // temporary first, so a blob is complete when it has its name
+        char directory[PATH_MAX];
+        snprintf(directory, sizeof(directory), "%s/%.2s", context->store, hex);
+        if (mkdir(directory, 0755) != 0 && errno != EEXIST) return errno;
+        snprintf(temporary, sizeof(temporary), "%s/.tmp-%d-%u", context->store, (int)getpid(),
+                 context->temporaryCounter++);
+        error = HIAHBlobClone(path, temporary);
+        if (!error && rename(temporary, blob) != 0) error = errno;
+        if (error) {
+            unlink(temporary);
+            return error;
+        }
+        context->stats.stored++;
+    }
+
+    return fprintf(context->manifest, "%s %llu %s\n", hex, (unsigned long long)st->st_size, relative) < 0
+               ? EIO
+               : 0;
+}
+
+// `relative` (PATH_MAX bytes, `length` used) is extended in place while descending
+static int HIAHBlobAddDirectory(HIAHBlobAddContext *context, char *relative, size_t length) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s%s%s", context->bundle, length ? "/" : "", relative);
+    DIR *directory = opendir(path);
+    if (!directory) return errno;
+
+    int error = 0;
+    struct dirent *item;
+    while (!error && (item = readdir(directory))) {
+        const char *name = item->d_name;
+        if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) continue;
+        // Our own bookkeeping: manifests, staging data, lazy install archives
+        if (strncmp(name, ".hiah-", 6) == 0) continue;
+
+        size_t nameLength = strlen(name);
+        if (length + 1 + nameLength >= PATH_MAX) {
+            error = ENAMETOOLONG;
+            break;
+        }
+        size_t childLength = length;
+        if (childLength) relative[childLength++] = '/';
+        memcpy(relative + childLength, name, nameLength + 1);
+        childLength += nameLength;
+
+        char child[PATH_MAX];
+        struct stat st;
+        snprintf(child, sizeof(child), "%s/%s", context->bundle, relative);
+        if (lstat(child, &st) != 0) {
+            error = errno;
+        } else if (S_ISDIR(st.st_mode)) {
+            error = HIAHBlobAddDirectory(context, relative, childLength);
+        } else if (S_ISREG(st.st_mode) && st.st_size >= HIAH_BLOB_MIN_SIZE) {
+            // A file that can't be shared stays as it is; the rest go on
+            int fileError = HIAHBlobAddFile(context, relative, &st);
+            if (fileError && !context->firstError) context->firstError = fileError;
+        }
+        relative[length] = '\0';
+    }
+    closedir(directory);
+    return error;
+}
+
+int HIAHBlobStoreAdd(const char *storePath, const char *bundlePath, HIAHBlobAddStats *stats) {
+    uint64_t start = HIAHBlobNowNs();
+    if (strlen(storePath) >= PATH_MAX || strlen(bundlePath) + sizeof("/" HIAH_BLOB_MANIFEST ".new") > PATH_MAX) {
+        return ENAMETOOLONG;
+    }
+
+    HIAHBlobAddContext *context = calloc(1, sizeof(*context));
+    char *relative = calloc(1, PATH_MAX);
+    if (context) context->buffer = malloc(HIAH_BLOB_READ_BUFFER);
+    if (!context || !relative || !context->buffer) {
+        if (context) free(context->buffer);
+        free(context);
+        free(relative);
+        return ENOMEM;
+    }
+    strcpy(context->store, storePath);
+    strcpy(context->bundle, bundlePath);
+
+    char manifest[PATH_MAX], temporary[PATH_MAX];
+    snprintf(manifest, sizeof(manifest), "%s/" HIAH_BLOB_MANIFEST, bundlePath);
+    snprintf(temporary, sizeof(temporary), "%s/" HIAH_BLOB_MANIFEST ".new", bundlePath);
+
+    pthread_mutex_lock(&g_storeLock);
+    int error = 0;
+    if (mkdir(storePath, 0755) != 0 && errno != EEXIST) error = errno;
+    if (!error && !(context->manifest = fopen(temporary, "w"))) error = errno;
+    if (!error) error = HIAHBlobAddDirectory(context, relative, 0);
+    if (context->manifest && fclose(context->manifest) != 0 && !error) error = errno;
+    if (!error && rename(temporary, manifest) != 0) error = errno;
+    if (error) unlink(temporary);
+    pthread_mutex_unlock(&g_storeLock);
+
+    if (!error) error = context->firstError;
+    context->stats.wallNs = HIAHBlobNowNs() - start;
+    if (stats) *stats = context->stats;
+
+    free(context->buffer);
+    free(context);
+    free(relative);
+    return error;
+}
+
+#pragma mark - Collect
+
+typedef struct {
+    uint8_t (*digests)[HIAH_BLOB_DIGEST_SIZE];
+    size_t count;
+    size_t capacity;
+} HIAHBlobSet;
+
+static int HIAHBlobCompare(const void *a, const void *b) {
+    return memcmp(a, b, HIAH_BLOB_DIGEST_SIZE);
+}
+
+static int HIAHBlobReadManifest(HIAHBlobSet *set, const char *path, HIAHBlobStoreReport *report) {
+    FILE *file = fopen(path, "r");
+    if (!file) return errno == ENOENT ? 0 : errno;
+    report->apps++;
+
+    char line[PATH_MAX + 128];
+    int error = 0;
+    while (!error && fgets(line, sizeof(line), file)) {
+        uint8_t digest[HIAH_BLOB_DIGEST_SIZE];
+        unsigned long long size;
+        if (strlen(line) < HIAH_BLOB_DIGEST_SIZE * 2 + 2 || line[HIAH_BLOB_DIGEST_SIZE * 2] != ' ' ||
+            !HIAHBlobParseHex(line, digest) ||
+            sscanf(line + HIAH_BLOB_DIGEST_SIZE * 2 + 1, "%llu", &size) != 1) {
+            continue;
+        }
+        if (set->count == set->capacity) {
+            size_t capacity = set->capacity ? set->capacity * 2 : 1024;
+            void *digests = realloc(set->digests, capacity * HIAH_BLOB_DIGEST_SIZE);
+            if (!digests) {
+                error = ENOMEM;
+                break;
+            }
+            set->digests = digests;
+            set->capacity = capacity;
+        }
+        memcpy(set->digests[set->count++], digest, HIAH_BLOB_DIGEST_SIZE);
+        report->referencedBytes += size;
+    }
+    fclose(file);
+    return error;
+}
+
+int HIAHBlobStoreCollect(const char *storePath, const char *applicationsPath,
+                         HIAHBlobStoreReport *report) {
+    HIAHBlobStoreReport local = {0};
+    HIAHBlobSet set = {0};
+    char path[PATH_MAX];
+    int error = 0;
+
+    pthread_mutex_lock(&g_storeLock);
+
+    DIR *apps = opendir(applicationsPath);
+    if (!apps) error = errno;
+    struct dirent *item;
+    while (!error && apps && (item = readdir(apps))) {
+        // Installs in progress (".install-…") have no manifest yet
+        if (item->d_name[0] == '.') continue;
+        if (snprintf(path, sizeof(path), "%s/%s/" HIAH_BLOB_MANIFEST, applicationsPath, item->d_name) <
+            (int)sizeof(path)) {
+            error = HIAHBlobReadManifest(&set, path, &local);
+        }
+    }
+    if (apps) closedir(apps);
+    if (set.count) qsort(set.digests, set.count, HIAH_BLOB_DIGEST_SIZE, HIAHBlobCompare);
+
+    DIR *store = error ? NULL : opendir(storePath);
+    while (store && !error && (item = readdir(store))) {
+        const char *fanout = item->d_name;
+        if (fanout[0] == '.') {
+            // Temporaries of an add that didn't finish
+            if (strncmp(fanout, ".tmp-", 5) == 0) {
+                snprintf(path, sizeof(path), "%s/%s", storePath, fanout);
+                unlink(path);
+            }
+            continue;
+        }
+        if (strlen(fanout) != 2) continue;
+
+        char directoryPath[PATH_MAX];
+        snprintf(directoryPath, sizeof(directoryPath), "%s/%s", storePath, fanout);
+        DIR *directory = opendir(directoryPath);
+        if (!directory) continue;
+        struct dirent *blob;
+        while ((blob = readdir(directory))) {
+            char hex[HIAH_BLOB_DIGEST_SIZE * 2 + 1];
+            uint8_t digest[HIAH_BLOB_DIGEST_SIZE];
+            if (strlen(blob->d_name) != HIAH_BLOB_DIGEST_SIZE * 2 - 2) continue;
+            memcpy(hex, fanout, 2);
+            memcpy(hex + 2, blob->d_name, HIAH_BLOB_DIGEST_SIZE * 2 - 2 + 1);
+            if (!HIAHBlobParseHex(hex, digest)) continue;
+
+            struct stat st;
+            snprintf(path, sizeof(path), "%s/%s", directoryPath, blob->d_name);
+            if (lstat(path, &st) != 0) continue;
+            if (set.count && bsearch(digest, set.digests, set.count, HIAH_BLOB_DIGEST_SIZE, HIAHBlobCompare)) {
+                local.blobs++;
+                local.blobBytes += (uint64_t)st.st_size;
+            } else if (unlink(path) == 0) {
+                local.removed++;
+                local.removedBytes += (uint64_t)st.st_size;
+            }
+        }
+        closedir(directory);
+    }
+    if (store) closedir(store);
+
+    pthread_mutex_unlock(&g_storeLock);
+
+    free(set.digests);
+    if (report) *report = local;
+    return error;
+}
@@ -0,0 +1,84 @@
+/**
+ * HIAHBlobStore.h
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Content-addressed storage shared by installed apps.
+ *
+ * Apps often embed identical files: the same Swift runtime libraries,
+ * SDK frameworks, fonts. After an install, each file of the bundle is
+ * hashed (SHA-256) and either becomes a blob in the store or, if a blob
+ * with that content exists, is replaced by a clone of it. Clones share
+ * storage until one side changes, so every copy after the first is free.
+ * The bundle stays an ordinary directory of ordinary files; a manifest in
+ * it lists the blobs it uses.
+ *
+ * Binaries are prepared at extraction (see HIAHMachOPrepare), so identical
+ * frameworks are identical once prepared too and share one prepared copy.
+ *
+ * Blobs are never modified. Blobs no installed app's manifest refers to
+ * are deleted by HIAHBlobStoreCollect, which also reports the space saved.
+ * Without clone support (other filesystems) nothing is deduplicated; Linux
+ * test builds use reflinks or hardlinks.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#ifndef HIAH_BLOB_STORE_H
+#define HIAH_BLOB_STORE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Manifest inside a bundle: one "<sha256> <size> <path>" line per file
+#define HIAH_BLOB_MANIFEST ".hiah-blobs"
+
+/// Smaller files are left alone: they save at most a block each
+#define HIAH_BLOB_MIN_SIZE (16 * 1024)
+
+typedef struct {
+    uint64_t files;               // Files hashed
+    uint64_t hashedBytes;
+    uint64_t shared;              // Replaced by a clone of an existing blob
+    uint64_t sharedBytes;         // Space saved by this bundle
+    uint64_t stored;              // Added to the store
+    uint64_t wallNs;
+} HIAHBlobAddStats;
+
+typedef struct {
+    uint64_t apps;                // Bundles with a manifest
+    uint64_t blobs;
+    uint64_t blobBytes;           // Stored once
+    uint64_t referencedBytes;     // As many times as apps use them
+    uint64_t removed;             // Unreferenced blobs deleted
+    uint64_t removedBytes;
+} HIAHBlobStoreReport;
+
+/**
+ * Moves the contents of the bundle at `bundlePath` into the store at
+ * `storePath` (created if needed) as described above and writes the
+ * bundle's manifest. Both must be on the same volume. Call it once the
+ * bundle is complete: files changed afterwards still work, but no longer
+ * match their blobs. `stats` may be NULL.
+ *
+ * @return 0 or an errno value; a failed file is left as it was.
+ */
+int HIAHBlobStoreAdd(const char *storePath, const char *bundlePath, HIAHBlobAddStats *stats);
+
+/**
+ * Deletes the blobs not listed in the manifest of any bundle directly in
+ * `applicationsPath`. `report` may be NULL.
+ *
+ * @return 0 or an errno value.
+ */
+int HIAHBlobStoreCollect(const char *storePath, const char *applicationsPath,
+                         HIAHBlobStoreReport *report);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HIAH_BLOB_STORE_H */
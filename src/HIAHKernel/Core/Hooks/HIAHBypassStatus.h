@@ -3,7 +3,9 @@
  * HIAH ProcessRunner Extension - Bypass Status Reader
  *
  * Lightweight status reader for ProcessRunner extension.
- * Reads bypass status from App Group shared storage.
+ * Reads bypass status from the shared-memory status page in the App Group
+ * (HIAHBypassStatusPage), falling back to the plist mirror until the main
+ * app has created the page.
  * This allows the extension to check VPN/JIT status without
  * importing LoginWindow classes.
  *
@@ -29,7 +31,8 @@ NS_ASSUME_NONNULL_BEGIN
 /// Whether bypass system is fully ready
 @property (nonatomic, readonly) BOOL isBypassReady;
 
-/// Refresh status from shared storage
+/// Refresh status from shared storage (lock-free page read plus csops).
+/// The properties above are all NO until this has been called once.
 - (void)refreshStatus;
 
 @end
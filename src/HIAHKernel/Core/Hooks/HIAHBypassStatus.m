@@ -9,6 +9,7 @@
  */
 
 #import "HIAHBypassStatus.h"
+#import "HIAHBypassStatusPage.h"
 #import "HIAHLogging.h"
 #import <sys/sysctl.h>
 
@@ -26,6 +27,8 @@ static NSString *const kLastUpdateKey = @"LastUpdate";
 @property(nonatomic, assign) BOOL isJITEnabled;
 @property(nonatomic, assign) BOOL isBypassReady;
 @property(nonatomic, strong) NSURL *statusFileURL;
+@property(nonatomic, strong) NSURL *statusPageURL;
+@property(nonatomic, assign) HIAHBypassStatusPage *statusPage;
 
 @end
 
@@ -49,23 +52,17 @@ static NSString *const kLastUpdateKey = @"LastUpdate";
         containerURLForSecurityApplicationGroupIdentifier:kAppGroupIdentifier];
     if (groupURL) {
       _statusFileURL = [groupURL URLByAppendingPathComponent:kBypassStatusFile];
+      _statusPageURL = [groupURL
+          URLByAppendingPathComponent:@HIAH_BYPASS_STATUS_PAGE_FILE];
     }
 
-    // Load initial status
-    [self refreshStatus];
+    // Nothing is read until the first refreshStatus, so guests that never
+    // look at the bypass state don't pay for the page mapping and csops
   }
   return self;
 }
 
-- (void)refreshStatus {
-  if (!self.statusFileURL) {
-    // No app group - assume not ready
-    _isVPNActive = NO;
-    _isJITEnabled = NO;
-    _isBypassReady = NO;
-    return;
-  }
-
+- (void)loadStatusFromMirror {
   NSDictionary *status =
       [NSDictionary dictionaryWithContentsOfURL:self.statusFileURL];
   if (status) {
@@ -88,6 +85,40 @@ static NSString *const kLastUpdateKey = @"LastUpdate";
     _isJITEnabled = NO;
     _isBypassReady = NO;
   }
+}
+
+- (void)refreshStatus {
+  if (!self.statusFileURL) {
+    // No app group - assume not ready
+    _isVPNActive = NO;
+    _isJITEnabled = NO;
+    _isBypassReady = NO;
+    return;
+  }
+
+  // The page is created by the main app; until it exists, fall back to the
+  // plist mirror and try to map it again next time
+  if (!self.statusPage && self.statusPageURL) {
+    self.statusPage = HIAHBypassStatusPageMap(
+        self.statusPageURL.fileSystemRepresentation, false);
+  }
+
+  HIAHBypassStatusSnapshot snapshot;
+  if (self.statusPage && HIAHBypassStatusPageRead(self.statusPage, &snapshot)) {
+    _isVPNActive = snapshot.vpnActive;
+    _isJITEnabled = snapshot.jitEnabled;
+    _isBypassReady = snapshot.bypassReady;
+
+    if (HIAHBypassStatusSnapshotAge(&snapshot) > 30.0) {
+      HIAHLogEx(HIAH_LOG_WARNING, @"BypassStatus",
+                @"Status is stale (>30s), resetting");
+      _isVPNActive = NO;
+      _isJITEnabled = NO;
+      _isBypassReady = NO;
+    }
+  } else {
+    [self loadStatusFromMirror];
+  }
 
   // Always verify JIT status directly (more reliable)
   extern int csops(pid_t pid, unsigned int ops, void *useraddr,
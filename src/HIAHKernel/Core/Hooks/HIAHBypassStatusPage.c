@@ -0,0 +1,159 @@
+/**
+ * HIAHBypassStatusPage.c
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Shared-memory bypass status implementation.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#include "HIAHBypassStatusPage.h"
+#include <fcntl.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define HIAH_BYPASS_PAGE_MAGIC 0x48424250u   // 'HBBP'
+#define HIAH_BYPASS_PAGE_VERSION 1u
+#define HIAH_BYPASS_PAGE_SIZE 4096
+
+#define HIAH_BYPASS_FLAG_VPN    (1u << 0)
+#define HIAH_BYPASS_FLAG_JIT    (1u << 1)
+#define HIAH_BYPASS_FLAG_READY  (1u << 2)
+
+// A writer that died mid-update leaves `seq` odd for good, so reads give up
+// after this many attempts (yielding after the first few) and callers fall
+// back to the plist mirror
+#define HIAH_BYPASS_READ_ATTEMPTS 48
+#define HIAH_BYPASS_READ_SPINS 16
+
+// On-disk layout. Every field is a lock-free atomic so the mapping is
+// well-defined across processes; the payload is only meaningful between
+// two equal, even reads of `seq`.
+struct HIAHBypassStatusPage {
+    _Atomic(uint32_t) magic;
+    _Atomic(uint32_t) version;
+    _Atomic(uint32_t) seq;                  // Odd while a write is in progress
+    _Atomic(uint32_t) flags;
+    _Atomic(uint64_t) lastUpdateNs;
+    _Atomic(int32_t) writerPID;
+    _Atomic(uint32_t) generation;
+};
+
+_Static_assert(sizeof(struct HIAHBypassStatusPage) <= HIAH_BYPASS_PAGE_SIZE,
+               "status page must fit in one page");
+
+#pragma mark - Mapping
+
+HIAHBypassStatusPage *HIAHBypassStatusPageMap(const char *path, bool writable) {
+    int fd = open(path, writable ? (O_RDWR | O_CREAT | O_CLOEXEC) : (O_RDONLY | O_CLOEXEC), 0644);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return NULL;
+    }
+    if (st.st_size < HIAH_BYPASS_PAGE_SIZE) {
+        // A fresh file reads as zeroes, i.e. "never written"
+        if (!writable || ftruncate(fd, HIAH_BYPASS_PAGE_SIZE) != 0) {
+            close(fd);
+            return NULL;
+        }
+    }
+
+    void *map = mmap(NULL, HIAH_BYPASS_PAGE_SIZE, writable ? (PROT_READ | PROT_WRITE) : PROT_READ,
+                     MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return NULL;
+
+    HIAHBypassStatusPage *page = map;
+    if (writable) {
+        // Recover from a writer that died mid-update or an older layout
+        uint32_t seq = atomic_load_explicit(&page->seq, memory_order_relaxed);
+        if ((seq & 1) ||
+            atomic_load_explicit(&page->version, memory_order_relaxed) != HIAH_BYPASS_PAGE_VERSION) {
+            atomic_store_explicit(&page->magic, 0, memory_order_relaxed);
+            atomic_store_explicit(&page->version, HIAH_BYPASS_PAGE_VERSION, memory_order_relaxed);
+            atomic_store_explicit(&page->seq, (seq + 1) & ~1u, memory_order_release);
+        }
+    }
+    return page;
+}
+
+#pragma mark - Writing
+
+static uint64_t HIAHRealtimeNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void HIAHBypassStatusPageWrite(HIAHBypassStatusPage *page, const HIAHBypassStatusSnapshot *status) {
+    if (!page || !status) return;
+
+    uint32_t flags = (status->vpnActive ? HIAH_BYPASS_FLAG_VPN : 0) |
+                     (status->jitEnabled ? HIAH_BYPASS_FLAG_JIT : 0) |
+                     (status->bypassReady ? HIAH_BYPASS_FLAG_READY : 0);
+    uint32_t seq = atomic_load_explicit(&page->seq, memory_order_relaxed);
+    // An odd value left by a writer that died mid-update
+    if (seq & 1) seq++;
+
+    atomic_store_explicit(&page->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    atomic_store_explicit(&page->flags, flags, memory_order_relaxed);
+    atomic_store_explicit(&page->lastUpdateNs, HIAHRealtimeNs(), memory_order_relaxed);
+    atomic_store_explicit(&page->writerPID, getpid(), memory_order_relaxed);
+    atomic_store_explicit(&page->generation,
+                          atomic_load_explicit(&page->generation, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+    atomic_store_explicit(&page->magic, HIAH_BYPASS_PAGE_MAGIC, memory_order_relaxed);
+
+    atomic_store_explicit(&page->seq, seq + 2, memory_order_release);
+}
+
+#pragma mark - Reading
+
+bool HIAHBypassStatusPageRead(const HIAHBypassStatusPage *page, HIAHBypassStatusSnapshot *out) {
+    if (!page || !out) return false;
+    HIAHBypassStatusPage *p = (HIAHBypassStatusPage *)page;
+
+    for (int attempt = 0; attempt < HIAH_BYPASS_READ_ATTEMPTS; attempt++) {
+        uint32_t begin = atomic_load_explicit(&p->seq, memory_order_acquire);
+        if (begin & 1) {
+            // The writer holds the page for a few stores at most
+            if (attempt >= HIAH_BYPASS_READ_SPINS) sched_yield();
+            continue;
+        }
+
+        uint32_t magic = atomic_load_explicit(&p->magic, memory_order_relaxed);
+        uint32_t flags = atomic_load_explicit(&p->flags, memory_order_relaxed);
+        uint64_t lastUpdateNs = atomic_load_explicit(&p->lastUpdateNs, memory_order_relaxed);
+        int32_t writerPID = atomic_load_explicit(&p->writerPID, memory_order_relaxed);
+        uint32_t generation = atomic_load_explicit(&p->generation, memory_order_relaxed);
+
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&p->seq, memory_order_relaxed) != begin) continue;
+
+        if (magic != HIAH_BYPASS_PAGE_MAGIC) return false;
+        out->vpnActive = (flags & HIAH_BYPASS_FLAG_VPN) != 0;
+        out->jitEnabled = (flags & HIAH_BYPASS_FLAG_JIT) != 0;
+        out->bypassReady = (flags & HIAH_BYPASS_FLAG_READY) != 0;
+        out->lastUpdateNs = lastUpdateNs;
+        out->writerPID = writerPID;
+        out->generation = generation;
+        return true;
+    }
+    return false;
+}
+
+double HIAHBypassStatusSnapshotAge(const HIAHBypassStatusSnapshot *status) {
+    uint64_t now = HIAHRealtimeNs();
+    if (!status || status->lastUpdateNs >= now) return 0;
+    return (double)(now - status->lastUpdateNs) / 1e9;
+}
@@ -0,0 +1,80 @@
+/**
+ * HIAHBypassStatusPage.h
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Shared-memory VPN/JIT bypass status.
+ *
+ * The main app (HIAHBypassCoordinator) is the only writer; it maps a small
+ * fixed-layout file in the App Group container and publishes each update
+ * under a sequence lock. Extensions map the same file read-only and take a
+ * consistent snapshot with a handful of loads and no system calls, retrying
+ * only if they race an update. HIAH_BypassStatus.plist is still written
+ * next to it as a human-readable mirror, but nothing reads it on the
+ * launch path anymore.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#ifndef HIAH_BYPASS_STATUS_PAGE_H
+#define HIAH_BYPASS_STATUS_PAGE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// File name inside the App Group container
+#define HIAH_BYPASS_STATUS_PAGE_FILE "HIAH_BypassStatus.page"
+
+typedef struct HIAHBypassStatusPage HIAHBypassStatusPage;
+
+typedef struct {
+    bool vpnActive;
+    bool jitEnabled;
+    bool bypassReady;
+    uint64_t lastUpdateNs;        // CLOCK_REALTIME of the last write
+    pid_t writerPID;
+    uint32_t generation;          // Number of writes since the page was created
+} HIAHBypassStatusSnapshot;
+
+/**
+ * Maps the status page at `path`.
+ *
+ * A writable mapping creates and sizes the file if needed. A read-only
+ * mapping fails (returns NULL) until the writer has created it, so readers
+ * should retry later. Mappings live for the rest of the process.
+ */
+HIAHBypassStatusPage *HIAHBypassStatusPageMap(const char *path, bool writable);
+
+/**
+ * Publishes `status`, stamping lastUpdateNs, writerPID and generation.
+ *
+ * Callers must serialize writes; readers are never blocked.
+ */
+void HIAHBypassStatusPageWrite(HIAHBypassStatusPage *page, const HIAHBypassStatusSnapshot *status);
+
+/**
+ * Copies a consistent snapshot into `out`. Lock-free; retries a bounded
+ * number of times (yielding after the first few) while a write is in
+ * progress.
+ *
+ * @return false if the page has never been written or no consistent
+ *         snapshot could be read (e.g. its writer died mid-update); callers
+ *         then fall back to the plist mirror.
+ */
+bool HIAHBypassStatusPageRead(const HIAHBypassStatusPage *page, HIAHBypassStatusSnapshot *out);
+
+/**
+ * Seconds since the snapshot was written (wall clock).
+ */
+double HIAHBypassStatusSnapshotAge(const HIAHBypassStatusSnapshot *status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HIAH_BYPASS_STATUS_PAGE_H */
@@ -0,0 +1,330 @@
+/**
+ * HIAHChildTable.c
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Virtual child process table implementation.
+ *
+ * All state lives behind one mutex; each parent owns a condition variable
+ * so a child's state change wakes only the threads waiting on that parent.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#include "HIAHChildTable.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <time.h>
+
+// wait(2) status encodings (W_EXITCODE/W_STOPCODE are hidden under strict
+// POSIX builds)
+#define HIAH_EXIT_STATUS(code) (((code) & 0xff) << 8)
+#define HIAH_STOP_STATUS(sig) ((((sig) & 0xff) << 8) | 0177)
+#ifdef __APPLE__
+#define HIAH_CONTINUED_STATUS HIAH_STOP_STATUS(0x13)
+#else
+#define HIAH_CONTINUED_STATUS 0xffff
+#endif
+
+typedef enum {
+    HIAHChildRunning,
+    HIAHChildStopped,
+    HIAHChildZombie
+} HIAHChildState;
+
+typedef struct HIAHParent HIAHParent;
+
+typedef struct HIAHChild {
+    pid_t vpid;
+    HIAHChildState state;
+    int status;
+    bool stopReported;
+    bool continuePending;       // Continued, not yet reported to WCONTINUED
+    HIAHParent *owner;          // NULL once orphaned
+    struct HIAHChild *next;     // Sibling in owner->children, or in g_orphans
+} HIAHChild;
+
+struct HIAHParent {
+    pid_t vpid;
+    bool exited;
+    int waiters;
+    pthread_cond_t cond;
+    HIAHChild *children;
+    HIAHParent *next;
+};
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static HIAHParent g_host = { .vpid = 0, .cond = PTHREAD_COND_INITIALIZER };
+static HIAHParent *g_parents = &g_host;
+static HIAHChild *g_orphans = NULL;
+static pid_t g_nextVPID = HIAH_GUEST_PID_BASE;
+static __thread pid_t t_currentVPID = 0;
+
+#pragma mark - Lookup (g_lock held)
+
+static HIAHParent *HIAHFindParent(pid_t vpid, bool create) {
+    for (HIAHParent *p = g_parents; p; p = p->next) {
+        if (p->vpid == vpid) return p;
+    }
+    if (!create) return NULL;
+
+    HIAHParent *p = calloc(1, sizeof(HIAHParent));
+    if (!p) return NULL;
+    p->vpid = vpid;
+    pthread_cond_init(&p->cond, NULL);
+    // Keep the host record at the head so it is found first
+    p->next = g_host.next;
+    g_host.next = p;
+    return p;
+}
+
+static HIAHChild **HIAHFindChildLink(pid_t vpid) {
+    for (HIAHParent *p = g_parents; p; p = p->next) {
+        for (HIAHChild **it = &p->children; *it; it = &(*it)->next) {
+            if ((*it)->vpid == vpid) return it;
+        }
+    }
+    for (HIAHChild **it = &g_orphans; *it; it = &(*it)->next) {
+        if ((*it)->vpid == vpid) return it;
+    }
+    return NULL;
+}
+
+static void HIAHReleaseParentIfIdle(HIAHParent *parent) {
+    if (parent == &g_host || !parent->exited || parent->waiters > 0 || parent->children) {
+        return;
+    }
+    for (HIAHParent **it = &g_parents; *it; it = &(*it)->next) {
+        if (*it == parent) {
+            *it = parent->next;
+            break;
+        }
+    }
+    pthread_cond_destroy(&parent->cond);
+    free(parent);
+}
+
+static bool HIAHChildReportable(const HIAHChild *child, int options) {
+    if (child->state == HIAHChildZombie) return true;
+    if (child->state == HIAHChildStopped) return !child->stopReported && (options & WUNTRACED);
+    return child->continuePending && (options & WCONTINUED);
+}
+
+static pid_t HIAHReap(HIAHChild **link, int *stat_loc) {
+    HIAHChild *child = *link;
+    pid_t vpid = child->vpid;
+
+    if (child->state == HIAHChildZombie) {
+        if (stat_loc) *stat_loc = child->status;
+        *link = child->next;
+        free(child);
+    } else if (child->state == HIAHChildStopped) {
+        if (stat_loc) *stat_loc = child->status;
+        child->stopReported = true;
+    } else {
+        if (stat_loc) *stat_loc = HIAH_CONTINUED_STATUS;
+        child->continuePending = false;
+    }
+    return vpid;
+}
+
+#pragma mark - Lifecycle
+
+pid_t HIAHChildTableSpawn(void) {
+    HIAHChild *child = calloc(1, sizeof(HIAHChild));
+    if (!child) return -1;
+
+    pthread_mutex_lock(&g_lock);
+    HIAHParent *parent = HIAHFindParent(t_currentVPID, true);
+    if (!parent) {
+        pthread_mutex_unlock(&g_lock);
+        free(child);
+        return -1;
+    }
+
+    child->vpid = g_nextVPID;
+    g_nextVPID = (g_nextVPID == INT32_MAX) ? HIAH_GUEST_PID_BASE : g_nextVPID + 1;
+    child->state = HIAHChildRunning;
+    child->owner = parent;
+    child->next = parent->children;
+    parent->children = child;
+    pid_t vpid = child->vpid;
+    pthread_mutex_unlock(&g_lock);
+
+    return vpid;
+}
+
+void HIAHChildTableAbandon(pid_t vpid) {
+    pthread_mutex_lock(&g_lock);
+    HIAHChild **link = HIAHFindChildLink(vpid);
+    if (link) {
+        HIAHChild *child = *link;
+        *link = child->next;
+        free(child);
+    }
+    pthread_mutex_unlock(&g_lock);
+}
+
+void HIAHChildTableAttachThread(pid_t vpid) {
+    t_currentVPID = vpid;
+}
+
+pid_t HIAHChildTableCurrentPID(void) {
+    return t_currentVPID;
+}
+
+void HIAHChildTableExit(pid_t vpid, int exitCode) {
+    pthread_mutex_lock(&g_lock);
+
+    HIAHChild **link = HIAHFindChildLink(vpid);
+    if (link) {
+        HIAHChild *child = *link;
+        if (!child->owner) {
+            // Orphan: nobody can wait for it, reap now
+            *link = child->next;
+            free(child);
+        } else {
+            child->state = HIAHChildZombie;
+            child->status = HIAH_EXIT_STATUS(exitCode);
+            pthread_cond_broadcast(&child->owner->cond);
+        }
+    }
+
+    // Orphan our own children
+    HIAHParent *self = HIAHFindParent(vpid, false);
+    if (self) {
+        HIAHChild *child = self->children;
+        while (child) {
+            HIAHChild *next = child->next;
+            if (child->state == HIAHChildZombie) {
+                free(child);
+            } else {
+                child->owner = NULL;
+                child->next = g_orphans;
+                g_orphans = child;
+            }
+            child = next;
+        }
+        self->children = NULL;
+        self->exited = true;
+        // Waiters on a specific child re-evaluate and see ECHILD
+        pthread_cond_broadcast(&self->cond);
+        HIAHReleaseParentIfIdle(self);
+    }
+
+    pthread_mutex_unlock(&g_lock);
+}
+
+bool HIAHChildTableStop(pid_t vpid, int signal) {
+    pthread_mutex_lock(&g_lock);
+    HIAHChild **link = HIAHFindChildLink(vpid);
+    if (link && (*link)->state == HIAHChildRunning && (*link)->owner) {
+        HIAHChild *child = *link;
+        child->state = HIAHChildStopped;
+        child->status = HIAH_STOP_STATUS(signal);
+        child->stopReported = false;
+        child->continuePending = false;
+        pthread_cond_broadcast(&child->owner->cond);
+    }
+    pthread_mutex_unlock(&g_lock);
+    return link != NULL;
+}
+
+bool HIAHChildTableContinue(pid_t vpid) {
+    pthread_mutex_lock(&g_lock);
+    HIAHChild **link = HIAHFindChildLink(vpid);
+    if (link && (*link)->state == HIAHChildStopped) {
+        HIAHChild *child = *link;
+        child->state = HIAHChildRunning;
+        child->continuePending = child->owner != NULL;
+        if (child->owner) pthread_cond_broadcast(&child->owner->cond);
+    }
+    pthread_mutex_unlock(&g_lock);
+    return link != NULL;
+}
+
+#pragma mark - Waiting
+
+bool HIAHChildTableExists(pid_t vpid) {
+    pthread_mutex_lock(&g_lock);
+    bool result = HIAHFindChildLink(vpid) != NULL;
+    pthread_mutex_unlock(&g_lock);
+    return result;
+}
+
+bool HIAHChildTableHasChildren(void) {
+    pthread_mutex_lock(&g_lock);
+    HIAHParent *parent = HIAHFindParent(t_currentVPID, false);
+    bool result = parent && parent->children;
+    pthread_mutex_unlock(&g_lock);
+    return result;
+}
+
+pid_t HIAHChildTableWait(pid_t pid, int *stat_loc, int options) {
+    return HIAHChildTableWaitTimeout(pid, stat_loc, options, 0);
+}
+
+pid_t HIAHChildTableWaitTimeout(pid_t pid, int *stat_loc, int options, uint32_t timeoutMs) {
+    struct timespec deadline;
+    if (timeoutMs) {
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += timeoutMs / 1000;
+        deadline.tv_nsec += (long)(timeoutMs % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+    }
+
+    pthread_mutex_lock(&g_lock);
+
+    for (;;) {
+        HIAHParent *scope = NULL;
+        HIAHChild **ready = NULL;
+
+        if (pid > 0) {
+            // Only the caller's own children can be waited for
+            HIAHChild **link = HIAHFindChildLink(pid);
+            if (!link || !(*link)->owner || (*link)->owner->vpid != t_currentVPID) break;
+            scope = (*link)->owner;
+            if (HIAHChildReportable(*link, options)) ready = link;
+        } else {
+            scope = HIAHFindParent(t_currentVPID, false);
+            if (!scope || !scope->children) break;
+            for (HIAHChild **it = &scope->children; *it; it = &(*it)->next) {
+                if (HIAHChildReportable(*it, options)) {
+                    ready = it;
+                    break;
+                }
+            }
+        }
+
+        if (ready) {
+            pid_t result = HIAHReap(ready, stat_loc);
+            pthread_mutex_unlock(&g_lock);
+            return result;
+        }
+
+        if (options & WNOHANG) {
+            pthread_mutex_unlock(&g_lock);
+            return 0;
+        }
+
+        scope->waiters++;
+        int rc = timeoutMs ? pthread_cond_timedwait(&scope->cond, &g_lock, &deadline)
+                           : pthread_cond_wait(&scope->cond, &g_lock);
+        scope->waiters--;
+        HIAHReleaseParentIfIdle(scope);
+        if (rc == ETIMEDOUT) {
+            pthread_mutex_unlock(&g_lock);
+            return 0;
+        }
+    }
+
+    pthread_mutex_unlock(&g_lock);
+    errno = ECHILD;
+    return -1;
+}
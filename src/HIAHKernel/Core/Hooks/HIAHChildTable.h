@@ -0,0 +1,140 @@
+/**
+ * HIAHChildTable.h
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Virtual child process table for thread-hosted guests.
+ *
+ * Guests spawned in-process run on a thread, but the code driving them
+ * (shells, build tools) expects real process semantics from waitpid().
+ * This table gives every guest thread a virtual PID, tracks which virtual
+ * process spawned it, keeps a zombie with the wait(2) status once it exits,
+ * and lets waiters block on a per-parent condition variable that is only
+ * signalled when one of that parent's children changes state.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#ifndef HIAH_CHILD_TABLE_H
+#define HIAH_CHILD_TABLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * First virtual PID handed out to thread-hosted guests.
+ *
+ * Darwin never assigns real PIDs above PID_MAX (99999), so anything at or
+ * above this value is unambiguously a virtual process.
+ */
+#define HIAH_GUEST_PID_BASE 100000
+
+/**
+ * Returns true if `pid` lies in the virtual PID range.
+ */
+static inline bool HIAHChildTableIsVirtualPID(pid_t pid) {
+    return pid >= HIAH_GUEST_PID_BASE;
+}
+
+/**
+ * Allocates a virtual PID for a new child of the calling virtual process.
+ *
+ * The parent is the guest attached to the calling thread, or the host
+ * (virtual PID 0) when called from a non-guest thread. The child starts in
+ * the running state.
+ */
+pid_t HIAHChildTableSpawn(void);
+
+/**
+ * Removes a child that never started (e.g. thread creation failed).
+ * No zombie is left behind and no waiter is woken.
+ */
+void HIAHChildTableAbandon(pid_t vpid);
+
+/**
+ * Marks the calling thread as the body of virtual process `vpid`.
+ * Children spawned from this thread are parented to `vpid`.
+ *
+ * `vpid` may also be a PID the kernel assigned below HIAH_GUEST_PID_BASE.
+ * Such a root process has no virtual parent and is never reported by
+ * waitpid(), but it must still call HIAHChildTableExit() when it ends so
+ * its children are orphaned and its parent record is released.
+ */
+void HIAHChildTableAttachThread(pid_t vpid);
+
+/**
+ * Returns the virtual PID attached to the calling thread, or 0 for host
+ * threads.
+ */
+pid_t HIAHChildTableCurrentPID(void);
+
+/**
+ * Records that `vpid` exited with `exitCode` and wakes its parent's waiters.
+ *
+ * Children of the exiting process are orphaned: zombies are reaped
+ * immediately and running children are reaped on exit, like init would.
+ * For a root process that is not in the table only the orphaning applies.
+ */
+void HIAHChildTableExit(pid_t vpid, int exitCode);
+
+/**
+ * Records that `vpid` was stopped by `signal` (reported to WUNTRACED
+ * waiters exactly once). The guest thread itself keeps running: this is
+ * the job-control state shells see through waitpid(), fed by kill() on
+ * virtual PIDs.
+ *
+ * @return false if `vpid` is not a live virtual process.
+ */
+bool HIAHChildTableStop(pid_t vpid, int signal);
+
+/**
+ * Returns a stopped child to the running state (reported to WCONTINUED
+ * waiters exactly once).
+ *
+ * @return false if `vpid` is not a live virtual process.
+ */
+bool HIAHChildTableContinue(pid_t vpid);
+
+/**
+ * Returns true if `vpid` is a virtual process that has not been reaped.
+ */
+bool HIAHChildTableExists(pid_t vpid);
+
+/**
+ * Returns true if the calling virtual process has any virtual children,
+ * including unreaped zombies.
+ */
+bool HIAHChildTableHasChildren(void);
+
+/**
+ * waitpid(2) over the virtual child table.
+ *
+ * - pid > 0 waits for that child; ECHILD if it is not the caller's.
+ * - pid == -1, pid == 0 and pid < -1 wait for any child of the caller
+ *   (guests have no process groups, so every child is in the caller's).
+ * - WNOHANG returns 0 when children exist but none has changed state.
+ * - WUNTRACED also reports stopped children, WCONTINUED continued ones.
+ *
+ * Blocks on the parent's condition variable; no polling.
+ *
+ * @return The reaped virtual PID, 0 for WNOHANG with nothing to report, or
+ *         -1 with errno set to ECHILD when there is nothing to wait for.
+ */
+pid_t HIAHChildTableWait(pid_t pid, int *stat_loc, int options);
+
+/**
+ * HIAHChildTableWait that gives up after `timeoutMs` (0 waits forever) and
+ * returns 0, for callers that also wait on real host children.
+ */
+pid_t HIAHChildTableWaitTimeout(pid_t pid, int *stat_loc, int options, uint32_t timeoutMs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HIAH_CHILD_TABLE_H */
@@ -0,0 +1,359 @@
+/**
+ * HIAHDeltaUpdate.c
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Delta app update implementation.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#if !defined(__APPLE__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE                       // renameat2
+#endif
+
+#include "HIAHDeltaUpdate.h"
+#include "HIAHStaging.h"
+#include "HIAHZipArchive.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// One entry of the app bundle, from the archive or from a manifest.
+// Directories have S_IFDIR set and no trailing slash.
+typedef struct {
+    HIAHZipEntryInfo info;        // `name` is unused; see nameOffset
+    uint32_t nameOffset;
+} HIAHDeltaItem;
+
+typedef struct {
+    HIAHZipBundle bundle;
+    HIAHDeltaItem *items;
+    size_t count;
+    size_t capacity;
+    char *names;
+    size_t namesSize;
+    size_t namesCapacity;
+} HIAHDeltaPlan;
+
+static _Atomic(uint32_t) g_updateCounter = 0;
+
+#pragma mark - Helpers
+
+static int HIAHDeltaRemoveItem(const char *path, const struct stat *st, int type, struct FTW *ftw) {
+    (void)st;
+    (void)ftw;
+    return (type == FTW_DP ? rmdir(path) : unlink(path)) == 0 ? 0 : errno;
+}
+
+static int HIAHDeltaRemoveTree(const char *path) {
+    return nftw(path, HIAHDeltaRemoveItem, 16, FTW_DEPTH | FTW_PHYS) == 0 ? 0 : errno;
+}
+
+#pragma mark - Plans
+
+static const char *HIAHDeltaName(const HIAHDeltaPlan *plan, const HIAHDeltaItem *item) {
+    return plan->names + item->nameOffset;
+}
+
+static int HIAHDeltaAdd(HIAHDeltaPlan *plan, const HIAHZipEntryInfo *info, const char *name,
+                        size_t nameLength) {
+    if (plan->count == plan->capacity) {
+        size_t capacity = plan->capacity ? plan->capacity * 2 : 256;
+        HIAHDeltaItem *items = realloc(plan->items, capacity * sizeof(*items));
+        if (!items) return ENOMEM;
+        plan->items = items;
+        plan->capacity = capacity;
+    }
+    if (plan->namesSize + nameLength + 1 > plan->namesCapacity) {
+        size_t capacity = plan->namesCapacity ? plan->namesCapacity : 16384;
+        while (plan->namesSize + nameLength + 1 > capacity) capacity *= 2;
+        char *names = realloc(plan->names, capacity);
+        if (!names) return ENOMEM;
+        plan->names = names;
+        plan->namesCapacity = capacity;
+    }
+
+    HIAHDeltaItem *item = &plan->items[plan->count++];
+    item->info = *info;
+    item->info.name = NULL;
+    item->nameOffset = (uint32_t)plan->namesSize;
+    memcpy(plan->names + plan->namesSize, name, nameLength);
+    plan->names[plan->namesSize + nameLength] = '\0';
+    plan->namesSize += nameLength + 1;
+    return 0;
+}
+
+static int HIAHDeltaCollect(void *userData, const HIAHZipEntryInfo *info) {
+    HIAHDeltaPlan *plan = userData;
+    size_t nameLength;
+    bool isDirectory;
+    const char *name = HIAHZipBundleEntry(&plan->bundle, info->name, &nameLength, &isDirectory);
+    if (!name) return 0;
+
+    HIAHZipEntryInfo entry = *info;
+    if (isDirectory) {
+        entry.mode = S_IFDIR | 0755;
+    } else if (!(entry.mode & S_IFMT)) {
+        entry.mode = S_IFREG | (entry.mode & 07777 ? entry.mode & 07777 : 0644);
+    }
+    return HIAHDeltaAdd(plan, &entry, name, nameLength);
+}
+
+static int HIAHDeltaCompareItems(const void *a, const void *b) {
+    // (name, item) pairs; see HIAHDeltaSort
+    const char *const *left = a;
+    const char *const *right = b;
+    return strcmp(*left, *right);
+}
+
+// Sorts the plan by name. The comparator gets no context, so it sorts
+// (name, item) pairs with the name pointer first, like the lazy index
+static int HIAHDeltaSort(HIAHDeltaPlan *plan) {
+    typedef struct {
+        const char *name;
+        HIAHDeltaItem item;
+    } HIAHDeltaSorted;
+
+    HIAHDeltaSorted *sorted = malloc((plan->count ? plan->count : 1) * sizeof(HIAHDeltaSorted));
+    if (!sorted) return ENOMEM;
+    for (size_t i = 0; i < plan->count; i++) {
+        sorted[i] = (HIAHDeltaSorted){HIAHDeltaName(plan, &plan->items[i]), plan->items[i]};
+    }
+    qsort(sorted, plan->count, sizeof(HIAHDeltaSorted), HIAHDeltaCompareItems);
+    for (size_t i = 0; i < plan->count; i++) plan->items[i] = sorted[i].item;
+    free(sorted);
+    return 0;
+}
+
+static const HIAHDeltaItem *HIAHDeltaFind(const HIAHDeltaPlan *plan, const char *name) {
+    size_t low = 0, high = plan->count;
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        int order = strcmp(HIAHDeltaName(plan, &plan->items[middle]), name);
+        if (order == 0) return &plan->items[middle];
+        if (order < 0) low = middle + 1;
+        else high = middle;
+    }
+    return NULL;
+}
+
+static void HIAHDeltaFree(HIAHDeltaPlan *plan) {
+    free(plan->items);
+    free(plan->names);
+}
+
+#pragma mark - Manifest
+
+static int HIAHDeltaWriteManifest(const HIAHDeltaPlan *plan, const char *bundlePath) {
+    char path[PATH_MAX], temporary[PATH_MAX];
+    if ((size_t)snprintf(temporary, sizeof(temporary), "%s/" HIAH_DELTA_MANIFEST ".new", bundlePath) >=
+        sizeof(temporary)) {
+        return ENAMETOOLONG;
+    }
+    snprintf(path, sizeof(path), "%s/" HIAH_DELTA_MANIFEST, bundlePath);
+
+    FILE *file = fopen(temporary, "w");
+    if (!file) return errno;
+    bool written = true;
+    for (size_t i = 0; i < plan->count && written; i++) {
+        const HIAHDeltaItem *item = &plan->items[i];
+        written = fprintf(file, "%08x %llu %o %s\n", item->info.crc,
+                          (unsigned long long)item->info.uncompressedSize, item->info.mode,
+                          HIAHDeltaName(plan, item)) > 0;
+    }
+    if (fclose(file) != 0) written = false;
+    if (!written || rename(temporary, path) != 0) {
+        int error = errno ? errno : EIO;
+        unlink(temporary);
+        return error;
+    }
+    return 0;
+}
+
+static int HIAHDeltaReadManifest(HIAHDeltaPlan *plan, const char *bundlePath) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/" HIAH_DELTA_MANIFEST, bundlePath);
+    FILE *file = fopen(path, "r");
+    if (!file) return errno;
+
+    char line[PATH_MAX + 64];
+    int error = 0;
+    while (!error && fgets(line, sizeof(line), file)) {
+        unsigned crc, mode;
+        unsigned long long size;
+        int nameStart = 0;
+        size_t length = strlen(line);
+        if (length && line[length - 1] == '\n') line[--length] = '\0';
+        if (sscanf(line, "%x %llu %o %n", &crc, &size, &mode, &nameStart) != 3 || !line[nameStart]) {
+            continue;
+        }
+        HIAHZipEntryInfo info = {.crc = crc, .uncompressedSize = size, .mode = mode};
+        error = HIAHDeltaAdd(plan, &info, line + nameStart, length - (size_t)nameStart);
+    }
+    fclose(file);
+    return error ? error : HIAHDeltaSort(plan);
+}
+
+int HIAHDeltaRecordManifest(const char *archivePath, const char *bundlePath) {
+    HIAHDeltaPlan plan = {0};
+    int error = HIAHZipEnumerate(archivePath, HIAHDeltaCollect, &plan);
+    if (!error && plan.bundle.prefixLength == 0) error = ENOENT;
+    if (!error) error = HIAHDeltaWriteManifest(&plan, bundlePath);
+    HIAHDeltaFree(&plan);
+    return error;
+}
+
+#pragma mark - Update
+
+// Exchanges the two directories in one step where the filesystem can
+static int HIAHDeltaSwap(const char *update, const char *installed) {
+#ifdef __APPLE__
+    if (renamex_np(update, installed, RENAME_SWAP) == 0) return 0;
+#else
+    if (renameat2(AT_FDCWD, update, AT_FDCWD, installed, RENAME_EXCHANGE) == 0) return 0;
+#endif
+    if (errno != ENOTSUP && errno != EINVAL) return errno;
+
+    char aside[PATH_MAX];
+    snprintf(aside, sizeof(aside), "%s.old", update);
+    if (rename(installed, aside) != 0) return errno;
+    if (rename(update, installed) != 0) {
+        int error = errno;
+        rename(aside, installed);
+        return error;
+    }
+    return rename(aside, update) == 0 ? 0 : errno;
+}
+
+// Brings the clone of the installed bundle at `staged` to the new version
+static int HIAHDeltaApply(const HIAHDeltaPlan *plan, const HIAHDeltaPlan *installed, int archive,
+                          const char *staged, const HIAHZipFilter *filter, HIAHDeltaStats *stats) {
+    char path[PATH_MAX];
+
+    // Files no longer in the app, or changed into something else
+    for (size_t i = 0; i < installed->count; i++) {
+        const HIAHDeltaItem *old = &installed->items[i];
+        const char *name = HIAHDeltaName(installed, old);
+        const HIAHDeltaItem *item = HIAHDeltaFind(plan, name);
+        if (S_ISDIR(old->info.mode) || (item && (item->info.mode & S_IFMT) == (old->info.mode & S_IFMT))) {
+            continue;
+        }
+        if ((size_t)snprintf(path, sizeof(path), "%s/%s", staged, name) >= sizeof(path)) return ENAMETOOLONG;
+        if (unlink(path) == 0 && !item) stats->removed++;
+    }
+
+    // Directories first, so every file's parent exists
+    for (size_t i = 0; i < plan->count; i++) {
+        const HIAHDeltaItem *item = &plan->items[i];
+        if (!S_ISDIR(item->info.mode)) continue;
+        if ((size_t)snprintf(path, sizeof(path), "%s/%s", staged, HIAHDeltaName(plan, item)) >= sizeof(path)) {
+            return ENAMETOOLONG;
+        }
+        struct stat st;
+        if (lstat(path, &st) == 0 && !S_ISDIR(st.st_mode)) unlink(path);
+        int error = HIAHZipMakeDirectories(path);
+        if (error) return error;
+    }
+
+    for (size_t i = 0; i < plan->count; i++) {
+        const HIAHDeltaItem *item = &plan->items[i];
+        if (S_ISDIR(item->info.mode)) continue;
+        const char *name = HIAHDeltaName(plan, item);
+        if ((size_t)snprintf(path, sizeof(path), "%s/%s", staged, name) >= sizeof(path)) return ENAMETOOLONG;
+        stats->files++;
+        stats->fullBytes += item->info.uncompressedSize;
+
+        // Kept as installed, prepared binaries included
+        const HIAHDeltaItem *old = HIAHDeltaFind(installed, name);
+        struct stat st;
+        if (old && old->info.crc == item->info.crc &&
+            old->info.uncompressedSize == item->info.uncompressedSize && old->info.mode == item->info.mode &&
+            lstat(path, &st) == 0) {
+            stats->unchanged++;
+            continue;
+        }
+
+        // Unlinked rather than overwritten: the staged file shares its data
+        // with the installed one
+        if (lstat(path, &st) == 0) {
+            int error = S_ISDIR(st.st_mode) ? HIAHDeltaRemoveTree(path) : (unlink(path) == 0 ? 0 : errno);
+            if (error) return error;
+        }
+        int error = HIAHZipMakeParent(path);
+        if (!error) error = HIAHZipExtractEntry(archive, &item->info, path, filter);
+        if (error) return error;
+        stats->extracted++;
+        stats->bytesWritten += item->info.uncompressedSize;
+    }
+
+    // Directories no longer in the app, deepest first; ones still holding
+    // files the app wrote itself stay
+    for (size_t i = installed->count; i-- > 0;) {
+        const HIAHDeltaItem *old = &installed->items[i];
+        const char *name = HIAHDeltaName(installed, old);
+        if (!S_ISDIR(old->info.mode) || HIAHDeltaFind(plan, name)) continue;
+        snprintf(path, sizeof(path), "%s/%s", staged, name);
+        rmdir(path);
+    }
+
+    return HIAHDeltaWriteManifest(plan, staged);
+}
+
+int HIAHDeltaUpdate(const char *archivePath, const char *applicationsPath, const HIAHZipFilter *filter,
+                    char *bundlePath, size_t bundlePathSize, HIAHDeltaStats *stats) {
+    HIAHDeltaStats result = {0};
+    if (stats) *stats = result;
+    if (!archivePath || !applicationsPath || !bundlePath) return EINVAL;
+
+    uint64_t begin = HIAHZipNowNs();
+    HIAHDeltaPlan plan = {0};
+    HIAHDeltaPlan installed = {0};
+    int error = HIAHZipEnumerate(archivePath, HIAHDeltaCollect, &plan);
+
+    // Built in "<applications>/.update-…/<Name>.app", swapped with the installed bundle
+    char updateRoot[PATH_MAX], staged[PATH_MAX];
+    if (!error) error = HIAHZipBundlePath(&plan.bundle, applicationsPath, bundlePath, bundlePathSize);
+    if (!error) {
+        snprintf(updateRoot, sizeof(updateRoot), "%s/.update-%d-%u", applicationsPath, (int)getpid(),
+                 atomic_fetch_add(&g_updateCounter, 1));
+        error = HIAHZipBundlePath(&plan.bundle, updateRoot, staged, sizeof(staged));
+    }
+    if (!error) error = HIAHDeltaSort(&plan);
+    if (!error) {
+        error = HIAHDeltaReadManifest(&installed, bundlePath);
+        if (error == ENOENT || error == ENOTDIR) error = ESRCH;
+    }
+
+    bool created = false;
+    int archive = -1;
+    if (!error) {
+        created = true;
+        // Cloned file by file; only what changed is written
+        error = HIAHStagingSync(bundlePath, staged, true, NULL);
+        char stagingManifest[PATH_MAX];
+        snprintf(stagingManifest, sizeof(stagingManifest), "%s/" HIAH_STAGING_MANIFEST, staged);
+        unlink(stagingManifest);
+    }
+    if (!error && (archive = open(archivePath, O_RDONLY | O_CLOEXEC)) < 0) error = errno;
+    if (!error) error = HIAHDeltaApply(&plan, &installed, archive, staged, filter, &result);
+    if (archive >= 0) close(archive);
+
+    // The swap puts the old version where the update was built
+    if (!error) error = HIAHDeltaSwap(staged, bundlePath);
+    if (created) HIAHDeltaRemoveTree(updateRoot);
+
+    HIAHDeltaFree(&plan);
+    HIAHDeltaFree(&installed);
+    result.wallNs = HIAHZipNowNs() - begin;
+    if (stats) *stats = result;
+    return error;
+}
@@ -0,0 +1,72 @@
+/**
+ * HIAHDeltaUpdate.h
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Updating an installed app from a new .ipa by extracting only what changed.
+ *
+ * Each install records the archive's central directory (name, CRC-32, size
+ * and mode of every entry of the app bundle) in a manifest inside the
+ * bundle. An update compares the new archive's central directory with it:
+ * files whose entry is unchanged are kept as installed - binaries stay
+ * prepared (see HIAHMachOPrepare) - new and changed files are extracted,
+ * and files no longer in the app are removed.
+ *
+ * The update is built next to the installed bundle from clones of its
+ * files (see HIAHStaging) and swapped in with one atomic rename, so a
+ * failed update leaves the installed version untouched.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#ifndef HIAH_DELTA_UPDATE_H
+#define HIAH_DELTA_UPDATE_H
+
+#include "HIAHZipArchive.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Manifest inside an installed bundle: one "<crc> <size> <mode> <path>" line per entry
+#define HIAH_DELTA_MANIFEST ".hiah-archive"
+
+typedef struct {
+    uint64_t files;               // Files and symlinks in the new version
+    uint64_t unchanged;           // Kept from the installed version
+    uint64_t extracted;           // New or changed
+    uint64_t removed;             // No longer in the app
+    uint64_t bytesWritten;        // Uncompressed bytes extracted
+    uint64_t fullBytes;           // What a full reinstall would have written
+    uint64_t wallNs;
+} HIAHDeltaStats;
+
+/**
+ * Records the central directory of `archivePath` as the manifest of the
+ * bundle at `bundlePath`, freshly installed from it, so later versions can
+ * be installed with HIAHDeltaUpdate.
+ *
+ * @return 0 or an errno value; ENOENT if the archive holds no app bundle.
+ */
+int HIAHDeltaRecordManifest(const char *archivePath, const char *bundlePath);
+
+/**
+ * Updates `applicationsPath`/<Name>.app to the app in `archivePath` and
+ * writes that path to `bundlePath`. `filter` applies to the extracted
+ * files; it and `stats` may be NULL.
+ *
+ * @return 0 or an errno value: ENOENT if the archive holds no app bundle,
+ *         ESRCH if there is no installed version with a manifest to update
+ *         (install it in full instead), otherwise as for HIAHZipExtract.
+ *         On failure the installed version is unchanged.
+ */
+int HIAHDeltaUpdate(const char *archivePath, const char *applicationsPath, const HIAHZipFilter *filter,
+                    char *bundlePath, size_t bundlePathSize, HIAHDeltaStats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HIAH_DELTA_UPDATE_H */
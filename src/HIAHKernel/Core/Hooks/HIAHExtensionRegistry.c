@@ -0,0 +1,243 @@
+/**
+ * HIAHExtensionRegistry.c
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Shared extension registry implementation.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#include "HIAHExtensionRegistry.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/sysctl.h>
+#include <time.h>
+#include <unistd.h>
+
+#define HIAH_REGISTRY_MAGIC 0x48455852u      // 'HEXR'
+#define HIAH_REGISTRY_VERSION 2u
+#define HIAH_REGISTRY_SIZE 4096
+
+typedef struct {
+    _Atomic(int32_t) pid;                    // 0 when free; claimed by CAS
+    _Atomic(uint32_t) flags;                 // Cleared before the slot is freed
+    _Atomic(uint64_t) registeredNs;
+    _Atomic(uint64_t) startTimeUs;           // 0 if it could not be read
+} HIAHExtensionSlot;
+
+struct HIAHExtensionRegistry {
+    _Atomic(uint32_t) magic;
+    _Atomic(uint32_t) version;
+    uint64_t reserved;
+    HIAHExtensionSlot slots[HIAH_EXTENSION_REGISTRY_CAPACITY];
+};
+
+_Static_assert(sizeof(struct HIAHExtensionRegistry) <= HIAH_REGISTRY_SIZE,
+               "registry must fit in one page");
+
+#pragma mark - Mapping
+
+HIAHExtensionRegistry *HIAHExtensionRegistryMap(const char *path) {
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 ||
+        (st.st_size < HIAH_REGISTRY_SIZE && ftruncate(fd, HIAH_REGISTRY_SIZE) != 0)) {
+        close(fd);
+        return NULL;
+    }
+
+    void *map = mmap(NULL, HIAH_REGISTRY_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return NULL;
+
+    // A fresh (zero-filled) file is already a valid empty table; stamp it so
+    // an incompatible future layout can be recognised
+    HIAHExtensionRegistry *registry = map;
+    uint32_t expected = 0;
+    if (atomic_compare_exchange_strong(&registry->magic, &expected, HIAH_REGISTRY_MAGIC)) {
+        atomic_store(&registry->version, HIAH_REGISTRY_VERSION);
+    } else if (expected != HIAH_REGISTRY_MAGIC) {
+        munmap(map, HIAH_REGISTRY_SIZE);
+        return NULL;
+    } else {
+        // Entries only mean something while their processes live, so a
+        // table written by an older build is simply cleared
+        uint32_t version = atomic_load(&registry->version);
+        if (version < HIAH_REGISTRY_VERSION &&
+            atomic_compare_exchange_strong(&registry->version, &version, HIAH_REGISTRY_VERSION)) {
+            memset(registry->slots, 0, sizeof(registry->slots));
+        } else if (version != HIAH_REGISTRY_VERSION) {
+            munmap(map, HIAH_REGISTRY_SIZE);
+            return NULL;
+        }
+    }
+    return registry;
+}
+
+#pragma mark - Entries
+
+static bool HIAHProcessExists(pid_t pid) {
+    // EPERM means the process exists but is outside our sandbox's reach
+    return kill(pid, 0) == 0 || errno != ESRCH;
+}
+
+// Start time of `pid` in microseconds since the epoch, or 0 if unavailable
+static uint64_t HIAHProcessStartTime(pid_t pid) {
+#ifdef KERN_PROC_PID
+    struct kinfo_proc info;
+    size_t size = sizeof(info);
+    int mib[4] = {CTL_KERN, KERN_PROC, KERN_PROC_PID, pid};
+    if (sysctl(mib, 4, &info, &size, NULL, 0) != 0 || size == 0) return 0;
+    return (uint64_t)info.kp_proc.p_starttime.tv_sec * 1000000ull +
+           (uint64_t)info.kp_proc.p_starttime.tv_usec;
+#else
+    (void)pid;
+    return 0;
+#endif
+}
+
+// Whether the process registered with `startTimeUs` is still running, as
+// opposed to a later process that was given the same PID
+static bool HIAHProcessAlive(pid_t pid, uint64_t startTimeUs) {
+    if (!HIAHProcessExists(pid)) return false;
+    if (startTimeUs == 0) return true;
+    uint64_t current = HIAHProcessStartTime(pid);
+    // An unreadable start time is given the benefit of the doubt
+    return current == 0 || current == startTimeUs;
+}
+
+static HIAHExtensionSlot *HIAHFindSlot(HIAHExtensionRegistry *registry, pid_t pid) {
+    for (int i = 0; i < HIAH_EXTENSION_REGISTRY_CAPACITY; i++) {
+        HIAHExtensionSlot *slot = &registry->slots[i];
+        if (atomic_load_explicit(&slot->pid, memory_order_acquire) == pid) return slot;
+    }
+    return NULL;
+}
+
+static void HIAHFreeSlot(HIAHExtensionSlot *slot, pid_t pid) {
+    atomic_store_explicit(&slot->flags, 0, memory_order_relaxed);
+    atomic_store_explicit(&slot->startTimeUs, 0, memory_order_relaxed);
+    int32_t expected = pid;
+    atomic_compare_exchange_strong_explicit(&slot->pid, &expected, 0,
+                                            memory_order_release, memory_order_relaxed);
+}
+
+static uint64_t HIAHRealtimeNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+bool HIAHExtensionRegistryRegister(HIAHExtensionRegistry *registry, pid_t pid) {
+    if (!registry || pid <= 0) return false;
+
+    uint64_t startTimeUs = HIAHProcessStartTime(pid);
+
+    // A previous process with our PID died without unregistering
+    HIAHExtensionSlot *slot = HIAHFindSlot(registry, pid);
+    if (slot) {
+        atomic_store_explicit(&slot->flags, 0, memory_order_relaxed);
+        atomic_store_explicit(&slot->startTimeUs, startTimeUs, memory_order_relaxed);
+        atomic_store_explicit(&slot->registeredNs, HIAHRealtimeNs(), memory_order_release);
+        return true;
+    }
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        for (int i = 0; i < HIAH_EXTENSION_REGISTRY_CAPACITY; i++) {
+            slot = &registry->slots[i];
+            int32_t expected = 0;
+            if (atomic_compare_exchange_strong_explicit(&slot->pid, &expected, pid,
+                                                        memory_order_acq_rel,
+                                                        memory_order_relaxed)) {
+                atomic_store_explicit(&slot->startTimeUs, startTimeUs, memory_order_relaxed);
+                atomic_store_explicit(&slot->registeredNs, HIAHRealtimeNs(), memory_order_release);
+                return true;
+            }
+        }
+        if (HIAHExtensionRegistryCollect(registry) == 0) break;
+    }
+    return false;
+}
+
+void HIAHExtensionRegistryUnregister(HIAHExtensionRegistry *registry, pid_t pid) {
+    if (!registry || pid <= 0) return;
+    HIAHExtensionSlot *slot = HIAHFindSlot(registry, pid);
+    if (slot) HIAHFreeSlot(slot, pid);
+}
+
+void HIAHExtensionRegistrySetFlags(HIAHExtensionRegistry *registry, pid_t pid, uint32_t flags) {
+    if (!registry || pid <= 0) return;
+    HIAHExtensionSlot *slot = HIAHFindSlot(registry, pid);
+    if (slot) atomic_fetch_or_explicit(&slot->flags, flags, memory_order_acq_rel);
+}
+
+#pragma mark - Scanning
+
+size_t HIAHExtensionRegistryClaimPendingJIT(HIAHExtensionRegistry *registry,
+                                            HIAHExtensionRecord *out, size_t max) {
+    if (!registry) return 0;
+    size_t count = 0;
+
+    for (int i = 0; i < HIAH_EXTENSION_REGISTRY_CAPACITY && count < max; i++) {
+        HIAHExtensionSlot *slot = &registry->slots[i];
+        pid_t pid = atomic_load_explicit(&slot->pid, memory_order_acquire);
+        if (pid <= 0) continue;
+
+        uint32_t old = atomic_fetch_or_explicit(&slot->flags, HIAHExtensionFlagJITRequested,
+                                                memory_order_acq_rel);
+        // Already handled, or already debugged (nothing left to attach)
+        if (old & (HIAHExtensionFlagJITRequested | HIAHExtensionFlagJITEnabled)) continue;
+
+        out[count].pid = pid;
+        out[count].flags = old | HIAHExtensionFlagJITRequested;
+        out[count].registeredNs = atomic_load_explicit(&slot->registeredNs, memory_order_acquire);
+        out[count].startTimeUs = atomic_load_explicit(&slot->startTimeUs, memory_order_relaxed);
+        count++;
+    }
+    return count;
+}
+
+size_t HIAHExtensionRegistrySnapshot(HIAHExtensionRegistry *registry,
+                                     HIAHExtensionRecord *out, size_t max) {
+    if (!registry) return 0;
+    size_t count = 0;
+
+    for (int i = 0; i < HIAH_EXTENSION_REGISTRY_CAPACITY && count < max; i++) {
+        HIAHExtensionSlot *slot = &registry->slots[i];
+        pid_t pid = atomic_load_explicit(&slot->pid, memory_order_acquire);
+        if (pid <= 0) continue;
+
+        out[count].pid = pid;
+        out[count].flags = atomic_load_explicit(&slot->flags, memory_order_relaxed);
+        out[count].registeredNs = atomic_load_explicit(&slot->registeredNs, memory_order_relaxed);
+        out[count].startTimeUs = atomic_load_explicit(&slot->startTimeUs, memory_order_relaxed);
+        count++;
+    }
+    return count;
+}
+
+size_t HIAHExtensionRegistryCollect(HIAHExtensionRegistry *registry) {
+    if (!registry) return 0;
+    size_t removed = 0;
+
+    for (int i = 0; i < HIAH_EXTENSION_REGISTRY_CAPACITY; i++) {
+        HIAHExtensionSlot *slot = &registry->slots[i];
+        pid_t pid = atomic_load_explicit(&slot->pid, memory_order_acquire);
+        if (pid <= 0 ||
+            HIAHProcessAlive(pid, atomic_load_explicit(&slot->startTimeUs, memory_order_relaxed))) {
+            continue;
+        }
+
+        HIAHFreeSlot(slot, pid);
+        removed++;
+    }
+    return removed;
+}
@@ -0,0 +1,106 @@
+/**
+ * HIAHExtensionRegistry.h
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Shared table of running ProcessRunner extension processes.
+ *
+ * Each extension claims a slot in a small file mapped from the App Group
+ * container when it loads, then posts the ExtensionStarted notification.
+ * The kernel walks the table in memory instead of listing the container,
+ * and atomically claims each entry's JIT-requested flag, so only extensions
+ * it has not yet handled get a JIT attach attempt. Entries are released by
+ * their owner at exit, and slots whose process has died are reclaimed by
+ * HIAHExtensionRegistryCollect. Each entry records its process's start
+ * time, so a later process that reuses the PID is not taken for it.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#ifndef HIAH_EXTENSION_REGISTRY_H
+#define HIAH_EXTENSION_REGISTRY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// File name inside the App Group container
+#define HIAH_EXTENSION_REGISTRY_FILE "HIAH_Extensions.registry"
+
+/// Maximum number of concurrently registered extensions
+#define HIAH_EXTENSION_REGISTRY_CAPACITY 128
+
+typedef enum {
+    HIAHExtensionFlagJITRequested = 1 << 0,   // The kernel has started a JIT attach
+    HIAHExtensionFlagJITEnabled   = 1 << 1,   // The extension observed CS_DEBUGGED (no attach needed)
+} HIAHExtensionFlags;
+
+typedef struct HIAHExtensionRegistry HIAHExtensionRegistry;
+
+typedef struct {
+    pid_t pid;
+    uint32_t flags;
+    uint64_t registeredNs;        // CLOCK_REALTIME at registration
+    uint64_t startTimeUs;         // Process start time, 0 if unavailable
+} HIAHExtensionRecord;
+
+/**
+ * Maps (creating if needed) the registry at `path`. Mappings live for the
+ * rest of the process.
+ */
+HIAHExtensionRegistry *HIAHExtensionRegistryMap(const char *path);
+
+/**
+ * Adds `pid`, replacing a stale entry left by an earlier process with the
+ * same PID.
+ *
+ * @return false if the table is full even after collecting dead entries.
+ */
+bool HIAHExtensionRegistryRegister(HIAHExtensionRegistry *registry, pid_t pid);
+
+/**
+ * Removes `pid` (no-op if absent).
+ */
+void HIAHExtensionRegistryUnregister(HIAHExtensionRegistry *registry, pid_t pid);
+
+/**
+ * Sets `flags` on `pid`'s entry.
+ */
+void HIAHExtensionRegistrySetFlags(HIAHExtensionRegistry *registry, pid_t pid, uint32_t flags);
+
+/**
+ * Claims every live entry that does not yet have HIAHExtensionFlagJITRequested
+ * by setting it, and copies those entries to `out`. Entries that already
+ * report HIAHExtensionFlagJITEnabled are claimed but not copied: they need
+ * no attach. Concurrent callers never claim the same entry twice.
+ *
+ * @return Number of entries written (at most `max`).
+ */
+size_t HIAHExtensionRegistryClaimPendingJIT(HIAHExtensionRegistry *registry,
+                                            HIAHExtensionRecord *out, size_t max);
+
+/**
+ * Copies all live entries to `out`.
+ *
+ * @return Number of entries written (at most `max`).
+ */
+size_t HIAHExtensionRegistrySnapshot(HIAHExtensionRegistry *registry,
+                                     HIAHExtensionRecord *out, size_t max);
+
+/**
+ * Frees the slots of processes that no longer exist.
+ *
+ * @return Number of entries removed.
+ */
+size_t HIAHExtensionRegistryCollect(HIAHExtensionRegistry *registry);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HIAH_EXTENSION_REGISTRY_H */
@@ -0,0 +1,191 @@
+/**
+ * HIAHFileActions.c
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * File-actions table implementation.
+ *
+ * Slot keys move EMPTY -> BUSY -> key -> TOMBSTONE -> BUSY -> ...
+ * A slot is claimed with a CAS to BUSY, initialised, then published by a
+ * release store of the key. Lookups probe until an EMPTY slot, so
+ * tombstones keep probe chains intact and are reused by later inserts.
+ *
+ * Tombstones left by churn would eventually make every miss scan the whole
+ * table, so once they pass a quarter of it (or an insert finds no free
+ * slot) the table is compacted: live records are re-inserted into a clean
+ * table. Normal operations share a read lock and stay CAS-based among
+ * themselves; only compaction takes it exclusively.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#include "HIAHFileActions.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HIAH_FILE_ACTIONS_SLOTS 512     // Power of two
+#define HIAH_FILE_ACTIONS_INLINE 8
+#define HIAH_FILE_ACTIONS_MAX_TOMBSTONES (HIAH_FILE_ACTIONS_SLOTS / 4)
+
+#define HIAH_SLOT_EMPTY ((uintptr_t)0)
+#define HIAH_SLOT_TOMBSTONE ((uintptr_t)1)
+#define HIAH_SLOT_BUSY ((uintptr_t)2)
+
+typedef struct {
+    _Atomic(uintptr_t) key;
+    uint32_t count;
+    uint32_t overflowCapacity;
+    HIAHAction inlineActions[HIAH_FILE_ACTIONS_INLINE];
+    HIAHAction *overflow;       // Actions past the inline ones
+} HIAHFileActionsRecord;
+
+static HIAHFileActionsRecord g_records[HIAH_FILE_ACTIONS_SLOTS];
+static pthread_rwlock_t g_compactLock = PTHREAD_RWLOCK_INITIALIZER;
+static _Atomic(uint32_t) g_tombstones = 0;
+
+static inline size_t HIAHSlotIndex(uintptr_t key) {
+    // Fibonacci hashing; low bits of stack/heap pointers carry no entropy
+    uint64_t h = (uint64_t)(key >> 4) * 0x9E3779B97F4A7C15ull;
+    return (size_t)(h >> 32) & (HIAH_FILE_ACTIONS_SLOTS - 1);
+}
+
+static HIAHFileActionsRecord *HIAHFindRecord(uintptr_t key, bool create) {
+    for (;;) {
+        size_t start = HIAHSlotIndex(key);
+        HIAHFileActionsRecord *reusable = NULL;
+
+        for (size_t i = 0; i < HIAH_FILE_ACTIONS_SLOTS; i++) {
+            HIAHFileActionsRecord *rec = &g_records[(start + i) & (HIAH_FILE_ACTIONS_SLOTS - 1)];
+            uintptr_t k = atomic_load_explicit(&rec->key, memory_order_acquire);
+            if (k == key) return rec;
+            if (k == HIAH_SLOT_TOMBSTONE) {
+                if (!reusable) reusable = rec;
+            } else if (k == HIAH_SLOT_EMPTY) {
+                if (!reusable) reusable = rec;
+                break;
+            }
+        }
+
+        if (!create || !reusable) return NULL;
+
+        uintptr_t expected = atomic_load_explicit(&reusable->key, memory_order_relaxed);
+        if ((expected == HIAH_SLOT_EMPTY || expected == HIAH_SLOT_TOMBSTONE) &&
+            atomic_compare_exchange_strong_explicit(&reusable->key, &expected, HIAH_SLOT_BUSY,
+                                                    memory_order_acquire, memory_order_relaxed)) {
+            if (expected == HIAH_SLOT_TOMBSTONE) atomic_fetch_sub(&g_tombstones, 1);
+            reusable->count = 0;
+            reusable->overflowCapacity = 0;
+            reusable->overflow = NULL;
+            atomic_store_explicit(&reusable->key, key, memory_order_release);
+            return reusable;
+        }
+        // Lost the slot to another thread; probe again
+    }
+}
+
+// Re-inserts every live record into a table without tombstones
+static void HIAHCompact(void) {
+    pthread_rwlock_wrlock(&g_compactLock);
+    if (atomic_load(&g_tombstones) > 0) {
+        size_t liveCount = 0;
+        HIAHFileActionsRecord *live = malloc(sizeof(g_records));
+        if (live) {
+            for (size_t i = 0; i < HIAH_FILE_ACTIONS_SLOTS; i++) {
+                uintptr_t k = atomic_load_explicit(&g_records[i].key, memory_order_relaxed);
+                if (k > HIAH_SLOT_BUSY) live[liveCount++] = g_records[i];
+                atomic_store_explicit(&g_records[i].key, HIAH_SLOT_EMPTY, memory_order_relaxed);
+            }
+            atomic_store(&g_tombstones, 0);
+            for (size_t i = 0; i < liveCount; i++) {
+                uintptr_t key = atomic_load_explicit(&live[i].key, memory_order_relaxed);
+                HIAHFileActionsRecord *rec = HIAHFindRecord(key, true);
+                uintptr_t published = atomic_load_explicit(&rec->key, memory_order_relaxed);
+                memcpy(rec, &live[i], sizeof(*rec));
+                atomic_store_explicit(&rec->key, published, memory_order_relaxed);
+            }
+            free(live);
+        }
+    }
+    pthread_rwlock_unlock(&g_compactLock);
+}
+
+static int HIAHAppendLocked(const void *fileActions, const HIAHAction *action) {
+    HIAHFileActionsRecord *rec = HIAHFindRecord((uintptr_t)fileActions, true);
+    if (!rec) return -1;
+
+    if (rec->count < HIAH_FILE_ACTIONS_INLINE) {
+        rec->inlineActions[rec->count++] = *action;
+        return 0;
+    }
+
+    uint32_t spill = rec->count - HIAH_FILE_ACTIONS_INLINE;
+    if (spill == rec->overflowCapacity) {
+        uint32_t capacity = rec->overflowCapacity ? rec->overflowCapacity * 2 : HIAH_FILE_ACTIONS_INLINE;
+        HIAHAction *grown = realloc(rec->overflow, capacity * sizeof(HIAHAction));
+        if (!grown) return -1;
+        rec->overflow = grown;
+        rec->overflowCapacity = capacity;
+    }
+    rec->overflow[spill] = *action;
+    rec->count++;
+    return 0;
+}
+
+int HIAHFileActionsAppend(const void *fileActions, const HIAHAction *action) {
+    if (!fileActions || !action) return -1;
+
+    for (int attempt = 0;; attempt++) {
+        pthread_rwlock_rdlock(&g_compactLock);
+        int result = HIAHAppendLocked(fileActions, action);
+        pthread_rwlock_unlock(&g_compactLock);
+        // A full table may only be full of tombstones
+        if (result == 0 || attempt > 0 || atomic_load(&g_tombstones) == 0) return result;
+        HIAHCompact();
+    }
+}
+
+size_t HIAHFileActionsCopy(const void *fileActions, HIAHAction **out) {
+    *out = NULL;
+    if (!fileActions) return 0;
+
+    pthread_rwlock_rdlock(&g_compactLock);
+    HIAHFileActionsRecord *rec = HIAHFindRecord((uintptr_t)fileActions, false);
+    HIAHAction *copy = (rec && rec->count > 0) ? malloc(rec->count * sizeof(HIAHAction)) : NULL;
+    if (!copy) {
+        pthread_rwlock_unlock(&g_compactLock);
+        return 0;
+    }
+
+    uint32_t inlineCount = rec->count < HIAH_FILE_ACTIONS_INLINE ? rec->count : HIAH_FILE_ACTIONS_INLINE;
+    memcpy(copy, rec->inlineActions, inlineCount * sizeof(HIAHAction));
+    if (rec->count > inlineCount) {
+        memcpy(copy + inlineCount, rec->overflow, (rec->count - inlineCount) * sizeof(HIAHAction));
+    }
+    size_t count = rec->count;
+    pthread_rwlock_unlock(&g_compactLock);
+    *out = copy;
+    return count;
+}
+
+void HIAHFileActionsRemove(const void *fileActions) {
+    if (!fileActions) return;
+
+    pthread_rwlock_rdlock(&g_compactLock);
+    HIAHFileActionsRecord *rec = HIAHFindRecord((uintptr_t)fileActions, false);
+    uint32_t tombstones = 0;
+    if (rec) {
+        free(rec->overflow);
+        rec->overflow = NULL;
+        rec->overflowCapacity = 0;
+        rec->count = 0;
+        atomic_store_explicit(&rec->key, HIAH_SLOT_TOMBSTONE, memory_order_release);
+        tombstones = atomic_fetch_add(&g_tombstones, 1) + 1;
+    }
+    pthread_rwlock_unlock(&g_compactLock);
+
+    if (tombstones > HIAH_FILE_ACTIONS_MAX_TOMBSTONES) HIAHCompact();
+}
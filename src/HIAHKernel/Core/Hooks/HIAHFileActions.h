@@ -0,0 +1,76 @@
+/**
+ * HIAHFileActions.h
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Storage for posix_spawn file actions recorded by the spawn hooks.
+ *
+ * In-process guests can't use the kernel's file actions, so the hooks
+ * record dup2/close calls per posix_spawn_file_actions_t and replay them on
+ * the guest thread. Records live in a fixed open-addressing table keyed by
+ * the file-actions pointer. Each record holds a few actions
+ * inline and spills to a heap array only for long pipelines.
+ *
+ * A file-actions object is built and consumed by one thread at a time (it
+ * is not thread-safe in POSIX either), so records need no locking of their
+ * own; slot ownership is arbitrated with atomics under a shared read lock.
+ * Removals leave tombstones, which are compacted away under the write lock
+ * once they make up a quarter of the table.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#ifndef HIAH_FILE_ACTIONS_H
+#define HIAH_FILE_ACTIONS_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    HIAHActionClose,
+    HIAHActionDup2,
+    HIAHActionOpen
+} HIAHActionType;
+
+typedef struct {
+    HIAHActionType type;
+    int fd;
+    int new_fd;
+    char *path;
+    int oflag;
+    mode_t mode;
+} HIAHAction;
+
+/**
+ * Appends `action` to the record for `fileActions`, creating it if needed.
+ *
+ * @return 0 on success, -1 if the table is full even after compaction or
+ *         allocation failed. The spawn hooks still pass the call on to the
+ *         real function and log the miss, so only an in-process guest
+ *         spawned from `fileActions` runs without the action.
+ */
+int HIAHFileActionsAppend(const void *fileActions, const HIAHAction *action);
+
+/**
+ * Copies the recorded actions for `fileActions` into a malloc'd array.
+ *
+ * @param out Receives the array (NULL when there are no actions); the
+ *            caller frees it.
+ * @return Number of actions copied.
+ */
+size_t HIAHFileActionsCopy(const void *fileActions, HIAHAction **out);
+
+/**
+ * Drops the record for `fileActions` (called from init and destroy).
+ */
+void HIAHFileActionsRemove(const void *fileActions);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HIAH_FILE_ACTIONS_H */
@@ -3,7 +3,7 @@
  * HIAHKernel – House in a House Virtual Kernel (for iOS)
  *
  * System call interception for guest processes.
- * Hooks posix_spawn, execve, and waitpid to enable virtual process control.
+ * Hooks posix_spawn, execve, waitpid and exit to enable virtual process control.
  */
 
 #import <Foundation/Foundation.h>
@@ -21,7 +21,8 @@ NS_ASSUME_NONNULL_BEGIN
  * - posix_spawn: Intercepts process creation, redirects to dlopen or kernel
  * - posix_spawn_file_actions_adddup2/addclose: Tracks pipe setup
  * - execve: Intercepts exec calls, handles SSH specially
- * - waitpid: Handles thread-based pseudo-PIDs
+ * - waitpid: Waits on virtual child PIDs (see HIAHChildTable.h)
+ * - exit/_exit: Ends only the calling guest thread, recording its status
  */
 __attribute__((visibility("default")))
 void HIAHInstallHooks(void);
@@ -8,6 +8,11 @@
 
 #import "HIAHGuestHooks.h"
 #import "HIAHHook.h"
+#import "HIAHChildTable.h"
+#import "HIAHImageCache.h"
+#import "HIAHFileActions.h"
+#import "HIAHGuestLauncher.h"
+#import "HIAHHookStats.h"
 #import <Foundation/Foundation.h>
 #import <spawn.h>
 #import <dlfcn.h>
@@ -18,47 +23,27 @@
 #import <sys/socket.h>
 #import <sys/un.h>
 #import <sys/wait.h>
+#import <signal.h>
 #import <sys/stat.h>
 #import <pthread.h>
 #import <fcntl.h>
 #import <stdint.h>
 
-#pragma mark - File Actions Tracking
-
-typedef enum {
-    HIAHActionClose,
-    HIAHActionDup2,
-    HIAHActionOpen
-} HIAHActionType;
-
-typedef struct {
-    HIAHActionType type;
-    int fd;
-    int new_fd;
-    char *path;
-    int oflag;
-    mode_t mode;
-} HIAHAction;
+#pragma mark - Guest Thread Arguments
 
 typedef struct HIAHThreadArgs {
     char *path;
     int argc;
     char **argv;
-    NSArray *actions;
+    HIAHAction *actions;    // Copied from HIAHFileActions at spawn time
+    size_t actionCount;
+    pid_t vpid;             // Virtual PID from HIAHChildTable
+    int exitCode;           // Entry return value or exit() status
+    HIAHImage *image;
 } HIAHThreadArgs;
 
-static NSMutableDictionary<NSValue *, NSMutableArray *> *g_actions_map = nil;
-static NSLock *g_actions_lock = nil;
 static BOOL g_hooksInstalled = NO;
 
-static void HIAHInitActions(void) {
-    static dispatch_once_t onceToken;
-    dispatch_once(&onceToken, ^{
-        g_actions_map = [[NSMutableDictionary alloc] init];
-        g_actions_lock = [[NSLock alloc] init];
-    });
-}
-
 #pragma mark - Thread-Local Hook Control
 
 static __thread BOOL gInHook = NO;
@@ -79,43 +64,46 @@ BOOL HIAHHooksInstalled(void) {
 
 typedef int (*ps_fa_adddup2_t)(posix_spawn_file_actions_t *, int, int);
 typedef int (*ps_fa_addclose_t)(posix_spawn_file_actions_t *, int);
+typedef int (*ps_fa_lifecycle_t)(posix_spawn_file_actions_t *);
 
 DEFINE_HOOK(posix_spawn_file_actions_adddup2, int, (posix_spawn_file_actions_t *fa, int fd, int new_fd)) {
-    HIAHInitActions();
-    [g_actions_lock lock];
-    NSValue *key = [NSValue valueWithPointer:fa];
-    if (!g_actions_map[key]) g_actions_map[key] = [NSMutableArray array];
-    
-    HIAHAction *a = calloc(1, sizeof(HIAHAction));
-    a->type = HIAHActionDup2;
-    a->fd = fd;
-    a->new_fd = new_fd;
-    [g_actions_map[key] addObject:[NSValue valueWithPointer:a]];
-    NSLog(@"[HIAHHook] Captured file action: dup2(%d, %d)", fd, new_fd);
-    [g_actions_lock unlock];
+    // Spawns that go to the real posix_spawn need the action regardless;
+    // only in-process guests lose it when it can't be recorded
+    HIAHAction a = { .type = HIAHActionDup2, .fd = fd, .new_fd = new_fd };
+    if (HIAHFileActionsAppend(fa, &a) != 0) {
+        NSLog(@"[HIAHHook] File actions table full, dup2(%d, %d) not recorded", fd, new_fd);
+    }
     
     return ORIG_FUNC(posix_spawn_file_actions_adddup2)(fa, fd, new_fd);
 }
 
 DEFINE_HOOK(posix_spawn_file_actions_addclose, int, (posix_spawn_file_actions_t *fa, int fd)) {
-    HIAHInitActions();
-    [g_actions_lock lock];
-    NSValue *key = [NSValue valueWithPointer:fa];
-    if (!g_actions_map[key]) g_actions_map[key] = [NSMutableArray array];
-    
-    HIAHAction *a = calloc(1, sizeof(HIAHAction));
-    a->type = HIAHActionClose;
-    a->fd = fd;
-    [g_actions_map[key] addObject:[NSValue valueWithPointer:a]];
-    [g_actions_lock unlock];
+    HIAHAction a = { .type = HIAHActionClose, .fd = fd };
+    if (HIAHFileActionsAppend(fa, &a) != 0) {
+        NSLog(@"[HIAHHook] File actions table full, close(%d) not recorded", fd);
+    }
     
     return ORIG_FUNC(posix_spawn_file_actions_addclose)(fa, fd);
 }
 
+// init/destroy bracket an object's lifetime: drop its record so the table
+// doesn't grow and a reused stack address doesn't inherit stale actions
+DEFINE_HOOK(posix_spawn_file_actions_init, int, (posix_spawn_file_actions_t *fa)) {
+    HIAHFileActionsRemove(fa);
+    return ORIG_FUNC(posix_spawn_file_actions_init)(fa);
+}
+
+DEFINE_HOOK(posix_spawn_file_actions_destroy, int, (posix_spawn_file_actions_t *fa)) {
+    HIAHFileActionsRemove(fa);
+    return ORIG_FUNC(posix_spawn_file_actions_destroy)(fa);
+}
+
 #pragma mark - Forward Declarations
 
 static void *HIAHGuestThread(void *data);
+static int HIAHStartGuestThread(HIAHThreadArgs *targs, char *const envp[], pid_t *pid);
 static int HIAHForwardSpawn(pid_t *pid, const char *path, char *const argv[], char *const envp[]);
+static int HIAHForwardSpawnRequest(pid_t *pid, const char *path, char *const argv[], char *const envp[]);
 static int HIAHInProcessSpawn(pid_t *pid, const char *path,
                               const posix_spawn_file_actions_t *file_actions,
                               const posix_spawnattr_t *attr,
@@ -138,15 +126,36 @@ DEFINE_HOOK(posix_spawn, int, (pid_t * __restrict pid, const char * __restrict p
 DEFINE_HOOK(execve, int, (const char *path, char *const argv[], char *const envp[]));
 DEFINE_HOOK(waitpid, pid_t, (pid_t pid, int *stat_loc, int options));
 
+static int HIAHPosixSpawn(pid_t * __restrict pid, const char * __restrict path,
+                          const posix_spawn_file_actions_t * __restrict file_actions,
+                          const posix_spawnattr_t * __restrict attr,
+                          char *const argv[ __restrict], char *const envp[ __restrict]);
+
 static int hook_posix_spawn(pid_t * __restrict pid, const char * __restrict path,
                             const posix_spawn_file_actions_t * __restrict file_actions,
                             const posix_spawnattr_t * __restrict attr,
                             char *const argv[ __restrict], char *const envp[ __restrict]) {
     
-    if (gInHook || getenv("HIAH_NO_HOOKS")) {
+    if (gInHook) {
+        HIAHHookStatsCount(HIAHHookStatPosixSpawn, HIAHHookCounterReentrant);
+        return ORIG_FUNC(posix_spawn)(pid, path, file_actions, attr, argv, envp);
+    }
+    if (getenv("HIAH_NO_HOOKS")) {
+        HIAHHookStatsCount(HIAHHookStatPosixSpawn, HIAHHookCounterDisabled);
         return ORIG_FUNC(posix_spawn)(pid, path, file_actions, attr, argv, envp);
     }
     
+    uint64_t start = HIAHHookStatsBegin(HIAHHookStatPosixSpawn);
+    int result = HIAHPosixSpawn(pid, path, file_actions, attr, argv, envp);
+    HIAHHookStatsEnd(HIAHHookStatPosixSpawn, start, result != 0);
+    return result;
+}
+
+static int HIAHPosixSpawn(pid_t * __restrict pid, const char * __restrict path,
+                          const posix_spawn_file_actions_t * __restrict file_actions,
+                          const posix_spawnattr_t * __restrict attr,
+                          char *const argv[ __restrict], char *const envp[ __restrict]) {
+    
     // Skip system binaries to avoid recursion
     if (path && (strncmp(path, "/usr/bin/", 9) == 0 || 
                  strncmp(path, "/bin/", 5) == 0 ||
@@ -192,26 +201,16 @@ static int hook_posix_spawn(pid_t * __restrict pid, const char * __restrict path
             for (int i = 0; i < argc; i++) targs->argv[i] = strdup(argv[i]);
             targs->argv[argc] = NULL;
             
-            HIAHInitActions();
-            [g_actions_lock lock];
-            NSValue *key = [NSValue valueWithPointer:file_actions];
-            if (g_actions_map[key]) {
-                targs->actions = [g_actions_map[key] copy];
-            }
-            [g_actions_lock unlock];
+            targs->actionCount = HIAHFileActionsCopy(file_actions, &targs->actions);
             
-            pthread_t thread;
-            if (pthread_create(&thread, NULL, HIAHGuestThread, targs) != 0) {
+            pid_t vpid = 0;
+            if (HIAHStartGuestThread(targs, envp, &vpid) != 0) {
                 gInHook = NO;
                 return EAGAIN;
             }
             
-            #pragma clang diagnostic push
-            #pragma clang diagnostic ignored "-Wint-to-pointer-cast"
-            #pragma clang diagnostic ignored "-Wpointer-to-int-cast"
-            if (pid) *pid = (pid_t)(uintptr_t)thread;
-            #pragma clang diagnostic pop
-            NSLog(@"[HIAHHook] SSH started in thread (pseudo-PID: %lu)", (unsigned long)thread);
+            if (pid) *pid = vpid;
+            NSLog(@"[HIAHHook] SSH started in thread (virtual PID: %d)", vpid);
             gInHook = NO;
             return 0;
         }
@@ -244,10 +243,17 @@ static int hook_posix_spawn(pid_t * __restrict pid, const char * __restrict path
 }
 
 static int hook_execve(const char *path, char *const argv[], char *const envp[]) {
-    if (gInHook || getenv("HIAH_NO_HOOKS")) {
+    if (gInHook) {
+        HIAHHookStatsCount(HIAHHookStatExecve, HIAHHookCounterReentrant);
+        return ORIG_FUNC(execve)(path, argv, envp);
+    }
+    if (getenv("HIAH_NO_HOOKS")) {
+        HIAHHookStatsCount(HIAHHookStatExecve, HIAHHookCounterDisabled);
         return ORIG_FUNC(execve)(path, argv, envp);
     }
 
+    // Successful paths never return, so they record before leaving
+    uint64_t start = HIAHHookStatsBegin(HIAHHookStatExecve);
     gInHook = YES;
     NSLog(@"[HIAHHook] Intercepted execve: %s", path);
 
@@ -303,6 +309,7 @@ static int hook_execve(const char *path, char *const argv[], char *const envp[])
         free(mergedEnvp);
         
         if (spawnResult == 0) {
+            HIAHHookStatsEnd(HIAHHookStatExecve, start, false);
             int status = 0;
             ORIG_FUNC(waitpid)(sshPid, &status, 0);
             int exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : 1;
@@ -310,6 +317,7 @@ static int hook_execve(const char *path, char *const argv[], char *const envp[])
         }
         
         gInHook = NO;
+        HIAHHookStatsEnd(HIAHHookStatExecve, start, true);
         errno = spawnResult;
         return -1;
     }
@@ -318,48 +326,181 @@ static int hook_execve(const char *path, char *const argv[], char *const envp[])
     pid_t pid;
     int result = HIAHForwardSpawn(&pid, path, (char *const *)argv, (char *const *)envp);
     if (result == 0) {
+        HIAHHookStatsEnd(HIAHHookStatExecve, start, false);
         exit(0);
     }
 
+    // The real execve only returns if it failed
     gInHook = NO;
-    return ORIG_FUNC(execve)(path, argv, envp);
+    int execResult = ORIG_FUNC(execve)(path, argv, envp);
+    int execErrno = errno;
+    HIAHHookStatsEnd(HIAHHookStatExecve, start, true);
+    errno = execErrno;
+    return execResult;
+}
+
+// Real children can only be polled, so while the caller has both kinds the
+// virtual wait wakes up this often to check on them
+#define HIAH_MIXED_WAIT_POLL_MS 10
+
+static pid_t HIAHWaitAnyChild(pid_t pid, int *stat_loc, int options) {
+    for (;;) {
+        pid_t real = ORIG_FUNC(waitpid)(pid, stat_loc, options | WNOHANG);
+        if (real > 0) return real;
+        BOOL hasReal = (real == 0);
+        
+        uint32_t timeoutMs = (hasReal && !(options & WNOHANG)) ? HIAH_MIXED_WAIT_POLL_MS : 0;
+        pid_t result = HIAHChildTableWaitTimeout(pid, stat_loc, options, timeoutMs);
+        if (result < 0 && errno == ECHILD && hasReal) {
+            // The virtual children are gone; only real ones are left
+            return ORIG_FUNC(waitpid)(pid, stat_loc, options);
+        }
+        if (result != 0 || (options & WNOHANG)) return result;
+    }
 }
 
 static pid_t hook_waitpid(pid_t pid, int *stat_loc, int options) {
-    if (gInHook || getenv("HIAH_NO_HOOKS")) {
+    if (gInHook) {
+        HIAHHookStatsCount(HIAHHookStatWaitpid, HIAHHookCounterReentrant);
         return ORIG_FUNC(waitpid)(pid, stat_loc, options);
     }
+    if (getenv("HIAH_NO_HOOKS")) {
+        HIAHHookStatsCount(HIAHHookStatWaitpid, HIAHHookCounterDisabled);
+        return ORIG_FUNC(waitpid)(pid, stat_loc, options);
+    }
+    
+    // Latency includes time blocked waiting for the child
+    uint64_t start = HIAHHookStatsBegin(HIAHHookStatWaitpid);
+    pid_t result;
     
-    // Handle thread-based pseudo-PIDs
-    if (pid > 100000) {
-        #pragma clang diagnostic push
-        #pragma clang diagnostic ignored "-Wint-to-pointer-cast"
-        pthread_t thread = (pthread_t)(uintptr_t)pid;
-        #pragma clang diagnostic pop
-        if (options & WNOHANG) return 0;
-        pthread_join(thread, NULL);
-        if (stat_loc) *stat_loc = 0;
-        return pid;
+    // Thread-hosted guests are waited on through the virtual child table.
+    // Specific PIDs are routed by range; "any child" waits cover both the
+    // virtual children and any real ones.
+    if (pid > 0) {
+        result = HIAHChildTableIsVirtualPID(pid) ? HIAHChildTableWait(pid, stat_loc, options)
+                                                 : ORIG_FUNC(waitpid)(pid, stat_loc, options);
+    } else if (!HIAHChildTableHasChildren()) {
+        result = ORIG_FUNC(waitpid)(pid, stat_loc, options);
+    } else {
+        result = HIAHWaitAnyChild(pid, stat_loc, options);
     }
     
-    return ORIG_FUNC(waitpid)(pid, stat_loc, options);
+    HIAHHookStatsEnd(HIAHHookStatWaitpid, start, result < 0);
+    return result;
+}
+
+#pragma mark - Signals
+
+DEFINE_HOOK(kill, int, (pid_t pid, int sig));
+
+/**
+ * Thread-hosted guests have no process to signal. Job-control signals are
+ * recorded in the child table so the parent's waitpid() sees them; other
+ * signals fail as they did before.
+ */
+static int hook_kill(pid_t pid, int sig) {
+    if (gInHook || !HIAHChildTableIsVirtualPID(pid)) {
+        return ORIG_FUNC(kill)(pid, sig);
+    }
+    
+    bool found;
+    switch (sig) {
+        case SIGSTOP:
+        case SIGTSTP:
+        case SIGTTIN:
+        case SIGTTOU:
+            found = HIAHChildTableStop(pid, sig);
+            break;
+        case SIGCONT:
+            found = HIAHChildTableContinue(pid);
+            break;
+        case 0:
+            found = HIAHChildTableExists(pid);
+            break;
+        default:
+            return ORIG_FUNC(kill)(pid, sig);
+    }
+    if (!found) {
+        errno = ESRCH;
+        return -1;
+    }
+    return 0;
+}
+
+#pragma mark - Guest Exit
+
+typedef void (*exit_t)(int);
+
+DEFINE_HOOK(exit, void, (int status));
+DEFINE_HOOK(_exit, void, (int status));
+
+static __thread HIAHThreadArgs *gCurrentGuest = NULL;
+
+/**
+ * exit() from a thread-hosted guest must end only that guest, not the host.
+ * Record the status and unwind the thread; HIAHGuestThreadFinish reports it.
+ */
+static void HIAHExitGuestThread(int status) {
+    gCurrentGuest->exitCode = status;
+    pthread_exit(NULL);
+}
+
+static void hook_exit(int status) {
+    if (gCurrentGuest) {
+        fflush(stdout);
+        fflush(stderr);
+        HIAHExitGuestThread(status);
+    }
+    ORIG_FUNC(exit)(status);
+    __builtin_unreachable();
+}
+
+static void hook__exit(int status) {
+    if (gCurrentGuest) {
+        HIAHExitGuestThread(status);
+    }
+    ORIG_FUNC(_exit)(status);
+    __builtin_unreachable();
 }
 
 #pragma mark - In-Process Thread Spawning
 
+static void HIAHGuestThreadFinish(void *data) {
+    HIAHThreadArgs *args = (HIAHThreadArgs *)data;
+    fflush(stdout);
+    fflush(stderr);
+    gCurrentGuest = NULL;
+    
+    NSLog(@"[HIAHHook] Guest %d finished: %d", args->vpid, args->exitCode);
+    HIAHImageCacheRelease(args->image);
+    HIAHChildTableExit(args->vpid, args->exitCode);
+    
+    for (int i = 0; i < args->argc; i++) free(args->argv[i]);
+    free(args->argv);
+    free(args->actions);
+    free(args->path);
+    free(args);
+}
+
 static void *HIAHGuestThread(void *data) {
     HIAHThreadArgs *args = (HIAHThreadArgs *)data;
-    NSLog(@"[HIAHHook] Guest thread started: %s", args->path);
+    NSLog(@"[HIAHHook] Guest thread started: %s (virtual PID %d)", args->path, args->vpid);
+    
+    HIAHChildTableAttachThread(args->vpid);
+    gCurrentGuest = args;
+    // Runs on return and on pthread_exit() from the exit() hooks
+    pthread_cleanup_push(HIAHGuestThreadFinish, args);
+    
+    // Command-not-found status unless the entry point says otherwise
+    args->exitCode = 127;
     
     // Apply file actions
-    if (args->actions && args->actions.count > 0) {
-        for (NSValue *val in args->actions) {
-            HIAHAction *a = [val pointerValue];
-            if (a->type == HIAHActionDup2) {
-                dup2(a->fd, a->new_fd);
-            } else if (a->type == HIAHActionClose) {
-                close(a->fd);
-            }
+    for (size_t i = 0; i < args->actionCount; i++) {
+        const HIAHAction *a = &args->actions[i];
+        if (a->type == HIAHActionDup2) {
+            dup2(a->fd, a->new_fd);
+        } else if (a->type == HIAHActionClose) {
+            close(a->fd);
         }
     }
     
@@ -371,33 +512,48 @@ static void *HIAHGuestThread(void *data) {
         setenv("SSHPASS", hiahPass, 1);
     }
     
-    void *handle = dlopen(args->path, RTLD_NOW | RTLD_GLOBAL);
-    if (!handle) {
-        NSLog(@"[HIAHHook] dlopen failed: %s", dlerror());
-        goto cleanup;
+    // Repeated spawns of the same tool reuse the loaded image and its
+    // resolved entry point
+    static const char *const entryNames[] = {
+        "ssh_main", "waypipe_main", "hello_entry", "main", NULL
+    };
+    args->image = HIAHImageCacheAcquire(args->path, entryNames);
+    if (!args->image) {
+        NSLog(@"[HIAHHook] dlopen failed: %s", dlerror() ?: "file not found");
+    } else {
+        HIAHImageEntryPoint entry = HIAHImageGetEntryPoint(args->image);
+        if (entry) {
+            NSLog(@"[HIAHHook] Calling entry point with %d args", args->argc);
+            fflush(stdout);
+            fflush(stderr);
+            args->exitCode = entry(args->argc, args->argv);
+        }
     }
     
-    int (*entry)(int, char **) = dlsym(handle, "ssh_main");
-    if (!entry) entry = dlsym(handle, "waypipe_main");
-    if (!entry) entry = dlsym(handle, "hello_entry");
-    if (!entry) entry = dlsym(handle, "main");
+    pthread_cleanup_pop(1);
+    return NULL;
+}
+
+/**
+ * Registers a virtual child and starts its guest thread.
+ * The thread is detached; its status is collected through waitpid().
+ */
+static int HIAHStartGuestThread(HIAHThreadArgs *targs, char *const envp[], pid_t *pid) {
+    targs->vpid = HIAHChildTableSpawn();
+    if (targs->vpid < 0) return -1;
+    
+    HIAHGuestThreadAttributes attrs;
+    HIAHGuestThreadAttributesInit(&attrs, targs->vpid, targs->argc > 0 ? targs->argv[0] : targs->path);
+    HIAHGuestThreadAttributesApplyEnvironment(&attrs, envp);
     
-    if (entry) {
-        NSLog(@"[HIAHHook] Calling entry point with %d args", args->argc);
-        fflush(stdout);
-        fflush(stderr);
-        int rc = entry(args->argc, args->argv);
-        fflush(stdout);
-        fflush(stderr);
-        NSLog(@"[HIAHHook] Guest thread finished: %d", rc);
+    int rc = HIAHGuestThreadLaunch(&attrs, HIAHGuestThread, targs);
+    if (rc != 0) {
+        HIAHChildTableAbandon(targs->vpid);
+        return -1;
     }
     
-cleanup:
-    for (int i = 0; i < args->argc; i++) free(args->argv[i]);
-    free(args->argv);
-    free(args->path);
-    free(args);
-    return NULL;
+    if (pid) *pid = targs->vpid;
+    return 0;
 }
 
 static int HIAHInProcessSpawn(pid_t *pid, const char *path,
@@ -413,30 +569,27 @@ static int HIAHInProcessSpawn(pid_t *pid, const char *path,
     for (int i = 0; i < argc; i++) targs->argv[i] = strdup(argv[i]);
     targs->argv[argc] = NULL;
     
-    HIAHInitActions();
-    [g_actions_lock lock];
-    NSValue *key = [NSValue valueWithPointer:file_actions];
-    if (g_actions_map[key]) {
-        targs->actions = [g_actions_map[key] copy];
-    }
-    [g_actions_lock unlock];
+    targs->actionCount = HIAHFileActionsCopy(file_actions, &targs->actions);
     
-    pthread_t thread;
-    if (pthread_create(&thread, NULL, HIAHGuestThread, targs) != 0) {
+    if (HIAHStartGuestThread(targs, envp, pid) != 0) {
+        for (int i = 0; i < argc; i++) free(targs->argv[i]);
+        free(targs->actions);
         free(targs->path);
         free(targs->argv);
         free(targs);
         return -1;
     }
-    #pragma clang diagnostic push
-    #pragma clang diagnostic ignored "-Wint-to-pointer-cast"
-    #pragma clang diagnostic ignored "-Wpointer-to-int-cast"
-    if (pid) *pid = (pid_t)(uintptr_t)thread;
-    #pragma clang diagnostic pop
     return 0;
 }
 
 static int HIAHForwardSpawn(pid_t *pid, const char *path, char *const argv[], char *const envp[]) {
+    uint64_t start = HIAHHookStatsBegin(HIAHHookStatForwardSpawn);
+    int result = HIAHForwardSpawnRequest(pid, path, argv, envp);
+    HIAHHookStatsEnd(HIAHHookStatForwardSpawn, start, result != 0);
+    return result;
+}
+
+static int HIAHForwardSpawnRequest(pid_t *pid, const char *path, char *const argv[], char *const envp[]) {
     const char *kernelSocketPath = getenv("HIAH_KERNEL_SOCKET");
     if (!kernelSocketPath) return -1;
 
@@ -504,7 +657,10 @@ static int HIAHForwardSpawn(pid_t *pid, const char *path, char *const argv[], ch
 void HIAHInstallHooks(void) {
     static dispatch_once_t onceToken;
     dispatch_once(&onceToken, ^{
-        HIAHInitActions();
+        const char *stats = getenv("HIAH_HOOK_STATS");
+        if (stats && strcmp(stats, "0") != 0) {
+            HIAHHookStatsSetEnabled(true);
+        }
         
         // Initialize original function pointers
         orig_posix_spawn = dlsym(RTLD_DEFAULT, "posix_spawn");
@@ -512,6 +668,11 @@ void HIAHInstallHooks(void) {
         orig_waitpid = dlsym(RTLD_DEFAULT, "waitpid");
         orig_posix_spawn_file_actions_adddup2 = dlsym(RTLD_DEFAULT, "posix_spawn_file_actions_adddup2");
         orig_posix_spawn_file_actions_addclose = dlsym(RTLD_DEFAULT, "posix_spawn_file_actions_addclose");
+        orig_posix_spawn_file_actions_init = dlsym(RTLD_DEFAULT, "posix_spawn_file_actions_init");
+        orig_posix_spawn_file_actions_destroy = dlsym(RTLD_DEFAULT, "posix_spawn_file_actions_destroy");
+        orig_kill = dlsym(RTLD_DEFAULT, "kill");
+        orig_exit = dlsym(RTLD_DEFAULT, "exit");
+        orig__exit = dlsym(RTLD_DEFAULT, "_exit");
         
         // Install hooks
         if (orig_posix_spawn) {
@@ -529,6 +690,21 @@ void HIAHInstallHooks(void) {
         if (orig_posix_spawn_file_actions_addclose) {
             HIAHHookIntercept(HIAHHookScopeGlobal, NULL, orig_posix_spawn_file_actions_addclose, hook_posix_spawn_file_actions_addclose);
         }
+        if (orig_posix_spawn_file_actions_init) {
+            HIAHHookIntercept(HIAHHookScopeGlobal, NULL, orig_posix_spawn_file_actions_init, hook_posix_spawn_file_actions_init);
+        }
+        if (orig_posix_spawn_file_actions_destroy) {
+            HIAHHookIntercept(HIAHHookScopeGlobal, NULL, orig_posix_spawn_file_actions_destroy, hook_posix_spawn_file_actions_destroy);
+        }
+        if (orig_kill) {
+            HIAHHookIntercept(HIAHHookScopeGlobal, NULL, orig_kill, hook_kill);
+        }
+        if (orig_exit) {
+            HIAHHookIntercept(HIAHHookScopeGlobal, NULL, orig_exit, hook_exit);
+        }
+        if (orig__exit) {
+            HIAHHookIntercept(HIAHHookScopeGlobal, NULL, orig__exit, hook__exit);
+        }
         
         g_hooksInstalled = YES;
         NSLog(@"[HIAHKernel] Virtual kernel hooks installed");
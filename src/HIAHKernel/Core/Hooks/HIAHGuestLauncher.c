@@ -0,0 +1,120 @@
+/**
+ * HIAHGuestLauncher.c
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Guest thread launcher implementation.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#include "HIAHGuestLauncher.h"
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef struct {
+    void *(*body)(void *);
+    void *context;
+    char name[64];              // MAXTHREADNAMESIZE
+} HIAHGuestTrampoline;
+
+void HIAHGuestThreadAttributesInit(HIAHGuestThreadAttributes *attrs, pid_t vpid, const char *name) {
+    memset(attrs, 0, sizeof(*attrs));
+    attrs->stackSize = HIAH_GUEST_DEFAULT_STACK_SIZE;
+    attrs->qosClass = QOS_CLASS_DEFAULT;
+    attrs->relativePriority = 0;
+    attrs->vpid = vpid;
+    attrs->name = name;
+}
+
+static const char *HIAHEnvValue(char *const envp[], const char *key) {
+    size_t keyLength = strlen(key);
+    for (int i = 0; envp && envp[i]; i++) {
+        if (strncmp(envp[i], key, keyLength) == 0 && envp[i][keyLength] == '=') {
+            return envp[i] + keyLength + 1;
+        }
+    }
+    return NULL;
+}
+
+static size_t HIAHParseSize(const char *value) {
+    char *end = NULL;
+    unsigned long long size = strtoull(value, &end, 10);
+    if (end == value) return 0;
+    if (*end == 'K' || *end == 'k') size *= 1024;
+    else if (*end == 'M' || *end == 'm') size *= 1024 * 1024;
+    return (size_t)size;
+}
+
+static qos_class_t HIAHParseQoS(const char *value) {
+    if (strcmp(value, "user-interactive") == 0) return QOS_CLASS_USER_INTERACTIVE;
+    if (strcmp(value, "user-initiated") == 0) return QOS_CLASS_USER_INITIATED;
+    if (strcmp(value, "default") == 0) return QOS_CLASS_DEFAULT;
+    if (strcmp(value, "utility") == 0) return QOS_CLASS_UTILITY;
+    if (strcmp(value, "background") == 0) return QOS_CLASS_BACKGROUND;
+    return QOS_CLASS_UNSPECIFIED;
+}
+
+void HIAHGuestThreadAttributesApplyEnvironment(HIAHGuestThreadAttributes *attrs, char *const envp[]) {
+    const char *value;
+
+    if ((value = HIAHEnvValue(envp, "HIAH_GUEST_STACK_SIZE"))) {
+        size_t size = HIAHParseSize(value);
+        if (size > 0) attrs->stackSize = size;
+    }
+    if ((value = HIAHEnvValue(envp, "HIAH_GUEST_QOS"))) {
+        qos_class_t qos = HIAHParseQoS(value);
+        if (qos != QOS_CLASS_UNSPECIFIED) attrs->qosClass = qos;
+    }
+    if ((value = HIAHEnvValue(envp, "HIAH_GUEST_PRIORITY"))) {
+        int priority = atoi(value);
+        if (priority <= 0 && priority >= QOS_MIN_RELATIVE_PRIORITY) attrs->relativePriority = priority;
+    }
+}
+
+static void *HIAHGuestTrampolineMain(void *data) {
+    HIAHGuestTrampoline trampoline = *(HIAHGuestTrampoline *)data;
+    free(data);
+
+    // Darwin only allows naming the calling thread
+    pthread_setname_np(trampoline.name);
+    return trampoline.body(trampoline.context);
+}
+
+int HIAHGuestThreadLaunch(const HIAHGuestThreadAttributes *attrs,
+                          void *(*body)(void *),
+                          void *context) {
+    HIAHGuestTrampoline *trampoline = calloc(1, sizeof(HIAHGuestTrampoline));
+    if (!trampoline) return ENOMEM;
+    trampoline->body = body;
+    trampoline->context = context;
+
+    const char *tool = attrs->name ? strrchr(attrs->name, '/') : NULL;
+    tool = tool ? tool + 1 : (attrs->name ?: "guest");
+    snprintf(trampoline->name, sizeof(trampoline->name), "hiah.guest.%d %s", attrs->vpid, tool);
+
+    // Stack sizes must be page multiples and at least PTHREAD_STACK_MIN
+    size_t pageSize = (size_t)getpagesize();
+    size_t stackSize = attrs->stackSize ? attrs->stackSize : HIAH_GUEST_DEFAULT_STACK_SIZE;
+    if (stackSize < PTHREAD_STACK_MIN) stackSize = PTHREAD_STACK_MIN;
+    stackSize = (stackSize + pageSize - 1) & ~(pageSize - 1);
+
+    qos_class_t qos = attrs->qosClass != QOS_CLASS_UNSPECIFIED ? attrs->qosClass : QOS_CLASS_DEFAULT;
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_attr_setstacksize(&attr, stackSize);
+    pthread_attr_set_qos_class_np(&attr, qos, attrs->relativePriority);
+
+    pthread_t thread;
+    int rc = pthread_create(&thread, &attr, HIAHGuestTrampolineMain, trampoline);
+    pthread_attr_destroy(&attr);
+    if (rc != 0) free(trampoline);
+    return rc;
+}
@@ -0,0 +1,72 @@
+/**
+ * HIAHGuestLauncher.h
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Dedicated execution threads for in-process guests.
+ *
+ * A guest's main() can run for the lifetime of the session and may recurse
+ * deeply, so it gets its own pthread instead of a GCD worker: an 8 MB stack
+ * like a real main thread (secondary threads default to 512 KB), an
+ * explicit QoS class and relative priority, and a name carrying its virtual
+ * PID ("hiah.guest.<vpid> <tool>") so it is identifiable in crash logs and
+ * the debugger. Both the kernel spawn path and the posix_spawn hooks launch
+ * guests through here.
+ *
+ * Per-spawn overrides come from the guest's environment:
+ *   HIAH_GUEST_STACK_SIZE  bytes, with optional K/M suffix (e.g. "16M")
+ *   HIAH_GUEST_QOS         user-interactive | user-initiated | default |
+ *                          utility | background
+ *   HIAH_GUEST_PRIORITY    relative priority within the QoS class (-15...0)
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#ifndef HIAH_GUEST_LAUNCHER_H
+#define HIAH_GUEST_LAUNCHER_H
+
+#include <pthread/qos.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Stack size of a process main thread on iOS/macOS
+#define HIAH_GUEST_DEFAULT_STACK_SIZE (8u * 1024 * 1024)
+
+typedef struct {
+    size_t stackSize;           // 0 uses HIAH_GUEST_DEFAULT_STACK_SIZE
+    qos_class_t qosClass;       // QOS_CLASS_UNSPECIFIED uses QOS_CLASS_DEFAULT
+    int relativePriority;       // 0 or negative, down to QOS_MIN_RELATIVE_PRIORITY
+    pid_t vpid;                 // Virtual PID shown in the thread name
+    const char *name;           // Tool path or name; last component is used
+} HIAHGuestThreadAttributes;
+
+/**
+ * Fills `attrs` with defaults for virtual process `vpid` running `name`.
+ */
+void HIAHGuestThreadAttributesInit(HIAHGuestThreadAttributes *attrs, pid_t vpid, const char *name);
+
+/**
+ * Applies HIAH_GUEST_* overrides from a NULL-terminated envp array.
+ */
+void HIAHGuestThreadAttributesApplyEnvironment(HIAHGuestThreadAttributes *attrs, char *const envp[]);
+
+/**
+ * Starts `body(context)` on a new detached guest thread.
+ *
+ * The thread is named before `body` runs.
+ *
+ * @return 0 on success or an errno value from pthread_create.
+ */
+int HIAHGuestThreadLaunch(const HIAHGuestThreadAttributes *attrs,
+                          void *(*body)(void *),
+                          void *context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HIAH_GUEST_LAUNCHER_H */
@@ -0,0 +1,444 @@
+/**
+ * HIAHHookStats.c
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Hook instrumentation implementation.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#include "HIAHHookStats.h"
+#include "HIAHChildTable.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <mach/mach_time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef struct HIAHHookThreadStats {
+    pid_t vpid;
+    // Reset generation the counters belong to. Only the owner clears its
+    // block (when this falls behind g_generation); readers skip stale blocks.
+    _Atomic(uint32_t) generation;
+    // Single writer (the owning thread); readers sum with relaxed loads
+    _Atomic(uint64_t) counters[HIAHHookStatCount][HIAHHookCounterCount];
+    _Atomic(uint64_t) histogram[HIAHHookStatCount][HIAH_HOOK_STATS_BUCKETS];
+    _Atomic(uint64_t) totalNs[HIAHHookStatCount];
+    _Atomic(uint64_t) maxNs[HIAHHookStatCount];
+    struct HIAHHookThreadStats *next;
+} HIAHHookThreadStats;
+
+static _Atomic(bool) g_enabled = false;
+static _Atomic(uint32_t) g_generation = 0;
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static HIAHHookThreadStats *g_threads = NULL;
+static HIAHHookStatsEntry g_retired[HIAHHookStatCount];
+static pthread_key_t g_key;
+static pthread_once_t g_keyOnce = PTHREAD_ONCE_INIT;
+static mach_timebase_info_data_t g_timebase;
+static __thread HIAHHookThreadStats *t_stats = NULL;
+
+#pragma mark - Per-Thread Blocks
+
+static inline uint64_t HIAHLoad(_Atomic(uint64_t) *value) {
+    return atomic_load_explicit(value, memory_order_relaxed);
+}
+
+static inline void HIAHAdd(_Atomic(uint64_t) *value, uint64_t delta) {
+    // Single writer: a plain load/store pair avoids a locked RMW
+    atomic_store_explicit(value, HIAHLoad(value) + delta, memory_order_relaxed);
+}
+
+static bool HIAHIsCurrent(HIAHHookThreadStats *stats) {
+    return atomic_load_explicit(&stats->generation, memory_order_acquire) ==
+           atomic_load_explicit(&g_generation, memory_order_relaxed);
+}
+
+static void HIAHFoldEntry(HIAHHookStatsEntry *out, const HIAHHookStatsEntry *in) {
+    for (int c = 0; c < HIAHHookCounterCount; c++) out->counters[c] += in->counters[c];
+    for (int b = 0; b < HIAH_HOOK_STATS_BUCKETS; b++) out->histogram[b] += in->histogram[b];
+    out->totalNs += in->totalNs;
+    if (in->maxNs > out->maxNs) out->maxNs = in->maxNs;
+}
+
+// g_lock held
+static void HIAHFold(HIAHHookStatsEntry *out, HIAHHookThreadStats *stats) {
+    if (!HIAHIsCurrent(stats)) return;
+    for (int s = 0; s < HIAHHookStatCount; s++) {
+        for (int c = 0; c < HIAHHookCounterCount; c++) {
+            out[s].counters[c] += HIAHLoad(&stats->counters[s][c]);
+        }
+        for (int b = 0; b < HIAH_HOOK_STATS_BUCKETS; b++) {
+            out[s].histogram[b] += HIAHLoad(&stats->histogram[s][b]);
+        }
+        out[s].totalNs += HIAHLoad(&stats->totalNs[s]);
+        uint64_t max = HIAHLoad(&stats->maxNs[s]);
+        if (max > out[s].maxNs) out[s].maxNs = max;
+    }
+}
+
+// TSD destructor, run on the exiting thread
+static void HIAHRetireThreadStats(void *data) {
+    HIAHHookThreadStats *stats = data;
+    // Hooks hit by later destructors on this thread allocate a fresh block
+    // (and re-arm the key) instead of writing to the freed one
+    t_stats = NULL;
+
+    pthread_mutex_lock(&g_lock);
+    HIAHFold(g_retired, stats);
+    for (HIAHHookThreadStats **it = &g_threads; *it; it = &(*it)->next) {
+        if (*it == stats) {
+            *it = stats->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_lock);
+
+    free(stats);
+}
+
+static void HIAHCreateKey(void) {
+    pthread_key_create(&g_key, HIAHRetireThreadStats);
+    mach_timebase_info(&g_timebase);
+}
+
+static HIAHHookThreadStats *HIAHThreadStats(void) {
+    if (t_stats) return t_stats;
+
+    pthread_once(&g_keyOnce, HIAHCreateKey);
+    HIAHHookThreadStats *stats = calloc(1, sizeof(HIAHHookThreadStats));
+    if (!stats) return NULL;
+    stats->vpid = HIAHChildTableCurrentPID();
+    atomic_store_explicit(&stats->generation, atomic_load(&g_generation), memory_order_relaxed);
+
+    pthread_mutex_lock(&g_lock);
+    stats->next = g_threads;
+    g_threads = stats;
+    pthread_mutex_unlock(&g_lock);
+
+    pthread_setspecific(g_key, stats);
+    t_stats = stats;
+    return stats;
+}
+
+// The owning thread's block, cleared first if a reset happened since its
+// last use
+static HIAHHookThreadStats *HIAHCurrentThreadStats(void) {
+    HIAHHookThreadStats *stats = HIAHThreadStats();
+    if (!stats) return NULL;
+
+    uint32_t generation = atomic_load_explicit(&g_generation, memory_order_acquire);
+    if (atomic_load_explicit(&stats->generation, memory_order_relaxed) != generation) {
+        for (int s = 0; s < HIAHHookStatCount; s++) {
+            for (int c = 0; c < HIAHHookCounterCount; c++) {
+                atomic_store_explicit(&stats->counters[s][c], 0, memory_order_relaxed);
+            }
+            for (int b = 0; b < HIAH_HOOK_STATS_BUCKETS; b++) {
+                atomic_store_explicit(&stats->histogram[s][b], 0, memory_order_relaxed);
+            }
+            atomic_store_explicit(&stats->totalNs[s], 0, memory_order_relaxed);
+            atomic_store_explicit(&stats->maxNs[s], 0, memory_order_relaxed);
+        }
+        atomic_store_explicit(&stats->generation, generation, memory_order_release);
+    }
+    return stats;
+}
+
+#pragma mark - Recording
+
+void HIAHHookStatsSetEnabled(bool enabled) {
+    pthread_once(&g_keyOnce, HIAHCreateKey);
+    atomic_store_explicit(&g_enabled, enabled, memory_order_relaxed);
+}
+
+bool HIAHHookStatsEnabled(void) {
+    return atomic_load_explicit(&g_enabled, memory_order_relaxed);
+}
+
+void HIAHHookStatsCount(HIAHHookStat stat, HIAHHookCounter counter) {
+    if (!HIAHHookStatsEnabled()) return;
+    HIAHHookThreadStats *stats = HIAHCurrentThreadStats();
+    if (stats) HIAHAdd(&stats->counters[stat][counter], 1);
+}
+
+uint64_t HIAHHookStatsBegin(HIAHHookStat stat) {
+    if (!HIAHHookStatsEnabled()) return 0;
+    HIAHHookThreadStats *stats = HIAHCurrentThreadStats();
+    if (!stats) return 0;
+    HIAHAdd(&stats->counters[stat][HIAHHookCounterCalls], 1);
+    return mach_absolute_time();
+}
+
+void HIAHHookStatsEnd(HIAHHookStat stat, uint64_t start, bool failed) {
+    if (start == 0) return;
+    uint64_t ns = (mach_absolute_time() - start) * g_timebase.numer / g_timebase.denom;
+
+    HIAHHookThreadStats *stats = t_stats;
+    if (!stats) return;
+
+    int bucket = ns ? 63 - __builtin_clzll(ns) : 0;
+    if (bucket >= HIAH_HOOK_STATS_BUCKETS) bucket = HIAH_HOOK_STATS_BUCKETS - 1;
+
+    HIAHAdd(&stats->histogram[stat][bucket], 1);
+    HIAHAdd(&stats->totalNs[stat], ns);
+    if (ns > HIAHLoad(&stats->maxNs[stat])) {
+        atomic_store_explicit(&stats->maxNs[stat], ns, memory_order_relaxed);
+    }
+    if (failed) HIAHAdd(&stats->counters[stat][HIAHHookCounterFailures], 1);
+}
+
+#pragma mark - Reading
+
+void HIAHHookStatsSnapshot(HIAHHookStatsEntry out[HIAHHookStatCount]) {
+    memset(out, 0, sizeof(HIAHHookStatsEntry) * HIAHHookStatCount);
+
+    pthread_mutex_lock(&g_lock);
+    memcpy(out, g_retired, sizeof(g_retired));
+    for (HIAHHookThreadStats *stats = g_threads; stats; stats = stats->next) {
+        HIAHFold(out, stats);
+    }
+    pthread_mutex_unlock(&g_lock);
+}
+
+size_t HIAHHookStatsGuestSpawns(HIAHHookGuestSpawns *out, size_t max) {
+    size_t count = 0;
+
+    pthread_mutex_lock(&g_lock);
+    for (HIAHHookThreadStats *stats = g_threads; stats; stats = stats->next) {
+        if (stats->vpid == 0 || !HIAHIsCurrent(stats)) continue;
+        uint64_t spawns = HIAHLoad(&stats->counters[HIAHHookStatPosixSpawn][HIAHHookCounterCalls]);
+        if (spawns == 0) continue;
+
+        // Insertion into a descending top-`max` list
+        size_t pos = count < max ? count : max;
+        while (pos > 0 && out[pos - 1].spawns < spawns) {
+            if (pos < max) out[pos] = out[pos - 1];
+            pos--;
+        }
+        if (pos < max) {
+            out[pos].vpid = stats->vpid;
+            out[pos].spawns = spawns;
+            if (count < max) count++;
+        }
+    }
+    pthread_mutex_unlock(&g_lock);
+
+    return count;
+}
+
+void HIAHHookStatsReset(void) {
+    // Zeroing live blocks here would race with their owners' load/store
+    // updates, so they are only marked stale and each owner clears its own
+    pthread_mutex_lock(&g_lock);
+    memset(g_retired, 0, sizeof(g_retired));
+    atomic_fetch_add_explicit(&g_generation, 1, memory_order_release);
+    pthread_mutex_unlock(&g_lock);
+}
+
+#pragma mark - Cross-Process Export
+
+#define HIAH_EXPORT_MAGIC 0x48485354u          // 'HHST'
+#define HIAH_EXPORT_WORDS (sizeof(HIAHHookStatsEntry) * HIAHHookStatCount / sizeof(uint64_t))
+#define HIAH_EXPORT_READ_RETRIES 32
+
+_Static_assert(sizeof(HIAHHookStatsEntry) % sizeof(uint64_t) == 0,
+               "entries are copied as 64-bit words");
+
+typedef struct {
+    _Atomic(uint32_t) magic;
+    _Atomic(int32_t) pid;
+    _Atomic(uint32_t) requestSeq;      // Bumped by a collector after filling in a request
+    _Atomic(int32_t) requestEnable;    // -1 leaves recording as it is
+    _Atomic(uint32_t) requestReset;    // Cleared by the owner when it resets
+    _Atomic(uint32_t) appliedSeq;      // Last request the owner has published for
+    _Atomic(uint32_t) sequence;        // Seqlock over words; odd while publishing
+    uint32_t reserved;
+    _Atomic(uint64_t) words[HIAH_EXPORT_WORDS];
+} HIAHHookStatsExportPage;
+
+static HIAHHookStatsExportPage *g_export = NULL;
+static pthread_mutex_t g_exportLock = PTHREAD_MUTEX_INITIALIZER;
+
+static HIAHHookStatsExportPage *HIAHMapExport(const char *path, bool create) {
+    int fd = open(path, create ? (O_RDWR | O_CREAT | O_CLOEXEC) : (O_RDWR | O_CLOEXEC), 0644);
+    if (fd < 0) return NULL;
+
+    // A new owner (possibly with a reused PID) starts from a zeroed page
+    if (create && (ftruncate(fd, 0) != 0 || ftruncate(fd, sizeof(HIAHHookStatsExportPage)) != 0)) {
+        close(fd);
+        return NULL;
+    }
+    void *map = mmap(NULL, sizeof(HIAHHookStatsExportPage), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return NULL;
+
+    HIAHHookStatsExportPage *page = map;
+    if (!create && atomic_load(&page->magic) != HIAH_EXPORT_MAGIC) {
+        munmap(map, sizeof(HIAHHookStatsExportPage));
+        return NULL;
+    }
+    return page;
+}
+
+static bool HIAHExportOwnerAlive(HIAHHookStatsExportPage *page) {
+    pid_t pid = atomic_load_explicit(&page->pid, memory_order_relaxed);
+    // EPERM means the process exists but is outside our sandbox's reach
+    return pid > 0 && (kill(pid, 0) == 0 || errno != ESRCH);
+}
+
+bool HIAHHookStatsExportOpen(const char *directory) {
+    pthread_mutex_lock(&g_exportLock);
+    if (!g_export) {
+        char path[PATH_MAX];
+        mkdir(directory, 0755);
+        snprintf(path, sizeof(path), "%s/%d.stats", directory, getpid());
+        HIAHHookStatsExportPage *page = HIAHMapExport(path, true);
+        if (page) {
+            atomic_store(&page->pid, getpid());
+            atomic_store(&page->requestEnable, -1);
+            atomic_store_explicit(&page->magic, HIAH_EXPORT_MAGIC, memory_order_release);
+            g_export = page;
+        }
+    }
+    bool opened = g_export != NULL;
+    pthread_mutex_unlock(&g_exportLock);
+    return opened;
+}
+
+void HIAHHookStatsExportPublish(void) {
+    pthread_mutex_lock(&g_exportLock);
+    HIAHHookStatsExportPage *page = g_export;
+    if (!page) {
+        pthread_mutex_unlock(&g_exportLock);
+        return;
+    }
+
+    uint32_t request = atomic_load_explicit(&page->requestSeq, memory_order_acquire);
+    int32_t enable = atomic_load_explicit(&page->requestEnable, memory_order_relaxed);
+    if (enable >= 0) HIAHHookStatsSetEnabled(enable != 0);
+
+    HIAHHookStatsEntry entries[HIAHHookStatCount];
+    HIAHHookStatsSnapshot(entries);
+    const uint64_t *words = (const uint64_t *)entries;
+
+    uint32_t sequence = atomic_load_explicit(&page->sequence, memory_order_relaxed);
+    atomic_store_explicit(&page->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    for (size_t i = 0; i < HIAH_EXPORT_WORDS; i++) {
+        atomic_store_explicit(&page->words[i], words[i], memory_order_relaxed);
+    }
+    atomic_store_explicit(&page->sequence, sequence + 2, memory_order_release);
+
+    // Reset after publishing, so the collector still sees this interval
+    if (atomic_exchange_explicit(&page->requestReset, 0, memory_order_relaxed)) {
+        HIAHHookStatsReset();
+    }
+    atomic_store_explicit(&page->appliedSeq, request, memory_order_release);
+    pthread_mutex_unlock(&g_exportLock);
+}
+
+void HIAHHookStatsRequestPublish(const char *directory, int enable, bool reset) {
+    DIR *dir = opendir(directory);
+    if (!dir) return;
+
+    struct dirent *ent;
+    while ((ent = readdir(dir))) {
+        if (!strstr(ent->d_name, ".stats")) continue;
+        char path[PATH_MAX];
+        snprintf(path, sizeof(path), "%s/%s", directory, ent->d_name);
+        HIAHHookStatsExportPage *page = HIAHMapExport(path, false);
+        if (!page) continue;
+
+        if (!HIAHExportOwnerAlive(page)) {
+            // A dead process's last numbers are kept until the next reset
+            if (reset) unlink(path);
+        } else {
+            atomic_store_explicit(&page->requestEnable, enable, memory_order_relaxed);
+            if (reset) atomic_store_explicit(&page->requestReset, 1, memory_order_relaxed);
+            atomic_fetch_add_explicit(&page->requestSeq, 1, memory_order_release);
+        }
+        munmap(page, sizeof(HIAHHookStatsExportPage));
+    }
+    closedir(dir);
+}
+
+static uint64_t HIAHMonotonicMs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+// Copies the published words, or fails if the owner keeps publishing
+static bool HIAHReadExport(HIAHHookStatsExportPage *page, HIAHHookStatsEntry out[HIAHHookStatCount]) {
+    uint64_t *words = (uint64_t *)out;
+    for (int attempt = 0; attempt < HIAH_EXPORT_READ_RETRIES; attempt++) {
+        uint32_t before = atomic_load_explicit(&page->sequence, memory_order_acquire);
+        if (before & 1) {
+            sched_yield();
+            continue;
+        }
+        for (size_t i = 0; i < HIAH_EXPORT_WORDS; i++) {
+            words[i] = atomic_load_explicit(&page->words[i], memory_order_relaxed);
+        }
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&page->sequence, memory_order_relaxed) == before) return true;
+    }
+    return false;
+}
+
+size_t HIAHHookStatsImport(const char *directory, uint32_t timeoutMs,
+                           HIAHHookStatsEntry out[HIAHHookStatCount]) {
+    memset(out, 0, sizeof(HIAHHookStatsEntry) * HIAHHookStatCount);
+    DIR *dir = opendir(directory);
+    if (!dir) return 0;
+
+    size_t processes = 0;
+    uint64_t deadline = HIAHMonotonicMs() + timeoutMs;
+    struct dirent *ent;
+    while ((ent = readdir(dir))) {
+        if (!strstr(ent->d_name, ".stats")) continue;
+        char path[PATH_MAX];
+        snprintf(path, sizeof(path), "%s/%s", directory, ent->d_name);
+        HIAHHookStatsExportPage *page = HIAHMapExport(path, false);
+        if (!page) continue;
+
+        // Give live owners until the deadline to answer the latest request
+        while (HIAHExportOwnerAlive(page) &&
+               atomic_load_explicit(&page->appliedSeq, memory_order_acquire) !=
+                   atomic_load_explicit(&page->requestSeq, memory_order_relaxed) &&
+               HIAHMonotonicMs() < deadline) {
+            usleep(2000);
+        }
+
+        HIAHHookStatsEntry entries[HIAHHookStatCount];
+        if (HIAHReadExport(page, entries)) {
+            for (int s = 0; s < HIAHHookStatCount; s++) HIAHFoldEntry(&out[s], &entries[s]);
+            processes++;
+        }
+        munmap(page, sizeof(HIAHHookStatsExportPage));
+    }
+    closedir(dir);
+    return processes;
+}
+
+const char *HIAHHookStatName(HIAHHookStat stat) {
+    switch (stat) {
+        case HIAHHookStatPosixSpawn:   return "posix_spawn";
+        case HIAHHookStatExecve:       return "execve";
+        case HIAHHookStatWaitpid:      return "waitpid";
+        case HIAHHookStatForwardSpawn: return "forward_spawn";
+        default:                       return "unknown";
+    }
+}
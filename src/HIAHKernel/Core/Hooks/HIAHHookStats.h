@@ -0,0 +1,154 @@
+/**
+ * HIAHHookStats.h
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Call counters and latency histograms for the virtual kernel hooks.
+ *
+ * Each thread that enters a hook gets its own counter block, so recording
+ * is a few uncontended relaxed stores; blocks are summed when a snapshot
+ * is taken and folded into a retired total when their thread exits.
+ * Latencies land in power-of-two nanosecond buckets. Recording is off
+ * until enabled (HIAH_HOOK_STATS=1 at hook install time, the kernel
+ * control socket's "hookstats" command, or HIAHHookStatsSetEnabled), and
+ * costs a single relaxed load per hook call while off.
+ *
+ * Processes other than the kernel's (the ProcessRunner extension) export
+ * their totals through a small page per process in the App Group. The
+ * kernel fills in a request (enable, reset) on each page, posts
+ * HIAH_HOOK_STATS_PUBLISH_NOTIFICATION, and the owners apply it and publish
+ * a fresh snapshot, so nothing runs in an extension between requests.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#ifndef HIAH_HOOK_STATS_H
+#define HIAH_HOOK_STATS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Instrumented operations
+ */
+typedef enum {
+    HIAHHookStatPosixSpawn = 0,
+    HIAHHookStatExecve,
+    HIAHHookStatWaitpid,
+    HIAHHookStatForwardSpawn,     // Round trip to the kernel control socket
+    HIAHHookStatCount
+} HIAHHookStat;
+
+/**
+ * Per-operation counters
+ */
+typedef enum {
+    HIAHHookCounterCalls = 0,     // Entries while recording was enabled
+    HIAHHookCounterReentrant,     // Fell through to the original (gInHook)
+    HIAHHookCounterDisabled,      // Fell through to the original (HIAH_NO_HOOKS)
+    HIAHHookCounterFailures,      // Returned an error
+    HIAHHookCounterCount
+} HIAHHookCounter;
+
+/// Bucket i counts latencies in [2^i, 2^(i+1)) ns; the last bucket is open-ended
+#define HIAH_HOOK_STATS_BUCKETS 32
+
+typedef struct {
+    uint64_t counters[HIAHHookCounterCount];
+    uint64_t histogram[HIAH_HOOK_STATS_BUCKETS];
+    uint64_t totalNs;
+    uint64_t maxNs;
+} HIAHHookStatsEntry;
+
+typedef struct {
+    pid_t vpid;                   // Guest virtual PID (0 for host threads)
+    uint64_t spawns;              // posix_spawn calls from that guest
+} HIAHHookGuestSpawns;
+
+void HIAHHookStatsSetEnabled(bool enabled);
+bool HIAHHookStatsEnabled(void);
+
+/**
+ * Counts a call to `stat` and returns a start timestamp, or 0 when
+ * recording is disabled.
+ */
+uint64_t HIAHHookStatsBegin(HIAHHookStat stat);
+
+/**
+ * Records the latency since `start` (no-op when `start` is 0).
+ */
+void HIAHHookStatsEnd(HIAHHookStat stat, uint64_t start, bool failed);
+
+/**
+ * Bumps a single counter (used for fall-through paths).
+ */
+void HIAHHookStatsCount(HIAHHookStat stat, HIAHHookCounter counter);
+
+/**
+ * Sums all live and retired thread blocks into `out[HIAHHookStatCount]`.
+ */
+void HIAHHookStatsSnapshot(HIAHHookStatsEntry out[HIAHHookStatCount]);
+
+/**
+ * Reports posix_spawn counts per live guest thread, busiest first.
+ *
+ * @return Number of entries written (at most `max`).
+ */
+size_t HIAHHookStatsGuestSpawns(HIAHHookGuestSpawns *out, size_t max);
+
+/**
+ * Clears all counters and histograms. Live threads' blocks are cleared by
+ * their owners on next use and read as empty until then.
+ */
+void HIAHHookStatsReset(void);
+
+/// Directory inside the App Group container holding exported pages
+#define HIAH_HOOK_STATS_EXPORT_DIR "HookStats"
+
+/// Darwin notification asking exporting processes to publish
+#define HIAH_HOOK_STATS_PUBLISH_NOTIFICATION "com.aspauldingcode.HIAHDesktop.HookStatsPublish"
+
+/**
+ * Creates this process's page in `directory` (created if needed).
+ */
+bool HIAHHookStatsExportOpen(const char *directory);
+
+/**
+ * Applies the pending request on this process's page and publishes a
+ * snapshot (a requested reset happens after publishing). No-op without a
+ * page.
+ */
+void HIAHHookStatsExportPublish(void);
+
+/**
+ * Files a request on every live page in `directory`: `enable` is 1, 0, or
+ * -1 to leave recording as it is. A reset also removes pages of processes
+ * that have exited. Post HIAH_HOOK_STATS_PUBLISH_NOTIFICATION afterwards.
+ */
+void HIAHHookStatsRequestPublish(const char *directory, int enable, bool reset);
+
+/**
+ * Sums the published pages in `directory` into `out`, waiting up to
+ * `timeoutMs` in total for live owners to answer the latest request.
+ *
+ * @return Number of processes included.
+ */
+size_t HIAHHookStatsImport(const char *directory, uint32_t timeoutMs,
+                           HIAHHookStatsEntry out[HIAHHookStatCount]);
+
+/**
+ * Short name of `stat` ("posix_spawn", "execve", ...).
+ */
+const char *HIAHHookStatName(HIAHHookStat stat);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HIAH_HOOK_STATS_H */
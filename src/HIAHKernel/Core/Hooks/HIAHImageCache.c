@@ -0,0 +1,164 @@
+/**
+ * HIAHImageCache.c
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Loaded-image cache implementation.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#include "HIAHImageCache.h"
+#include "HIAHPrefetch.h"
+#include <dlfcn.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+struct HIAHImage {
+    char *path;
+    dev_t dev;
+    ino_t ino;
+    struct timespec mtime;
+    void *handle;
+    HIAHImageEntryPoint entry;
+    unsigned refcount;
+    bool stale;                 // Superseded by a newer file at the same path
+    struct HIAHImage *next;
+};
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static HIAHImage *g_images = NULL;
+
+static struct timespec HIAHImageMtime(const struct stat *st) {
+#ifdef __APPLE__
+    return st->st_mtimespec;
+#else
+    return st->st_mtim;
+#endif
+}
+
+static bool HIAHImageMatches(const HIAHImage *image, const struct stat *st) {
+    struct timespec mtime = HIAHImageMtime(st);
+    return image->dev == st->st_dev &&
+           image->ino == st->st_ino &&
+           image->mtime.tv_sec == mtime.tv_sec &&
+           image->mtime.tv_nsec == mtime.tv_nsec;
+}
+
+// g_lock held
+static void HIAHImageUnlink(HIAHImage *image) {
+    for (HIAHImage **it = &g_images; *it; it = &(*it)->next) {
+        if (*it == image) {
+            *it = image->next;
+            return;
+        }
+    }
+}
+
+static void HIAHImageDestroy(HIAHImage *image) {
+    if (image->handle) dlclose(image->handle);
+    free(image->path);
+    free(image);
+}
+
+HIAHImage *HIAHImageCacheAcquire(const char *path, const char *const *entryNames) {
+    if (!path) return NULL;
+
+    struct stat st;
+    if (stat(path, &st) != 0) return NULL;
+
+    HIAHImage *closeFirst = NULL;
+
+    pthread_mutex_lock(&g_lock);
+    for (HIAHImage *image = g_images; image; image = image->next) {
+        if (image->stale || strcmp(image->path, path) != 0) continue;
+
+        if (HIAHImageMatches(image, &st)) {
+            image->refcount++;
+            pthread_mutex_unlock(&g_lock);
+            return image;
+        }
+
+        // The file changed underneath us. dyld hands back the already-loaded
+        // image for a known path, so the old one must be closed before the
+        // new file can be opened.
+        image->stale = true;
+        if (image->refcount == 0) {
+            HIAHImageUnlink(image);
+            closeFirst = image;
+        }
+        break;
+    }
+    pthread_mutex_unlock(&g_lock);
+
+    if (closeFirst) HIAHImageDestroy(closeFirst);
+
+    // Load outside the lock: dlopen runs initializers that may spawn
+    HIAHPrefetch *prefetch = HIAHPrefetchBegin(path);
+    void *handle = dlopen(path, RTLD_NOW | RTLD_GLOBAL);
+    HIAHPrefetchFinish(prefetch, handle != NULL, NULL);
+    if (!handle) return NULL;
+
+    HIAHImageEntryPoint entry = NULL;
+    for (const char *const *name = entryNames; name && *name && !entry; name++) {
+        entry = (HIAHImageEntryPoint)dlsym(handle, *name);
+    }
+
+    HIAHImage *image = calloc(1, sizeof(HIAHImage));
+    if (!image || !(image->path = strdup(path))) {
+        free(image);
+        dlclose(handle);
+        return NULL;
+    }
+    image->dev = st.st_dev;
+    image->ino = st.st_ino;
+    image->mtime = HIAHImageMtime(&st);
+    image->handle = handle;
+    image->entry = entry;
+    image->refcount = 1;
+
+    pthread_mutex_lock(&g_lock);
+    for (HIAHImage *existing = g_images; existing; existing = existing->next) {
+        // Another thread may have loaded the same file concurrently
+        if (!existing->stale && strcmp(existing->path, path) == 0 && HIAHImageMatches(existing, &st)) {
+            existing->refcount++;
+            pthread_mutex_unlock(&g_lock);
+            // Balances our dlopen; dyld keeps the shared image loaded
+            HIAHImageDestroy(image);
+            return existing;
+        }
+        // A replaced binary whose old image is still in use: dyld handed
+        // back the old image. Run it, but don't cache it as the new file;
+        // a later spawn loads again once the old image has been released.
+        if (existing->handle == handle && !HIAHImageMatches(existing, &st)) {
+            image->stale = true;
+        }
+    }
+    image->next = g_images;
+    g_images = image;
+    pthread_mutex_unlock(&g_lock);
+
+    return image;
+}
+
+HIAHImageEntryPoint HIAHImageGetEntryPoint(const HIAHImage *image) {
+    return image ? image->entry : NULL;
+}
+
+void HIAHImageCacheRelease(HIAHImage *image) {
+    if (!image) return;
+
+    bool destroy = false;
+    pthread_mutex_lock(&g_lock);
+    if (image->refcount > 0) image->refcount--;
+    if (image->refcount == 0 && image->stale) {
+        HIAHImageUnlink(image);
+        destroy = true;
+    }
+    pthread_mutex_unlock(&g_lock);
+
+    if (destroy) HIAHImageDestroy(image);
+}
@@ -0,0 +1,57 @@
+/**
+ * HIAHImageCache.h
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Cache of loaded guest images for in-process spawning.
+ *
+ * Scripts spawn the same tools over and over. Each cached image keeps the
+ * dlopen handle and the resolved entry point, so a repeated spawn costs a
+ * stat() and a lookup instead of dlopen plus several dlsym calls. Entries
+ * are keyed by path, inode and mtime: a binary replaced on disk gets a
+ * fresh entry and the stale one is closed once its last user exits. Until
+ * then dyld keeps returning the old image, so spawns in that window run
+ * the old code uncached and the new file is loaded after the old image
+ * has been released.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#ifndef HIAH_IMAGE_CACHE_H
+#define HIAH_IMAGE_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int (*HIAHImageEntryPoint)(int argc, char **argv);
+
+typedef struct HIAHImage HIAHImage;
+
+/**
+ * Returns a referenced image for `path`, loading it on first use.
+ *
+ * `entryNames` is a NULL-terminated list of symbols tried in order; the
+ * first one found becomes the image's entry point (resolved once).
+ *
+ * @return The image, or NULL if the file is missing or dlopen fails
+ *         (dlerror() describes the failure on the calling thread).
+ */
+HIAHImage *HIAHImageCacheAcquire(const char *path, const char *const *entryNames);
+
+/**
+ * Returns the cached entry point, or NULL if none of the names resolved.
+ */
+HIAHImageEntryPoint HIAHImageGetEntryPoint(const HIAHImage *image);
+
+/**
+ * Drops a reference taken by HIAHImageCacheAcquire.
+ * Current images stay loaded for the next spawn; stale ones are closed.
+ */
+void HIAHImageCacheRelease(HIAHImage *image);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HIAH_IMAGE_CACHE_H */
@@ -0,0 +1,65 @@
+/**
+ * HIAHJITReadiness.c
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * JIT readiness notification implementation.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#include "HIAHJITReadiness.h"
+#include <notify.h>
+#include <stdio.h>
+
+#define CS_OPS_STATUS 0
+#define CS_DEBUGGED 0x10000000
+
+extern int csops(pid_t pid, unsigned int ops, void *useraddr, size_t usersize);
+
+static void HIAHJITNotificationName(const char *prefix, pid_t pid, char *name, size_t size) {
+    snprintf(name, size, "%s.%d", prefix, pid);
+}
+
+static int HIAHJITRegisterHandler(const char *prefix, pid_t pid, dispatch_queue_t queue,
+                                  dispatch_block_t handler) {
+    char name[128];
+    HIAHJITNotificationName(prefix, pid, name, sizeof(name));
+
+    int token = -1;
+    uint32_t status = notify_register_dispatch(name, &token, queue, ^(int t) {
+        (void)t;
+        handler();
+    });
+    return status == NOTIFY_STATUS_OK ? token : -1;
+}
+
+bool HIAHJITIsActive(pid_t pid) {
+    int flags = 0;
+    if (csops(pid, CS_OPS_STATUS, &flags, sizeof(flags)) != 0) return false;
+    return (flags & CS_DEBUGGED) != 0;
+}
+
+void HIAHJITPostReady(pid_t pid) {
+    char name[128];
+    HIAHJITNotificationName(HIAH_JIT_READY_NOTIFICATION_PREFIX, pid, name, sizeof(name));
+    notify_post(name);
+}
+
+int HIAHJITRegisterReadyHandler(pid_t pid, dispatch_queue_t queue, dispatch_block_t handler) {
+    return HIAHJITRegisterHandler(HIAH_JIT_READY_NOTIFICATION_PREFIX, pid, queue, handler);
+}
+
+void HIAHJITCancelReadyHandler(int token) {
+    if (token >= 0) notify_cancel(token);
+}
+
+void HIAHJITPostDeclined(pid_t pid) {
+    char name[128];
+    HIAHJITNotificationName(HIAH_JIT_DECLINED_NOTIFICATION_PREFIX, pid, name, sizeof(name));
+    notify_post(name);
+}
+
+int HIAHJITRegisterDeclinedHandler(pid_t pid, dispatch_queue_t queue, dispatch_block_t handler) {
+    return HIAHJITRegisterHandler(HIAH_JIT_DECLINED_NOTIFICATION_PREFIX, pid, queue, handler);
+}
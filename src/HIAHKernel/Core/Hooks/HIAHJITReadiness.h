@@ -0,0 +1,73 @@
+/**
+ * HIAHJITReadiness.h
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Event delivery for JIT (CS_DEBUGGED) attachment.
+ *
+ * Whoever enables JIT for a process (HIAHJITManager via minimuxer) posts a
+ * per-PID Darwin notification once CS_DEBUGGED is confirmed; the process
+ * waiting on it registers a handler and wakes immediately instead of
+ * sleeping in fixed intervals. The notification carries no payload, so
+ * receivers still confirm with csops. A process that sees CS_DEBUGGED
+ * itself posts it too, so an enabler waiting for its attach to land wakes.
+ *
+ * A process that stops waiting and settles on JIT-less mode posts the
+ * per-PID "declined" notification, so the enabler drops its pending
+ * attach attempts.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#ifndef HIAH_JIT_READINESS_H
+#define HIAH_JIT_READINESS_H
+
+#include <dispatch/dispatch.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Notification names are "<prefix>.<pid>"
+#define HIAH_JIT_READY_NOTIFICATION_PREFIX "com.aspauldingcode.HIAHDesktop.JITReady"
+#define HIAH_JIT_DECLINED_NOTIFICATION_PREFIX "com.aspauldingcode.HIAHDesktop.JITDeclined"
+
+/**
+ * Whether CS_DEBUGGED is set on `pid` (csops).
+ */
+bool HIAHJITIsActive(pid_t pid);
+
+/**
+ * Announces that JIT is now enabled for `pid`.
+ */
+void HIAHJITPostReady(pid_t pid);
+
+/**
+ * Calls `handler` on `queue` each time JIT readiness is posted for `pid`.
+ *
+ * @return A token for HIAHJITCancelReadyHandler, or -1 on failure.
+ */
+int HIAHJITRegisterReadyHandler(pid_t pid, dispatch_queue_t queue, dispatch_block_t handler);
+
+void HIAHJITCancelReadyHandler(int token);
+
+/**
+ * Announces that `pid` no longer wants JIT.
+ */
+void HIAHJITPostDeclined(pid_t pid);
+
+/**
+ * Calls `handler` on `queue` when `pid` declines JIT. Cancel the token
+ * with HIAHJITCancelReadyHandler.
+ *
+ * @return A token, or -1 on failure.
+ */
+int HIAHJITRegisterDeclinedHandler(pid_t pid, dispatch_queue_t queue, dispatch_block_t handler);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HIAH_JIT_READINESS_H */
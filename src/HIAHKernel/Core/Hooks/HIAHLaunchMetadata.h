@@ -0,0 +1,73 @@
+/**
+ * HIAHLaunchMetadata.h
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Cached bundle resolution for guest launches.
+ *
+ * Resolving a .app (finding its executable, reading Info.plist, pulling
+ * entitlements out of the code signature) is done once per Info.plist
+ * version. Results are kept in memory and in the App Group container, so
+ * the kernel and every extension process share them; a repeat launch
+ * costs two stat calls (Info.plist and executable) plus, in a fresh
+ * process, reading one small binary plist. Entries are keyed by bundle
+ * path and invalidated when Info.plist's inode or mtime changes, or when
+ * the main executable's inode, size or mtime no longer match.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface HIAHLaunchMetadata : NSObject
+
+/// The enclosing .app, or nil for a bare executable
+@property(nonatomic, copy, readonly, nullable) NSString *bundlePath;
+
+/// Binary to load
+@property(nonatomic, copy, readonly) NSString *executablePath;
+
+@property(nonatomic, copy, readonly, nullable) NSString *bundleIdentifier;
+@property(nonatomic, copy, readonly, nullable) NSString *bundleName;
+@property(nonatomic, copy, readonly, nullable) NSString *principalClass;
+
+/// Entitlements embedded in the executable's code signature when the
+/// bundle was first resolved (preparation may strip the signature later)
+@property(nonatomic, copy, readonly, nullable) NSDictionary *entitlements;
+
+/// YES if the executable links UIKit or SwiftUI (assumed YES for secondary
+/// executables inside a bundle, which are not inspected)
+@property(nonatomic, assign, readonly) BOOL usesUIKit;
+
+/// Identifies the executable's current contents (inode, size, mtime); use
+/// it to key work done on the binary such as signing or patching
+@property(nonatomic, copy, readonly) NSString *preparedBinaryKey;
+
+/// YES if the result came from the memory or App Group cache
+@property(nonatomic, assign, readonly) BOOL cached;
+
+/**
+ * Resolves `path`, which may be a .app bundle or an executable (inside a
+ * bundle or not). Ensures the executable is 0755, calling chmod only when
+ * its mode differs.
+ *
+ * @param appGroupIdentifier Container for the shared cache; nil keeps the
+ *        cache in memory only.
+ * @return nil with `error` set (NSPOSIXErrorDomain, ENOENT) if no
+ *         executable can be found.
+ */
++ (nullable instancetype)metadataForPath:(NSString *)path
+                      appGroupIdentifier:(nullable NSString *)appGroupIdentifier
+                                   error:(NSError **)error;
+
+/**
+ * Forgets the cached entry for `bundlePath` (e.g. after reinstalling).
+ */
++ (void)invalidateBundlePath:(NSString *)bundlePath
+          appGroupIdentifier:(nullable NSString *)appGroupIdentifier;
+
+@end
+
+NS_ASSUME_NONNULL_END
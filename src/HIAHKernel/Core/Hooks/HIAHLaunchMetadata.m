@@ -0,0 +1,560 @@
+/**
+ * HIAHLaunchMetadata.m
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Cached bundle resolution implementation.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#import "HIAHLaunchMetadata.h"
+#import "HIAHLogging.h"
+#import "HIAHPlistReader.h"
+#import <errno.h>
+#import <libkern/OSByteOrder.h>
+#import <mach-o/fat.h>
+#import <mach-o/loader.h>
+#import <os/lock.h>
+#import <sys/stat.h>
+
+static NSString *const kCacheDirectoryName = @"LaunchMetadata";
+static const NSInteger kCacheVersion = 3;
+
+static NSString *const kVersionKey = @"Version";
+static NSString *const kBundlePathKey = @"BundlePath";
+static NSString *const kInfoInodeKey = @"InfoPlistInode";
+static NSString *const kInfoMTimeKey = @"InfoPlistMTime";
+static NSString *const kExecutablePathKey = @"ExecutablePath";
+static NSString *const kExecutableKeyKey = @"ExecutableKey";
+static NSString *const kBundleIdentifierKey = @"BundleIdentifier";
+static NSString *const kBundleNameKey = @"BundleName";
+static NSString *const kPrincipalClassKey = @"PrincipalClass";
+static NSString *const kEntitlementsKey = @"Entitlements";
+static NSString *const kUsesUIKitKey = @"UsesUIKit";
+
+// Code signature blobs (big-endian)
+#define HIAH_CSMAGIC_EMBEDDED_SIGNATURE 0xfade0cc0
+#define HIAH_CSMAGIC_EMBEDDED_ENTITLEMENTS 0xfade7171
+#define HIAH_CSSLOT_ENTITLEMENTS 5
+
+@interface HIAHLaunchMetadata ()
+@property(nonatomic, copy, readwrite, nullable) NSString *bundlePath;
+@property(nonatomic, copy, readwrite) NSString *executablePath;
+@property(nonatomic, copy, readwrite, nullable) NSString *bundleIdentifier;
+@property(nonatomic, copy, readwrite, nullable) NSString *bundleName;
+@property(nonatomic, copy, readwrite, nullable) NSString *principalClass;
+@property(nonatomic, copy, readwrite, nullable) NSDictionary *entitlements;
+@property(nonatomic, assign, readwrite) BOOL usesUIKit;
+@property(nonatomic, copy, readwrite) NSString *preparedBinaryKey;
+@property(nonatomic, assign, readwrite) BOOL cached;
+@property(nonatomic, assign) ino_t infoInode;
+@property(nonatomic, assign) uint64_t infoMTime;
+// preparedBinaryKey of the main executable when the entry was resolved
+@property(nonatomic, copy, nullable) NSString *executableKey;
+- (HIAHLaunchMetadata *)copyWithCached:(BOOL)cached;
+@end
+
+static os_unfair_lock gCacheLock = OS_UNFAIR_LOCK_INIT;
+static NSMutableDictionary<NSString *, HIAHLaunchMetadata *> *gMemoryCache;
+static NSMutableDictionary<NSString *, NSString *> *gCacheDirectories;
+
+#pragma mark - Helpers
+
+static uint64_t HIAHMTimeNs(const struct stat *st) {
+  return (uint64_t)st->st_mtimespec.tv_sec * 1000000000ull +
+         (uint64_t)st->st_mtimespec.tv_nsec;
+}
+
+// Identifies a file's contents for as long as nothing rewrites it
+static NSString *HIAHBinaryKey(const struct stat *st) {
+  return [NSString stringWithFormat:@"%llx-%llx-%llx",
+                                    (unsigned long long)st->st_ino,
+                                    (unsigned long long)st->st_size,
+                                    HIAHMTimeNs(st)];
+}
+
+static NSError *HIAHMissingError(NSString *description) {
+  return [NSError errorWithDomain:NSPOSIXErrorDomain
+                             code:ENOENT
+                         userInfo:@{NSLocalizedDescriptionKey : description}];
+}
+
+// Finds the enclosing .app by looking at path components only
+static NSString *HIAHBundlePathForPath(NSString *path) {
+  NSString *searchPath = path;
+  while (searchPath.length > 1) {
+    if ([searchPath.pathExtension isEqualToString:@"app"]) {
+      return searchPath;
+    }
+    searchPath = searchPath.stringByDeletingLastPathComponent;
+  }
+  return nil;
+}
+
+static NSString *HIAHCacheDirectory(NSString *appGroupIdentifier) {
+  if (!appGroupIdentifier) {
+    return nil;
+  }
+
+  os_unfair_lock_lock(&gCacheLock);
+  NSString *directory = gCacheDirectories[appGroupIdentifier];
+  os_unfair_lock_unlock(&gCacheLock);
+  if (directory) {
+    return directory.length ? directory : nil;
+  }
+
+  NSURL *groupURL = [[NSFileManager defaultManager]
+      containerURLForSecurityApplicationGroupIdentifier:appGroupIdentifier];
+  directory = groupURL
+                  ? [groupURL.path
+                        stringByAppendingPathComponent:kCacheDirectoryName]
+                  : @"";
+  if (directory.length) {
+    [[NSFileManager defaultManager] createDirectoryAtPath:directory
+                              withIntermediateDirectories:YES
+                                               attributes:nil
+                                                    error:nil];
+  }
+
+  os_unfair_lock_lock(&gCacheLock);
+  if (!gCacheDirectories) {
+    gCacheDirectories = [NSMutableDictionary dictionary];
+  }
+  gCacheDirectories[appGroupIdentifier] = directory;
+  os_unfair_lock_unlock(&gCacheLock);
+  return directory.length ? directory : nil;
+}
+
+static NSString *HIAHCacheFilePath(NSString *directory, NSString *bundlePath) {
+  // FNV-1a of the bundle path
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (const char *c = bundlePath.fileSystemRepresentation; *c; c++) {
+    hash = (hash ^ (uint8_t)*c) * 0x100000001b3ull;
+  }
+  return [directory
+      stringByAppendingPathComponent:[NSString
+                                         stringWithFormat:@"%016llx.plist",
+                                                          hash]];
+}
+
+#pragma mark - Executable
+
+// Whether a load command pulls in UIKit (directly or through SwiftUI)
+static BOOL HIAHIsUIKitDylib(const struct load_command *command,
+                             size_t available) {
+  if ((command->cmd != LC_LOAD_DYLIB && command->cmd != LC_LOAD_WEAK_DYLIB &&
+       command->cmd != LC_REEXPORT_DYLIB &&
+       command->cmd != LC_LAZY_LOAD_DYLIB) ||
+      command->cmdsize > available ||
+      command->cmdsize < sizeof(struct dylib_command)) {
+    return NO;
+  }
+  const struct dylib_command *dylib = (const struct dylib_command *)command;
+  uint32_t offset = dylib->dylib.name.offset;
+  if (offset >= command->cmdsize) {
+    return NO;
+  }
+  const char *name = (const char *)command + offset;
+  size_t length = strnlen(name, command->cmdsize - offset);
+  NSString *path = [[NSString alloc] initWithBytes:name
+                                            length:length
+                                          encoding:NSUTF8StringEncoding];
+  return [path containsString:@"/UIKit.framework/"] ||
+         [path containsString:@"/SwiftUI.framework/"];
+}
+
+// Reads the entitlements blob from the code signature of the arm64 slice
+// (or the only slice), and whether that slice links UIKit
+static NSDictionary *HIAHReadExecutableInfo(NSString *executablePath,
+                                            BOOL *usesUIKit) {
+  *usesUIKit = NO;
+  NSData *data = [NSData dataWithContentsOfFile:executablePath
+                                        options:NSDataReadingMappedIfSafe
+                                          error:nil];
+  const uint8_t *bytes = data.bytes;
+  size_t length = data.length;
+  if (length < sizeof(struct mach_header_64)) {
+    return nil;
+  }
+
+  size_t sliceOffset = 0;
+  size_t sliceSize = length;
+  if (OSReadBigInt32(bytes, 0) == FAT_MAGIC) {
+    uint32_t count = OSReadBigInt32(bytes, offsetof(struct fat_header, nfat_arch));
+    const struct fat_arch *chosen = NULL;
+    for (uint32_t i = 0; i < count; i++) {
+      size_t at = sizeof(struct fat_header) + i * sizeof(struct fat_arch);
+      if (at + sizeof(struct fat_arch) > length) {
+        break;
+      }
+      const struct fat_arch *arch = (const struct fat_arch *)(bytes + at);
+      if (!chosen || (cpu_type_t)OSSwapBigToHostInt32(arch->cputype) ==
+                         CPU_TYPE_ARM64) {
+        chosen = arch;
+      }
+    }
+    if (!chosen) {
+      return nil;
+    }
+    sliceOffset = OSSwapBigToHostInt32(chosen->offset);
+    sliceSize = OSSwapBigToHostInt32(chosen->size);
+    if (sliceOffset > length || sliceSize > length - sliceOffset) {
+      return nil;
+    }
+  }
+
+  const struct mach_header_64 *header =
+      (const struct mach_header_64 *)(bytes + sliceOffset);
+  if (sliceSize < sizeof(*header) || header->magic != MH_MAGIC_64) {
+    return nil;
+  }
+
+  const uint8_t *slice = bytes + sliceOffset;
+  size_t at = sizeof(*header);
+  const struct linkedit_data_command *signature = NULL;
+  for (uint32_t i = 0; i < header->ncmds; i++) {
+    if (at + sizeof(struct load_command) > sliceSize) {
+      return nil;
+    }
+    const struct load_command *command =
+        (const struct load_command *)(slice + at);
+    if (command->cmd == LC_CODE_SIGNATURE &&
+        at + sizeof(struct linkedit_data_command) <= sliceSize) {
+      signature = (const struct linkedit_data_command *)command;
+    } else if (!*usesUIKit && HIAHIsUIKitDylib(command, sliceSize - at)) {
+      *usesUIKit = YES;
+    }
+    if (command->cmdsize == 0) {
+      return nil;
+    }
+    at += command->cmdsize;
+  }
+  if (!signature || signature->dataoff > sliceSize ||
+      signature->datasize > sliceSize - signature->dataoff ||
+      signature->datasize < 12) {
+    return nil;
+  }
+
+  const uint8_t *superBlob = slice + signature->dataoff;
+  if (OSReadBigInt32(superBlob, 0) != HIAH_CSMAGIC_EMBEDDED_SIGNATURE) {
+    return nil;
+  }
+  uint32_t count = OSReadBigInt32(superBlob, 8);
+  for (uint32_t i = 0; i < count; i++) {
+    size_t index = 12 + (size_t)i * 8;
+    if (index + 8 > signature->datasize) {
+      return nil;
+    }
+    if (OSReadBigInt32(superBlob, index) != HIAH_CSSLOT_ENTITLEMENTS) {
+      continue;
+    }
+
+    uint32_t blobOffset = OSReadBigInt32(superBlob, index + 4);
+    if (blobOffset > signature->datasize - 8 ||
+        OSReadBigInt32(superBlob, blobOffset) !=
+            HIAH_CSMAGIC_EMBEDDED_ENTITLEMENTS) {
+      return nil;
+    }
+    uint32_t blobLength = OSReadBigInt32(superBlob, blobOffset + 4);
+    if (blobLength < 8 || blobLength > signature->datasize - blobOffset) {
+      return nil;
+    }
+    NSData *xml = [NSData dataWithBytes:superBlob + blobOffset + 8
+                                 length:blobLength - 8];
+    id entitlements = [NSPropertyListSerialization propertyListWithData:xml
+                                                                options:0
+                                                                 format:NULL
+                                                                  error:nil];
+    return [entitlements isKindOfClass:[NSDictionary class]] ? entitlements
+                                                               : nil;
+  }
+  return nil;
+}
+
+#pragma mark - Cache Entries
+
+@implementation HIAHLaunchMetadata
+
+- (NSDictionary *)cacheRepresentation {
+  NSMutableDictionary *entry = [NSMutableDictionary dictionary];
+  entry[kVersionKey] = @(kCacheVersion);
+  entry[kBundlePathKey] = self.bundlePath;
+  entry[kInfoInodeKey] = @(self.infoInode);
+  entry[kInfoMTimeKey] = @(self.infoMTime);
+  entry[kExecutablePathKey] = self.executablePath;
+  entry[kExecutableKeyKey] = self.executableKey;
+  entry[kBundleIdentifierKey] = self.bundleIdentifier;
+  entry[kBundleNameKey] = self.bundleName;
+  entry[kPrincipalClassKey] = self.principalClass;
+  entry[kEntitlementsKey] = self.entitlements;
+  entry[kUsesUIKitKey] = @(self.usesUIKit);
+  return entry;
+}
+
++ (instancetype)metadataFromCacheRepresentation:(NSDictionary *)entry {
+  if (![entry isKindOfClass:[NSDictionary class]] ||
+      [entry[kVersionKey] integerValue] != kCacheVersion ||
+      ![entry[kExecutablePathKey] isKindOfClass:[NSString class]]) {
+    return nil;
+  }
+
+  HIAHLaunchMetadata *metadata = [[HIAHLaunchMetadata alloc] init];
+  metadata.bundlePath = entry[kBundlePathKey];
+  metadata.infoInode = (ino_t)[entry[kInfoInodeKey] unsignedLongLongValue];
+  metadata.infoMTime = [entry[kInfoMTimeKey] unsignedLongLongValue];
+  metadata.executablePath = entry[kExecutablePathKey];
+  metadata.executableKey = entry[kExecutableKeyKey];
+  metadata.bundleIdentifier = entry[kBundleIdentifierKey];
+  metadata.bundleName = entry[kBundleNameKey];
+  metadata.principalClass = entry[kPrincipalClassKey];
+  metadata.entitlements = entry[kEntitlementsKey];
+  metadata.usesUIKit = [entry[kUsesUIKitKey] boolValue];
+  return metadata;
+}
+
+// Full resolution: parse Info.plist and locate the executable
++ (instancetype)resolveBundle:(NSString *)bundlePath
+                     infoStat:(const struct stat *)infoStat {
+  NSString *infoPlistPath =
+      [bundlePath stringByAppendingPathComponent:@"Info.plist"];
+
+  // Only four keys are needed; look them up in place rather than
+  // deserializing the whole Info.plist
+  static const char *const kInfoKeys[] = {
+      "CFBundleExecutable", "CFBundleIdentifier", "CFBundleName",
+      "NSPrincipalClass"};
+  HIAHPlistValue values[4];
+  HIAHPlist *infoPlist = HIAHPlistOpen(infoPlistPath.fileSystemRepresentation);
+  if (!infoPlist) {
+    return nil;
+  }
+  HIAHPlistGetKeys(infoPlist, kInfoKeys, values, 4);
+  NSString *executableName = HIAHPlistValueString(&values[0]);
+  NSString *bundleIdentifier = HIAHPlistValueString(&values[1]);
+  NSString *bundleName = HIAHPlistValueString(&values[2]);
+  NSString *principalClass = HIAHPlistValueString(&values[3]);
+  HIAHPlistClose(infoPlist);
+  if (executableName.length == 0) {
+    return nil;
+  }
+
+  // App.app/ExecutableName, or Contents/MacOS (rare on iOS but possible)
+  NSString *executablePath =
+      [bundlePath stringByAppendingPathComponent:executableName];
+  struct stat st;
+  if (stat(executablePath.fileSystemRepresentation, &st) != 0) {
+    executablePath = [[bundlePath
+        stringByAppendingPathComponent:@"Contents/MacOS"]
+        stringByAppendingPathComponent:executableName];
+    if (stat(executablePath.fileSystemRepresentation, &st) != 0) {
+      return nil;
+    }
+  }
+
+  HIAHLaunchMetadata *metadata = [[HIAHLaunchMetadata alloc] init];
+  metadata.bundlePath = bundlePath;
+  metadata.infoInode = infoStat->st_ino;
+  metadata.infoMTime = HIAHMTimeNs(infoStat);
+  metadata.executablePath = executablePath;
+  metadata.executableKey = HIAHBinaryKey(&st);
+  metadata.bundleIdentifier = bundleIdentifier;
+  metadata.bundleName = bundleName;
+  metadata.principalClass = principalClass;
+  BOOL usesUIKit = NO;
+  metadata.entitlements = HIAHReadExecutableInfo(executablePath, &usesUIKit);
+  metadata.usesUIKit = usesUIKit;
+  return metadata;
+}
+
++ (HIAHLaunchMetadata *)cachedMetadataForBundle:(NSString *)bundlePath
+                                       infoStat:(const struct stat *)infoStat
+                                 cacheDirectory:(NSString *)cacheDirectory {
+  os_unfair_lock_lock(&gCacheLock);
+  HIAHLaunchMetadata *metadata = gMemoryCache[bundlePath];
+  os_unfair_lock_unlock(&gCacheLock);
+
+  if (!metadata && cacheDirectory) {
+    NSData *data = [NSData
+        dataWithContentsOfFile:HIAHCacheFilePath(cacheDirectory, bundlePath)];
+    if (data) {
+      metadata = [self
+          metadataFromCacheRepresentation:
+              [NSPropertyListSerialization propertyListWithData:data
+                                                        options:0
+                                                         format:NULL
+                                                          error:nil]];
+    }
+  }
+
+  if (metadata && [metadata.bundlePath isEqualToString:bundlePath] &&
+      metadata.infoInode == infoStat->st_ino &&
+      metadata.infoMTime == HIAHMTimeNs(infoStat)) {
+    return metadata;
+  }
+  return nil;
+}
+
++ (void)storeMetadata:(HIAHLaunchMetadata *)metadata
+       cacheDirectory:(NSString *)cacheDirectory
+          writeToDisk:(BOOL)writeToDisk {
+  os_unfair_lock_lock(&gCacheLock);
+  if (!gMemoryCache) {
+    gMemoryCache = [NSMutableDictionary dictionary];
+  }
+  gMemoryCache[metadata.bundlePath] = metadata;
+  os_unfair_lock_unlock(&gCacheLock);
+
+  if (writeToDisk && cacheDirectory) {
+    NSData *data = [NSPropertyListSerialization
+        dataWithPropertyList:[metadata cacheRepresentation]
+                      format:NSPropertyListBinaryFormat_v1_0
+                     options:0
+                       error:nil];
+    [data writeToFile:HIAHCacheFilePath(cacheDirectory, metadata.bundlePath)
+           atomically:YES];
+  }
+}
+
+#pragma mark - Resolution
+
++ (instancetype)metadataForPath:(NSString *)path
+             appGroupIdentifier:(NSString *)appGroupIdentifier
+                          error:(NSError **)error {
+  path = path.stringByStandardizingPath;
+  NSString *bundlePath = HIAHBundlePathForPath(path);
+  BOOL pathIsBundle = [bundlePath isEqualToString:path];
+
+  HIAHLaunchMetadata *metadata = nil;
+  struct stat infoStat;
+  NSString *infoPlistPath =
+      [bundlePath stringByAppendingPathComponent:@"Info.plist"];
+  if (bundlePath &&
+      stat(infoPlistPath.fileSystemRepresentation, &infoStat) == 0) {
+    NSString *cacheDirectory = HIAHCacheDirectory(appGroupIdentifier);
+    metadata = [self cachedMetadataForBundle:bundlePath
+                                    infoStat:&infoStat
+                              cacheDirectory:cacheDirectory];
+    if (metadata) {
+      metadata = [metadata copyWithCached:YES];
+      [self storeMetadata:metadata
+           cacheDirectory:cacheDirectory
+              writeToDisk:NO];
+    } else {
+      metadata = [self resolveBundle:bundlePath infoStat:&infoStat];
+      if (metadata) {
+        [self storeMetadata:metadata
+             cacheDirectory:cacheDirectory
+                writeToDisk:YES];
+        metadata = [metadata copyWithCached:NO];
+      }
+    }
+  }
+
+  if (pathIsBundle && !metadata) {
+    if (error) {
+      *error = HIAHMissingError(
+          [NSString stringWithFormat:@"No executable found in bundle %@",
+                                     bundlePath]);
+    }
+    return nil;
+  }
+  if (!pathIsBundle) {
+    // Given an executable: load that binary, keeping the bundle's metadata
+    // (entitlements only describe the main executable)
+    HIAHLaunchMetadata *resolved = [[HIAHLaunchMetadata alloc] init];
+    resolved.bundlePath = bundlePath;
+    resolved.executablePath = path;
+    resolved.bundleIdentifier = metadata.bundleIdentifier;
+    resolved.bundleName = metadata.bundleName;
+    resolved.principalClass = metadata.principalClass;
+    // Another executable in the bundle may well be a UI app; assume so
+    resolved.usesUIKit = YES;
+    if ([metadata.executablePath isEqualToString:path]) {
+      resolved.executableKey = metadata.executableKey;
+      resolved.entitlements = metadata.entitlements;
+      resolved.usesUIKit = metadata.usesUIKit;
+    } else if (!bundlePath) {
+      // A bare tool: nothing is cached, so read its load commands now
+      BOOL usesUIKit = NO;
+      resolved.entitlements = HIAHReadExecutableInfo(path, &usesUIKit);
+      resolved.usesUIKit = usesUIKit;
+    }
+    resolved.cached = metadata.cached;
+    metadata = resolved;
+  }
+
+  // One stat covers the existence check, the prepared-binary key and the
+  // permission check
+  struct stat executableStat;
+  if (stat(metadata.executablePath.fileSystemRepresentation,
+           &executableStat) != 0 ||
+      !S_ISREG(executableStat.st_mode)) {
+    if (bundlePath) {
+      [self invalidateBundlePath:bundlePath
+              appGroupIdentifier:appGroupIdentifier];
+    }
+    if (error) {
+      *error = HIAHMissingError([NSString
+          stringWithFormat:@"Executable not found: %@",
+                           metadata.executablePath]);
+    }
+    return nil;
+  }
+
+  if ((executableStat.st_mode & 0777) != 0755) {
+    if (chmod(metadata.executablePath.fileSystemRepresentation, 0755) != 0) {
+      HIAHLogEx(HIAH_LOG_WARNING, @"LaunchMetadata",
+                @"Could not set executable permissions on %@: %s",
+                metadata.executablePath, strerror(errno));
+    }
+  }
+
+  metadata.preparedBinaryKey = HIAHBinaryKey(&executableStat);
+
+  // Entitlements and the UIKit check come from the executable, which can
+  // be replaced without touching Info.plist
+  if (metadata.cached && metadata.executableKey &&
+      ![metadata.executableKey isEqualToString:metadata.preparedBinaryKey]) {
+    [self invalidateBundlePath:bundlePath
+            appGroupIdentifier:appGroupIdentifier];
+    return [self metadataForPath:path
+              appGroupIdentifier:appGroupIdentifier
+                           error:error];
+  }
+  return metadata;
+}
+
+// Cache entries are shared; hand callers their own copy
+- (HIAHLaunchMetadata *)copyWithCached:(BOOL)cached {
+  HIAHLaunchMetadata *copy = [[HIAHLaunchMetadata alloc] init];
+  copy.bundlePath = self.bundlePath;
+  copy.executablePath = self.executablePath;
+  copy.executableKey = self.executableKey;
+  copy.bundleIdentifier = self.bundleIdentifier;
+  copy.bundleName = self.bundleName;
+  copy.principalClass = self.principalClass;
+  copy.entitlements = self.entitlements;
+  copy.usesUIKit = self.usesUIKit;
+  copy.infoInode = self.infoInode;
+  copy.infoMTime = self.infoMTime;
+  copy.cached = cached;
+  return copy;
+}
+
++ (void)invalidateBundlePath:(NSString *)bundlePath
+          appGroupIdentifier:(NSString *)appGroupIdentifier {
+  bundlePath = bundlePath.stringByStandardizingPath;
+
+  os_unfair_lock_lock(&gCacheLock);
+  [gMemoryCache removeObjectForKey:bundlePath];
+  os_unfair_lock_unlock(&gCacheLock);
+
+  NSString *cacheDirectory = HIAHCacheDirectory(appGroupIdentifier);
+  if (cacheDirectory) {
+    unlink(HIAHCacheFilePath(cacheDirectory, bundlePath)
+               .fileSystemRepresentation);
+  }
+}
+
+@end
@@ -0,0 +1,633 @@
+/**
+ * HIAHLazyBundle.c
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Install-from-archive implementation.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#include "HIAHLazyBundle.h"
+#include "HIAHMountTable.h"
+#include "HIAHZipArchive.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __APPLE__
+#include <copyfile.h>
+#endif
+
+#define HIAH_LAZY_INDEX_MAGIC 0x495a4c48u   // 'HLZI'
+#define HIAH_LAZY_INDEX_VERSION 1u
+#define HIAH_LAZY_MAX_MOUNTS 8
+#define HIAH_LAZY_COPY_BUFFER (256 * 1024)
+
+// Index file: this header, `entryCount` entries sorted by name, then the
+// NUL-terminated names (relative to the bundle root) they point into
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t archiveSize;
+    uint32_t entryCount;
+    uint32_t namesSize;
+} HIAHLazyIndexHeader;
+
+typedef struct {
+    uint64_t dataOffset;
+    uint64_t compressedSize;
+    uint64_t uncompressedSize;
+    uint32_t crc;
+    uint32_t nameOffset;
+    uint32_t mode;
+    uint16_t method;
+    uint16_t reserved;
+} HIAHLazyIndexEntry;
+
+typedef struct {
+    char root[PATH_MAX];
+    size_t rootLength;
+    char realRoot[PATH_MAX];      // The same root with symlinks resolved
+    size_t realRootLength;
+    char cache[PATH_MAX];         // Where extractions are written before being moved in
+    int archive;
+
+    void *map;
+    size_t mapSize;
+    const HIAHLazyIndexEntry *entries;
+    uint32_t entryCount;
+    const char *names;
+
+    uint64_t *lastUse;            // Per entry, realtime ns; 0 while a placeholder
+    uint64_t cachedBytes;         // Filled from the archive
+} HIAHLazyMount;
+
+static HIAHLazyMount *g_mounts[HIAH_LAZY_MAX_MOUNTS];
+static _Atomic(size_t) g_mountCount = 0;
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;   // Mounting and cache bookkeeping
+static uint64_t g_sessionStart = 0;
+static _Atomic(uint32_t) g_temporaryCounter = 0;
+
+#pragma mark - Helpers
+
+// Wall-clock time, comparable with the file modification times recency is
+// stored in
+static uint64_t HIAHLazyTimestampNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static bool HIAHHasPrefix(const char *string, const char *prefix) {
+    return strncmp(string, prefix, strlen(prefix)) == 0;
+}
+
+static bool HIAHHasSuffix(const char *string, const char *suffix) {
+    size_t length = strlen(string);
+    size_t suffixLength = strlen(suffix);
+    return length >= suffixLength && strcmp(string + length - suffixLength, suffix) == 0;
+}
+
+static int HIAHCopyArchive(const char *source, const char *destination) {
+#ifdef __APPLE__
+    // A clone costs no space until one side changes
+    if (copyfile(source, destination, NULL, COPYFILE_CLONE | COPYFILE_DATA) == 0) return 0;
+#endif
+    int in = open(source, O_RDONLY | O_CLOEXEC);
+    if (in < 0) return errno;
+    int out = open(destination, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    uint8_t *buffer = malloc(HIAH_LAZY_COPY_BUFFER);
+    int error = out < 0 ? errno : buffer ? 0 : ENOMEM;
+
+    while (!error) {
+        ssize_t got = read(in, buffer, HIAH_LAZY_COPY_BUFFER);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) {
+            error = got < 0 ? errno : 0;
+            break;
+        }
+        for (ssize_t done = 0; done < got && !error;) {
+            ssize_t put = write(out, buffer + done, (size_t)(got - done));
+            if (put < 0 && errno != EINTR) error = errno;
+            if (put > 0) done += put;
+        }
+    }
+
+    free(buffer);
+    close(in);
+    if (out >= 0 && close(out) != 0 && !error) error = errno;
+    return error;
+}
+
+static mode_t HIAHLazyPermissions(uint32_t mode) {
+    return mode & 0777 ? (mode & 0777) | S_IRUSR | S_IWUSR : 0644;
+}
+
+// An empty file standing in for one still in the archive, so listings (and
+// NSBundle lookups) see the whole bundle. Lazy files are never empty, so a
+// zero size is what marks a placeholder.
+static int HIAHLazyWritePlaceholder(const char *path, uint32_t mode) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_NOFOLLOW,
+                  HIAHLazyPermissions(mode));
+    if (fd < 0) return errno;
+    return close(fd) == 0 ? 0 : errno;
+}
+
+#pragma mark - Install
+
+typedef struct {
+    HIAHLazyIndexEntry entry;
+    uint32_t nameLength;
+} HIAHLazyItem;
+
+typedef struct {
+    HIAHZipBundle bundle;
+    HIAHLazyItem *items;
+    size_t count;
+    size_t capacity;
+    char *names;
+    size_t namesSize;
+    size_t namesCapacity;
+} HIAHLazyPlan;
+
+static const char *HIAHLazyPlanName(const HIAHLazyPlan *plan, const HIAHLazyItem *item) {
+    return plan->names + item->entry.nameOffset;
+}
+
+// Everything opened by something other than the hooked guest: dyld (the
+// executables and frameworks), LaunchServices-style metadata readers in the
+// desktop (Info.plists, icons) and code signing
+static bool HIAHLazyIsEager(const char *name, uint32_t mode, uint64_t size) {
+    const char *base = strrchr(name, '/');
+    base = base ? base + 1 : name;
+    return size == 0 || S_ISLNK(mode) || (mode & 0111) || strcmp(base, "Info.plist") == 0 ||
+           HIAHHasSuffix(name, ".dylib") || HIAHHasPrefix(name, "Frameworks/") ||
+           HIAHHasPrefix(name, "PlugIns/") || HIAHHasPrefix(name, "Extensions/") ||
+           HIAHHasPrefix(name, "_CodeSignature/") || HIAHHasPrefix(name, "SC_Info/") ||
+           strcmp(name, "embedded.mobileprovision") == 0 ||
+           (base == name && HIAHHasSuffix(name, ".png"));
+}
+
+static int HIAHLazyCollect(void *userData, const HIAHZipEntryInfo *info) {
+    HIAHLazyPlan *plan = userData;
+    size_t nameLength;
+    bool isDirectory;
+    const char *name = HIAHZipBundleEntry(&plan->bundle, info->name, &nameLength, &isDirectory);
+    if (!name) return 0;
+
+    if (plan->count == plan->capacity) {
+        size_t capacity = plan->capacity ? plan->capacity * 2 : 256;
+        HIAHLazyItem *items = realloc(plan->items, capacity * sizeof(HIAHLazyItem));
+        if (!items) return ENOMEM;
+        plan->items = items;
+        plan->capacity = capacity;
+    }
+    if (plan->namesSize + nameLength + 1 > plan->namesCapacity) {
+        size_t capacity = plan->namesCapacity ? plan->namesCapacity * 2 : 64 * 1024;
+        while (capacity < plan->namesSize + nameLength + 1) capacity *= 2;
+        char *names = realloc(plan->names, capacity);
+        if (!names) return ENOMEM;
+        plan->names = names;
+        plan->namesCapacity = capacity;
+    }
+    if (plan->namesSize + nameLength + 1 > UINT32_MAX) return EFBIG;
+
+    memcpy(plan->names + plan->namesSize, name, nameLength);
+    plan->names[plan->namesSize + nameLength] = '\0';
+    plan->items[plan->count++] = (HIAHLazyItem){
+        .entry = {
+            .dataOffset = info->dataOffset,
+            .compressedSize = info->compressedSize,
+            .uncompressedSize = info->uncompressedSize,
+            .crc = info->crc,
+            .nameOffset = (uint32_t)plan->namesSize,
+            .mode = isDirectory ? (S_IFDIR | 0755) : info->mode,
+            .method = info->method,
+        },
+        .nameLength = (uint32_t)nameLength,
+    };
+    plan->namesSize += nameLength + 1;
+    return 0;
+}
+
+static int HIAHLazyExtract(int archive, const HIAHLazyIndexEntry *entry, const char *path,
+                           const HIAHZipFilter *filter) {
+    HIAHZipEntryInfo info = {
+        .method = entry->method,
+        .crc = entry->crc,
+        .compressedSize = entry->compressedSize,
+        .uncompressedSize = entry->uncompressedSize,
+        .dataOffset = entry->dataOffset,
+        .mode = entry->mode,
+    };
+    return HIAHZipExtractEntry(archive, &info, path, filter);
+}
+
+static int HIAHLazyCompareItems(const void *a, const void *b) {
+    // Names were sorted through this pointer pair; see HIAHLazyWriteIndex
+    const char *const *left = a;
+    const char *const *right = b;
+    return strcmp(*left, *right);
+}
+
+static int HIAHLazyWriteIndex(const HIAHLazyPlan *plan, const char *lazyDirectory,
+                              uint64_t archiveSize) {
+    // Sort (name, item) pairs; the name pointer comes first so the pair
+    // compares by name
+    typedef struct {
+        const char *name;
+        const HIAHLazyItem *item;
+    } HIAHLazySorted;
+
+    size_t lazyCount = 0;
+    HIAHLazySorted *sorted = malloc((plan->count ? plan->count : 1) * sizeof(HIAHLazySorted));
+    if (!sorted) return ENOMEM;
+    for (size_t i = 0; i < plan->count; i++) {
+        const HIAHLazyItem *item = &plan->items[i];
+        if (S_ISDIR(item->entry.mode) ||
+            HIAHLazyIsEager(HIAHLazyPlanName(plan, item), item->entry.mode,
+                            item->entry.uncompressedSize)) {
+            continue;
+        }
+        sorted[lazyCount++] = (HIAHLazySorted){HIAHLazyPlanName(plan, item), item};
+    }
+    qsort(sorted, lazyCount, sizeof(HIAHLazySorted), HIAHLazyCompareItems);
+
+    char indexPath[PATH_MAX];
+    char temporaryPath[PATH_MAX];
+    snprintf(indexPath, sizeof(indexPath), "%s/index", lazyDirectory);
+    snprintf(temporaryPath, sizeof(temporaryPath), "%s/index.%d", lazyDirectory, getpid());
+    errno = 0;
+    FILE *file = fopen(temporaryPath, "wb");
+    if (!file) {
+        free(sorted);
+        return errno;
+    }
+
+    HIAHLazyIndexHeader header = {
+        .magic = HIAH_LAZY_INDEX_MAGIC,
+        .version = HIAH_LAZY_INDEX_VERSION,
+        .archiveSize = archiveSize,
+        .entryCount = (uint32_t)lazyCount,
+        .namesSize = (uint32_t)plan->namesSize,
+    };
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+    for (size_t i = 0; i < lazyCount && written; i++) {
+        written = fwrite(&sorted[i].item->entry, sizeof(HIAHLazyIndexEntry), 1, file) == 1;
+    }
+    written = written && fwrite(plan->names, 1, plan->namesSize, file) == plan->namesSize;
+    free(sorted);
+
+    if (fclose(file) != 0) written = false;
+    if (!written || rename(temporaryPath, indexPath) != 0) {
+        int error = errno ? errno : EIO;
+        unlink(temporaryPath);
+        return error;
+    }
+    return 0;
+}
+
+int HIAHLazyBundleInstall(const char *archivePath, const char *applicationsPath,
+                          const HIAHZipFilter *filter, char *bundlePath, size_t bundlePathSize,
+                          HIAHLazyInstallStats *stats) {
+    HIAHLazyInstallStats result = {0};
+    if (stats) *stats = result;
+    if (!archivePath || !applicationsPath || !bundlePath) return EINVAL;
+
+    uint64_t begin = HIAHZipNowNs();
+    HIAHLazyPlan plan = {0};
+    int error = HIAHZipEnumerate(archivePath, HIAHLazyCollect, &plan);
+
+    char lazyDirectory[PATH_MAX];
+    char copyPath[PATH_MAX];
+    if (!error) error = HIAHZipBundlePath(&plan.bundle, applicationsPath, bundlePath, bundlePathSize);
+    if (!error) {
+        snprintf(lazyDirectory, sizeof(lazyDirectory), "%s/%s/cache", bundlePath,
+                 HIAH_LAZY_DIRECTORY);
+        if (strlen(bundlePath) + 64 >= sizeof(lazyDirectory)) {
+            error = ENAMETOOLONG;
+        } else {
+            error = HIAHZipMakeDirectories(lazyDirectory);
+            *strrchr(lazyDirectory, '/') = '\0';
+        }
+    }
+    if (!error) {
+        snprintf(copyPath, sizeof(copyPath), "%s/archive.ipa", lazyDirectory);
+        error = HIAHCopyArchive(archivePath, copyPath);
+    }
+
+    int archive = -1;
+    struct stat st;
+    if (!error && ((archive = open(copyPath, O_RDONLY | O_CLOEXEC)) < 0 ||
+                   fstat(archive, &st) != 0)) {
+        error = errno;
+    }
+
+    // Directories (including parents only implied by file names) and
+    // placeholders for the lazy files all exist on disk, so listing a lazy
+    // bundle shows its full contents
+    for (size_t i = 0; i < plan.count && !error; i++) {
+        const HIAHLazyItem *item = &plan.items[i];
+        const char *name = HIAHLazyPlanName(&plan, item);
+        char path[PATH_MAX];
+        if ((size_t)snprintf(path, sizeof(path), "%s/%s", bundlePath, name) >= sizeof(path)) {
+            error = ENAMETOOLONG;
+            break;
+        }
+        if (S_ISDIR(item->entry.mode)) {
+            error = HIAHZipMakeDirectories(path);
+        } else if (!(error = HIAHZipMakeParent(path))) {
+            if (HIAHLazyIsEager(name, item->entry.mode, item->entry.uncompressedSize)) {
+                error = HIAHLazyExtract(archive, &item->entry, path, filter);
+                result.eagerFiles++;
+                result.eagerBytes += item->entry.uncompressedSize;
+            } else {
+                error = HIAHLazyWritePlaceholder(path, item->entry.mode);
+                result.lazyFiles++;
+                result.lazyBytes += item->entry.uncompressedSize;
+            }
+        }
+    }
+
+    if (!error) error = HIAHLazyWriteIndex(&plan, lazyDirectory, (uint64_t)st.st_size);
+
+    if (archive >= 0) close(archive);
+    free(plan.items);
+    free(plan.names);
+    result.wallNs = HIAHZipNowNs() - begin;
+    if (stats) *stats = result;
+    return error;
+}
+
+#pragma mark - Mounts
+
+static void HIAHLazyFilePath(const HIAHLazyMount *mount, uint32_t index, char *out, size_t size) {
+    snprintf(out, size, "%s/%s", mount->root, mount->names + mount->entries[index].nameOffset);
+}
+
+// Puts the placeholder back over a filled file. Descriptors already open on
+// the filled copy keep reading it.
+static void HIAHLazyResetFile(HIAHLazyMount *mount, uint32_t index) {
+    char path[PATH_MAX];
+    char temporary[PATH_MAX];
+    HIAHLazyFilePath(mount, index, path, sizeof(path));
+    snprintf(temporary, sizeof(temporary), "%s/.%u.%d.%u", mount->cache, index, getpid(),
+             atomic_fetch_add(&g_temporaryCounter, 1));
+    if (HIAHLazyWritePlaceholder(temporary, mount->entries[index].mode) != 0 ||
+        rename(temporary, path) != 0) {
+        unlink(temporary);
+    }
+}
+
+// Clears out interrupted extractions, then rebuilds the bookkeeping from
+// the bundle: a file at its full size was filled in an earlier session, an
+// empty one is a placeholder, and a missing one (an install made before
+// placeholders) gets one
+static void HIAHLazyScan(HIAHLazyMount *mount) {
+    DIR *directory = opendir(mount->cache);
+    struct dirent *item;
+    while (directory && (item = readdir(directory))) {
+        if (strcmp(item->d_name, ".") == 0 || strcmp(item->d_name, "..") == 0) continue;
+        char path[PATH_MAX];
+        snprintf(path, sizeof(path), "%s/%s", mount->cache, item->d_name);
+        unlink(path);
+    }
+    if (directory) closedir(directory);
+
+    for (uint32_t i = 0; i < mount->entryCount; i++) {
+        const HIAHLazyIndexEntry *entry = &mount->entries[i];
+        char path[PATH_MAX];
+        struct stat st;
+        HIAHLazyFilePath(mount, i, path, sizeof(path));
+        if (lstat(path, &st) != 0) {
+            if (errno == ENOENT && HIAHZipMakeParent(path) == 0) {
+                HIAHLazyWritePlaceholder(path, entry->mode);
+            }
+            continue;
+        }
+        if (!S_ISREG(st.st_mode) || (uint64_t)st.st_size != entry->uncompressedSize) continue;
+#ifdef __APPLE__
+        struct timespec modified = st.st_mtimespec;
+#else
+        struct timespec modified = st.st_mtim;
+#endif
+        uint64_t lastUse = (uint64_t)modified.tv_sec * 1000000000ull + (uint64_t)modified.tv_nsec;
+        mount->lastUse[i] = lastUse ? lastUse : 1;
+        mount->cachedBytes += entry->uncompressedSize;
+    }
+}
+
+static HIAHLazyMount *HIAHLazyLoad(const char *bundlePath) {
+    HIAHLazyMount *mount = calloc(1, sizeof(HIAHLazyMount));
+    if (!mount) return NULL;
+    mount->archive = -1;
+    mount->map = MAP_FAILED;
+
+    char path[PATH_MAX];
+    struct stat st;
+    snprintf(mount->root, sizeof(mount->root), "%s", bundlePath);
+    while (mount->rootLength = strlen(mount->root),
+           mount->rootLength > 1 && mount->root[mount->rootLength - 1] == '/') {
+        mount->root[mount->rootLength - 1] = '\0';
+    }
+    if (realpath(mount->root, mount->realRoot)) mount->realRootLength = strlen(mount->realRoot);
+    snprintf(mount->cache, sizeof(mount->cache), "%s/%s/cache", mount->root, HIAH_LAZY_DIRECTORY);
+
+    snprintf(path, sizeof(path), "%s/%s/index", mount->root, HIAH_LAZY_DIRECTORY);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd >= 0 && fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(HIAHLazyIndexHeader)) {
+        mount->mapSize = (size_t)st.st_size;
+        mount->map = mmap(NULL, mount->mapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    if (fd >= 0) close(fd);
+
+    snprintf(path, sizeof(path), "%s/%s/archive.ipa", mount->root, HIAH_LAZY_DIRECTORY);
+    bool valid = mount->map != MAP_FAILED &&
+                 (mount->archive = open(path, O_RDONLY | O_CLOEXEC)) >= 0 &&
+                 fstat(mount->archive, &st) == 0;
+    if (valid) {
+        const HIAHLazyIndexHeader *header = mount->map;
+        uint64_t expected = sizeof(*header) +
+                            (uint64_t)header->entryCount * sizeof(HIAHLazyIndexEntry) +
+                            header->namesSize;
+        valid = header->magic == HIAH_LAZY_INDEX_MAGIC &&
+                header->version == HIAH_LAZY_INDEX_VERSION &&
+                header->archiveSize == (uint64_t)st.st_size && expected == mount->mapSize &&
+                (header->namesSize == 0 ||
+                 ((const char *)mount->map)[mount->mapSize - 1] == '\0');
+        mount->entries = (const HIAHLazyIndexEntry *)(header + 1);
+        mount->entryCount = header->entryCount;
+        mount->names = (const char *)(mount->entries + mount->entryCount);
+        for (uint32_t i = 0; i < mount->entryCount && valid; i++) {
+            valid = mount->entries[i].nameOffset < header->namesSize;
+        }
+    }
+    if (valid) {
+        mount->lastUse = calloc(mount->entryCount ? mount->entryCount : 1, sizeof(uint64_t));
+        valid = mount->lastUse != NULL;
+    }
+    if (!valid) {
+        if (mount->map != MAP_FAILED) munmap(mount->map, mount->mapSize);
+        if (mount->archive >= 0) close(mount->archive);
+        free(mount);
+        return NULL;
+    }
+
+    mkdir(mount->cache, 0755);
+    HIAHLazyScan(mount);
+    return mount;
+}
+
+bool HIAHLazyBundleMount(const char *bundlePath) {
+    if (!bundlePath) return false;
+
+    pthread_mutex_lock(&g_lock);
+    if (g_sessionStart == 0) g_sessionStart = HIAHLazyTimestampNs();
+
+    size_t count = atomic_load(&g_mountCount);
+    bool mounted = false;
+    for (size_t i = 0; i < count && !mounted; i++) {
+        mounted = strcmp(g_mounts[i]->root, bundlePath) == 0;
+    }
+    if (!mounted && count < HIAH_LAZY_MAX_MOUNTS) {
+        HIAHLazyMount *mount = HIAHLazyLoad(bundlePath);
+        if (mount) {
+            // Lookups read the table without the lock: publish the slot
+            // before the count
+            g_mounts[count] = mount;
+            atomic_store_explicit(&g_mountCount, count + 1, memory_order_release);
+            mounted = true;
+        }
+    }
+    pthread_mutex_unlock(&g_lock);
+    return mounted;
+}
+
+// Finds the index entry for an absolute path inside a mounted bundle
+static HIAHLazyMount *HIAHLazyLookup(const char *path, uint32_t *index) {
+    if (!path || path[0] != '/') return NULL;
+
+    size_t count = atomic_load_explicit(&g_mountCount, memory_order_acquire);
+    for (size_t i = 0; i < count; i++) {
+        HIAHLazyMount *mount = g_mounts[i];
+        const char *relative = NULL;
+        if (strncmp(path, mount->root, mount->rootLength) == 0 &&
+            path[mount->rootLength] == '/') {
+            relative = path + mount->rootLength + 1;
+        } else if (mount->realRootLength > 0 &&
+                   strncmp(path, mount->realRoot, mount->realRootLength) == 0 &&
+                   path[mount->realRootLength] == '/') {
+            relative = path + mount->realRootLength + 1;
+        }
+        if (!relative) continue;
+
+        uint32_t low = 0;
+        uint32_t high = mount->entryCount;
+        while (low < high) {
+            uint32_t middle = low + (high - low) / 2;
+            int order = strcmp(relative, mount->names + mount->entries[middle].nameOffset);
+            if (order == 0) {
+                *index = middle;
+                return mount;
+            }
+            if (order < 0) {
+                high = middle;
+            } else {
+                low = middle + 1;
+            }
+        }
+        return NULL;
+    }
+    return NULL;
+}
+
+#pragma mark - Cache
+
+// Returns least recently used files to placeholders until the filled ones
+// fit the budget again, never the one just filled. Called with g_lock held.
+static void HIAHLazyEvict(HIAHLazyMount *mount, uint32_t keep) {
+    while (mount->cachedBytes > HIAH_LAZY_CACHE_BYTES) {
+        uint32_t victim = UINT32_MAX;
+        for (uint32_t i = 0; i < mount->entryCount; i++) {
+            if (i == keep || mount->lastUse[i] == 0) continue;
+            if (victim == UINT32_MAX || mount->lastUse[i] < mount->lastUse[victim]) victim = i;
+        }
+        if (victim == UINT32_MAX) return;
+
+        HIAHLazyResetFile(mount, victim);
+        mount->cachedBytes -= mount->entries[victim].uncompressedSize;
+        mount->lastUse[victim] = 0;
+    }
+}
+
+int HIAHLazyBundleFill(const char *path) {
+    uint32_t index;
+    HIAHLazyMount *mount = HIAHLazyLookup(path, &index);
+    if (!mount) return 0;
+    const HIAHLazyIndexEntry *entry = &mount->entries[index];
+    char filePath[PATH_MAX];
+    HIAHLazyFilePath(mount, index, filePath, sizeof(filePath));
+
+    // Another thread or process may have filled it already
+    struct stat st;
+    bool filled = stat(filePath, &st) == 0 && (uint64_t)st.st_size == entry->uncompressedSize;
+    if (!filled) {
+        // Extract to a private name and rename over the placeholder, so a
+        // concurrent open of the same file sees either one or a complete copy
+        char temporary[PATH_MAX];
+        snprintf(temporary, sizeof(temporary), "%s/.%u.%d.%u", mount->cache, index, getpid(),
+                 atomic_fetch_add(&g_temporaryCounter, 1));
+        int error = HIAHLazyExtract(mount->archive, entry, temporary, NULL);
+        if (!error && rename(temporary, filePath) != 0) {
+            error = errno;
+            unlink(temporary);
+        }
+        if (error) return error;
+    }
+
+    pthread_mutex_lock(&g_lock);
+    uint64_t lastUse = mount->lastUse[index];
+    if (lastUse == 0) mount->cachedBytes += entry->uncompressedSize;
+    mount->lastUse[index] = HIAHLazyTimestampNs();
+    if (!filled) HIAHLazyEvict(mount, index);
+    pthread_mutex_unlock(&g_lock);
+
+    // The file's mtime carries recency over to later sessions; refreshed
+    // once per session
+    if (filled && lastUse < g_sessionStart) utimensat(AT_FDCWD, filePath, NULL, 0);
+    return 0;
+}
+
+bool HIAHLazyBundleStat(const char *path, struct stat *st) {
+    uint32_t index;
+    HIAHLazyMount *mount = HIAHLazyLookup(path, &index);
+    if (!mount || !st) return false;
+
+    char filePath[PATH_MAX];
+    HIAHLazyFilePath(mount, index, filePath, sizeof(filePath));
+    if (stat(filePath, st) != 0) return false;
+    if (st->st_size == 0) {
+        // A placeholder: report the size the file will have
+        uint64_t size = mount->entries[index].uncompressedSize;
+        st->st_size = (off_t)size;
+        st->st_blocks = (blkcnt_t)((size + 511) / 512);
+    }
+    return true;
+}
+
+#pragma mark - Hooks
+
+// The file hooks live with the mount table, which translates virtual paths
+// before they get here
+void HIAHLazyBundleInstallHooks(void) {
+    HIAHMountInstallHooks();
+}
@@ -0,0 +1,107 @@
+/**
+ * HIAHLazyBundle.h
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Install-from-archive: app bundles whose files stay in the .ipa until a
+ * guest opens them.
+ *
+ * A lazy install keeps the archive inside the bundle (in .hiah-lazy/,
+ * cloned rather than copied where the filesystem allows) together with a
+ * sorted index of its files, and extracts only what has to exist on disk:
+ * binaries and frameworks (dyld maps them directly), Info.plists, root
+ * icons, signature data and symlinks. Everything else - usually most of the
+ * app's size - is written as an empty placeholder, so directory listings
+ * and NSBundle lookups see every file, and filled in on demand.
+ *
+ * In the process running the guest, hooks on open, openat, fopen, stat,
+ * lstat and access consult the index. stat and access report a
+ * placeholder's eventual size without extracting anything; open fills the
+ * placeholder from the archive first. Past HIAH_LAZY_CACHE_BYTES of filled
+ * files per bundle, the least recently used ones go back to placeholders.
+ * Code that reads a placeholder without going through the hooks sees an
+ * empty file.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#ifndef HIAH_LAZY_BUNDLE_H
+#define HIAH_LAZY_BUNDLE_H
+
+#include "HIAHZipArchive.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/stat.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Directory inside a lazily installed bundle holding the archive, index and cache
+#define HIAH_LAZY_DIRECTORY ".hiah-lazy"
+
+/// Budget for files filled from the archive, per bundle
+#define HIAH_LAZY_CACHE_BYTES (128ull * 1024 * 1024)
+
+typedef struct {
+    uint64_t eagerFiles;          // Extracted at install time
+    uint64_t eagerBytes;
+    uint64_t lazyFiles;           // Left in the archive
+    uint64_t lazyBytes;
+    uint64_t wallNs;
+} HIAHLazyInstallStats;
+
+/**
+ * Installs the app in `archivePath` (the Payload/<Name>.app/ it contains)
+ * as `applicationsPath`/<Name>.app and writes that path to `bundlePath`.
+ * An existing bundle at that path should be removed first; on failure the
+ * partly written bundle is left for the caller to remove.
+ *
+ * `filter` applies to the files extracted at install time. It and `stats`
+ * may be NULL.
+ *
+ * @return 0 or an errno value: ENOENT if the archive holds no app bundle,
+ *         otherwise as for HIAHZipExtract.
+ */
+int HIAHLazyBundleInstall(const char *archivePath, const char *applicationsPath,
+                          const HIAHZipFilter *filter, char *bundlePath, size_t bundlePathSize,
+                          HIAHLazyInstallStats *stats);
+
+/**
+ * Makes the lazily installed bundle at `bundlePath` available to the
+ * functions below (and the hooks). Mounting a bundle twice is harmless.
+ *
+ * @return true if the bundle is a lazy install and was mounted.
+ */
+bool HIAHLazyBundleMount(const char *bundlePath);
+
+/**
+ * If `path` is a file of a mounted bundle that is served from the archive,
+ * makes sure it holds its contents rather than the placeholder.
+ *
+ * @return 0 (also when `path` is not served from an archive) or an errno
+ *         value if extraction failed.
+ */
+int HIAHLazyBundleFill(const char *path);
+
+/**
+ * Fills `st` for a file of a mounted bundle that is served from the
+ * archive, with its full size even while it is still a placeholder.
+ *
+ * @return false if `path` is not served from an archive.
+ */
+bool HIAHLazyBundleStat(const char *path, struct stat *st);
+
+/**
+ * Installs the file hooks (see HIAHMountInstallHooks), which serve files of
+ * mounted bundles from the archive. Only needed in the process running a
+ * guest from a mounted bundle; a no-op off Darwin.
+ */
+void HIAHLazyBundleInstallHooks(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HIAH_LAZY_BUNDLE_H */
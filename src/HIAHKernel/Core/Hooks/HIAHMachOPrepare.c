@@ -0,0 +1,674 @@
+/**
+ * HIAHMachOPrepare.c
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Streaming Mach-O preparation implementation.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#include "HIAHMachOPrepare.h"
+#include <CommonCrypto/CommonDigest.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Mach-O constants, spelled out so this builds without the SDK headers
+#define HIAH_FAT_MAGIC 0xcafebabeu        // Big-endian on disk
+#define HIAH_FAT_MAGIC_64 0xcafebabfu
+#define HIAH_MH_MAGIC_64 0xfeedfacfu
+#define HIAH_MH_EXECUTE 0x2u
+#define HIAH_MH_BUNDLE 0x8u
+#define HIAH_LC_SEGMENT_64 0x19u
+#define HIAH_LC_CODE_SIGNATURE 0x1du
+#define HIAH_CPU_TYPE_ARM64 0x0100000cu
+#define HIAH_CPU_SUBTYPE_MASK 0x00ffffffu
+#define HIAH_MACH_HEADER_SIZE 32
+#define HIAH_FAT_MAX_ARCHS 16
+
+// The __PAGEZERO placement JIT-less loading needs (see HIAHMachOUtils)
+#define HIAH_PAGEZERO_VMADDR 0xFFFFC000ull
+#define HIAH_PAGEZERO_VMSIZE 0x4000ull
+#define HIAH_LINKEDIT_ALIGN 0x4000ull
+
+// Code signing blobs (big-endian)
+#define HIAH_CS_SUPERBLOB 0xfade0cc0u
+#define HIAH_CS_CODEDIRECTORY 0xfade0c02u
+#define HIAH_CS_REQUIREMENTS 0xfade0c01u
+#define HIAH_CS_ENTITLEMENTS 0xfade7171u
+#define HIAH_CS_CMS_WRAPPER 0xfade0b01u
+#define HIAH_CS_SLOT_CODEDIRECTORY 0u
+#define HIAH_CS_SLOT_REQUIREMENTS 2u
+#define HIAH_CS_SLOT_ENTITLEMENTS 5u
+#define HIAH_CS_SLOT_SIGNATURE 0x10000u
+#define HIAH_CS_ADHOC 0x2u
+#define HIAH_CS_VERSION 0x20400u          // With the exec segment fields
+#define HIAH_CS_HASHTYPE_SHA256 2u
+#define HIAH_CS_DIRECTORY_SIZE 88
+#define HIAH_CS_SPECIAL_SLOTS 5u
+#define HIAH_CS_PAGE_SHIFT 12
+#define HIAH_CS_PAGE_SIZE (1u << HIAH_CS_PAGE_SHIFT)
+#define HIAH_CS_HASH_SIZE CC_SHA256_DIGEST_LENGTH
+
+/// Headers (fat table or load commands) larger than this are left alone
+#define HIAH_PREPARE_MAX_HEADER (256 * 1024)
+
+// The entitlements HIAHSigner requests when signing at launch
+static const char kHIAHPrepareEntitlements[] =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<!DOCTYPE plist PUBLIC \"-//Apple//DTD PLIST 1.0//EN\" "
+    "\"http://www.apple.com/DTDs/PropertyList-1.0.dtd\">\n"
+    "<plist version=\"1.0\">\n"
+    "<dict>\n"
+    "\t<key>com.apple.security.cs.allow-jit</key>\n"
+    "\t<true/>\n"
+    "\t<key>com.apple.security.cs.allow-unsigned-executable-memory</key>\n"
+    "\t<true/>\n"
+    "\t<key>com.apple.security.cs.disable-library-validation</key>\n"
+    "\t<true/>\n"
+    "\t<key>get-task-allow</key>\n"
+    "\t<true/>\n"
+    "</dict>\n"
+    "</plist>\n";
+
+typedef enum {
+    HIAHPrepareSniff,             // Collecting the magic
+    HIAHPrepareFatTable,          // Collecting the fat header and arch table
+    HIAHPrepareSliceHeader,       // Collecting the slice's header and load commands
+    HIAHPrepareSlice,             // Streaming the slice body
+    HIAHPreparePassthrough,       // Not something we rewrite: copied unchanged
+} HIAHPreparePhase;
+
+typedef struct {
+    int fd;
+    HIAHMachOPrepareStats *stats;
+    char identifier[256];         // Signing identifier: the file's name
+    HIAHPreparePhase phase;
+    uint64_t fileSize;
+
+    uint8_t *head;                // Bytes collected for the current header
+    size_t headLength;
+    size_t headNeeded;
+
+    uint64_t input;               // Input bytes consumed so far
+    bool fat;
+    uint64_t sliceOffset;         // Within the input; 0 for thin files
+    uint64_t sliceSize;
+    uint64_t sliceInput;          // Slice bytes consumed so far
+
+    // Re-signing: slice bytes before codeLimit are hashed page by page and
+    // written, the old signature after it is replaced at the end
+    bool sign;
+    uint64_t codeLimit;
+    uint32_t pageCount;
+    uint32_t pagesHashed;
+    uint32_t pageFill;
+    CC_SHA256_CTX page;
+    uint8_t *hashes;
+    uint64_t textOffset;
+    uint64_t textSize;
+    size_t signatureSize;         // Padded; what LC_CODE_SIGNATURE now records
+} HIAHPrepare;
+
+#pragma mark - Helpers
+
+static uint32_t HIAHGet32(const uint8_t *bytes) {
+    return (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 |
+           (uint32_t)bytes[3] << 24;
+}
+
+static uint64_t HIAHGet64(const uint8_t *bytes) {
+    return (uint64_t)HIAHGet32(bytes) | (uint64_t)HIAHGet32(bytes + 4) << 32;
+}
+
+static void HIAHPut32(uint8_t *bytes, uint32_t value) {
+    for (int i = 0; i < 4; i++) bytes[i] = (uint8_t)(value >> (8 * i));
+}
+
+static void HIAHPut64(uint8_t *bytes, uint64_t value) {
+    HIAHPut32(bytes, (uint32_t)value);
+    HIAHPut32(bytes + 4, (uint32_t)(value >> 32));
+}
+
+static uint32_t HIAHGetBE32(const uint8_t *bytes) {
+    return (uint32_t)bytes[0] << 24 | (uint32_t)bytes[1] << 16 | (uint32_t)bytes[2] << 8 |
+           (uint32_t)bytes[3];
+}
+
+static uint64_t HIAHGetBE64(const uint8_t *bytes) {
+    return (uint64_t)HIAHGetBE32(bytes) << 32 | HIAHGetBE32(bytes + 4);
+}
+
+static void HIAHPutBE32(uint8_t *bytes, uint32_t value) {
+    for (int i = 0; i < 4; i++) bytes[i] = (uint8_t)(value >> (24 - 8 * i));
+}
+
+static void HIAHPutBE64(uint8_t *bytes, uint64_t value) {
+    HIAHPutBE32(bytes, (uint32_t)(value >> 32));
+    HIAHPutBE32(bytes + 4, (uint32_t)value);
+}
+
+static int HIAHPrepareWriteFully(int fd, const void *buffer, size_t length) {
+    const uint8_t *bytes = buffer;
+    while (length > 0) {
+        ssize_t written = write(fd, bytes, length);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return written < 0 ? errno : EIO;
+        bytes += written;
+        length -= (size_t)written;
+    }
+    return 0;
+}
+
+static void HIAHPrepareCount(uint64_t *counter, uint64_t amount) {
+    __atomic_fetch_add(counter, amount, __ATOMIC_RELAXED);
+}
+
+#pragma mark - Signature
+
+static size_t HIAHSignatureSize(size_t identifierLength, uint32_t pageCount) {
+    size_t directory = HIAH_CS_DIRECTORY_SIZE + identifierLength + 1 +
+                       (HIAH_CS_SPECIAL_SLOTS + pageCount) * (size_t)HIAH_CS_HASH_SIZE;
+    size_t total = 12 + 4 * 8 + directory + 12 + 8 + (sizeof(kHIAHPrepareEntitlements) - 1) + 8;
+    return (total + 15) & ~(size_t)15;
+}
+
+// Builds the ad-hoc signature blob (code directory, empty requirements,
+// entitlements and an empty CMS wrapper) into `blob`, zero-padded to
+// `prepare->signatureSize`
+static void HIAHSignatureBuild(const HIAHPrepare *prepare, uint8_t *blob) {
+    size_t identifierLength = strlen(prepare->identifier) + 1;
+    size_t hashOffset = HIAH_CS_DIRECTORY_SIZE + identifierLength +
+                        HIAH_CS_SPECIAL_SLOTS * (size_t)HIAH_CS_HASH_SIZE;
+    size_t directorySize = hashOffset + (size_t)prepare->pageCount * HIAH_CS_HASH_SIZE;
+    size_t entitlementsLength = sizeof(kHIAHPrepareEntitlements) - 1;
+
+    size_t directoryAt = 12 + 4 * 8;
+    size_t requirementsAt = directoryAt + directorySize;
+    size_t entitlementsAt = requirementsAt + 12;
+    size_t signatureAt = entitlementsAt + 8 + entitlementsLength;
+    size_t total = signatureAt + 8;
+    memset(blob, 0, prepare->signatureSize);
+
+    HIAHPutBE32(blob, HIAH_CS_SUPERBLOB);
+    HIAHPutBE32(blob + 4, (uint32_t)total);
+    HIAHPutBE32(blob + 8, 4);
+    const uint32_t slots[4][2] = {
+        {HIAH_CS_SLOT_CODEDIRECTORY, (uint32_t)directoryAt},
+        {HIAH_CS_SLOT_REQUIREMENTS, (uint32_t)requirementsAt},
+        {HIAH_CS_SLOT_ENTITLEMENTS, (uint32_t)entitlementsAt},
+        {HIAH_CS_SLOT_SIGNATURE, (uint32_t)signatureAt},
+    };
+    for (int i = 0; i < 4; i++) {
+        HIAHPutBE32(blob + 12 + 8 * i, slots[i][0]);
+        HIAHPutBE32(blob + 16 + 8 * i, slots[i][1]);
+    }
+
+    uint8_t *requirements = blob + requirementsAt;
+    HIAHPutBE32(requirements, HIAH_CS_REQUIREMENTS);
+    HIAHPutBE32(requirements + 4, 12);
+    uint8_t *entitlements = blob + entitlementsAt;
+    HIAHPutBE32(entitlements, HIAH_CS_ENTITLEMENTS);
+    HIAHPutBE32(entitlements + 4, (uint32_t)(8 + entitlementsLength));
+    memcpy(entitlements + 8, kHIAHPrepareEntitlements, entitlementsLength);
+    HIAHPutBE32(blob + signatureAt, HIAH_CS_CMS_WRAPPER);
+    HIAHPutBE32(blob + signatureAt + 4, 8);
+
+    uint8_t *directory = blob + directoryAt;
+    HIAHPutBE32(directory, HIAH_CS_CODEDIRECTORY);
+    HIAHPutBE32(directory + 4, (uint32_t)directorySize);
+    HIAHPutBE32(directory + 8, HIAH_CS_VERSION);
+    HIAHPutBE32(directory + 12, HIAH_CS_ADHOC);
+    HIAHPutBE32(directory + 16, (uint32_t)hashOffset);
+    HIAHPutBE32(directory + 20, HIAH_CS_DIRECTORY_SIZE);
+    HIAHPutBE32(directory + 24, HIAH_CS_SPECIAL_SLOTS);
+    HIAHPutBE32(directory + 28, prepare->pageCount);
+    HIAHPutBE32(directory + 32, (uint32_t)prepare->codeLimit);
+    directory[36] = HIAH_CS_HASH_SIZE;
+    directory[37] = HIAH_CS_HASHTYPE_SHA256;
+    directory[39] = HIAH_CS_PAGE_SHIFT;
+    HIAHPutBE64(directory + 64, prepare->textOffset);
+    HIAHPutBE64(directory + 72, prepare->textSize);
+    memcpy(directory + HIAH_CS_DIRECTORY_SIZE, prepare->identifier, identifierLength);
+
+    // Special slot n sits n hashes before code slot 0
+    uint8_t *codeSlots = directory + hashOffset;
+    CC_SHA256(requirements, 12, codeSlots - HIAH_CS_SLOT_REQUIREMENTS * HIAH_CS_HASH_SIZE);
+    CC_SHA256(entitlements, (CC_LONG)(8 + entitlementsLength),
+              codeSlots - HIAH_CS_SLOT_ENTITLEMENTS * HIAH_CS_HASH_SIZE);
+    memcpy(codeSlots, prepare->hashes, (size_t)prepare->pageCount * HIAH_CS_HASH_SIZE);
+}
+
+#pragma mark - Slice
+
+// Patches the executable's header in `prepare->head` (header and load
+// commands) and, when its signature is where it can be replaced, resizes
+// the signature for the ad-hoc one. Returns false to copy the slice as is.
+static bool HIAHPreparePatchHeader(HIAHPrepare *prepare) {
+    uint8_t *head = prepare->head;
+    if (HIAHGet32(head) != HIAH_MH_MAGIC_64 || HIAHGet32(head + 4) != HIAH_CPU_TYPE_ARM64 ||
+        HIAHGet32(head + 12) != HIAH_MH_EXECUTE) {
+        return false;
+    }
+
+    uint32_t commandCount = HIAHGet32(head + 16);
+    size_t end = HIAH_MACH_HEADER_SIZE + HIAHGet32(head + 20);
+    uint8_t *pageZero = NULL;
+    uint8_t *linkEdit = NULL;
+    uint8_t *codeSignature = NULL;
+    size_t offset = HIAH_MACH_HEADER_SIZE;
+    for (uint32_t i = 0; i < commandCount; i++) {
+        if (offset + 8 > end) return false;
+        uint8_t *command = head + offset;
+        uint32_t type = HIAHGet32(command);
+        uint32_t size = HIAHGet32(command + 4);
+        if (size < 8 || size > end - offset) return false;
+
+        if (type == HIAH_LC_SEGMENT_64 && size >= 72) {
+            char name[17] = {0};
+            memcpy(name, command + 8, 16);
+            if (strcmp(name, "__PAGEZERO") == 0) {
+                pageZero = command;
+            } else if (strcmp(name, "__TEXT") == 0) {
+                prepare->textOffset = HIAHGet64(command + 40);
+                prepare->textSize = HIAHGet64(command + 48);
+            } else if (strcmp(name, "__LINKEDIT") == 0) {
+                linkEdit = command;
+            }
+        } else if (type == HIAH_LC_CODE_SIGNATURE && size >= 16) {
+            codeSignature = command;
+        }
+        offset += size;
+    }
+
+    HIAHPut32(head + 12, HIAH_MH_BUNDLE);
+    if (pageZero) {
+        HIAHPut64(pageZero + 24, HIAH_PAGEZERO_VMADDR);
+        HIAHPut64(pageZero + 32, HIAH_PAGEZERO_VMSIZE);
+    }
+
+    // The old signature has to be the tail of __LINKEDIT and of the slice,
+    // so the new one can take its place without moving anything else
+    if (!linkEdit || !codeSignature) return true;
+    uint64_t signatureOffset = HIAHGet32(codeSignature + 8);
+    uint64_t signatureSize = HIAHGet32(codeSignature + 12);
+    uint64_t linkEditOffset = HIAHGet64(linkEdit + 40);
+    uint64_t linkEditEnd = linkEditOffset + HIAHGet64(linkEdit + 48);
+    if (signatureOffset < end || signatureOffset + signatureSize != prepare->sliceSize ||
+        linkEditEnd != prepare->sliceSize || signatureOffset < linkEditOffset) {
+        return true;
+    }
+
+    prepare->codeLimit = signatureOffset;
+    prepare->pageCount =
+        (uint32_t)((signatureOffset + HIAH_CS_PAGE_SIZE - 1) >> HIAH_CS_PAGE_SHIFT);
+    prepare->hashes = malloc((size_t)prepare->pageCount * HIAH_CS_HASH_SIZE);
+    if (!prepare->hashes) return true;
+    prepare->signatureSize = HIAHSignatureSize(strlen(prepare->identifier), prepare->pageCount);
+
+    uint64_t linkEditSize = signatureOffset + prepare->signatureSize - linkEditOffset;
+    uint64_t linkEditVMSize = (linkEditSize + HIAH_LINKEDIT_ALIGN - 1) & ~(HIAH_LINKEDIT_ALIGN - 1);
+    HIAHPut32(codeSignature + 12, (uint32_t)prepare->signatureSize);
+    HIAHPut64(linkEdit + 48, linkEditSize);
+    if (linkEditVMSize > HIAHGet64(linkEdit + 32)) HIAHPut64(linkEdit + 32, linkEditVMSize);
+    prepare->sign = true;
+    CC_SHA256_Init(&prepare->page);
+    return true;
+}
+
+// Writes slice bytes, hashing everything before the code limit and
+// dropping the old signature after it
+static int HIAHPrepareEmit(HIAHPrepare *prepare, const uint8_t *data, size_t length) {
+    if (!prepare->sign) return HIAHPrepareWriteFully(prepare->fd, data, length);
+
+    uint64_t position = prepare->sliceInput;
+    if (position >= prepare->codeLimit) return 0;
+    if (length > prepare->codeLimit - position) length = (size_t)(prepare->codeLimit - position);
+
+    for (size_t done = 0; done < length;) {
+        size_t chunk = HIAH_CS_PAGE_SIZE - prepare->pageFill;
+        if (chunk > length - done) chunk = length - done;
+        CC_SHA256_Update(&prepare->page, data + done, (CC_LONG)chunk);
+        prepare->pageFill += (uint32_t)chunk;
+        done += chunk;
+        if (prepare->pageFill == HIAH_CS_PAGE_SIZE) {
+            CC_SHA256_Final(prepare->hashes + (size_t)prepare->pagesHashed++ * HIAH_CS_HASH_SIZE,
+                            &prepare->page);
+            CC_SHA256_Init(&prepare->page);
+            prepare->pageFill = 0;
+        }
+    }
+    return HIAHPrepareWriteFully(prepare->fd, data, length);
+}
+
+#pragma mark - Stream
+
+// Collects input into `head` up to `headNeeded` bytes; returns how many
+// bytes of `data` were taken
+static size_t HIAHPrepareCollect(HIAHPrepare *prepare, const uint8_t *data, size_t length) {
+    size_t take = prepare->headNeeded - prepare->headLength;
+    if (take > length) take = length;
+    memcpy(prepare->head + prepare->headLength, data, take);
+    prepare->headLength += take;
+    return take;
+}
+
+static bool HIAHPrepareGrowHead(HIAHPrepare *prepare, size_t needed) {
+    if (needed > HIAH_PREPARE_MAX_HEADER) return false;
+    uint8_t *head = realloc(prepare->head, needed);
+    if (!head) return false;
+    prepare->head = head;
+    prepare->headNeeded = needed;
+    return true;
+}
+
+// Gives up on rewriting: whatever was collected is written as it came
+static int HIAHPrepareGiveUp(HIAHPrepare *prepare) {
+    prepare->phase = HIAHPreparePassthrough;
+    int error = HIAHPrepareWriteFully(prepare->fd, prepare->head, prepare->headLength);
+    prepare->headLength = 0;
+    return error;
+}
+
+static void HIAHPrepareStartSlice(HIAHPrepare *prepare) {
+    prepare->phase = HIAHPrepareSliceHeader;
+    prepare->headLength = 0;
+    prepare->headNeeded = HIAH_MACH_HEADER_SIZE;
+}
+
+// Picks the arm64 slice from a complete fat table; false if there is none
+static bool HIAHPrepareChooseSlice(HIAHPrepare *prepare) {
+    bool wide = HIAHGetBE32(prepare->head) == HIAH_FAT_MAGIC_64;
+    uint32_t count = HIAHGetBE32(prepare->head + 4);
+    size_t entrySize = wide ? 32 : 20;
+    bool found = false;
+
+    for (uint32_t i = 0; i < count; i++) {
+        const uint8_t *arch = prepare->head + 8 + i * entrySize;
+        if (HIAHGetBE32(arch) != HIAH_CPU_TYPE_ARM64) continue;
+        uint64_t offset = wide ? HIAHGetBE64(arch + 8) : HIAHGetBE32(arch + 8);
+        uint64_t size = wide ? HIAHGetBE64(arch + 16) : HIAHGetBE32(arch + 12);
+        if (offset < prepare->headNeeded || offset > prepare->fileSize ||
+            size > prepare->fileSize - offset || size < HIAH_MACH_HEADER_SIZE) {
+            continue;
+        }
+        // Plain arm64 runs everywhere; arm64e only if nothing else is there
+        bool plain = (HIAHGetBE32(arch + 4) & HIAH_CPU_SUBTYPE_MASK) == 0;
+        if (!found || plain) {
+            prepare->sliceOffset = offset;
+            prepare->sliceSize = size;
+            found = true;
+            if (plain) break;
+        }
+    }
+    return found;
+}
+
+static int HIAHPrepareInput(HIAHPrepare *prepare, const uint8_t *data, size_t length) {
+    int error = 0;
+    while (length > 0 && !error) {
+        size_t used = 0;
+        switch (prepare->phase) {
+            case HIAHPrepareSniff: {
+                used = HIAHPrepareCollect(prepare, data, length);
+                if (prepare->headLength < prepare->headNeeded) break;
+
+                uint32_t fatMagic = HIAHGetBE32(prepare->head);
+                uint32_t count = HIAHGetBE32(prepare->head + 4);
+                if ((fatMagic == HIAH_FAT_MAGIC || fatMagic == HIAH_FAT_MAGIC_64) && count > 0 &&
+                    count <= HIAH_FAT_MAX_ARCHS &&
+                    HIAHPrepareGrowHead(prepare,
+                                        8 + count * (fatMagic == HIAH_FAT_MAGIC_64 ? 32 : 20))) {
+                    prepare->fat = true;
+                    prepare->phase = HIAHPrepareFatTable;
+                    HIAHPrepareCount(&prepare->stats->binaries, 1);
+                } else if (HIAHGet32(prepare->head) == HIAH_MH_MAGIC_64) {
+                    // The collected bytes are the slice's first; keep them
+                    prepare->sliceSize = prepare->fileSize;
+                    prepare->sliceInput = prepare->headLength;
+                    prepare->phase = HIAHPrepareSliceHeader;
+                    prepare->headNeeded = HIAH_MACH_HEADER_SIZE;
+                    HIAHPrepareCount(&prepare->stats->binaries, 1);
+                } else {
+                    error = HIAHPrepareGiveUp(prepare);
+                }
+                break;
+            }
+
+            case HIAHPrepareFatTable:
+                used = HIAHPrepareCollect(prepare, data, length);
+                if (prepare->headLength < prepare->headNeeded) break;
+                if (!HIAHPrepareChooseSlice(prepare)) {
+                    error = HIAHPrepareGiveUp(prepare);
+                } else {
+                    HIAHPrepareStartSlice(prepare);
+                }
+                break;
+
+            case HIAHPrepareSliceHeader: {
+                // Bytes before the slice (other slices, padding) are dropped
+                if (prepare->input < prepare->sliceOffset) {
+                    uint64_t skip = prepare->sliceOffset - prepare->input;
+                    used = skip < length ? (size_t)skip : length;
+                    break;
+                }
+                used = HIAHPrepareCollect(prepare, data, length);
+                prepare->sliceInput += used;
+                if (prepare->headLength < prepare->headNeeded) break;
+
+                if (prepare->headNeeded == HIAH_MACH_HEADER_SIZE) {
+                    size_t needed = HIAH_MACH_HEADER_SIZE + HIAHGet32(prepare->head + 20);
+                    if (HIAHGet32(prepare->head) == HIAH_MH_MAGIC_64 &&
+                        needed > HIAH_MACH_HEADER_SIZE && needed <= prepare->sliceSize &&
+                        HIAHPrepareGrowHead(prepare, needed)) {
+                        break;
+                    }
+                } else {
+                    HIAHPreparePatchHeader(prepare);
+                }
+
+                // The head goes out through the same path as the body
+                prepare->phase = HIAHPrepareSlice;
+                uint64_t bodyStart = prepare->sliceInput;
+                prepare->sliceInput = 0;
+                error = HIAHPrepareEmit(prepare, prepare->head, prepare->headLength);
+                prepare->sliceInput = bodyStart;
+                break;
+            }
+
+            case HIAHPrepareSlice: {
+                uint64_t remaining = prepare->sliceSize - prepare->sliceInput;
+                used = remaining < length ? (size_t)remaining : length;
+                if (used > 0) error = HIAHPrepareEmit(prepare, data, used);
+                prepare->sliceInput += used;
+                // Anything past the slice (later slices) is dropped
+                if (used < length) used = length;
+                break;
+            }
+
+            case HIAHPreparePassthrough:
+                used = length;
+                error = HIAHPrepareWriteFully(prepare->fd, data, length);
+                break;
+        }
+        prepare->input += used;
+        data += used;
+        length -= used;
+    }
+    return error;
+}
+
+// Ends the slice: the final partial page is hashed and the signature written
+static int HIAHPrepareFinishSlice(HIAHPrepare *prepare) {
+    if (prepare->fat) {
+        HIAHPrepareCount(&prepare->stats->thinned, 1);
+        HIAHPrepareCount(&prepare->stats->thinnedBytes, prepare->fileSize - prepare->sliceSize);
+    }
+    if (!prepare->sign) return 0;
+
+    if (prepare->pageFill > 0) {
+        CC_SHA256_Final(prepare->hashes + (size_t)prepare->pagesHashed++ * HIAH_CS_HASH_SIZE,
+                        &prepare->page);
+        prepare->pageFill = 0;
+    }
+    if (prepare->pagesHashed != prepare->pageCount) return EILSEQ;
+
+    uint8_t *blob = malloc(prepare->signatureSize);
+    if (!blob) return ENOMEM;
+    HIAHSignatureBuild(prepare, blob);
+    int error = HIAHPrepareWriteFully(prepare->fd, blob, prepare->signatureSize);
+    free(blob);
+    if (!error) HIAHPrepareCount(&prepare->stats->prepared, 1);
+    return error;
+}
+
+#pragma mark - Filter
+
+static void *HIAHPrepareBegin(void *userData, const char *name, uint64_t size, int fd) {
+    // Nothing smaller than a Mach-O header is worth a look
+    if (size < HIAH_MACH_HEADER_SIZE) return NULL;
+
+    HIAHPrepare *prepare = calloc(1, sizeof(HIAHPrepare));
+    if (!prepare) return NULL;
+    prepare->head = malloc(HIAH_MACH_HEADER_SIZE);
+    if (!prepare->head) {
+        free(prepare);
+        return NULL;
+    }
+
+    static HIAHMachOPrepareStats unused;
+    prepare->stats = userData ? userData : &unused;
+    prepare->fd = fd;
+    prepare->fileSize = size;
+    prepare->headNeeded = 8;
+    const char *base = strrchr(name, '/');
+    snprintf(prepare->identifier, sizeof(prepare->identifier), "%s", base ? base + 1 : name);
+    return prepare;
+}
+
+static int HIAHPrepareWrite(void *state, const void *data, size_t length) {
+    return HIAHPrepareInput(state, data, length);
+}
+
+static int HIAHPrepareFinish(void *state, int error) {
+    HIAHPrepare *prepare = state;
+    if (!error && prepare->phase == HIAHPrepareSlice) {
+        error = prepare->sliceInput == prepare->sliceSize ? HIAHPrepareFinishSlice(prepare)
+                                                          : EILSEQ;
+    } else if (!error && prepare->phase != HIAHPreparePassthrough) {
+        // Ended while still collecting a header: keep the bytes unchanged
+        error = HIAHPrepareGiveUp(prepare);
+    }
+    free(prepare->hashes);
+    free(prepare->head);
+    free(prepare);
+    return error;
+}
+
+HIAHZipFilter HIAHMachOPrepareFilter(HIAHMachOPrepareStats *stats) {
+    return (HIAHZipFilter){
+        .begin = HIAHPrepareBegin,
+        .write = HIAHPrepareWrite,
+        .finish = HIAHPrepareFinish,
+        .userData = stats,
+    };
+}
+
+#pragma mark - Launch
+
+bool HIAHMachOIsPrepared(const char *path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    uint8_t header[HIAH_MACH_HEADER_SIZE];
+    uint8_t *commands = NULL;
+    uint8_t *page = NULL;
+    bool prepared = false;
+    if (pread(fd, header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+        HIAHGet32(header) != HIAH_MH_MAGIC_64 || HIAHGet32(header + 4) != HIAH_CPU_TYPE_ARM64 ||
+        HIAHGet32(header + 12) != HIAH_MH_BUNDLE || HIAHGet32(header + 20) == 0 ||
+        HIAHGet32(header + 20) > HIAH_PREPARE_MAX_HEADER) {
+        goto done;
+    }
+
+    size_t commandsSize = HIAHGet32(header + 20);
+    uint32_t commandCount = HIAHGet32(header + 16);
+    commands = malloc(commandsSize);
+    if (!commands || pread(fd, commands, commandsSize, HIAH_MACH_HEADER_SIZE) !=
+                         (ssize_t)commandsSize) {
+        goto done;
+    }
+
+    bool pageZeroPatched = false;
+    uint64_t signatureOffset = 0;
+    uint64_t signatureSize = 0;
+    for (size_t offset = 0, i = 0; i < commandCount && offset + 8 <= commandsSize; i++) {
+        const uint8_t *command = commands + offset;
+        uint32_t size = HIAHGet32(command + 4);
+        if (size < 8 || size > commandsSize - offset) break;
+        if (HIAHGet32(command) == HIAH_LC_SEGMENT_64 && size >= 72 &&
+            strncmp((const char *)command + 8, "__PAGEZERO", 16) == 0) {
+            pageZeroPatched = HIAHGet64(command + 24) == HIAH_PAGEZERO_VMADDR;
+        } else if (HIAHGet32(command) == HIAH_LC_CODE_SIGNATURE && size >= 16) {
+            signatureOffset = HIAHGet32(command + 8);
+            signatureSize = HIAHGet32(command + 12);
+        }
+        offset += size;
+    }
+    if (!pageZeroPatched || signatureSize < 12 + 8 + HIAH_CS_DIRECTORY_SIZE) goto done;
+
+    // Find the code directory through the superblob index
+    uint8_t index[12 + 16 * 8];
+    if (pread(fd, index, 12, (off_t)signatureOffset) != 12 ||
+        HIAHGetBE32(index) != HIAH_CS_SUPERBLOB || HIAHGetBE32(index + 8) > 16) {
+        goto done;
+    }
+    uint32_t slotCount = HIAHGetBE32(index + 8);
+    if (pread(fd, index + 12, slotCount * 8, (off_t)signatureOffset + 12) !=
+        (ssize_t)(slotCount * 8)) {
+        goto done;
+    }
+    uint64_t directoryOffset = 0;
+    for (uint32_t i = 0; i < slotCount; i++) {
+        if (HIAHGetBE32(index + 12 + 8 * i) == HIAH_CS_SLOT_CODEDIRECTORY) {
+            directoryOffset = signatureOffset + HIAHGetBE32(index + 16 + 8 * i);
+        }
+    }
+    uint8_t directory[HIAH_CS_DIRECTORY_SIZE];
+    if (directoryOffset == 0 ||
+        directoryOffset + sizeof(directory) > signatureOffset + signatureSize ||
+        pread(fd, directory, sizeof(directory), (off_t)directoryOffset) !=
+            (ssize_t)sizeof(directory) ||
+        HIAHGetBE32(directory) != HIAH_CS_CODEDIRECTORY ||
+        !(HIAHGetBE32(directory + 12) & HIAH_CS_ADHOC) ||
+        HIAHGetBE32(directory + 32) != signatureOffset || HIAHGetBE32(directory + 28) == 0 ||
+        directory[36] != HIAH_CS_HASH_SIZE || directory[37] != HIAH_CS_HASHTYPE_SHA256 ||
+        directory[39] != HIAH_CS_PAGE_SHIFT) {
+        goto done;
+    }
+
+    // The header page is what any later patch would touch: its hash must
+    // still match
+    uint8_t expected[HIAH_CS_HASH_SIZE];
+    uint8_t actual[HIAH_CS_HASH_SIZE];
+    size_t pageLength = signatureOffset < HIAH_CS_PAGE_SIZE ? (size_t)signatureOffset
+                                                            : HIAH_CS_PAGE_SIZE;
+    page = malloc(HIAH_CS_PAGE_SIZE);
+    if (page && pread(fd, expected, sizeof(expected),
+                      (off_t)(directoryOffset + HIAHGetBE32(directory + 16))) ==
+                    (ssize_t)sizeof(expected) &&
+        pread(fd, page, pageLength, 0) == (ssize_t)pageLength) {
+        CC_SHA256(page, (CC_LONG)pageLength, actual);
+        prepared = memcmp(expected, actual, sizeof(actual)) == 0;
+    }
+
+done:
+    free(commands);
+    free(page);
+    close(fd);
+    return prepared;
+}
@@ -0,0 +1,63 @@
+/**
+ * HIAHMachOPrepare.h
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Install-time preparation of guest binaries, fused into extraction.
+ *
+ * Plugged into HIAHZipExtract as a filter, this recognizes Mach-O files as
+ * they are inflated and rewrites them on their way to disk, so each binary
+ * is written once and already launch-ready:
+ *
+ *  - Fat binaries are thinned to their arm64 slice.
+ *  - Executables get the JIT-less patches (MH_EXECUTE to MH_BUNDLE and the
+ *    __PAGEZERO move, as HIAHMachOUtils applies at launch).
+ *  - Their signature is replaced by an ad-hoc one equivalent to what the
+ *    launch-time signer produces. The code directory's page hashes are
+ *    computed while the pages stream past; the new signature takes the
+ *    old one's place at the end of __LINKEDIT, its size fixed up front.
+ *
+ * Libraries and other Mach-O files are only thinned; their slices keep
+ * their own valid signatures. Anything that doesn't parse cleanly is
+ * written unchanged and prepared at launch as before.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#ifndef HIAH_MACHO_PREPARE_H
+#define HIAH_MACHO_PREPARE_H
+
+#include "HIAHZipArchive.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint64_t binaries;            // Mach-O files seen
+    uint64_t thinned;             // Fat files reduced to one slice
+    uint64_t thinnedBytes;        // Dropped with the other slices
+    uint64_t prepared;            // Executables patched and ad-hoc signed
+} HIAHMachOPrepareStats;
+
+/**
+ * A filter for HIAHZipExtract / HIAHZipCopyEntry that prepares Mach-O
+ * files as described above. `stats`, if not NULL, is updated atomically
+ * and must outlive the extraction.
+ */
+HIAHZipFilter HIAHMachOPrepareFilter(HIAHMachOPrepareStats *stats);
+
+/**
+ * Whether the binary at `path` needs no JIT-less preparation at launch: a
+ * thin arm64 MH_BUNDLE with the __PAGEZERO patch and an ad-hoc signature
+ * whose code directory still matches the header page.
+ */
+bool HIAHMachOIsPrepared(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HIAH_MACHO_PREPARE_H */
@@ -0,0 +1,782 @@
+/**
+ * HIAHMountTable.c
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Virtual mount table implementation.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#include "HIAHMountTable.h"
+#include "HIAHChildTable.h"
+#include "HIAHLazyBundle.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __APPLE__
+#include "HIAHHook.h"
+#include <dirent.h>
+#include <dlfcn.h>
+#include <mach-o/dyld.h>
+#include <stdarg.h>
+#endif
+
+// Symlinks followed while resolving one path before giving up with ELOOP
+#define HIAH_MOUNT_MAX_LINKS 16
+
+// Longest path and translation kept in the cache; longer ones are resolved
+// every time
+#define HIAH_MOUNT_CACHE_KEY_MAX 160
+#define HIAH_MOUNT_CACHE_VALUE_MAX 336
+
+typedef struct {
+    char *virtualPath;            // Normalized, "/" or without a trailing slash
+    char *backingPath;
+    char *lowerPath;              // Read-only layer of an overlay, or NULL
+    uint32_t flags;
+} HIAHMount;
+
+typedef struct HIAHMountNode {
+    char *name;
+    size_t nameLength;
+    int mount;                    // Index of the mount here, or -1
+    struct HIAHMountNode **children;  // Sorted by name
+    size_t childCount;
+} HIAHMountNode;
+
+// Never changed once published: HIAHMountAdd builds a new table and swaps
+// it in, so lookups need no lock
+typedef struct {
+    HIAHMount *mounts;
+    size_t mountCount;
+    HIAHMountNode root;
+} HIAHMountTableState;
+
+// One cached resolution. `sequence` is odd while a writer fills the slot;
+// a reader copies the slot and keeps the copy only if `sequence` is even
+// and unchanged afterwards.
+typedef struct {
+    _Atomic(uint32_t) sequence;
+    _Atomic(uint32_t) lastUse;
+    uint64_t hash;
+    uint32_t generation;
+    uint8_t flags;
+    uint8_t result;               // 0 (not virtual) or 1 (translated to value)
+    uint16_t keyLength;
+    uint16_t valueLength;
+    char key[HIAH_MOUNT_CACHE_KEY_MAX];
+    char value[HIAH_MOUNT_CACHE_VALUE_MAX];
+} HIAHMountCacheSlot;
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static _Atomic(HIAHMountTableState *) g_table = NULL;
+// Bumped after each new table is published; cache entries from older
+// generations are ignored
+static _Atomic(uint32_t) g_generation = 1;
+
+static HIAHMountCacheSlot g_cache[HIAH_MOUNT_CACHE_SETS][HIAH_MOUNT_CACHE_WAYS];
+// Advances on every fill, so hits only read it: LRU order is kept to the
+// granularity of misses, without a shared counter written on every hit
+static _Atomic(uint32_t) g_cacheClock = 0;
+
+static _Atomic(int) g_scope = HIAHMountScopeProcess;
+
+static _Atomic(uint64_t) g_lookups = 0;
+static _Atomic(uint64_t) g_hits = 0;
+static _Atomic(uint64_t) g_translated = 0;
+
+#pragma mark - Paths
+
+// Collapses repeated slashes, "." and ".." without touching the disk
+// (symlinks are resolved afterwards, through the table)
+static bool HIAHMountNormalize(const char *path, char *out, size_t size) {
+    if (size < 2) return false;
+    size_t length = 0;
+    out[length++] = '/';
+
+    const char *cursor = path;
+    while (*cursor) {
+        while (*cursor == '/') cursor++;
+        if (!*cursor) break;
+        const char *end = strchr(cursor, '/');
+        size_t nameLength = end ? (size_t)(end - cursor) : strlen(cursor);
+
+        if (nameLength == 1 && cursor[0] == '.') {
+            // Stays put
+        } else if (nameLength == 2 && cursor[0] == '.' && cursor[1] == '.') {
+            while (length > 1 && out[length - 1] != '/') length--;
+            if (length > 1) length--;
+        } else {
+            if (length > 1) out[length++] = '/';
+            if (length + nameLength >= size) return false;
+            memcpy(out + length, cursor, nameLength);
+            length += nameLength;
+        }
+        cursor += nameLength;
+    }
+    out[length] = '\0';
+    return true;
+}
+
+static bool HIAHMountJoin(char *out, size_t size, const char *root, const char *rest) {
+    int written = snprintf(out, size, "%s%s", root, rest);
+    return written >= 0 && (size_t)written < size;
+}
+
+static uint64_t HIAHMountHash(const char *key, size_t length, uint32_t flags) {
+    uint64_t hash = 0xcbf29ce484222325ull ^ flags;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (uint8_t)key[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash ^ (hash >> 29);
+}
+
+#pragma mark - Table
+
+static HIAHMountNode *HIAHMountChild(const HIAHMountNode *node, const char *name, size_t nameLength,
+                                     size_t *insertAt) {
+    size_t low = 0, high = node->childCount;
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        const HIAHMountNode *child = node->children[middle];
+        size_t common = child->nameLength < nameLength ? child->nameLength : nameLength;
+        int order = memcmp(child->name, name, common);
+        if (order == 0) order = (child->nameLength > nameLength) - (child->nameLength < nameLength);
+        if (order == 0) return node->children[middle];
+        if (order < 0) low = middle + 1;
+        else high = middle;
+    }
+    if (insertAt) *insertAt = low;
+    return NULL;
+}
+
+static int HIAHMountInsert(HIAHMountNode *root, const char *virtualPath, int mount) {
+    HIAHMountNode *node = root;
+    const char *cursor = virtualPath;
+    while (*cursor) {
+        while (*cursor == '/') cursor++;
+        if (!*cursor) break;
+        const char *end = strchr(cursor, '/');
+        size_t nameLength = end ? (size_t)(end - cursor) : strlen(cursor);
+
+        size_t insertAt = 0;
+        HIAHMountNode *child = HIAHMountChild(node, cursor, nameLength, &insertAt);
+        if (!child) {
+            child = calloc(1, sizeof(*child));
+            HIAHMountNode **children = realloc(node->children, (node->childCount + 1) * sizeof(*children));
+            if (!child || !children || !(child->name = strndup(cursor, nameLength))) {
+                free(child);
+                if (children) node->children = children;
+                return ENOMEM;
+            }
+            child->nameLength = nameLength;
+            child->mount = -1;
+            memmove(children + insertAt + 1, children + insertAt, (node->childCount - insertAt) * sizeof(*children));
+            children[insertAt] = child;
+            node->children = children;
+            node->childCount++;
+        }
+        node = child;
+        cursor += nameLength;
+    }
+    node->mount = mount;
+    return 0;
+}
+
+// The deepest mount `path` (normalized) is under, and where in `path` the
+// part below the mount point starts ("" or "/...")
+static const HIAHMount *HIAHMountFind(const HIAHMountTableState *table, const char *path, size_t *split) {
+    const HIAHMountNode *node = &table->root;
+    const HIAHMount *found = node->mount >= 0 ? &table->mounts[node->mount] : NULL;
+    *split = 0;
+    if (path[1] == '\0') {
+        *split = 1;
+        return found;
+    }
+
+    const char *cursor = path;
+    while (*cursor == '/') {
+        const char *name = cursor + 1;
+        const char *end = strchr(name, '/');
+        size_t nameLength = end ? (size_t)(end - name) : strlen(name);
+        node = HIAHMountChild(node, name, nameLength, NULL);
+        if (!node) break;
+        cursor = name + nameLength;
+        if (node->mount >= 0) {
+            found = &table->mounts[node->mount];
+            *split = (size_t)(cursor - path);
+        }
+    }
+    return found;
+}
+
+int HIAHMountAdd(const char *virtualPath, const char *backingPath, const char *lowerPath, uint32_t flags) {
+    if (!virtualPath || virtualPath[0] != '/' || !backingPath) return EINVAL;
+    char normalized[PATH_MAX];
+    if (!HIAHMountNormalize(virtualPath, normalized, sizeof(normalized))) return ENAMETOOLONG;
+
+    pthread_mutex_lock(&g_lock);
+    const HIAHMountTableState *current = atomic_load(&g_table);
+    size_t previousCount = current ? current->mountCount : 0;
+
+    HIAHMountTableState *table = calloc(1, sizeof(*table));
+    HIAHMount *mounts = calloc(previousCount + 1, sizeof(*mounts));
+    int error = (table && mounts) ? 0 : ENOMEM;
+    size_t count = 0;
+    for (size_t i = 0; i < previousCount && !error; i++) {
+        if (strcmp(current->mounts[i].virtualPath, normalized) == 0) continue;
+        mounts[count++] = current->mounts[i];
+    }
+    if (!error) {
+        HIAHMount *mount = &mounts[count++];
+        mount->virtualPath = strdup(normalized);
+        mount->backingPath = strdup(backingPath);
+        mount->lowerPath = lowerPath ? strdup(lowerPath) : NULL;
+        mount->flags = flags;
+        if (!mount->virtualPath || !mount->backingPath || (lowerPath && !mount->lowerPath)) error = ENOMEM;
+    }
+
+    if (table) table->root.mount = -1;
+    for (size_t i = 0; i < count && !error; i++) {
+        error = HIAHMountInsert(&table->root, mounts[i].virtualPath, (int)i);
+    }
+    if (error) {
+        // Leaks whatever part of the new table was built; only on ENOMEM
+        pthread_mutex_unlock(&g_lock);
+        return error;
+    }
+
+    table->mounts = mounts;
+    table->mountCount = count;
+    // The old table is never freed: a lookup may still be walking it, and
+    // mounts change a handful of times per process
+    atomic_store(&g_table, table);
+    atomic_fetch_add(&g_generation, 1);
+    pthread_mutex_unlock(&g_lock);
+    return 0;
+}
+
+void HIAHMountRemoveAll(void) {
+    pthread_mutex_lock(&g_lock);
+    atomic_store(&g_table, NULL);
+    atomic_fetch_add(&g_generation, 1);
+    pthread_mutex_unlock(&g_lock);
+}
+
+void HIAHMountInvalidateCache(void) {
+    pthread_mutex_lock(&g_lock);
+    atomic_fetch_add(&g_generation, 1);
+    pthread_mutex_unlock(&g_lock);
+}
+
+#pragma mark - Persistence
+
+// Lines are "flags<TAB>virtual<TAB>backing<TAB>lower", lower empty for
+// plain mounts
+
+static bool HIAHMountSavable(const char *path) {
+    return !path || !strpbrk(path, "\t\n");
+}
+
+int HIAHMountSave(const char *path) {
+    if (!path) return EINVAL;
+    char temporary[PATH_MAX];
+    if (snprintf(temporary, sizeof(temporary), "%s.%d", path, (int)getpid()) >= (int)sizeof(temporary)) {
+        return ENAMETOOLONG;
+    }
+
+    const HIAHMountTableState *table = atomic_load(&g_table);
+    size_t count = table ? table->mountCount : 0;
+    for (size_t i = 0; i < count; i++) {
+        const HIAHMount *mount = &table->mounts[i];
+        if (!HIAHMountSavable(mount->virtualPath) || !HIAHMountSavable(mount->backingPath) ||
+            !HIAHMountSavable(mount->lowerPath)) {
+            return EINVAL;
+        }
+    }
+
+    FILE *file = fopen(temporary, "w");
+    if (!file) return errno;
+    for (size_t i = 0; i < count; i++) {
+        const HIAHMount *mount = &table->mounts[i];
+        fprintf(file, "%u\t%s\t%s\t%s\n", mount->flags, mount->virtualPath, mount->backingPath,
+                mount->lowerPath ? mount->lowerPath : "");
+    }
+    int error = ferror(file) ? EIO : 0;
+    if (fclose(file) != 0 && !error) error = errno;
+    if (!error && rename(temporary, path) != 0) error = errno;
+    if (error) unlink(temporary);
+    return error;
+}
+
+int HIAHMountLoad(const char *path) {
+    if (!path) return EINVAL;
+    FILE *file = fopen(path, "r");
+    if (!file) return errno;
+
+    int error = 0;
+    char *line = NULL;
+    size_t capacity = 0;
+    ssize_t length;
+    while ((length = getline(&line, &capacity, file)) > 0) {
+        if (line[length - 1] == '\n') line[length - 1] = '\0';
+        char *cursor = line;
+        char *flags = strsep(&cursor, "\t");
+        char *virtualPath = strsep(&cursor, "\t");
+        char *backingPath = strsep(&cursor, "\t");
+        char *lowerPath = strsep(&cursor, "\t");
+        if (!lowerPath || cursor || !backingPath[0]) {
+            error = EINVAL;
+            continue;
+        }
+        // The desktop's own container, for one, is out of the extension's reach
+        if (access(backingPath, F_OK) != 0) continue;
+
+        int added = HIAHMountAdd(virtualPath, backingPath, lowerPath[0] ? lowerPath : NULL,
+                                 (uint32_t)strtoul(flags, NULL, 10));
+        if (added && !error) error = added;
+    }
+    free(line);
+    fclose(file);
+    return error;
+}
+
+#pragma mark - Resolution
+
+// Walks the components of `current` below `split` in the layer at `root`.
+// If one is a symlink (the last one only with `followLast`), replaces it in
+// `current` with its target - translated again by the caller, so absolute
+// targets land in the virtual tree, not the host's.
+// Returns 1 if `current` was rewritten, 0 if there was no link to follow.
+static int HIAHMountFollowLink(const char *root, char *current, size_t currentSize, size_t split,
+                               bool followLast) {
+    char path[PATH_MAX];
+    size_t length = strlen(root);
+    if (length >= sizeof(path)) return 0;
+    memcpy(path, root, length + 1);
+
+    const char *cursor = current + split;
+    while (*cursor == '/') {
+        const char *name = cursor + 1;
+        const char *end = strchr(name, '/');
+        if (!end) end = name + strlen(name);
+        size_t nameLength = (size_t)(end - name);
+        if (length + 1 + nameLength >= sizeof(path)) return 0;
+        path[length++] = '/';
+        memcpy(path + length, name, nameLength);
+        length += nameLength;
+        path[length] = '\0';
+
+        struct stat st;
+        if (lstat(path, &st) != 0) return 0;
+        if (S_ISLNK(st.st_mode) && (*end != '\0' || followLast)) {
+            char target[PATH_MAX];
+            ssize_t targetLength = readlink(path, target, sizeof(target) - 1);
+            if (targetLength <= 0) return 0;
+            target[targetLength] = '\0';
+
+            char rewritten[PATH_MAX * 2];
+            int written = target[0] == '/'
+                ? snprintf(rewritten, sizeof(rewritten), "%s%s", target, end)
+                : snprintf(rewritten, sizeof(rewritten), "%.*s/%s%s", (int)(name - 1 - current), current,
+                           target, end);
+            if (written < 0 || (size_t)written >= sizeof(rewritten) ||
+                !HIAHMountNormalize(rewritten, current, currentSize)) {
+                errno = ENAMETOOLONG;
+                return -1;
+            }
+            return 1;
+        }
+        cursor = end;
+    }
+    return 0;
+}
+
+// Sets `*cacheable` when the result depends only on the table and the
+// backing directory: no symlink was followed, and no overlay's lower
+// directory was (or, for a missing path, could later be) chosen
+static int HIAHMountTranslate(const HIAHMountTableState *table, const char *path, uint32_t flags,
+                              char *resolved, size_t resolvedSize, bool *cacheable) {
+    *cacheable = false;
+    char current[PATH_MAX];
+    if (!HIAHMountNormalize(path, current, sizeof(current))) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    bool writing = flags & HIAHMountResolveWrite;
+    bool followLast = !(flags & HIAHMountResolveNoFollow);
+
+    for (unsigned links = 0;; links++) {
+        if (links > HIAH_MOUNT_MAX_LINKS) {
+            errno = ELOOP;
+            return -1;
+        }
+
+        size_t split;
+        const HIAHMount *mount = HIAHMountFind(table, current, &split);
+        if (!mount) {
+            // Not virtual, or a symlink led out of the virtual tree
+            if (links == 0) {
+                *cacheable = true;
+                return 0;
+            }
+            if (strlen(current) >= resolvedSize) {
+                errno = ENAMETOOLONG;
+                return -1;
+            }
+            strcpy(resolved, current);
+            return 1;
+        }
+
+        const char *rest = current + split;
+        char upper[PATH_MAX], lower[PATH_MAX];
+        if (!HIAHMountJoin(upper, sizeof(upper), mount->backingPath, rest) ||
+            (mount->lowerPath && !HIAHMountJoin(lower, sizeof(lower), mount->lowerPath, rest))) {
+            errno = ENAMETOOLONG;
+            return -1;
+        }
+
+        // The backing directory shadows the lower one
+        struct stat st;
+        int layer = -1;
+        if (lstat(upper, &st) == 0) layer = 0;
+        else if (mount->lowerPath && lstat(lower, &st) == 0) layer = 1;
+
+        // A missing path may just be behind a symlink the kernel would follow
+        // into the host's tree; a found one may be a symlink itself
+        int followed = 0;
+        if (layer < 0) {
+            followed = HIAHMountFollowLink(mount->backingPath, current, sizeof(current), split, followLast);
+            if (followed == 0 && mount->lowerPath) {
+                followed = HIAHMountFollowLink(mount->lowerPath, current, sizeof(current), split, followLast);
+            }
+        } else if (S_ISLNK(st.st_mode) && followLast) {
+            followed = HIAHMountFollowLink(layer == 0 ? mount->backingPath : mount->lowerPath, current,
+                                           sizeof(current), split, true);
+        }
+        if (followed < 0) return -1;
+        if (followed > 0) continue;
+
+        if (writing && ((mount->flags & HIAHMountReadOnly) || layer == 1)) {
+            errno = EROFS;
+            return -1;
+        }
+        const char *translated = layer == 1 ? lower : upper;
+        if (strlen(translated) >= resolvedSize) {
+            errno = ENAMETOOLONG;
+            return -1;
+        }
+        strcpy(resolved, translated);
+        *cacheable = links == 0 && (layer == 0 || !mount->lowerPath);
+        return 1;
+    }
+}
+
+#pragma mark - Cache
+
+static bool HIAHMountCacheGet(uint64_t hash, const char *key, size_t keyLength, uint32_t flags,
+                              uint32_t generation, char *resolved, size_t resolvedSize, int *result) {
+    HIAHMountCacheSlot *set = g_cache[hash & (HIAH_MOUNT_CACHE_SETS - 1)];
+    for (int way = 0; way < HIAH_MOUNT_CACHE_WAYS; way++) {
+        HIAHMountCacheSlot *slot = &set[way];
+        uint32_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        if (sequence & 1) continue;
+        if (slot->hash != hash || slot->generation != generation || slot->flags != flags ||
+            slot->keyLength != keyLength) {
+            continue;
+        }
+
+        // Copy first and check afterwards: a writer may be changing the slot
+        char value[HIAH_MOUNT_CACHE_VALUE_MAX];
+        size_t valueLength = slot->valueLength;
+        if (valueLength >= sizeof(value)) continue;
+        memcpy(value, slot->value, valueLength);
+        bool matches = memcmp(slot->key, key, keyLength) == 0;
+        int cached = slot->result;
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&slot->sequence, memory_order_relaxed) != sequence || !matches) continue;
+
+        if (cached) {
+            if (valueLength >= resolvedSize) return false;
+            memcpy(resolved, value, valueLength);
+            resolved[valueLength] = '\0';
+        }
+        atomic_store_explicit(&slot->lastUse, atomic_load_explicit(&g_cacheClock, memory_order_relaxed),
+                              memory_order_relaxed);
+        *result = cached;
+        return true;
+    }
+    return false;
+}
+
+static void HIAHMountCachePut(uint64_t hash, const char *key, size_t keyLength, uint32_t flags,
+                              uint32_t generation, const char *resolved, int result) {
+    size_t valueLength = result ? strlen(resolved) : 0;
+    if (keyLength >= HIAH_MOUNT_CACHE_KEY_MAX || valueLength >= HIAH_MOUNT_CACHE_VALUE_MAX) return;
+
+    // Replace a stale slot, else the least recently used one
+    HIAHMountCacheSlot *set = g_cache[hash & (HIAH_MOUNT_CACHE_SETS - 1)];
+    HIAHMountCacheSlot *victim = &set[0];
+    uint32_t now = atomic_fetch_add_explicit(&g_cacheClock, 1, memory_order_relaxed) + 1;
+    uint32_t oldest = 0;
+    for (int way = 0; way < HIAH_MOUNT_CACHE_WAYS; way++) {
+        HIAHMountCacheSlot *slot = &set[way];
+        if (slot->generation != generation) {
+            victim = slot;
+            break;
+        }
+        uint32_t age = now - atomic_load_explicit(&slot->lastUse, memory_order_relaxed);
+        if (age >= oldest) {
+            oldest = age;
+            victim = slot;
+        }
+    }
+
+    // Another thread filling the same slot wins; this result just isn't cached
+    uint32_t sequence = atomic_load_explicit(&victim->sequence, memory_order_relaxed);
+    if ((sequence & 1) || !atomic_compare_exchange_strong(&victim->sequence, &sequence, sequence + 1)) return;
+    atomic_thread_fence(memory_order_release);
+
+    victim->hash = hash;
+    victim->generation = generation;
+    victim->flags = (uint8_t)flags;
+    victim->result = (uint8_t)result;
+    victim->keyLength = (uint16_t)keyLength;
+    victim->valueLength = (uint16_t)valueLength;
+    memcpy(victim->key, key, keyLength);
+    memcpy(victim->value, resolved, valueLength);
+    atomic_store_explicit(&victim->lastUse, now, memory_order_relaxed);
+    atomic_store_explicit(&victim->sequence, sequence + 2, memory_order_release);
+}
+
+int HIAHMountResolve(const char *path, uint32_t flags, char *resolved, size_t resolvedSize) {
+    if (!path || path[0] != '/' || !resolved) return 0;
+
+    // Read the generation before the table, so a result cached under it was
+    // computed with that table or a newer one
+    uint32_t generation = atomic_load(&g_generation);
+    const HIAHMountTableState *table = atomic_load(&g_table);
+    if (!table || table->mountCount == 0) return 0;
+
+    // Writes are rarer and depend on what exists right now
+    bool cacheable;
+    if (flags & HIAHMountResolveWrite) {
+        return HIAHMountTranslate(table, path, flags, resolved, resolvedSize, &cacheable);
+    }
+
+    atomic_fetch_add_explicit(&g_lookups, 1, memory_order_relaxed);
+    size_t keyLength = strlen(path);
+    uint64_t hash = HIAHMountHash(path, keyLength, flags);
+    int result;
+    if (HIAHMountCacheGet(hash, path, keyLength, flags, generation, resolved, resolvedSize, &result)) {
+        atomic_fetch_add_explicit(&g_hits, 1, memory_order_relaxed);
+        if (result) atomic_fetch_add_explicit(&g_translated, 1, memory_order_relaxed);
+        return result;
+    }
+
+    result = HIAHMountTranslate(table, path, flags, resolved, resolvedSize, &cacheable);
+    if (result >= 0 && cacheable) HIAHMountCachePut(hash, path, keyLength, flags, generation, resolved, result);
+    if (result > 0) atomic_fetch_add_explicit(&g_translated, 1, memory_order_relaxed);
+    return result;
+}
+
+void HIAHMountGetStats(HIAHMountStats *stats) {
+    if (!stats) return;
+    const HIAHMountTableState *table = atomic_load(&g_table);
+    stats->lookups = atomic_load_explicit(&g_lookups, memory_order_relaxed);
+    stats->hits = atomic_load_explicit(&g_hits, memory_order_relaxed);
+    stats->translated = atomic_load_explicit(&g_translated, memory_order_relaxed);
+    stats->mounts = table ? (uint32_t)table->mountCount : 0;
+}
+
+#pragma mark - Hooks
+
+void HIAHMountSetScope(HIAHMountScope scope) {
+    atomic_store(&g_scope, (int)scope);
+}
+
+#ifdef __APPLE__
+
+// Set while a hook is working, so file calls made on its behalf (including
+// from the lazy bundle code, whose own imports are hooked too) go straight
+// through
+static __thread bool gInFileHook = false;
+
+// Whether the calling thread's file calls go straight through
+static bool HIAHMountHookBypassed(void) {
+    if (gInFileHook) return true;
+    return atomic_load_explicit(&g_scope, memory_order_relaxed) == HIAHMountScopeGuestThreads &&
+           HIAHChildTableCurrentPID() == 0;
+}
+
+// The path a hooked call should use: translated through the table, with a
+// lazily installed bundle's placeholder filled in. NULL with errno set on
+// failure.
+static const char *HIAHMountHookPath(const char *path, uint32_t flags, char *translated) {
+    if (!path || HIAHMountHookBypassed()) return path;
+    gInFileHook = true;
+    int result = HIAHMountResolve(path, flags, translated, PATH_MAX);
+    int error = errno;
+    if (result > 0) path = translated;
+    if (result >= 0) error = HIAHLazyBundleFill(path);
+    gInFileHook = false;
+    if (result < 0 || error) {
+        errno = error;
+        return NULL;
+    }
+    return path;
+}
+
+// Like HIAHMountHookPath for stat-like calls. Returns 1 if `st` was filled
+// from a lazily installed bundle, 0 to make the call with `*path`, -1 on
+// failure.
+static int HIAHMountHookStat(const char **path, uint32_t flags, char *translated, struct stat *st) {
+    if (!*path || HIAHMountHookBypassed()) return 0;
+    gInFileHook = true;
+    int result = HIAHMountResolve(*path, flags, translated, PATH_MAX);
+    int error = errno;
+    if (result > 0) *path = translated;
+    bool lazy = result >= 0 && HIAHLazyBundleStat(*path, st);
+    gInFileHook = false;
+    if (result < 0) {
+        errno = error;
+        return -1;
+    }
+    return lazy ? 1 : 0;
+}
+
+DEFINE_HOOK(open, int, (const char *path, int flags, ...)) {
+    mode_t mode = 0;
+    if (flags & O_CREAT) {
+        va_list args;
+        va_start(args, flags);
+        mode = (mode_t)va_arg(args, int);
+        va_end(args);
+    }
+
+    uint32_t resolveFlags = 0;
+    if (flags & (O_WRONLY | O_RDWR | O_CREAT | O_TRUNC | O_APPEND)) resolveFlags |= HIAHMountResolveWrite;
+    if (flags & O_NOFOLLOW) resolveFlags |= HIAHMountResolveNoFollow;
+    char translated[PATH_MAX];
+    path = HIAHMountHookPath(path, resolveFlags, translated);
+    if (!path) return -1;
+    return ORIG_FUNC(open)(path, flags, mode);
+}
+
+// Relative paths (including those under a directory descriptor) are left
+// alone, so only absolute ones are translated
+DEFINE_HOOK(openat, int, (int fd, const char *path, int flags, ...)) {
+    mode_t mode = 0;
+    if (flags & O_CREAT) {
+        va_list args;
+        va_start(args, flags);
+        mode = (mode_t)va_arg(args, int);
+        va_end(args);
+    }
+
+    uint32_t resolveFlags = 0;
+    if (flags & (O_WRONLY | O_RDWR | O_CREAT | O_TRUNC | O_APPEND)) resolveFlags |= HIAHMountResolveWrite;
+    if (flags & O_NOFOLLOW) resolveFlags |= HIAHMountResolveNoFollow;
+    char translated[PATH_MAX];
+    path = HIAHMountHookPath(path, resolveFlags, translated);
+    if (!path) return -1;
+    return ORIG_FUNC(openat)(fd, path, flags, mode);
+}
+
+DEFINE_HOOK(fopen, FILE *, (const char *path, const char *mode)) {
+    bool writing = mode && (strchr(mode, 'w') || strchr(mode, 'a') || strchr(mode, '+'));
+    char translated[PATH_MAX];
+    path = HIAHMountHookPath(path, writing ? HIAHMountResolveWrite : 0, translated);
+    if (!path) return NULL;
+    return ORIG_FUNC(fopen)(path, mode);
+}
+
+DEFINE_HOOK(stat, int, (const char *path, struct stat *st)) {
+    char translated[PATH_MAX];
+    int result = HIAHMountHookStat(&path, 0, translated, st);
+    if (result != 0) return result > 0 ? 0 : -1;
+    return ORIG_FUNC(stat)(path, st);
+}
+
+DEFINE_HOOK(lstat, int, (const char *path, struct stat *st)) {
+    char translated[PATH_MAX];
+    int result = HIAHMountHookStat(&path, HIAHMountResolveNoFollow, translated, st);
+    if (result != 0) return result > 0 ? 0 : -1;
+    return ORIG_FUNC(lstat)(path, st);
+}
+
+DEFINE_HOOK(access, int, (const char *path, int mode)) {
+    char translated[PATH_MAX];
+    struct stat st;
+    int result = HIAHMountHookStat(&path, (mode & W_OK) ? HIAHMountResolveWrite : 0, translated, &st);
+    if (result < 0) return -1;
+    if (result > 0) {
+        if ((mode & W_OK) || ((mode & X_OK) && !(st.st_mode & 0111))) {
+            errno = EACCES;
+            return -1;
+        }
+        return 0;
+    }
+    return ORIG_FUNC(access)(path, mode);
+}
+
+DEFINE_HOOK(opendir, DIR *, (const char *path)) {
+    char translated[PATH_MAX];
+    if (path && !HIAHMountHookBypassed()) {
+        gInFileHook = true;
+        int result = HIAHMountResolve(path, 0, translated, sizeof(translated));
+        int error = errno;
+        gInFileHook = false;
+        if (result < 0) {
+            errno = error;
+            return NULL;
+        }
+        if (result > 0) path = translated;
+    }
+    return ORIG_FUNC(opendir)(path);
+}
+
+static void HIAHMountHookImage(const struct mach_header *header, intptr_t slide) {
+    (void)slide;
+    const HIAHMachHeader *image = (const HIAHMachHeader *)header;
+    if (orig_open) HIAHHookIntercept(HIAHHookScopeImage, image, orig_open, hook_open);
+    if (orig_openat) HIAHHookIntercept(HIAHHookScopeImage, image, orig_openat, hook_openat);
+    if (orig_fopen) HIAHHookIntercept(HIAHHookScopeImage, image, orig_fopen, hook_fopen);
+    if (orig_stat) HIAHHookIntercept(HIAHHookScopeImage, image, orig_stat, hook_stat);
+    if (orig_lstat) HIAHHookIntercept(HIAHHookScopeImage, image, orig_lstat, hook_lstat);
+    if (orig_access) HIAHHookIntercept(HIAHHookScopeImage, image, orig_access, hook_access);
+    if (orig_opendir) HIAHHookIntercept(HIAHHookScopeImage, image, orig_opendir, hook_opendir);
+}
+
+static void HIAHMountInstallHooksOnce(void) {
+    orig_open = dlsym(RTLD_DEFAULT, "open");
+    orig_openat = dlsym(RTLD_DEFAULT, "openat");
+    orig_fopen = dlsym(RTLD_DEFAULT, "fopen");
+    orig_stat = dlsym(RTLD_DEFAULT, "stat");
+    orig_lstat = dlsym(RTLD_DEFAULT, "lstat");
+    orig_access = dlsym(RTLD_DEFAULT, "access");
+    orig_opendir = dlsym(RTLD_DEFAULT, "opendir");
+    // Runs for every image already loaded, then for each one added later
+    _dyld_register_func_for_add_image(HIAHMountHookImage);
+}
+
+void HIAHMountInstallHooks(void) {
+    static pthread_once_t once = PTHREAD_ONCE_INIT;
+    pthread_once(&once, HIAHMountInstallHooksOnce);
+}
+
+#else
+
+void HIAHMountInstallHooks(void) {}
+
+#endif
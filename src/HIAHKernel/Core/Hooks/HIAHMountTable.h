@@ -0,0 +1,136 @@
+/**
+ * HIAHMountTable.h
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Virtual mount table: translates the Unix paths guests use (/bin/sh,
+ * /etc/profile, /home/...) into the directories that back them.
+ *
+ * Mounts are kept in a trie of path components, so a lookup costs one step
+ * per component and the deepest mount wins (/usr/bin over /usr). A mount
+ * can be read-only, or an overlay: a writable backing directory over a
+ * read-only lower one (e.g. the host's /usr), where files are looked up in
+ * the backing directory first and new files are always created there.
+ * Symlinks with absolute targets are resolved through the table, so a
+ * link to /usr/bin/env inside a mount leads to the virtual /usr/bin/env.
+ *
+ * Resolved paths are kept in a small set-associative LRU cache. Readers
+ * take no locks: each slot is a seqlock, and a read racing a write simply
+ * misses. Paths that went through a symlink, were found in an overlay's
+ * lower directory or are missing from both of its layers are resolved
+ * every time, since files coming and going change them. Changing the
+ * mounts invalidates the cache; so must removing a file from an overlay's
+ * backing directory behind the guests' backs, which uncovers the lower one.
+ *
+ * In processes running guests, hooks on open, openat, fopen, stat, lstat,
+ * access and opendir send paths through the table (and then through any
+ * lazily installed bundle, see HIAHLazyBundle): those of every thread, or
+ * only of guest threads where guests share the process with the host app.
+ * The table is saved to the App Group so the extension, which runs guests
+ * in their own process, mounts the same one.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#ifndef HIAH_MOUNT_TABLE_H
+#define HIAH_MOUNT_TABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// The saved table's name in the App Group container
+#define HIAH_MOUNT_TABLE_FILE "mounts"
+
+/// Cache geometry: HIAH_MOUNT_CACHE_SETS sets of HIAH_MOUNT_CACHE_WAYS slots
+#define HIAH_MOUNT_CACHE_SETS 64
+#define HIAH_MOUNT_CACHE_WAYS 4
+
+typedef enum {
+    HIAHMountReadOnly = 1 << 0,   // Writes fail with EROFS
+} HIAHMountFlags;
+
+typedef enum {
+    HIAHMountResolveWrite = 1 << 0,     // The caller will write (or create) the file
+    HIAHMountResolveNoFollow = 1 << 1,  // Don't follow a symlink in the last component
+} HIAHMountResolveFlags;
+
+typedef enum {
+    HIAHMountScopeProcess,        // Every thread's calls are translated
+    HIAHMountScopeGuestThreads,   // Only calls from threads attached to a virtual process
+} HIAHMountScope;
+
+typedef struct {
+    uint64_t lookups;             // Read resolutions
+    uint64_t hits;                // Answered from the cache
+    uint64_t translated;          // Resolved to a backing directory
+    uint32_t mounts;
+} HIAHMountStats;
+
+/**
+ * Mounts `backingPath` at the absolute virtual path `virtualPath`,
+ * replacing any mount already there. With `lowerPath`, the mount is an
+ * overlay of `backingPath` over the read-only `lowerPath`.
+ *
+ * @return 0 or an errno value.
+ */
+int HIAHMountAdd(const char *virtualPath, const char *backingPath, const char *lowerPath, uint32_t flags);
+
+/// Removes every mount
+void HIAHMountRemoveAll(void);
+
+/**
+ * Writes the mounts to `path` (replaced atomically), one per line.
+ *
+ * @return 0 or an errno value (EINVAL for paths containing tabs or newlines).
+ */
+int HIAHMountSave(const char *path);
+
+/**
+ * Adds the mounts saved in `path` by HIAHMountSave. Mounts whose backing
+ * directory this process can't reach are skipped.
+ *
+ * @return 0 or an errno value (EINVAL if a line was malformed; the others
+ *         are still added).
+ */
+int HIAHMountLoad(const char *path);
+
+/// Drops every cached resolution, e.g. after files were added to a backing
+/// directory
+void HIAHMountInvalidateCache(void);
+
+/**
+ * Translates `path` (HIAHMountResolveFlags in `flags`). Relative paths and
+ * paths under no mount are left alone. For writing, the result is where the
+ * file is (or will be) written; writes to read-only mounts or to files that
+ * only exist in an overlay's lower directory fail. Only reads are cached.
+ *
+ * @return 1 if `resolved` should be used instead of `path`, 0 if `path` is
+ *         not virtual, -1 with errno set (EROFS, ELOOP, ENAMETOOLONG).
+ */
+int HIAHMountResolve(const char *path, uint32_t flags, char *resolved, size_t resolvedSize);
+
+void HIAHMountGetStats(HIAHMountStats *stats);
+
+/**
+ * Hooks open, openat, fopen, stat, lstat, access and opendir in every loaded image
+ * and every image loaded later. A no-op off Darwin.
+ */
+void HIAHMountInstallHooks(void);
+
+/**
+ * Which threads the hooks translate for (HIAHMountScopeProcess by default).
+ * With HIAHMountScopeGuestThreads, calls from host threads (and from threads
+ * a guest creates itself) pass straight through, so the host app's
+ * frameworks neither pay for the lookups nor see virtual paths.
+ */
+void HIAHMountSetScope(HIAHMountScope scope);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HIAH_MOUNT_TABLE_H */
@@ -0,0 +1,669 @@
+/**
+ * HIAHPlistReader.c
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Zero-copy property list reader implementation.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#include "HIAHPlistReader.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define HIAH_BPLIST_HEADER_SIZE 8
+#define HIAH_BPLIST_TRAILER_SIZE 32
+
+struct HIAHPlist {
+    const uint8_t *bytes;
+    size_t length;
+    bool mapped;
+    bool binary;
+    HIAHPlistValue root;
+
+    // bplist00 trailer
+    unsigned offsetSize;
+    unsigned refSize;
+    uint64_t objectCount;
+    uint64_t offsetTable;
+};
+
+typedef struct {
+    size_t position;              // Of '<'
+    size_t end;                   // Just past '>'
+    const char *name;
+    size_t nameLength;
+    bool closing;
+    bool selfClosing;
+} HIAHXMLTag;
+
+#pragma mark - Text
+
+// Decoded text goes to a buffer, is compared against a string, or both
+typedef struct {
+    char *buffer;
+    size_t size;
+    const char *compare;
+    size_t length;
+    bool mismatch;
+} HIAHTextSink;
+
+static void HIAHSinkBytes(HIAHTextSink *sink, const char *bytes, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (sink->compare && !sink->mismatch && sink->compare[sink->length] != bytes[i]) {
+            sink->mismatch = true;
+        }
+        if (sink->buffer && sink->length + 1 < sink->size) sink->buffer[sink->length] = bytes[i];
+        sink->length++;
+    }
+}
+
+static void HIAHSinkCodePoint(HIAHTextSink *sink, uint32_t c) {
+    char utf8[4];
+    size_t count;
+    if (c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF)) c = 0xFFFD;
+    if (c < 0x80) {
+        utf8[0] = (char)c;
+        count = 1;
+    } else if (c < 0x800) {
+        utf8[0] = (char)(0xC0 | (c >> 6));
+        utf8[1] = (char)(0x80 | (c & 0x3F));
+        count = 2;
+    } else if (c < 0x10000) {
+        utf8[0] = (char)(0xE0 | (c >> 12));
+        utf8[1] = (char)(0x80 | ((c >> 6) & 0x3F));
+        utf8[2] = (char)(0x80 | (c & 0x3F));
+        count = 3;
+    } else {
+        utf8[0] = (char)(0xF0 | (c >> 18));
+        utf8[1] = (char)(0x80 | ((c >> 12) & 0x3F));
+        utf8[2] = (char)(0x80 | ((c >> 6) & 0x3F));
+        utf8[3] = (char)(0x80 | (c & 0x3F));
+        count = 4;
+    }
+    HIAHSinkBytes(sink, utf8, count);
+}
+
+static void HIAHDecodeUTF16BE(HIAHTextSink *sink, const uint8_t *bytes, size_t length) {
+    for (size_t i = 0; i + 1 < length; i += 2) {
+        uint32_t c = ((uint32_t)bytes[i] << 8) | bytes[i + 1];
+        if (c >= 0xD800 && c <= 0xDBFF && i + 3 < length) {
+            uint32_t low = ((uint32_t)bytes[i + 2] << 8) | bytes[i + 3];
+            if (low >= 0xDC00 && low <= 0xDFFF) {
+                c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+                i += 2;
+            }
+        }
+        HIAHSinkCodePoint(sink, c);
+    }
+}
+
+static bool HIAHDecodeEntity(const char *entity, size_t length, uint32_t *out) {
+    if (length == 2 && memcmp(entity, "lt", 2) == 0) *out = '<';
+    else if (length == 2 && memcmp(entity, "gt", 2) == 0) *out = '>';
+    else if (length == 3 && memcmp(entity, "amp", 3) == 0) *out = '&';
+    else if (length == 4 && memcmp(entity, "quot", 4) == 0) *out = '"';
+    else if (length == 4 && memcmp(entity, "apos", 4) == 0) *out = '\'';
+    else if (length >= 2 && entity[0] == '#') {
+        bool hex = entity[1] == 'x' || entity[1] == 'X';
+        uint32_t c = 0;
+        size_t i = hex ? 2 : 1;
+        if (i == length) return false;
+        for (; i < length; i++) {
+            char d = entity[i];
+            uint32_t digit;
+            if (d >= '0' && d <= '9') digit = (uint32_t)(d - '0');
+            else if (hex && d >= 'a' && d <= 'f') digit = (uint32_t)(d - 'a' + 10);
+            else if (hex && d >= 'A' && d <= 'F') digit = (uint32_t)(d - 'A' + 10);
+            else return false;
+            c = c * (hex ? 16 : 10) + digit;
+            if (c > 0x10FFFF) return false;
+        }
+        *out = c;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static void HIAHDecodeXML(HIAHTextSink *sink, const char *text, size_t length) {
+    size_t run = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (text[i] != '&') continue;
+        const char *semicolon = memchr(text + i, ';', length - i < 12 ? length - i : 12);
+        uint32_t c;
+        if (!semicolon || !HIAHDecodeEntity(text + i + 1, (size_t)(semicolon - text) - i - 1, &c)) {
+            continue;
+        }
+        HIAHSinkBytes(sink, text + run, i - run);
+        HIAHSinkCodePoint(sink, c);
+        i = (size_t)(semicolon - text);
+        run = i + 1;
+    }
+    HIAHSinkBytes(sink, text + run, length - run);
+}
+
+static void HIAHDecodeText(HIAHTextSink *sink, const HIAHPlistValue *value) {
+    switch (value->text) {
+        case HIAHPlistTextUTF16BE:
+            HIAHDecodeUTF16BE(sink, value->bytes, value->length);
+            break;
+        case HIAHPlistTextXMLEscaped:
+            HIAHDecodeXML(sink, value->bytes, value->length);
+            break;
+        case HIAHPlistTextUTF8:
+        case HIAHPlistTextBase64:
+            HIAHSinkBytes(sink, value->bytes, value->length);
+            break;
+    }
+}
+
+size_t HIAHPlistStringCopy(const HIAHPlistValue *value, char *buffer, size_t size) {
+    if (!value || value->type != HIAHPlistTypeString) {
+        if (buffer && size) buffer[0] = '\0';
+        return 0;
+    }
+    HIAHTextSink sink = {.buffer = buffer, .size = size};
+    HIAHDecodeText(&sink, value);
+    if (buffer && size) buffer[sink.length < size ? sink.length : size - 1] = '\0';
+    return sink.length;
+}
+
+bool HIAHPlistStringEquals(const HIAHPlistValue *value, const char *string) {
+    if (!value || !string || value->type != HIAHPlistTypeString) return false;
+    if (value->text == HIAHPlistTextUTF8) {
+        return strlen(string) == value->length && memcmp(string, value->bytes, value->length) == 0;
+    }
+    HIAHTextSink sink = {.compare = string};
+    HIAHDecodeText(&sink, value);
+    return !sink.mismatch && string[sink.length] == '\0';
+}
+
+#pragma mark - bplist00
+
+static bool HIAHReadBE(const HIAHPlist *plist, uint64_t position, unsigned size, uint64_t *out) {
+    if (size == 0 || size > 8 || position > plist->length || size > plist->length - position) {
+        return false;
+    }
+    uint64_t value = 0;
+    for (unsigned i = 0; i < size; i++) value = (value << 8) | plist->bytes[position + i];
+    *out = value;
+    return true;
+}
+
+static bool HIAHBinaryRef(const HIAHPlist *plist, uint64_t position, uint64_t index, uint64_t *ref) {
+    return HIAHReadBE(plist, position + index * plist->refSize, plist->refSize, ref) &&
+           *ref < plist->objectCount;
+}
+
+// Element count of a data/string/array/dict object; `body` is where its
+// contents start
+static bool HIAHBinaryCount(const HIAHPlist *plist, uint64_t offset, uint64_t *count,
+                            uint64_t *body) {
+    uint8_t info = plist->bytes[offset] & 0x0F;
+    if (info != 0x0F) {
+        *count = info;
+        *body = offset + 1;
+        return true;
+    }
+    if (offset + 1 >= plist->offsetTable) return false;
+    uint8_t marker = plist->bytes[offset + 1];
+    if ((marker & 0xF0) != 0x10 || (marker & 0x0F) > 3) return false;
+    unsigned size = 1u << (marker & 0x0F);
+    *body = offset + 2 + size;
+    return HIAHReadBE(plist, offset + 2, size, count);
+}
+
+static bool HIAHBinaryValue(const HIAHPlist *plist, uint64_t ref, HIAHPlistValue *out) {
+    memset(out, 0, sizeof(*out));
+
+    uint64_t offset;
+    if (ref >= plist->objectCount ||
+        !HIAHReadBE(plist, plist->offsetTable + ref * plist->offsetSize, plist->offsetSize,
+                    &offset) ||
+        offset < HIAH_BPLIST_HEADER_SIZE || offset >= plist->offsetTable) {
+        return false;
+    }
+
+    uint8_t marker = plist->bytes[offset];
+    uint64_t count = 0;
+    uint64_t body = 0;
+    uint64_t limit = plist->offsetTable;
+    switch (marker >> 4) {
+        case 0x0:
+            if (marker == 0x08 || marker == 0x09) {
+                out->type = HIAHPlistTypeBool;
+                out->boolean = marker == 0x09;
+            } else {
+                out->type = HIAHPlistTypeOther;
+            }
+            return true;
+
+        case 0x1: {
+            unsigned size = 1u << (marker & 0x0F);
+            uint64_t value;
+            if (size > 8) {
+                out->type = HIAHPlistTypeOther;
+                return true;
+            }
+            if (!HIAHReadBE(plist, offset + 1, size, &value)) return false;
+            out->type = HIAHPlistTypeInteger;
+            out->integer = (int64_t)value;
+            return true;
+        }
+
+        case 0x4:       // Data
+        case 0x5:       // ASCII string
+        case 0x6:       // UTF-16BE string, count in code units
+        case 0x7: {     // UTF-8 string
+            if (!HIAHBinaryCount(plist, offset, &count, &body)) return false;
+            uint64_t length = (marker >> 4) == 0x6 ? count * 2 : count;
+            if (count > limit || body > limit || length > limit - body) return false;
+            out->type = (marker >> 4) == 0x4 ? HIAHPlistTypeData : HIAHPlistTypeString;
+            out->text = (marker >> 4) == 0x6 ? HIAHPlistTextUTF16BE : HIAHPlistTextUTF8;
+            out->bytes = plist->bytes + body;
+            out->length = (size_t)length;
+            return true;
+        }
+
+        case 0xA:       // Array: count refs
+        case 0xD: {     // Dict: count key refs, then count value refs
+            if (!HIAHBinaryCount(plist, offset, &count, &body)) return false;
+            uint64_t refs = (marker >> 4) == 0xD ? 2 : 1;
+            if (count > limit || body > limit ||
+                count * refs * plist->refSize > limit - body) {
+                return false;
+            }
+            out->type = (marker >> 4) == 0xD ? HIAHPlistTypeDict : HIAHPlistTypeArray;
+            out->count = (size_t)count;
+            out->position = body;
+            return true;
+        }
+
+        default:        // Real, date, UID, sets
+            out->type = HIAHPlistTypeOther;
+            return true;
+    }
+}
+
+static bool HIAHBinaryOpen(HIAHPlist *plist) {
+    if (plist->length < HIAH_BPLIST_HEADER_SIZE + HIAH_BPLIST_TRAILER_SIZE) return false;
+
+    const uint8_t *trailer = plist->bytes + plist->length - HIAH_BPLIST_TRAILER_SIZE;
+    uint64_t position = plist->length - HIAH_BPLIST_TRAILER_SIZE;
+    uint64_t topObject;
+    plist->offsetSize = trailer[6];
+    plist->refSize = trailer[7];
+    if (plist->offsetSize < 1 || plist->offsetSize > 8 || plist->refSize < 1 ||
+        plist->refSize > 8 ||
+        !HIAHReadBE(plist, position + 8, 8, &plist->objectCount) ||
+        !HIAHReadBE(plist, position + 16, 8, &topObject) ||
+        !HIAHReadBE(plist, position + 24, 8, &plist->offsetTable)) {
+        return false;
+    }
+    if (plist->offsetTable < HIAH_BPLIST_HEADER_SIZE || plist->offsetTable > position ||
+        plist->objectCount > (position - plist->offsetTable) / plist->offsetSize) {
+        return false;
+    }
+
+    plist->binary = true;
+    return HIAHBinaryValue(plist, topObject, &plist->root) &&
+           plist->root.type == HIAHPlistTypeDict;
+}
+
+#pragma mark - XML
+
+static bool HIAHXMLStartsWith(const HIAHPlist *plist, size_t position, const char *prefix) {
+    size_t length = strlen(prefix);
+    return position <= plist->length && length <= plist->length - position &&
+           memcmp(plist->bytes + position, prefix, length) == 0;
+}
+
+static size_t HIAHXMLFind(const HIAHPlist *plist, size_t position, const char *needle) {
+    while (position < plist->length) {
+        const uint8_t *hit = memchr(plist->bytes + position, needle[0], plist->length - position);
+        if (!hit) break;
+        position = (size_t)(hit - plist->bytes);
+        if (HIAHXMLStartsWith(plist, position, needle)) return position;
+        position++;
+    }
+    return plist->length;
+}
+
+// Skips whitespace, text, comments, processing instructions and DOCTYPE;
+// returns the position of the next element tag (or the end)
+static size_t HIAHXMLSkipMisc(const HIAHPlist *plist, size_t position) {
+    while (position < plist->length) {
+        const uint8_t *hit = memchr(plist->bytes + position, '<', plist->length - position);
+        if (!hit) return plist->length;
+        position = (size_t)(hit - plist->bytes);
+
+        if (HIAHXMLStartsWith(plist, position, "<!--")) {
+            position = HIAHXMLFind(plist, position + 4, "-->");
+            if (position < plist->length) position += 3;
+        } else if (HIAHXMLStartsWith(plist, position, "<?")) {
+            position = HIAHXMLFind(plist, position + 2, "?>");
+            if (position < plist->length) position += 2;
+        } else if (HIAHXMLStartsWith(plist, position, "<!")) {
+            position = HIAHXMLFind(plist, position + 2, ">");
+            if (position < plist->length) position += 1;
+        } else {
+            return position;
+        }
+    }
+    return plist->length;
+}
+
+static bool HIAHXMLParseTag(const HIAHPlist *plist, size_t position, HIAHXMLTag *tag) {
+    if (position >= plist->length || plist->bytes[position] != '<') return false;
+    const uint8_t *gt = memchr(plist->bytes + position, '>', plist->length - position);
+    if (!gt) return false;
+
+    size_t end = (size_t)(gt - plist->bytes);
+    size_t name = position + 1;
+    tag->position = position;
+    tag->end = end + 1;
+    tag->closing = name < end && plist->bytes[name] == '/';
+    if (tag->closing) name++;
+    tag->selfClosing = !tag->closing && plist->bytes[end - 1] == '/';
+
+    size_t nameEnd = name;
+    while (nameEnd < end && plist->bytes[nameEnd] != '/' && plist->bytes[nameEnd] != ' ' &&
+           plist->bytes[nameEnd] != '\t' && plist->bytes[nameEnd] != '\r' &&
+           plist->bytes[nameEnd] != '\n') {
+        nameEnd++;
+    }
+    tag->name = (const char *)plist->bytes + name;
+    tag->nameLength = nameEnd - name;
+    return tag->nameLength > 0;
+}
+
+static bool HIAHXMLTagIs(const HIAHXMLTag *tag, const char *name) {
+    return tag->nameLength == strlen(name) && memcmp(tag->name, name, tag->nameLength) == 0;
+}
+
+// `position` is just inside an open <dict> or <array>. Counts its direct
+// children and returns the position just past its closing tag.
+static bool HIAHXMLSkipContainer(const HIAHPlist *plist, size_t position, size_t *children,
+                                 size_t *next) {
+    size_t depth = 0;
+    *children = 0;
+    for (;;) {
+        HIAHXMLTag tag;
+        position = HIAHXMLSkipMisc(plist, position);
+        if (!HIAHXMLParseTag(plist, position, &tag)) return false;
+        position = tag.end;
+
+        if (tag.closing) {
+            if (depth == 0) {
+                *next = position;
+                return true;
+            }
+            depth--;
+        } else {
+            if (depth == 0) (*children)++;
+            if (!tag.selfClosing) depth++;
+        }
+    }
+}
+
+static bool HIAHXMLValue(const HIAHPlist *plist, size_t position, HIAHPlistValue *out,
+                         size_t *next) {
+    memset(out, 0, sizeof(*out));
+
+    HIAHXMLTag tag;
+    if (!HIAHXMLParseTag(plist, position, &tag) || tag.closing) return false;
+
+    bool dict = HIAHXMLTagIs(&tag, "dict");
+    if (dict || HIAHXMLTagIs(&tag, "array")) {
+        out->type = dict ? HIAHPlistTypeDict : HIAHPlistTypeArray;
+        out->position = tag.end;
+        if (tag.selfClosing) {
+            *next = tag.end;
+            return true;
+        }
+        size_t children;
+        if (!HIAHXMLSkipContainer(plist, tag.end, &children, next)) return false;
+        out->count = dict ? children / 2 : children;
+        return true;
+    }
+
+    if (HIAHXMLTagIs(&tag, "true") || HIAHXMLTagIs(&tag, "false")) {
+        out->type = HIAHPlistTypeBool;
+        out->boolean = HIAHXMLTagIs(&tag, "true");
+        if (tag.selfClosing) {
+            *next = tag.end;
+            return true;
+        }
+    }
+
+    // Everything else is <name>text</name> or <name/>
+    const char *text = (const char *)plist->bytes + tag.end;
+    size_t length = 0;
+    *next = tag.end;
+    if (!tag.selfClosing) {
+        HIAHXMLTag close;
+        size_t end = HIAHXMLFind(plist, tag.end, "<");
+        if (!HIAHXMLParseTag(plist, end, &close) || !close.closing ||
+            close.nameLength != tag.nameLength || memcmp(close.name, tag.name, tag.nameLength)) {
+            return false;
+        }
+        length = end - tag.end;
+        *next = close.end;
+    }
+
+    if (out->type == HIAHPlistTypeBool) return true;
+    if (HIAHXMLTagIs(&tag, "string") || HIAHXMLTagIs(&tag, "key")) {
+        out->type = HIAHPlistTypeString;
+        out->text = memchr(text, '&', length) ? HIAHPlistTextXMLEscaped : HIAHPlistTextUTF8;
+        out->bytes = text;
+        out->length = length;
+    } else if (HIAHXMLTagIs(&tag, "data")) {
+        out->type = HIAHPlistTypeData;
+        out->text = HIAHPlistTextBase64;
+        out->bytes = text;
+        out->length = length;
+    } else if (HIAHXMLTagIs(&tag, "integer")) {
+        char digits[32];
+        if (length == 0 || length >= sizeof(digits)) return false;
+        memcpy(digits, text, length);
+        digits[length] = '\0';
+        char *start = digits;
+        while (*start == ' ' || *start == '\t' || *start == '\n' || *start == '\r') start++;
+        bool negative = *start == '-';
+        const char *magnitude = negative || *start == '+' ? start + 1 : start;
+        bool hex = magnitude[0] == '0' && (magnitude[1] == 'x' || magnitude[1] == 'X');
+        out->type = HIAHPlistTypeInteger;
+        out->integer = (int64_t)strtoull(hex ? magnitude + 2 : magnitude, NULL, hex ? 16 : 10);
+        if (negative) out->integer = -out->integer;
+    } else {
+        out->type = HIAHPlistTypeOther;
+    }
+    return true;
+}
+
+static bool HIAHXMLOpen(HIAHPlist *plist) {
+    size_t position = 0;
+    if (HIAHXMLStartsWith(plist, 0, "\xEF\xBB\xBF")) position = 3;
+
+    HIAHXMLTag tag;
+    position = HIAHXMLSkipMisc(plist, position);
+    if (!HIAHXMLParseTag(plist, position, &tag) || tag.closing) return false;
+    if (HIAHXMLTagIs(&tag, "plist")) {
+        if (tag.selfClosing) return false;
+        position = HIAHXMLSkipMisc(plist, tag.end);
+    }
+
+    size_t next;
+    return HIAHXMLValue(plist, position, &plist->root, &next) &&
+           plist->root.type == HIAHPlistTypeDict;
+}
+
+#pragma mark - Lookup
+
+// Visits a dict's entries in order until `visit` returns false
+typedef bool (*HIAHDictVisitor)(const HIAHPlistValue *key, uint64_t valueRef,
+                                const HIAHPlistValue *xmlValue, void *context);
+
+static void HIAHDictEnumerate(const HIAHPlist *plist, const HIAHPlistValue *dict,
+                              HIAHDictVisitor visit, void *context) {
+    if (!dict || dict->type != HIAHPlistTypeDict) return;
+
+    size_t position = (size_t)dict->position;
+    for (size_t i = 0; i < dict->count; i++) {
+        HIAHPlistValue key;
+        if (plist->binary) {
+            uint64_t keyRef, valueRef;
+            if (!HIAHBinaryRef(plist, dict->position, i, &keyRef) ||
+                !HIAHBinaryRef(plist, dict->position, dict->count + i, &valueRef) ||
+                !HIAHBinaryValue(plist, keyRef, &key)) {
+                return;
+            }
+            if (key.type == HIAHPlistTypeString && !visit(&key, valueRef, NULL, context)) return;
+        } else {
+            HIAHPlistValue value;
+            if (!HIAHXMLValue(plist, HIAHXMLSkipMisc(plist, position), &key, &position) ||
+                !HIAHXMLValue(plist, HIAHXMLSkipMisc(plist, position), &value, &position)) {
+                return;
+            }
+            if (key.type == HIAHPlistTypeString && !visit(&key, 0, &value, context)) return;
+        }
+    }
+}
+
+typedef struct {
+    const HIAHPlist *plist;
+    const char *const *keys;
+    HIAHPlistValue *out;
+    size_t count;
+    size_t found;
+} HIAHLookup;
+
+static bool HIAHLookupVisit(const HIAHPlistValue *key, uint64_t valueRef,
+                            const HIAHPlistValue *xmlValue, void *context) {
+    HIAHLookup *lookup = context;
+    for (size_t i = 0; i < lookup->count; i++) {
+        if (lookup->out[i].type != HIAHPlistTypeNone ||
+            !HIAHPlistStringEquals(key, lookup->keys[i])) {
+            continue;
+        }
+        if (xmlValue) {
+            lookup->out[i] = *xmlValue;
+        } else if (!HIAHBinaryValue(lookup->plist, valueRef, &lookup->out[i])) {
+            memset(&lookup->out[i], 0, sizeof(HIAHPlistValue));
+            continue;
+        }
+        lookup->found++;
+        break;
+    }
+    return lookup->found < lookup->count;
+}
+
+static size_t HIAHDictGetKeys(const HIAHPlist *plist, const HIAHPlistValue *dict,
+                              const char *const *keys, HIAHPlistValue *out, size_t count) {
+    if (!out) return 0;
+    // `out` may alias `dict` (stepping into a nested dict in place)
+    HIAHPlistValue container = dict ? *dict : (HIAHPlistValue){0};
+    memset(out, 0, count * sizeof(HIAHPlistValue));
+    if (!plist || !dict || !keys || count == 0) return 0;
+
+    HIAHLookup lookup = {.plist = plist, .keys = keys, .out = out, .count = count};
+    HIAHDictEnumerate(plist, &container, HIAHLookupVisit, &lookup);
+    return lookup.found;
+}
+
+size_t HIAHPlistGetKeys(const HIAHPlist *plist, const char *const *keys, HIAHPlistValue *out,
+                        size_t count) {
+    return HIAHDictGetKeys(plist, plist ? &plist->root : NULL, keys, out, count);
+}
+
+bool HIAHPlistGet(const HIAHPlist *plist, const char *key, HIAHPlistValue *out) {
+    return HIAHPlistGetKeys(plist, &key, out, 1) == 1;
+}
+
+bool HIAHPlistDictGet(const HIAHPlist *plist, const HIAHPlistValue *dict, const char *key,
+                      HIAHPlistValue *out) {
+    return HIAHDictGetKeys(plist, dict, &key, out, 1) == 1;
+}
+
+bool HIAHPlistArrayGet(const HIAHPlist *plist, const HIAHPlistValue *array, size_t index,
+                       HIAHPlistValue *out) {
+    if (!out) return false;
+    // `out` may alias `array`
+    HIAHPlistValue container = array ? *array : (HIAHPlistValue){0};
+    array = &container;
+    memset(out, 0, sizeof(*out));
+    if (!plist || container.type != HIAHPlistTypeArray || index >= container.count) {
+        return false;
+    }
+
+    if (plist->binary) {
+        uint64_t ref;
+        return HIAHBinaryRef(plist, array->position, index, &ref) &&
+               HIAHBinaryValue(plist, ref, out);
+    }
+
+    size_t position = (size_t)array->position;
+    for (size_t i = 0; i <= index; i++) {
+        if (!HIAHXMLValue(plist, HIAHXMLSkipMisc(plist, position), out, &position)) {
+            memset(out, 0, sizeof(*out));
+            return false;
+        }
+    }
+    return true;
+}
+
+#pragma mark - Reader
+
+static HIAHPlist *HIAHPlistCreate(const uint8_t *bytes, size_t length, bool mapped) {
+    HIAHPlist *plist = calloc(1, sizeof(HIAHPlist));
+    if (!plist) return NULL;
+    plist->bytes = bytes;
+    plist->length = length;
+    plist->mapped = mapped;
+
+    bool valid = length >= HIAH_BPLIST_HEADER_SIZE && memcmp(bytes, "bplist00", 8) == 0
+                     ? HIAHBinaryOpen(plist)
+                     : HIAHXMLOpen(plist);
+    if (!valid) {
+        plist->mapped = false;
+        HIAHPlistClose(plist);
+        return NULL;
+    }
+    return plist;
+}
+
+HIAHPlist *HIAHPlistOpenBytes(const void *bytes, size_t length) {
+    if (!bytes || length == 0) return NULL;
+    return HIAHPlistCreate(bytes, length, false);
+}
+
+HIAHPlist *HIAHPlistOpen(const char *path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+        close(fd);
+        return NULL;
+    }
+    size_t length = (size_t)st.st_size;
+    void *bytes = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (bytes == MAP_FAILED) return NULL;
+
+    HIAHPlist *plist = HIAHPlistCreate(bytes, length, true);
+    if (!plist) munmap(bytes, length);
+    return plist;
+}
+
+void HIAHPlistClose(HIAHPlist *plist) {
+    if (!plist) return;
+    if (plist->mapped) munmap((void *)plist->bytes, plist->length);
+    free(plist);
+}
@@ -0,0 +1,150 @@
+/**
+ * HIAHPlistReader.h
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Zero-copy property list key lookup.
+ *
+ * Launch and install paths only need a few Info.plist keys
+ * (CFBundleExecutable, CFBundleIdentifier, NSPrincipalClass, icons), so
+ * rather than deserializing the whole file this maps it and walks straight
+ * to the requested keys: through the offset table for bplist00, or with a
+ * tag scan for XML. Values are borrowed views into the mapping; nothing is
+ * allocated per lookup and nothing needs freeing except the reader.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#ifndef HIAH_PLIST_READER_H
+#define HIAH_PLIST_READER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct HIAHPlist HIAHPlist;
+
+typedef enum {
+    HIAHPlistTypeNone = 0,        // Key not present
+    HIAHPlistTypeString,
+    HIAHPlistTypeInteger,
+    HIAHPlistTypeBool,
+    HIAHPlistTypeData,
+    HIAHPlistTypeArray,
+    HIAHPlistTypeDict,
+    HIAHPlistTypeOther,           // Real, date, UID, null
+} HIAHPlistType;
+
+/// How a string view's bytes are encoded
+typedef enum {
+    HIAHPlistTextUTF8 = 0,        // Plain bytes (bplist ASCII or data, unescaped XML)
+    HIAHPlistTextUTF16BE,         // bplist Unicode string; length is in bytes
+    HIAHPlistTextXMLEscaped,      // XML text containing entities
+    HIAHPlistTextBase64,          // XML <data> contents
+} HIAHPlistText;
+
+/**
+ * A borrowed value. `bytes` points into the mapping and stays valid until
+ * HIAHPlistClose. Arrays and dicts can be passed back in to look inside them.
+ */
+typedef struct {
+    HIAHPlistType type;
+    HIAHPlistText text;           // String and data only
+    const void *bytes;            // String and data only; not NUL-terminated
+    size_t length;                // Of `bytes`, in bytes
+    int64_t integer;
+    bool boolean;
+    size_t count;                 // Array elements / dict entries
+    uint64_t position;            // Internal: where the container's body starts
+} HIAHPlistValue;
+
+/**
+ * Maps the plist at `path`. Returns NULL if it cannot be read or is neither
+ * bplist00 nor XML with a dict at the root.
+ */
+HIAHPlist *HIAHPlistOpen(const char *path);
+
+/**
+ * Wraps `bytes` (which must outlive the reader) without copying.
+ */
+HIAHPlist *HIAHPlistOpenBytes(const void *bytes, size_t length);
+
+void HIAHPlistClose(HIAHPlist *plist);
+
+/**
+ * Looks up a top-level key. Returns false (with out->type None) if absent.
+ */
+bool HIAHPlistGet(const HIAHPlist *plist, const char *key, HIAHPlistValue *out);
+
+/**
+ * Looks up `count` top-level keys in a single pass over the root dict.
+ * Missing keys get type None.
+ *
+ * @return The number of keys found.
+ */
+size_t HIAHPlistGetKeys(const HIAHPlist *plist, const char *const *keys, HIAHPlistValue *out,
+                        size_t count);
+
+/**
+ * Looks up `key` inside a dict value returned by an earlier lookup. `out`
+ * may be `dict` itself.
+ */
+bool HIAHPlistDictGet(const HIAHPlist *plist, const HIAHPlistValue *dict, const char *key,
+                      HIAHPlistValue *out);
+
+/**
+ * Returns element `index` of an array value returned by an earlier lookup.
+ * `out` may be `array` itself.
+ */
+bool HIAHPlistArrayGet(const HIAHPlist *plist, const HIAHPlistValue *array, size_t index,
+                       HIAHPlistValue *out);
+
+/**
+ * Decodes a string value to NUL-terminated UTF-8 in `buffer` (truncating
+ * to fit, like strlcpy).
+ *
+ * @return The full decoded length, excluding the terminator.
+ */
+size_t HIAHPlistStringCopy(const HIAHPlistValue *value, char *buffer, size_t size);
+
+/**
+ * Whether a string value equals the UTF-8 string `string`, without copying
+ * in the common (plain ASCII) case.
+ */
+bool HIAHPlistStringEquals(const HIAHPlistValue *value, const char *string);
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifdef __OBJC__
+#import <Foundation/Foundation.h>
+
+/**
+ * Copies a string value into an NSString; nil for anything else.
+ */
+static inline NSString *HIAHPlistValueString(const HIAHPlistValue *value) {
+    if (!value || value->type != HIAHPlistTypeString) return nil;
+    if (value->text == HIAHPlistTextUTF8) {
+        return [[NSString alloc] initWithBytes:value->bytes
+                                        length:value->length
+                                      encoding:NSUTF8StringEncoding];
+    }
+    if (value->text == HIAHPlistTextUTF16BE) {
+        return [[NSString alloc] initWithBytes:value->bytes
+                                        length:value->length
+                                      encoding:NSUTF16BigEndianStringEncoding];
+    }
+    NSMutableData *buffer = [NSMutableData dataWithLength:value->length + 1];
+    size_t length = HIAHPlistStringCopy(value, buffer.mutableBytes, buffer.length);
+    return [[NSString alloc] initWithBytes:buffer.bytes
+                                    length:MIN(length, buffer.length - 1)
+                                  encoding:NSUTF8StringEncoding];
+}
+#endif
+
+#endif /* HIAH_PLIST_READER_H */
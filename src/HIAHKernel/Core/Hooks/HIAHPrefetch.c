@@ -0,0 +1,463 @@
+/**
+ * HIAHPrefetch.c
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Guest binary read-ahead implementation.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#include "HIAHPrefetch.h"
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __APPLE__
+#include <mach-o/dyld.h>
+#endif
+
+#define HIAH_PREFETCH_MAGIC 0x48504650u   // 'HPFP'
+#define HIAH_PREFETCH_VERSION 2u
+#define HIAH_PREFETCH_MAX_RANGES 4096
+#define HIAH_PREFETCH_MAX_SEGMENTS 16
+#define HIAH_PREFETCH_HEADER_READ (64 * 1024)
+
+// Mach-O constants, spelled out so this builds without the SDK headers
+#define HIAH_FAT_MAGIC 0xcafebabeu        // Big-endian on disk
+#define HIAH_MH_MAGIC_64 0xfeedfacfu
+#define HIAH_LC_SEGMENT_64 0x19u
+#define HIAH_CPU_TYPE_ARM64 0x0100000cu
+
+typedef struct {
+    uint64_t offset;
+    uint64_t length;
+} HIAHPrefetchRange;
+
+typedef struct {
+    char name[17];
+    uint64_t vmaddr;
+    uint64_t fileoff;             // Within the slice
+    uint64_t filesize;
+} HIAHPrefetchSegment;
+
+// Profile file: this header, then `rangeCount` ranges in replay order
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t fileSize;
+    uint64_t fingerprint;         // Of the Mach-O header and load commands
+    uint32_t rangeCount;
+    uint32_t reserved;
+    // Measured on the recording launch, which gave no advice
+    uint64_t baselineMajorFaults;
+    uint64_t baselineMinorFaults;
+    uint64_t baselineWallNs;
+} HIAHPrefetchProfileHeader;
+
+struct HIAHPrefetch {
+    int fd;
+    char path[PATH_MAX];
+    uint64_t fileSize;
+    uint64_t sliceOffset;
+    uint64_t fingerprint;
+    HIAHPrefetchSegment segments[HIAH_PREFETCH_MAX_SEGMENTS];
+    unsigned segmentCount;
+
+    bool usedProfile;
+    uint64_t baselineMajorFaults;
+    uint64_t baselineMinorFaults;
+    uint64_t baselineWallNs;
+    uint32_t rangesAdvised;
+    uint64_t bytesAdvised;
+    uint64_t startNs;
+    struct rusage startUsage;
+
+    // Recording only: which file pages were cached before the load, so
+    // pages it faulted in can be told apart from ones that already were
+    unsigned char *resident;
+    uint64_t residentPages;
+    uint64_t pageSize;
+
+    HIAHPrefetchRange *touched;
+    size_t touchedCount;
+    size_t touchedCapacity;
+};
+
+#pragma mark - Helpers
+
+static uint64_t HIAHNowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t HIAHReadBE32(const uint8_t *bytes) {
+    return ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) |
+           bytes[3];
+}
+
+static uint32_t HIAHRead32(const uint8_t *bytes) {
+    uint32_t value;
+    memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+static uint64_t HIAHRead64(const uint8_t *bytes) {
+    uint64_t value;
+    memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+static void HIAHProfilePath(const char *path, char *out, size_t size) {
+    snprintf(out, size, "%s%s", path, HIAH_PREFETCH_PROFILE_SUFFIX);
+}
+
+static void HIAHAdvise(HIAHPrefetch *prefetch, uint64_t offset, uint64_t length) {
+    if (offset >= prefetch->fileSize) return;
+    if (length > prefetch->fileSize - offset) length = prefetch->fileSize - offset;
+    if (length == 0) return;
+
+#ifdef F_RDADVISE
+    // ra_count is an int; split very large segments
+    for (uint64_t done = 0; done < length;) {
+        uint64_t chunk = length - done;
+        if (chunk > (1u << 30)) chunk = 1u << 30;
+        struct radvisory advisory = {
+            .ra_offset = (off_t)(offset + done),
+            .ra_count = (int)chunk,
+        };
+        fcntl(prefetch->fd, F_RDADVISE, &advisory);
+        done += chunk;
+    }
+#else
+    posix_fadvise(prefetch->fd, (off_t)offset, (off_t)length, POSIX_FADV_WILLNEED);
+#endif
+    prefetch->rangesAdvised++;
+    prefetch->bytesAdvised += length;
+}
+
+#pragma mark - Mach-O
+
+// Finds the arm64 (or only) slice and its segments. Leaves segmentCount at
+// zero for anything that isn't a 64-bit Mach-O.
+static void HIAHParseBinary(HIAHPrefetch *prefetch) {
+    uint8_t *buffer = malloc(HIAH_PREFETCH_HEADER_READ);
+    if (!buffer) return;
+
+    ssize_t length = pread(prefetch->fd, buffer, HIAH_PREFETCH_HEADER_READ, 0);
+    if (length >= 8 && HIAHReadBE32(buffer) == HIAH_FAT_MAGIC) {
+        uint32_t count = HIAHReadBE32(buffer + 4);
+        const uint8_t *chosen = NULL;
+        for (uint32_t i = 0; i < count && 8 + (i + 1) * 20 <= (size_t)length; i++) {
+            const uint8_t *arch = buffer + 8 + i * 20;
+            if (!chosen || HIAHReadBE32(arch) == HIAH_CPU_TYPE_ARM64) chosen = arch;
+        }
+        if (!chosen) {
+            free(buffer);
+            return;
+        }
+        prefetch->sliceOffset = HIAHReadBE32(chosen + 8);
+        length = pread(prefetch->fd, buffer, HIAH_PREFETCH_HEADER_READ,
+                       (off_t)prefetch->sliceOffset);
+    }
+    if (length < 32 || HIAHRead32(buffer) != HIAH_MH_MAGIC_64) {
+        free(buffer);
+        return;
+    }
+
+    uint32_t commandCount = HIAHRead32(buffer + 16);
+    uint64_t commandsEnd = 32 + (uint64_t)HIAHRead32(buffer + 20);
+    if (commandsEnd > (uint64_t)length) commandsEnd = (uint64_t)length;
+
+    // FNV-1a over the header and load commands, plus the file size
+    uint64_t hash = 0xcbf29ce484222325ull ^ prefetch->fileSize;
+    for (uint64_t i = 0; i < commandsEnd; i++) hash = (hash ^ buffer[i]) * 0x100000001b3ull;
+    prefetch->fingerprint = hash;
+
+    uint64_t at = 32;
+    for (uint32_t i = 0; i < commandCount && at + 8 <= commandsEnd; i++) {
+        uint32_t command = HIAHRead32(buffer + at);
+        uint32_t size = HIAHRead32(buffer + at + 4);
+        if (size < 8 || at + size > commandsEnd) break;
+
+        if (command == HIAH_LC_SEGMENT_64 && size >= 72 &&
+            prefetch->segmentCount < HIAH_PREFETCH_MAX_SEGMENTS) {
+            HIAHPrefetchSegment *segment = &prefetch->segments[prefetch->segmentCount];
+            memcpy(segment->name, buffer + at + 8, 16);
+            segment->name[16] = '\0';
+            segment->vmaddr = HIAHRead64(buffer + at + 24);
+            segment->fileoff = HIAHRead64(buffer + at + 40);
+            segment->filesize = HIAHRead64(buffer + at + 48);
+            if (segment->filesize > 0) prefetch->segmentCount++;
+        }
+        at += size;
+    }
+    free(buffer);
+}
+
+#pragma mark - Profiles
+
+static bool HIAHReplayProfile(HIAHPrefetch *prefetch) {
+    char profilePath[PATH_MAX + 16];
+    HIAHProfilePath(prefetch->path, profilePath, sizeof(profilePath));
+    int fd = open(profilePath, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    HIAHPrefetchProfileHeader header;
+    HIAHPrefetchRange *ranges = NULL;
+    bool valid = read(fd, &header, sizeof(header)) == (ssize_t)sizeof(header) &&
+                 header.magic == HIAH_PREFETCH_MAGIC && header.version == HIAH_PREFETCH_VERSION &&
+                 header.fileSize == prefetch->fileSize &&
+                 header.fingerprint == prefetch->fingerprint && header.rangeCount > 0 &&
+                 header.rangeCount <= HIAH_PREFETCH_MAX_RANGES;
+    if (valid) {
+        size_t bytes = header.rangeCount * sizeof(HIAHPrefetchRange);
+        ranges = malloc(bytes);
+        valid = ranges && read(fd, ranges, bytes) == (ssize_t)bytes;
+    }
+    close(fd);
+
+    if (valid) {
+        prefetch->baselineMajorFaults = header.baselineMajorFaults;
+        prefetch->baselineMinorFaults = header.baselineMinorFaults;
+        prefetch->baselineWallNs = header.baselineWallNs;
+        for (uint32_t i = 0; i < header.rangeCount; i++) {
+            HIAHAdvise(prefetch, ranges[i].offset, ranges[i].length);
+        }
+    }
+    free(ranges);
+    return valid;
+}
+
+static void HIAHSaveProfile(HIAHPrefetch *prefetch, const HIAHPrefetchStats *measured) {
+    char profilePath[PATH_MAX + 16];
+    char temporaryPath[PATH_MAX + 32];
+    HIAHProfilePath(prefetch->path, profilePath, sizeof(profilePath));
+    snprintf(temporaryPath, sizeof(temporaryPath), "%s.%d", profilePath, getpid());
+
+    int fd = open(temporaryPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return;
+
+    HIAHPrefetchProfileHeader header = {
+        .magic = HIAH_PREFETCH_MAGIC,
+        .version = HIAH_PREFETCH_VERSION,
+        .fileSize = prefetch->fileSize,
+        .fingerprint = prefetch->fingerprint,
+        .rangeCount = (uint32_t)prefetch->touchedCount,
+        .baselineMajorFaults = measured->majorFaults,
+        .baselineMinorFaults = measured->minorFaults,
+        .baselineWallNs = measured->wallNs,
+    };
+    size_t bytes = prefetch->touchedCount * sizeof(HIAHPrefetchRange);
+    bool written = write(fd, &header, sizeof(header)) == (ssize_t)sizeof(header) &&
+                   write(fd, prefetch->touched, bytes) == (ssize_t)bytes;
+    close(fd);
+
+    if (!written || rename(temporaryPath, profilePath) != 0) unlink(temporaryPath);
+}
+
+#pragma mark - Recording
+
+// Notes which pages of the file are already cached, before the load runs.
+// Mapping the file and asking mincore faults nothing in.
+static void HIAHSampleResidency(HIAHPrefetch *prefetch) {
+    prefetch->pageSize = (uint64_t)sysconf(_SC_PAGESIZE);
+    if (prefetch->fileSize == 0) return;
+    uint64_t pages = (prefetch->fileSize + prefetch->pageSize - 1) / prefetch->pageSize;
+
+    void *mapping = mmap(NULL, (size_t)prefetch->fileSize, PROT_READ, MAP_SHARED, prefetch->fd, 0);
+    if (mapping == MAP_FAILED) return;
+    unsigned char *resident = malloc((size_t)pages);
+    if (resident && mincore(mapping, (size_t)prefetch->fileSize, (void *)resident) == 0) {
+        prefetch->resident = resident;
+        prefetch->residentPages = pages;
+    } else {
+        free(resident);
+    }
+    munmap(mapping, (size_t)prefetch->fileSize);
+}
+
+static bool HIAHWasResident(const HIAHPrefetch *prefetch, uint64_t fileOffset) {
+    if (!prefetch->resident) return false;
+    uint64_t page = fileOffset / prefetch->pageSize;
+    return page < prefetch->residentPages && (prefetch->resident[page] & 1);
+}
+
+static void HIAHAddTouched(HIAHPrefetch *prefetch, uint64_t offset, uint64_t length) {
+    if (prefetch->touchedCount > 0) {
+        HIAHPrefetchRange *last = &prefetch->touched[prefetch->touchedCount - 1];
+        if (last->offset + last->length == offset) {
+            last->length += length;
+            return;
+        }
+    }
+    if (prefetch->touchedCount == prefetch->touchedCapacity) {
+        if (prefetch->touchedCapacity >= HIAH_PREFETCH_MAX_RANGES) return;
+        size_t capacity = prefetch->touchedCapacity ? prefetch->touchedCapacity * 2 : 64;
+        HIAHPrefetchRange *grown = realloc(prefetch->touched, capacity * sizeof(*grown));
+        if (!grown) return;
+        prefetch->touched = grown;
+        prefetch->touchedCapacity = capacity;
+    }
+    prefetch->touched[prefetch->touchedCount++] = (HIAHPrefetchRange){offset, length};
+}
+
+void HIAHPrefetchRecordRegion(HIAHPrefetch *prefetch, const void *address, uint64_t fileOffset,
+                              uint64_t length) {
+    if (!prefetch || !address || length == 0) return;
+
+    uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+    uintptr_t start = (uintptr_t)address & ~(uintptr_t)(page - 1);
+    uint64_t lead = (uintptr_t)address - start;
+    uint64_t pages = (lead + length + page - 1) / page;
+    unsigned char *residency = malloc(pages);
+    if (!residency) return;
+
+    if (mincore((void *)start, (size_t)(pages * page), (void *)residency) == 0) {
+        // Where the pmap tracks references, those are the pages this
+        // process actually touched. Otherwise a page counts only if the
+        // load brought it in: resident now but not before Begin.
+#ifdef MINCORE_REFERENCED
+        unsigned char touchedMask = MINCORE_REFERENCED | MINCORE_MODIFIED;
+        bool tracked = false;
+        for (uint64_t i = 0; i < pages && !tracked; i++) tracked = residency[i] & touchedMask;
+        if (!tracked) touchedMask = MINCORE_INCORE;
+#else
+        unsigned char touchedMask = 1;
+        bool tracked = false;
+#endif
+        for (uint64_t i = 0; i < pages; i++) {
+            if (!(residency[i] & touchedMask)) continue;
+            // Page i covers file bytes [i * page - lead, (i + 1) * page - lead)
+            uint64_t begin = i * page > lead ? i * page - lead : 0;
+            uint64_t end = (i + 1) * page - lead;
+            if (end > length) end = length;
+            if (!tracked && HIAHWasResident(prefetch, fileOffset + begin)) continue;
+            HIAHAddTouched(prefetch, fileOffset + begin, end - begin);
+        }
+    }
+    free(residency);
+}
+
+#ifdef __APPLE__
+// mincore says which pages were touched, not when. dyld reads __LINKEDIT
+// (binds, fixups, symbols) first, then writes the data segments, and only
+// runs code in __TEXT for initializers, so profiles list segments in that
+// order and pages by offset within each
+static int HIAHSegmentRank(const HIAHPrefetchSegment *segment) {
+    if (strcmp(segment->name, "__LINKEDIT") == 0) return 0;
+    if (strcmp(segment->name, "__TEXT") == 0) return 2;
+    return 1;
+}
+
+static void HIAHRecordLoadedImage(HIAHPrefetch *prefetch) {
+    char wanted[PATH_MAX];
+    if (!realpath(prefetch->path, wanted)) return;
+
+    uint32_t count = _dyld_image_count();
+    for (uint32_t i = 0; i < count; i++) {
+        const char *name = _dyld_get_image_name(i);
+        char loaded[PATH_MAX];
+        if (!name || !realpath(name, loaded) || strcmp(loaded, wanted) != 0) continue;
+
+        uintptr_t slide = (uintptr_t)_dyld_get_image_vmaddr_slide(i);
+        for (int rank = 0; rank <= 2; rank++) {
+            for (unsigned s = 0; s < prefetch->segmentCount; s++) {
+                const HIAHPrefetchSegment *segment = &prefetch->segments[s];
+                if (HIAHSegmentRank(segment) != rank) continue;
+                HIAHPrefetchRecordRegion(prefetch, (const void *)(segment->vmaddr + slide),
+                                         prefetch->sliceOffset + segment->fileoff,
+                                         segment->filesize);
+            }
+        }
+        return;
+    }
+}
+#endif
+
+#pragma mark - Sessions
+
+HIAHPrefetch *HIAHPrefetchBegin(const char *path) {
+    if (!path) return NULL;
+
+    HIAHPrefetch *prefetch = calloc(1, sizeof(HIAHPrefetch));
+    if (!prefetch) return NULL;
+    prefetch->fd = open(path, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (prefetch->fd < 0 || fstat(prefetch->fd, &st) != 0 ||
+        strlen(path) >= sizeof(prefetch->path)) {
+        if (prefetch->fd >= 0) close(prefetch->fd);
+        free(prefetch);
+        return NULL;
+    }
+    strcpy(prefetch->path, path);
+    prefetch->fileSize = (uint64_t)st.st_size;
+
+    HIAHParseBinary(prefetch);
+    if (prefetch->segmentCount > 0) {
+        prefetch->usedProfile = HIAHReplayProfile(prefetch);
+        if (!prefetch->usedProfile) {
+            // No profile yet: this launch records one, so it gives no advice
+            // (which would make every advised page look touched) and is the
+            // baseline later launches are compared against
+            HIAHSampleResidency(prefetch);
+        }
+    }
+
+    getrusage(RUSAGE_SELF, &prefetch->startUsage);
+    prefetch->startNs = HIAHNowNs();
+    return prefetch;
+}
+
+void HIAHPrefetchFinish(HIAHPrefetch *prefetch, bool loaded, HIAHPrefetchStats *stats) {
+    if (!prefetch) {
+        if (stats) memset(stats, 0, sizeof(*stats));
+        return;
+    }
+
+    uint64_t endNs = HIAHNowNs();
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    HIAHPrefetchStats measured = {
+        .usedProfile = prefetch->usedProfile,
+        .rangesAdvised = prefetch->rangesAdvised,
+        .bytesAdvised = prefetch->bytesAdvised,
+        .majorFaults = (uint64_t)(usage.ru_majflt - prefetch->startUsage.ru_majflt),
+        .minorFaults = (uint64_t)(usage.ru_minflt - prefetch->startUsage.ru_minflt),
+        .wallNs = endNs - prefetch->startNs,
+        .baselineMajorFaults = prefetch->baselineMajorFaults,
+        .baselineMinorFaults = prefetch->baselineMinorFaults,
+        .baselineWallNs = prefetch->baselineWallNs,
+    };
+
+    if (loaded && !prefetch->usedProfile && prefetch->segmentCount > 0) {
+#ifdef __APPLE__
+        HIAHRecordLoadedImage(prefetch);
+#endif
+        if (prefetch->touchedCount > 0) {
+            HIAHSaveProfile(prefetch, &measured);
+            measured.recordedProfile = true;
+        }
+    }
+    if (stats) *stats = measured;
+
+    close(prefetch->fd);
+    free(prefetch->resident);
+    free(prefetch->touched);
+    free(prefetch);
+}
+
+void HIAHPrefetchInvalidate(const char *path) {
+    if (!path) return;
+    char profilePath[PATH_MAX + 16];
+    HIAHProfilePath(path, profilePath, sizeof(profilePath));
+    unlink(profilePath);
+}
@@ -0,0 +1,90 @@
+/**
+ * HIAHPrefetch.h
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Read-ahead for guest binaries ahead of dlopen.
+ *
+ * A freshly prepared guest is usually cold: dyld maps it and then faults
+ * pages in one at a time while it binds symbols, applies fixups and runs
+ * initializers, all on the launch thread. HIAHPrefetchBegin asks the kernel
+ * to start reading what dyld is about to touch (F_RDADVISE on Darwin,
+ * posix_fadvise elsewhere) so those faults find the pages already cached.
+ *
+ * The first launch gives no advice and records which pages of the loaded
+ * image the load actually touched: those the pmap marks referenced, or
+ * where it doesn't track references, those that were not cached before
+ * the load began. The pages are saved next to the binary as
+ * <binary>.prefetch, with __LINKEDIT first, then the data segments, then
+ * __TEXT (the order dyld works through them; mincore gives no finer
+ * order), and advised on later launches. The recording launch's faults
+ * and wall time are kept in the profile as the baseline those launches
+ * report against. A profile only applies while the binary's size and load
+ * commands are unchanged, so re-signing in place keeps it valid but a new
+ * build does not.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#ifndef HIAH_PREFETCH_H
+#define HIAH_PREFETCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Suffix of the profile stored next to a binary
+#define HIAH_PREFETCH_PROFILE_SUFFIX ".prefetch"
+
+typedef struct {
+    bool usedProfile;             // Replayed a recorded profile
+    bool recordedProfile;         // Wrote a new profile
+    uint32_t rangesAdvised;
+    uint64_t bytesAdvised;
+    uint64_t majorFaults;         // Process-wide, between Begin and Finish
+    uint64_t minorFaults;
+    uint64_t wallNs;              // Between Begin and Finish
+    // With usedProfile: the same measurements from the recording launch
+    uint64_t baselineMajorFaults;
+    uint64_t baselineMinorFaults;
+    uint64_t baselineWallNs;
+} HIAHPrefetchStats;
+
+typedef struct HIAHPrefetch HIAHPrefetch;
+
+/**
+ * Issues read-ahead for the binary at `path` and starts measuring. Call it
+ * immediately before dlopen. Returns NULL if the file cannot be opened (the
+ * caller just loads without prefetching).
+ */
+HIAHPrefetch *HIAHPrefetchBegin(const char *path);
+
+/**
+ * Marks the pages of [address, address + length) that the load touched
+ * (see above) when recording. `address` is where file offset `fileOffset` of the binary is
+ * mapped. Darwin callers don't need this; Finish walks the loaded image.
+ */
+void HIAHPrefetchRecordRegion(HIAHPrefetch *prefetch, const void *address, uint64_t fileOffset,
+                              uint64_t length);
+
+/**
+ * Stops measuring, fills `stats` (may be NULL) and frees the session.
+ * When no profile was replayed and `loaded` is true, records the pages the
+ * load touched and saves them, with this launch's measurements, as the
+ * binary's profile.
+ */
+void HIAHPrefetchFinish(HIAHPrefetch *prefetch, bool loaded, HIAHPrefetchStats *stats);
+
+/**
+ * Deletes the profile for `path` (e.g. when the binary is replaced).
+ */
+void HIAHPrefetchInvalidate(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HIAH_PREFETCH_H */
@@ -0,0 +1,70 @@
+/**
+ * HIAHSHA256.h
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * SHA-256 for content hashing. On Darwin this is CommonCrypto; elsewhere
+ * (the Linux test builds) a portable implementation with the same shape.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#ifndef HIAH_SHA256_H
+#define HIAH_SHA256_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __APPLE__
+#include <CommonCrypto/CommonDigest.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HIAH_SHA256_DIGEST_SIZE 32
+
+#ifdef __APPLE__
+
+typedef CC_SHA256_CTX HIAHSHA256Context;
+
+static inline void HIAHSHA256Init(HIAHSHA256Context *context) {
+    CC_SHA256_Init(context);
+}
+
+static inline void HIAHSHA256Update(HIAHSHA256Context *context, const void *data, size_t length) {
+    // CC_LONG is 32 bits
+    const uint8_t *bytes = (const uint8_t *)data;
+    while (length > 0) {
+        CC_LONG chunk = length > 0x40000000u ? 0x40000000u : (CC_LONG)length;
+        CC_SHA256_Update(context, bytes, chunk);
+        bytes += chunk;
+        length -= chunk;
+    }
+}
+
+static inline void HIAHSHA256Final(HIAHSHA256Context *context, uint8_t digest[HIAH_SHA256_DIGEST_SIZE]) {
+    CC_SHA256_Final(digest, context);
+}
+
+#else
+
+typedef struct {
+    uint32_t state[8];
+    uint64_t length;              // Bytes hashed so far
+    uint8_t block[64];
+    size_t used;                  // Bytes buffered in `block`
+} HIAHSHA256Context;
+
+void HIAHSHA256Init(HIAHSHA256Context *context);
+void HIAHSHA256Update(HIAHSHA256Context *context, const void *data, size_t length);
+void HIAHSHA256Final(HIAHSHA256Context *context, uint8_t digest[HIAH_SHA256_DIGEST_SIZE]);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HIAH_SHA256_H */
@@ -0,0 +1,461 @@
+/**
+ * HIAHStaging.c
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Incremental staging implementation.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#include "HIAHStaging.h"
+#include "HIAHZipArchive.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __APPLE__
+#include <copyfile.h>
+#include <sys/clonefile.h>
+#else
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
+
+#define HIAH_STAGING_MAGIC 0x47545348u      // 'HSTG'
+#define HIAH_STAGING_VERSION 1u
+#define HIAH_STAGING_TEMPORARY ".hiah-staged.tmp"
+#define HIAH_STAGING_COPY_BUFFER (256 * 1024)
+
+// Manifest: this header, `entryCount` entries sorted by name, then the
+// NUL-terminated names (relative to the tree root) they point into. Each
+// entry describes the source file the staged copy was made from.
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t namesSize;
+} HIAHStagingHeader;
+
+typedef struct {
+    uint64_t inode;
+    uint64_t size;
+    uint64_t mtimeNs;
+    uint32_t nameOffset;
+    uint32_t reserved;
+} HIAHStagingEntry;
+
+typedef struct {
+    HIAHStagingEntry *entries;
+    uint32_t count;
+    uint32_t capacity;
+    char *names;
+    uint32_t namesSize;
+    uint32_t namesCapacity;
+} HIAHStagingManifest;
+
+typedef struct {
+    char source[PATH_MAX];
+    char destination[PATH_MAX];
+    char temporary[PATH_MAX];
+    HIAHStagingManifest previous;
+    bool *seen;                   // Per previous entry
+    HIAHStagingManifest next;
+    uint8_t *buffer;              // Copy fallback
+    HIAHStagingStats stats;
+} HIAHStagingContext;
+
+#pragma mark - Helpers
+
+static uint64_t HIAHStagingMtime(const struct stat *st) {
+#ifdef __APPLE__
+    return (uint64_t)st->st_mtimespec.tv_sec * 1000000000ull + (uint64_t)st->st_mtimespec.tv_nsec;
+#else
+    return (uint64_t)st->st_mtim.tv_sec * 1000000000ull + (uint64_t)st->st_mtim.tv_nsec;
+#endif
+}
+
+// rm -rf, for the rare staged path that changed from directory to file
+static int HIAHStagingRemove(const char *path) {
+    struct stat st;
+    if (lstat(path, &st) != 0) return errno == ENOENT ? 0 : errno;
+    if (!S_ISDIR(st.st_mode)) return unlink(path) == 0 ? 0 : errno;
+
+    DIR *directory = opendir(path);
+    if (!directory) return errno;
+    int error = 0;
+    struct dirent *item;
+    char child[PATH_MAX];
+    while (!error && (item = readdir(directory))) {
+        if (strcmp(item->d_name, ".") == 0 || strcmp(item->d_name, "..") == 0) continue;
+        if (snprintf(child, sizeof(child), "%s/%s", path, item->d_name) >= (int)sizeof(child)) {
+            error = ENAMETOOLONG;
+        } else {
+            error = HIAHStagingRemove(child);
+        }
+    }
+    closedir(directory);
+    if (!error && rmdir(path) != 0) error = errno;
+    return error;
+}
+
+#pragma mark - Manifest
+
+static int HIAHStagingManifestAdd(HIAHStagingManifest *manifest, const char *name,
+                                  const HIAHStagingEntry *entry) {
+    uint32_t nameSize = (uint32_t)strlen(name) + 1;
+    if (manifest->count == manifest->capacity) {
+        uint32_t capacity = manifest->capacity ? manifest->capacity * 2 : 256;
+        HIAHStagingEntry *entries = realloc(manifest->entries, capacity * sizeof(*entries));
+        if (!entries) return ENOMEM;
+        manifest->entries = entries;
+        manifest->capacity = capacity;
+    }
+    if (manifest->namesSize + nameSize > manifest->namesCapacity) {
+        uint32_t capacity = manifest->namesCapacity ? manifest->namesCapacity : 8192;
+        while (manifest->namesSize + nameSize > capacity) capacity *= 2;
+        char *names = realloc(manifest->names, capacity);
+        if (!names) return ENOMEM;
+        manifest->names = names;
+        manifest->namesCapacity = capacity;
+    }
+
+    HIAHStagingEntry *slot = &manifest->entries[manifest->count++];
+    *slot = *entry;
+    slot->nameOffset = manifest->namesSize;
+    memcpy(manifest->names + manifest->namesSize, name, nameSize);
+    manifest->namesSize += nameSize;
+    return 0;
+}
+
+static void HIAHStagingManifestFree(HIAHStagingManifest *manifest) {
+    free(manifest->entries);
+    free(manifest->names);
+    memset(manifest, 0, sizeof(*manifest));
+}
+
+// A missing or unreadable manifest leaves `manifest` empty: everything is staged again
+static void HIAHStagingManifestLoad(HIAHStagingManifest *manifest, const char *path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+
+    HIAHStagingHeader header;
+    bool valid = pread(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) &&
+                 header.magic == HIAH_STAGING_MAGIC && header.version == HIAH_STAGING_VERSION &&
+                 header.entryCount < (1u << 24) && header.namesSize < (1u << 28);
+    if (valid) {
+        size_t entriesSize = (size_t)header.entryCount * sizeof(HIAHStagingEntry);
+        manifest->entries = malloc(entriesSize ? entriesSize : 1);
+        manifest->names = malloc(header.namesSize ? header.namesSize : 1);
+        valid = manifest->entries && manifest->names &&
+                pread(fd, manifest->entries, entriesSize, sizeof(header)) == (ssize_t)entriesSize &&
+                pread(fd, manifest->names, header.namesSize, (off_t)(sizeof(header) + entriesSize)) ==
+                    (ssize_t)header.namesSize &&
+                (header.namesSize == 0 || manifest->names[header.namesSize - 1] == '\0');
+        for (uint32_t i = 0; valid && i < header.entryCount; i++) {
+            valid = manifest->entries[i].nameOffset < header.namesSize;
+        }
+    }
+    close(fd);
+
+    if (!valid) {
+        HIAHStagingManifestFree(manifest);
+        return;
+    }
+    manifest->count = manifest->capacity = header.entryCount;
+    manifest->namesSize = manifest->namesCapacity = header.namesSize;
+}
+
+static int HIAHStagingCompareEntries(const void *a, const void *b) {
+    // (name, entry) pairs; see HIAHStagingManifestSave
+    const char *const *left = a;
+    const char *const *right = b;
+    return strcmp(*left, *right);
+}
+
+// Sorts `manifest` by name. The comparator gets no context, so it sorts
+// (name, entry) pairs with the name pointer first, like the lazy index
+static int HIAHStagingManifestSort(HIAHStagingManifest *manifest) {
+    typedef struct {
+        const char *name;
+        HIAHStagingEntry entry;
+    } HIAHStagingSorted;
+
+    HIAHStagingSorted *sorted =
+        malloc((manifest->count ? manifest->count : 1) * sizeof(HIAHStagingSorted));
+    if (!sorted) return ENOMEM;
+    for (uint32_t i = 0; i < manifest->count; i++) {
+        sorted[i] = (HIAHStagingSorted){manifest->names + manifest->entries[i].nameOffset,
+                                        manifest->entries[i]};
+    }
+    qsort(sorted, manifest->count, sizeof(HIAHStagingSorted), HIAHStagingCompareEntries);
+    for (uint32_t i = 0; i < manifest->count; i++) manifest->entries[i] = sorted[i].entry;
+    free(sorted);
+    return 0;
+}
+
+static int HIAHStagingManifestSave(HIAHStagingManifest *manifest, const char *destination) {
+    int sortError = HIAHStagingManifestSort(manifest);
+    if (sortError) return sortError;
+
+    char path[PATH_MAX], temporary[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/" HIAH_STAGING_MANIFEST, destination);
+    snprintf(temporary, sizeof(temporary), "%s/" HIAH_STAGING_MANIFEST ".new", destination);
+
+    int fd = open(temporary, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return errno;
+    HIAHStagingHeader header = {HIAH_STAGING_MAGIC, HIAH_STAGING_VERSION, manifest->count,
+                                manifest->namesSize};
+    size_t entriesSize = (size_t)manifest->count * sizeof(HIAHStagingEntry);
+    int error = 0;
+    if (write(fd, &header, sizeof(header)) != (ssize_t)sizeof(header) ||
+        (entriesSize && write(fd, manifest->entries, entriesSize) != (ssize_t)entriesSize) ||
+        (manifest->namesSize &&
+         write(fd, manifest->names, manifest->namesSize) != (ssize_t)manifest->namesSize)) {
+        error = errno ? errno : EIO;
+    }
+    if (close(fd) != 0 && !error) error = errno;
+    if (!error && rename(temporary, path) != 0) error = errno;
+    if (error) unlink(temporary);
+    return error;
+}
+
+static const HIAHStagingEntry *HIAHStagingManifestFind(const HIAHStagingManifest *manifest,
+                                                       const char *name) {
+    size_t low = 0, high = manifest->count;
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        int order = strcmp(manifest->names + manifest->entries[middle].nameOffset, name);
+        if (order == 0) return &manifest->entries[middle];
+        if (order < 0) low = middle + 1;
+        else high = middle;
+    }
+    return NULL;
+}
+
+#pragma mark - Staging
+
+#ifndef __APPLE__
+static int HIAHStagingCopy(HIAHStagingContext *context, const char *source, const char *destination,
+                           mode_t mode) {
+    if (!context->buffer && !(context->buffer = malloc(HIAH_STAGING_COPY_BUFFER))) return ENOMEM;
+    int in = open(source, O_RDONLY | O_CLOEXEC);
+    if (in < 0) return errno;
+    int out = open(destination, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, mode & 07777);
+    int error = out < 0 ? errno : 0;
+
+    while (!error) {
+        ssize_t got = read(in, context->buffer, HIAH_STAGING_COPY_BUFFER);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) {
+            error = got < 0 ? errno : 0;
+            break;
+        }
+        context->stats.copiedBytes += (uint64_t)got;
+        for (ssize_t done = 0; done < got && !error;) {
+            ssize_t put = write(out, context->buffer + done, (size_t)(got - done));
+            if (put < 0 && errno != EINTR) error = errno;
+            if (put > 0) done += put;
+        }
+    }
+
+    close(in);
+    if (out >= 0 && close(out) != 0 && !error) error = errno;
+    return error;
+}
+#endif
+
+// Stages one regular file as the temporary, cheapest way first
+static int HIAHStagingFile(HIAHStagingContext *context, const char *source, const struct stat *st) {
+    const char *temporary = context->temporary;
+#ifdef __APPLE__
+    // Hardlinks are not an option here: the extension may patch a staged
+    // binary in place, which must never reach the installed bundle
+    if (clonefile(source, temporary, CLONE_NOFOLLOW) == 0) {
+        context->stats.cloned++;
+        return 0;
+    }
+    if (copyfile(source, temporary, NULL, COPYFILE_DATA | COPYFILE_STAT) != 0) return errno;
+    context->stats.copied++;
+    context->stats.copiedBytes += (uint64_t)st->st_size;
+    return 0;
+#else
+    int in = open(source, O_RDONLY | O_CLOEXEC);
+    if (in < 0) return errno;
+    int out = open(temporary, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, st->st_mode & 07777);
+    if (out < 0) {
+        int error = errno;
+        close(in);
+        return error;
+    }
+    int cloned = ioctl(out, FICLONE, in);
+    close(in);
+    close(out);
+    if (cloned == 0) {
+        context->stats.cloned++;
+        return 0;
+    }
+    unlink(temporary);
+
+    // Test builds only; a hardlinked tree must not be patched in place
+    if (link(source, temporary) == 0) {
+        context->stats.linked++;
+        return 0;
+    }
+    context->stats.copied++;
+    return HIAHStagingCopy(context, source, temporary, st->st_mode);
+#endif
+}
+
+static int HIAHStagingSymlink(const char *source, const char *temporary) {
+    char target[PATH_MAX];
+    ssize_t length = readlink(source, target, sizeof(target) - 1);
+    if (length < 0) return errno;
+    target[length] = '\0';
+    return symlink(target, temporary) == 0 ? 0 : errno;
+}
+
+// `relative` is the entry's path below both roots, without a leading slash
+static int HIAHStagingEntryAt(HIAHStagingContext *context, const char *relative, const struct stat *st) {
+    char source[PATH_MAX], destination[PATH_MAX];
+    if (snprintf(source, sizeof(source), "%s/%s", context->source, relative) >= (int)sizeof(source) ||
+        snprintf(destination, sizeof(destination), "%s/%s", context->destination, relative) >=
+            (int)sizeof(destination)) {
+        return ENAMETOOLONG;
+    }
+
+    struct stat staged;
+    bool exists = lstat(destination, &staged) == 0;
+    HIAHStagingEntry entry = {(uint64_t)st->st_ino, (uint64_t)st->st_size, HIAHStagingMtime(st), 0, 0};
+
+    const HIAHStagingEntry *previous = HIAHStagingManifestFind(&context->previous, relative);
+    if (previous) context->seen[previous - context->previous.entries] = true;
+    context->stats.files++;
+
+    // The staged copy may have been patched since; as long as its source is
+    // the same file, it is kept as it is
+    if (exists && previous && previous->inode == entry.inode && previous->size == entry.size &&
+        previous->mtimeNs == entry.mtimeNs && S_ISLNK(staged.st_mode) == S_ISLNK(st->st_mode)) {
+        context->stats.unchanged++;
+        return HIAHStagingManifestAdd(&context->next, relative, &entry);
+    }
+
+    unlink(context->temporary);
+    int error = S_ISLNK(st->st_mode) ? HIAHStagingSymlink(source, context->temporary)
+                                     : HIAHStagingFile(context, source, st);
+    if (!error && exists && S_ISDIR(staged.st_mode)) error = HIAHStagingRemove(destination);
+    if (!error && rename(context->temporary, destination) != 0) error = errno;
+    // Also when renaming over a hardlink of the same file, which does nothing
+    unlink(context->temporary);
+    if (error) return error;
+    return HIAHStagingManifestAdd(&context->next, relative, &entry);
+}
+
+// `relative` (PATH_MAX bytes, `length` used) is extended in place while descending
+static int HIAHStagingDirectory(HIAHStagingContext *context, char *relative, size_t length) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s%s%s", context->source, length ? "/" : "", relative);
+    DIR *directory = opendir(path);
+    if (!directory) return errno;
+
+    int error = 0;
+    struct dirent *item;
+    while (!error && (item = readdir(directory))) {
+        const char *name = item->d_name;
+        if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) continue;
+        if (length == 0 && strncmp(name, HIAH_STAGING_MANIFEST, strlen(HIAH_STAGING_MANIFEST)) == 0) continue;
+
+        size_t nameLength = strlen(name);
+        if (length + 1 + nameLength >= PATH_MAX) {
+            error = ENAMETOOLONG;
+            break;
+        }
+        size_t childLength = length;
+        if (childLength) relative[childLength++] = '/';
+        memcpy(relative + childLength, name, nameLength + 1);
+        childLength += nameLength;
+
+        char child[PATH_MAX];
+        struct stat st;
+        snprintf(child, sizeof(child), "%s/%s", context->source, relative);
+        if (lstat(child, &st) != 0) {
+            error = errno == ENOENT ? 0 : errno;   // Vanished while walking
+        } else if (S_ISDIR(st.st_mode)) {
+            snprintf(child, sizeof(child), "%s/%s", context->destination, relative);
+            struct stat staged;
+            if (lstat(child, &staged) == 0 && !S_ISDIR(staged.st_mode)) unlink(child);
+            if (mkdir(child, 0755) != 0 && errno != EEXIST) error = errno;
+            if (!error) error = HIAHStagingDirectory(context, relative, childLength);
+        } else if (S_ISREG(st.st_mode) || S_ISLNK(st.st_mode)) {
+            error = HIAHStagingEntryAt(context, relative, &st);
+        }
+        relative[length] = '\0';
+    }
+    closedir(directory);
+    return error;
+}
+
+int HIAHStagingSync(const char *source, const char *destination, bool prune,
+                    HIAHStagingStats *stats) {
+    uint64_t start = HIAHZipNowNs();
+    HIAHStagingContext *context = calloc(1, sizeof(*context));
+    if (!context) return ENOMEM;
+
+    int error = 0;
+    if (strlen(source) >= sizeof(context->source) ||
+        strlen(destination) + sizeof("/" HIAH_STAGING_TEMPORARY) > sizeof(context->destination)) {
+        error = ENAMETOOLONG;
+    } else {
+        strcpy(context->source, source);
+        strcpy(context->destination, destination);
+        snprintf(context->temporary, sizeof(context->temporary), "%s/" HIAH_STAGING_TEMPORARY, destination);
+        error = HIAHZipMakeDirectories(context->destination);
+    }
+
+    if (!error) {
+        char manifest[PATH_MAX];
+        snprintf(manifest, sizeof(manifest), "%s/" HIAH_STAGING_MANIFEST, destination);
+        HIAHStagingManifestLoad(&context->previous, manifest);
+        context->seen = calloc(context->previous.count ? context->previous.count : 1, sizeof(bool));
+        if (!context->seen) error = ENOMEM;
+    }
+
+    char *relative = error ? NULL : calloc(1, PATH_MAX);
+    if (!error && !relative) error = ENOMEM;
+    if (!error) error = HIAHStagingDirectory(context, relative, 0);
+    free(relative);
+
+    // Files staged earlier and since removed from the source: deleted, or
+    // carried over so a later sync can delete them
+    for (uint32_t i = 0; !error && i < context->previous.count; i++) {
+        if (context->seen[i]) continue;
+        const HIAHStagingEntry *entry = &context->previous.entries[i];
+        const char *name = context->previous.names + entry->nameOffset;
+        if (prune) {
+            char path[PATH_MAX];
+            snprintf(path, sizeof(path), "%s/%s", destination, name);
+            if (unlink(path) == 0) context->stats.removed++;
+        } else {
+            error = HIAHStagingManifestAdd(&context->next, name, entry);
+        }
+    }
+
+    // On failure the old manifest stays: whatever was re-staged no longer
+    // matches it and is simply staged again next time
+    if (!error) error = HIAHStagingManifestSave(&context->next, destination);
+
+    context->stats.wallNs = HIAHZipNowNs() - start;
+    if (stats) *stats = context->stats;
+
+    HIAHStagingManifestFree(&context->previous);
+    HIAHStagingManifestFree(&context->next);
+    free(context->seen);
+    free(context->buffer);
+    free(context);
+    return error;
+}
@@ -0,0 +1,68 @@
+/**
+ * HIAHStaging.h
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Incremental staging of app bundles into the App Group container.
+ *
+ * A staged tree is kept between launches. Each sync walks the source
+ * bundle and compares every file's inode, size and modification time with
+ * what the staged copy was made from (recorded in a manifest inside the
+ * staged tree); only new or changed files are staged again. Files are
+ * staged as APFS clones, which share storage with the source until either
+ * side changes, so even a full stage costs almost no flash writes. Where
+ * clones are unavailable (other filesystems, or Linux test builds) files
+ * are reflinked, hardlinked or, as a last resort, copied.
+ *
+ * Staged files are replaced by rename, so a process running from the tree
+ * keeps the files it has open. Files created inside the staged tree (e.g.
+ * read-ahead profiles or a lazy bundle's cache) are not in the manifest
+ * and are left alone.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#ifndef HIAH_STAGING_H
+#define HIAH_STAGING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Manifest file inside a staged tree
+#define HIAH_STAGING_MANIFEST ".hiah-staged"
+
+typedef struct {
+    uint64_t files;               // Regular files and symlinks in the source
+    uint64_t unchanged;           // Already staged and up to date
+    uint64_t cloned;              // Staged as clones or reflinks
+    uint64_t linked;              // Staged as hardlinks
+    uint64_t copied;              // Staged as full copies
+    uint64_t copiedBytes;
+    uint64_t removed;             // Staged earlier, since gone from the source
+    uint64_t wallNs;
+} HIAHStagingStats;
+
+/**
+ * Brings the staged tree at `destination` up to date with `source`,
+ * creating it if needed. With `prune`, files staged earlier that no longer
+ * exist in the source are deleted; pass false while the tree is in use.
+ * Syncs of different trees may run concurrently; syncs of the same
+ * `destination` must not.
+ *
+ * `stats` may be NULL.
+ *
+ * @return 0 or an errno value. On failure the tree may be partly updated;
+ *         the next sync completes it.
+ */
+int HIAHStagingSync(const char *source, const char *destination, bool prune,
+                    HIAHStagingStats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HIAH_STAGING_H */
@@ -0,0 +1,809 @@
+/**
+ * HIAHZipArchive.c
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Streaming archive extraction implementation.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#include "HIAHZipArchive.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#define HIAH_ZIP_EOCD_SIGNATURE 0x06054b50u
+#define HIAH_ZIP64_EOCD_SIGNATURE 0x06064b50u
+#define HIAH_ZIP64_LOCATOR_SIGNATURE 0x07064b50u
+#define HIAH_ZIP_CENTRAL_SIGNATURE 0x02014b50u
+#define HIAH_ZIP_LOCAL_SIGNATURE 0x04034b50u
+#define HIAH_ZIP_EOCD_SIZE 22
+#define HIAH_ZIP64_EOCD_SIZE 56
+#define HIAH_ZIP64_LOCATOR_SIZE 20
+#define HIAH_ZIP_CENTRAL_SIZE 46
+#define HIAH_ZIP_LOCAL_SIZE 30
+#define HIAH_ZIP_MAX_COMMENT 0xffff
+#define HIAH_ZIP64_EXTRA_ID 0x0001
+
+#define HIAH_ZIP_METHOD_STORED 0
+#define HIAH_ZIP_METHOD_DEFLATE 8
+#define HIAH_ZIP_FLAG_ENCRYPTED 0x0001
+#define HIAH_ZIP_HOST_UNIX 3
+
+/// Upper bound when the thread count is picked automatically
+#define HIAH_ZIP_MAX_THREADS 8
+
+typedef struct {
+    const char *name;             // Not NUL-terminated; points into the central directory
+    uint16_t nameLength;
+    uint16_t flags;
+    uint16_t method;
+    uint32_t crc;
+    uint64_t compressedSize;
+    uint64_t uncompressedSize;
+    uint64_t localHeaderOffset;
+    mode_t mode;                  // Type and permission bits; 0 if not recorded
+} HIAHZipEntry;
+
+typedef struct {
+    int archive;
+    uint64_t archiveSize;
+    int destination;              // Directory fd everything is created relative to
+    const HIAHZipFilter *filter;  // NULL to write files as they are
+    uint8_t *directory;           // Central directory, which entry names point into
+    HIAHZipEntry *entries;
+    size_t entryCount;
+    const HIAHZipEntry **files;   // Non-directory entries, largest first
+    size_t fileCount;
+    char lastDirectory[PATH_MAX]; // Parent most recently created, to skip repeats
+    _Atomic(size_t) nextFile;
+    _Atomic(int) error;           // First failure; stops the other workers
+    HIAHZipStats stats;
+} HIAHZipContext;
+
+typedef struct {
+    HIAHZipContext *context;
+    pthread_t thread;
+    z_stream stream;
+    bool streamReady;
+    uint8_t *input;
+    uint8_t *output;
+    HIAHZipStats stats;
+} HIAHZipWorker;
+
+#pragma mark - Helpers
+
+static uint16_t HIAHRead16(const uint8_t *bytes) {
+    return (uint16_t)(bytes[0] | (bytes[1] << 8));
+}
+
+static uint32_t HIAHRead32(const uint8_t *bytes) {
+    return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) |
+           ((uint32_t)bytes[3] << 24);
+}
+
+static uint64_t HIAHRead64(const uint8_t *bytes) {
+    return (uint64_t)HIAHRead32(bytes) | ((uint64_t)HIAHRead32(bytes + 4) << 32);
+}
+
+uint64_t HIAHZipNowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int HIAHReadFully(int fd, void *buffer, size_t length, uint64_t offset) {
+    uint8_t *bytes = buffer;
+    while (length > 0) {
+        ssize_t got = pread(fd, bytes, length, (off_t)offset);
+        if (got < 0 && errno == EINTR) continue;
+        if (got < 0) return errno;
+        if (got == 0) return EILSEQ;   // Archive shorter than its directory claims
+        bytes += got;
+        length -= (size_t)got;
+        offset += (uint64_t)got;
+    }
+    return 0;
+}
+
+static int HIAHWriteFully(int fd, const void *buffer, size_t length) {
+    const uint8_t *bytes = buffer;
+    while (length > 0) {
+        ssize_t put = write(fd, bytes, length);
+        if (put < 0 && errno == EINTR) continue;
+        if (put < 0) return errno;
+        bytes += put;
+        length -= (size_t)put;
+    }
+    return 0;
+}
+
+// Rejects names that would land outside the destination
+static bool HIAHZipNameIsSafe(const char *name) {
+    if (name[0] == '\0' || name[0] == '/') return false;
+    for (const char *component = name; *component;) {
+        const char *end = strchr(component, '/');
+        size_t length = end ? (size_t)(end - component) : strlen(component);
+        if (length == 2 && component[0] == '.' && component[1] == '.') return false;
+        if (!end) break;
+        component = end + 1;
+    }
+    return true;
+}
+
+// mkdir -p relative to the destination; `path` is modified temporarily
+static int HIAHZipMakeDirectoriesAt(HIAHZipContext *context, char *path) {
+    if (strcmp(path, context->lastDirectory) == 0) return 0;
+
+    for (char *slash = strchr(path, '/');; slash = strchr(slash + 1, '/')) {
+        if (slash) *slash = '\0';
+        int result = path[0] ? mkdirat(context->destination, path, 0755) : 0;
+        int error = errno;
+        if (slash) *slash = '/';
+        if (result != 0 && error != EEXIST) return error;
+        if (!slash) break;
+    }
+    strncpy(context->lastDirectory, path, sizeof(context->lastDirectory) - 1);
+    return 0;
+}
+
+static int HIAHZipMakeParentAt(HIAHZipContext *context, char *path) {
+    char *slash = strrchr(path, '/');
+    if (!slash) return 0;
+    *slash = '\0';
+    int error = HIAHZipMakeDirectoriesAt(context, path);
+    *slash = '/';
+    return error;
+}
+
+int HIAHZipMakeDirectories(char *path) {
+    for (char *slash = strchr(path + 1, '/');; slash = strchr(slash + 1, '/')) {
+        if (slash) *slash = '\0';
+        int result = mkdir(path, 0755);
+        int error = errno;
+        if (slash) *slash = '/';
+        if (result != 0 && error != EEXIST) return error;
+        if (!slash) return 0;
+    }
+}
+
+int HIAHZipMakeParent(char *path) {
+    char *slash = strrchr(path, '/');
+    if (!slash || slash == path) return 0;
+    *slash = '\0';
+    int error = HIAHZipMakeDirectories(path);
+    *slash = '/';
+    return error;
+}
+
+static int HIAHMakeDestination(const char *destination) {
+    char path[PATH_MAX];
+    size_t length = strlen(destination);
+    if (length == 0 || length >= sizeof(path)) return length ? ENAMETOOLONG : EINVAL;
+    memcpy(path, destination, length + 1);
+    return HIAHZipMakeDirectories(path);
+}
+
+#pragma mark - Entries
+
+typedef struct {
+    int fd;
+    const HIAHZipFilter *filter;
+    void *state;                  // The filter's; NULL writes straight to `fd`
+} HIAHZipOutput;
+
+static int HIAHZipOutputWrite(const HIAHZipOutput *output, const void *data, size_t length) {
+    return output->state ? output->filter->write(output->state, data, length)
+                         : HIAHWriteFully(output->fd, data, length);
+}
+
+// Streams the entry's data to `output`, verifying size and CRC-32
+static int HIAHZipCopyData(HIAHZipWorker *worker, int archive, const HIAHZipEntry *entry,
+                           uint64_t dataOffset, const HIAHZipOutput *output) {
+    uint64_t remaining = entry->compressedSize;
+    uint64_t offset = dataOffset;
+    uint64_t written = 0;
+    uLong crc = crc32(0, Z_NULL, 0);
+    int error = 0;
+
+    if (entry->method == HIAH_ZIP_METHOD_STORED) {
+        if (entry->compressedSize != entry->uncompressedSize) return EILSEQ;
+        while (remaining > 0 && !error) {
+            size_t chunk = remaining < HIAH_ZIP_BUFFER_SIZE ? (size_t)remaining
+                                                            : HIAH_ZIP_BUFFER_SIZE;
+            if ((error = HIAHReadFully(archive, worker->input, chunk, offset))) break;
+            crc = crc32(crc, worker->input, (uInt)chunk);
+            error = HIAHZipOutputWrite(output, worker->input, chunk);
+            offset += chunk;
+            remaining -= chunk;
+            written += chunk;
+        }
+        worker->stats.bytesRead += written;
+    } else {
+        z_stream *stream = &worker->stream;
+        if (inflateReset(stream) != Z_OK) return EILSEQ;
+        stream->avail_in = 0;
+
+        int status = Z_OK;
+        while (status != Z_STREAM_END && !error) {
+            if (stream->avail_in == 0) {
+                if (remaining == 0) return EILSEQ;   // Deflate stream truncated
+                size_t chunk = remaining < HIAH_ZIP_BUFFER_SIZE ? (size_t)remaining
+                                                                : HIAH_ZIP_BUFFER_SIZE;
+                if ((error = HIAHReadFully(archive, worker->input, chunk, offset))) break;
+                stream->next_in = worker->input;
+                stream->avail_in = (uInt)chunk;
+                offset += chunk;
+                remaining -= chunk;
+                worker->stats.bytesRead += chunk;
+            }
+
+            stream->next_out = worker->output;
+            stream->avail_out = HIAH_ZIP_BUFFER_SIZE;
+            status = inflate(stream, Z_NO_FLUSH);
+            if (status != Z_OK && status != Z_STREAM_END) return EILSEQ;
+
+            size_t produced = HIAH_ZIP_BUFFER_SIZE - stream->avail_out;
+            written += produced;
+            if (written > entry->uncompressedSize) return EILSEQ;
+            crc = crc32(crc, worker->output, (uInt)produced);
+            error = HIAHZipOutputWrite(output, worker->output, produced);
+        }
+    }
+
+    if (error) return error;
+    if (written != entry->uncompressedSize || (uint32_t)crc != entry->crc) return EILSEQ;
+    worker->stats.bytesWritten += written;
+    return 0;
+}
+
+// The local header's name and extra lengths can differ from the central
+// directory's, so the data offset comes from the local header itself
+static int HIAHZipFindData(const HIAHZipContext *context, const HIAHZipEntry *entry,
+                           uint64_t *dataOffset) {
+    uint8_t local[HIAH_ZIP_LOCAL_SIZE];
+    int error = HIAHReadFully(context->archive, local, sizeof(local), entry->localHeaderOffset);
+    if (error) return error;
+    if (HIAHRead32(local) != HIAH_ZIP_LOCAL_SIGNATURE) return EILSEQ;
+    uint64_t offset = entry->localHeaderOffset + HIAH_ZIP_LOCAL_SIZE + HIAHRead16(local + 26) +
+                      HIAHRead16(local + 28);
+    if (offset > context->archiveSize || entry->compressedSize > context->archiveSize - offset) {
+        return EILSEQ;
+    }
+    *dataOffset = offset;
+    return 0;
+}
+
+static int HIAHZipFilteredCopy(HIAHZipWorker *worker, int archive, const HIAHZipEntry *entry,
+                               uint64_t dataOffset, const char *name,
+                               const HIAHZipFilter *filter, int fd) {
+    HIAHZipOutput output = {fd, filter, NULL};
+    if (filter) output.state = filter->begin(filter->userData, name, entry->uncompressedSize, fd);
+    int error = HIAHZipCopyData(worker, archive, entry, dataOffset, &output);
+    return output.state ? filter->finish(output.state, error) : error;
+}
+
+// The entry's data is the link target (PATH_MAX bytes); only stored,
+// relative targets that stay inside the bundle are recreated
+static int HIAHZipReadLinkTarget(int archive, uint16_t method, uint64_t size, uint64_t dataOffset,
+                                 char *target) {
+    if (size >= PATH_MAX || method != HIAH_ZIP_METHOD_STORED) return ENOTSUP;
+    int error = HIAHReadFully(archive, target, (size_t)size, dataOffset);
+    if (error) return error;
+    target[size] = '\0';
+    return HIAHZipNameIsSafe(target) ? 0 : EILSEQ;
+}
+
+static mode_t HIAHZipPermissions(uint32_t mode) {
+    return mode & 0777 ? (mode & 0777) | S_IRUSR | S_IWUSR : 0644;
+}
+
+// Writes one file or symlink; its parent directory already exists
+static int HIAHZipExtractFile(HIAHZipWorker *worker, const HIAHZipEntry *entry) {
+    HIAHZipContext *context = worker->context;
+    char path[PATH_MAX];
+    memcpy(path, entry->name, entry->nameLength);
+    path[entry->nameLength] = '\0';
+
+    uint64_t dataOffset;
+    int error = HIAHZipFindData(context, entry, &dataOffset);
+    if (error) return error;
+
+    if (S_ISLNK(entry->mode)) {
+        char target[PATH_MAX];
+        if ((error = HIAHZipReadLinkTarget(context->archive, entry->method,
+                                           entry->uncompressedSize, dataOffset, target))) {
+            return error;
+        }
+        unlinkat(context->destination, path, 0);
+        if (symlinkat(target, context->destination, path) != 0) return errno;
+        worker->stats.files++;
+        return 0;
+    }
+
+    int fd = openat(context->destination, path,
+                    O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_NOFOLLOW,
+                    HIAHZipPermissions(entry->mode));
+    if (fd < 0) return errno;
+
+    error = HIAHZipFilteredCopy(worker, context->archive, entry, dataOffset, path,
+                                context->filter, fd);
+    if (close(fd) != 0 && !error) error = errno;
+    if (error) {
+        unlinkat(context->destination, path, 0);
+        return error;
+    }
+    worker->stats.files++;
+    return 0;
+}
+
+#pragma mark - Workers
+
+static void *HIAHZipWorkerRun(void *argument) {
+    HIAHZipWorker *worker = argument;
+    HIAHZipContext *context = worker->context;
+    while (atomic_load_explicit(&context->error, memory_order_relaxed) == 0) {
+        size_t index = atomic_fetch_add_explicit(&context->nextFile, 1, memory_order_relaxed);
+        if (index >= context->fileCount) break;
+
+        int error = HIAHZipExtractFile(worker, context->files[index]);
+        if (error) {
+            int expected = 0;
+            atomic_compare_exchange_strong(&context->error, &expected, error);
+        }
+    }
+    return NULL;
+}
+
+static bool HIAHZipWorkerInit(HIAHZipWorker *worker, HIAHZipContext *context) {
+    worker->context = context;
+    worker->input = malloc(HIAH_ZIP_BUFFER_SIZE);
+    worker->output = malloc(HIAH_ZIP_BUFFER_SIZE);
+    // Raw deflate: zip entries carry no zlib header
+    worker->streamReady = worker->input && worker->output &&
+                          inflateInit2(&worker->stream, -MAX_WBITS) == Z_OK;
+    return worker->streamReady;
+}
+
+static void HIAHZipWorkerDestroy(HIAHZipWorker *worker) {
+    if (worker->streamReady) inflateEnd(&worker->stream);
+    free(worker->input);
+    free(worker->output);
+}
+
+static unsigned HIAHZipThreadCount(unsigned requested, size_t fileCount) {
+    unsigned threads = requested;
+    if (threads == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = online > 0 ? (unsigned)online : 1;
+        if (threads > HIAH_ZIP_MAX_THREADS) threads = HIAH_ZIP_MAX_THREADS;
+    }
+    if (threads > fileCount) threads = (unsigned)fileCount;
+    return threads ? threads : 1;
+}
+
+// Runs the workers, the calling thread being the first; a worker whose
+// thread can't be started just leaves its share to the others
+static int HIAHZipExtractFiles(HIAHZipContext *context, unsigned threads) {
+    HIAHZipWorker *workers = calloc(threads, sizeof(HIAHZipWorker));
+    if (!workers) return ENOMEM;
+
+    unsigned started = 0;
+    bool *running = calloc(threads, sizeof(bool));
+    for (unsigned i = 0; i < threads && running; i++) {
+        if (!HIAHZipWorkerInit(&workers[i], context)) break;
+        started++;
+        if (i > 0) {
+            running[i] = pthread_create(&workers[i].thread, NULL, HIAHZipWorkerRun,
+                                        &workers[i]) == 0;
+        }
+    }
+    if (started > 0) HIAHZipWorkerRun(&workers[0]);
+
+    for (unsigned i = 0; i < threads; i++) {
+        if (running && running[i]) pthread_join(workers[i].thread, NULL);
+        context->stats.files += workers[i].stats.files;
+        context->stats.bytesRead += workers[i].stats.bytesRead;
+        context->stats.bytesWritten += workers[i].stats.bytesWritten;
+        HIAHZipWorkerDestroy(&workers[i]);
+    }
+    context->stats.threads = started;
+    free(running);
+    free(workers);
+
+    int error = atomic_load(&context->error);
+    return started > 0 ? error : ENOMEM;
+}
+
+#pragma mark - Archive
+
+static void HIAHZipContextFree(HIAHZipContext *context) {
+    if (context->archive >= 0) close(context->archive);
+    if (context->destination >= 0) close(context->destination);
+    free(context->directory);
+    free(context->entries);
+    free(context->files);
+    free(context);
+}
+
+// Locates the central directory. The end record is found by searching back
+// over a possible archive comment; if a ZIP64 locator precedes it, the
+// ZIP64 end record supplies the 64-bit count, size and offset (archives
+// over 4 GB or with more than 65,535 entries).
+static int HIAHZipFindDirectory(HIAHZipContext *context, uint64_t *offset, uint64_t *size,
+                                uint64_t *count) {
+    if (context->archiveSize < HIAH_ZIP_EOCD_SIZE) return EILSEQ;
+
+    uint64_t tailSize = HIAH_ZIP_EOCD_SIZE + HIAH_ZIP_MAX_COMMENT;
+    if (tailSize > context->archiveSize) tailSize = context->archiveSize;
+    uint64_t tailOffset = context->archiveSize - tailSize;
+    uint8_t *tail = malloc((size_t)tailSize);
+    if (!tail) return ENOMEM;
+    int error = HIAHReadFully(context->archive, tail, (size_t)tailSize, tailOffset);
+
+    // The comment may itself contain the signature, so a candidate only
+    // counts if its comment length reaches exactly to the end of the file
+    uint64_t eocd = UINT64_MAX;
+    for (uint64_t at = tailSize - HIAH_ZIP_EOCD_SIZE + 1; !error && at-- > 0;) {
+        if (HIAHRead32(tail + at) == HIAH_ZIP_EOCD_SIGNATURE &&
+            at + HIAH_ZIP_EOCD_SIZE + HIAHRead16(tail + at + 20) == tailSize) {
+            eocd = at;
+            break;
+        }
+    }
+    if (!error && eocd == UINT64_MAX) error = EILSEQ;
+    if (error) {
+        free(tail);
+        return error;
+    }
+
+    const uint8_t *record = tail + eocd;
+    if (HIAHRead16(record + 4) != 0 || HIAHRead16(record + 6) != 0) {
+        free(tail);
+        return ENOTSUP;   // Split archives
+    }
+    *count = HIAHRead16(record + 10);
+    *size = HIAHRead32(record + 12);
+    *offset = HIAHRead32(record + 16);
+    uint64_t eocdOffset = tailOffset + eocd;
+    free(tail);
+
+    if (eocdOffset >= HIAH_ZIP64_LOCATOR_SIZE) {
+        uint8_t locator[HIAH_ZIP64_LOCATOR_SIZE];
+        if ((error = HIAHReadFully(context->archive, locator, sizeof(locator),
+                                   eocdOffset - HIAH_ZIP64_LOCATOR_SIZE))) {
+            return error;
+        }
+        if (HIAHRead32(locator) == HIAH_ZIP64_LOCATOR_SIGNATURE) {
+            uint8_t zip64[HIAH_ZIP64_EOCD_SIZE];
+            uint64_t zip64Offset = HIAHRead64(locator + 8);
+            if (zip64Offset > context->archiveSize - sizeof(zip64)) return EILSEQ;
+            if ((error = HIAHReadFully(context->archive, zip64, sizeof(zip64), zip64Offset))) {
+                return error;
+            }
+            if (HIAHRead32(zip64) != HIAH_ZIP64_EOCD_SIGNATURE) return EILSEQ;
+            *count = HIAHRead64(zip64 + 32);
+            *size = HIAHRead64(zip64 + 40);
+            *offset = HIAHRead64(zip64 + 48);
+        }
+    }
+
+    if (*offset > context->archiveSize || *size > context->archiveSize - *offset ||
+        *count > *size / HIAH_ZIP_CENTRAL_SIZE) {
+        return EILSEQ;
+    }
+    return 0;
+}
+
+// Replaces 32-bit fields saturated at 0xFFFFFFFF with their values from the
+// ZIP64 extra field, which lists only the saturated ones, in this order
+static int HIAHZipApplyZip64(HIAHZipEntry *entry, const uint8_t *extra, uint16_t extraLength) {
+    bool needUncompressed = entry->uncompressedSize == UINT32_MAX;
+    bool needCompressed = entry->compressedSize == UINT32_MAX;
+    bool needOffset = entry->localHeaderOffset == UINT32_MAX;
+    if (!needUncompressed && !needCompressed && !needOffset) return 0;
+
+    for (uint32_t at = 0; at + 4 <= extraLength;) {
+        uint16_t id = HIAHRead16(extra + at);
+        uint16_t length = HIAHRead16(extra + at + 2);
+        if (at + 4 + length > extraLength) break;
+        if (id == HIAH_ZIP64_EXTRA_ID) {
+            const uint8_t *field = extra + at + 4;
+            const uint8_t *end = field + length;
+            if (needUncompressed) {
+                if (field + 8 > end) return EILSEQ;
+                entry->uncompressedSize = HIAHRead64(field);
+                field += 8;
+            }
+            if (needCompressed) {
+                if (field + 8 > end) return EILSEQ;
+                entry->compressedSize = HIAHRead64(field);
+                field += 8;
+            }
+            if (needOffset) {
+                if (field + 8 > end) return EILSEQ;
+                entry->localHeaderOffset = HIAHRead64(field);
+            }
+            return 0;
+        }
+        at += 4 + length;
+    }
+    return EILSEQ;
+}
+
+// Entries with a data descriptor (flag bit 3) have zero sizes and CRC in
+// their local header; the central directory always has the real values,
+// and those are the only ones used.
+static int HIAHZipReadDirectory(HIAHZipContext *context) {
+    uint64_t directoryOffset, directorySize, entryCount;
+    int error = HIAHZipFindDirectory(context, &directoryOffset, &directorySize, &entryCount);
+    if (error) return error;
+
+    // The central directory is proportional to the number of entries, not
+    // their size, so it is read in one go
+    context->directory = malloc(directorySize ? (size_t)directorySize : 1);
+    context->entries = calloc(entryCount ? (size_t)entryCount : 1, sizeof(HIAHZipEntry));
+    if (!context->directory || !context->entries) return ENOMEM;
+    if ((error = HIAHReadFully(context->archive, context->directory, (size_t)directorySize,
+                               directoryOffset))) {
+        return error;
+    }
+
+    uint64_t at = 0;
+    for (uint64_t i = 0; i < entryCount; i++) {
+        const uint8_t *record = context->directory + at;
+        if (at + HIAH_ZIP_CENTRAL_SIZE > directorySize ||
+            HIAHRead32(record) != HIAH_ZIP_CENTRAL_SIGNATURE) {
+            return EILSEQ;
+        }
+        uint16_t nameLength = HIAHRead16(record + 28);
+        uint16_t extraLength = HIAHRead16(record + 30);
+        uint64_t recordSize = HIAH_ZIP_CENTRAL_SIZE + nameLength + extraLength +
+                              HIAHRead16(record + 32);
+        if (at + recordSize > directorySize) return EILSEQ;
+
+        uint32_t externalAttributes = HIAHRead32(record + 38);
+        HIAHZipEntry *entry = &context->entries[i];
+        *entry = (HIAHZipEntry){
+            .name = (const char *)record + HIAH_ZIP_CENTRAL_SIZE,
+            .nameLength = nameLength,
+            .flags = HIAHRead16(record + 8),
+            .method = HIAHRead16(record + 10),
+            .crc = HIAHRead32(record + 16),
+            .compressedSize = HIAHRead32(record + 20),
+            .uncompressedSize = HIAHRead32(record + 24),
+            .localHeaderOffset = HIAHRead32(record + 42),
+            .mode = record[5] == HIAH_ZIP_HOST_UNIX ? (mode_t)(externalAttributes >> 16) : 0,
+        };
+        if ((error = HIAHZipApplyZip64(entry, record + HIAH_ZIP_CENTRAL_SIZE + nameLength,
+                                       extraLength))) {
+            return error;
+        }
+        at += recordSize;
+    }
+    context->entryCount = (size_t)entryCount;
+    return 0;
+}
+
+static int HIAHZipCompareSize(const void *a, const void *b) {
+    uint64_t left = (*(const HIAHZipEntry *const *)a)->uncompressedSize;
+    uint64_t right = (*(const HIAHZipEntry *const *)b)->uncompressedSize;
+    return left < right ? 1 : left > right ? -1 : 0;
+}
+
+// Copies the entry's name into `path` (PATH_MAX bytes, without the trailing
+// slash of a directory) and rejects what this extractor can't write safely
+static int HIAHZipCheckEntry(const HIAHZipEntry *entry, char *path, bool *isDirectory) {
+    if (entry->nameLength == 0 || entry->nameLength >= PATH_MAX) return EILSEQ;
+    memcpy(path, entry->name, entry->nameLength);
+    path[entry->nameLength] = '\0';
+    if (!HIAHZipNameIsSafe(path)) return EILSEQ;
+
+    *isDirectory = path[entry->nameLength - 1] == '/';
+    if (*isDirectory) {
+        path[entry->nameLength - 1] = '\0';
+        return 0;
+    }
+    if (entry->flags & HIAH_ZIP_FLAG_ENCRYPTED) return ENOTSUP;
+    if (entry->method != HIAH_ZIP_METHOD_STORED && entry->method != HIAH_ZIP_METHOD_DEFLATE) {
+        return ENOTSUP;
+    }
+    return 0;
+}
+
+// Validates every entry and creates every directory before any file is
+// written, so workers never race on mkdir; then orders the files largest
+// first so one big asset doesn't end up alone on the last worker
+static int HIAHZipPlan(HIAHZipContext *context) {
+    context->files = malloc((context->entryCount ? context->entryCount : 1) *
+                            sizeof(HIAHZipEntry *));
+    if (!context->files) return ENOMEM;
+
+    for (size_t i = 0; i < context->entryCount; i++) {
+        const HIAHZipEntry *entry = &context->entries[i];
+        char path[PATH_MAX];
+        bool isDirectory;
+        int error = HIAHZipCheckEntry(entry, path, &isDirectory);
+        if (error) return error;
+
+        if (isDirectory) {
+            if ((error = HIAHZipMakeDirectoriesAt(context, path))) return error;
+            context->stats.directories++;
+            continue;
+        }
+        if ((error = HIAHZipMakeParentAt(context, path))) return error;
+        context->files[context->fileCount++] = entry;
+    }
+
+    qsort(context->files, context->fileCount, sizeof(HIAHZipEntry *), HIAHZipCompareSize);
+    return 0;
+}
+
+int HIAHZipExtract(const char *archivePath, const char *destination, unsigned threads,
+                   const HIAHZipFilter *filter, HIAHZipStats *stats) {
+    if (stats) memset(stats, 0, sizeof(*stats));
+    if (!archivePath || !destination) return EINVAL;
+
+    uint64_t begin = HIAHZipNowNs();
+    HIAHZipContext *context = calloc(1, sizeof(HIAHZipContext));
+    if (!context) return ENOMEM;
+    context->destination = -1;
+    context->filter = filter;
+
+    int error = 0;
+    struct stat st;
+    if ((context->archive = open(archivePath, O_RDONLY | O_CLOEXEC)) < 0 ||
+        fstat(context->archive, &st) != 0) {
+        error = errno;
+    } else if (!(error = HIAHMakeDestination(destination))) {
+        context->archiveSize = (uint64_t)st.st_size;
+        context->destination = open(destination, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (context->destination < 0) error = errno;
+    }
+
+    if (!error) error = HIAHZipReadDirectory(context);
+    if (!error) error = HIAHZipPlan(context);
+    if (!error && context->fileCount > 0) {
+        error = HIAHZipExtractFiles(context, HIAHZipThreadCount(threads, context->fileCount));
+    }
+
+    context->stats.wallNs = HIAHZipNowNs() - begin;
+    if (stats) *stats = context->stats;
+    HIAHZipContextFree(context);
+    return error;
+}
+
+#pragma mark - Single Entries
+
+int HIAHZipEnumerate(const char *archivePath, HIAHZipEntryCallback callback, void *userData) {
+    if (!archivePath || !callback) return EINVAL;
+
+    HIAHZipContext *context = calloc(1, sizeof(HIAHZipContext));
+    if (!context) return ENOMEM;
+    context->destination = -1;
+
+    int error = 0;
+    struct stat st;
+    if ((context->archive = open(archivePath, O_RDONLY | O_CLOEXEC)) < 0 ||
+        fstat(context->archive, &st) != 0) {
+        error = errno;
+    } else {
+        context->archiveSize = (uint64_t)st.st_size;
+        error = HIAHZipReadDirectory(context);
+    }
+
+    for (size_t i = 0; i < context->entryCount && !error; i++) {
+        const HIAHZipEntry *entry = &context->entries[i];
+        char path[PATH_MAX + 1];
+        bool isDirectory;
+        if ((error = HIAHZipCheckEntry(entry, path, &isDirectory))) break;
+
+        HIAHZipEntryInfo info = {
+            .name = path,
+            .method = entry->method,
+            .crc = entry->crc,
+            .compressedSize = entry->compressedSize,
+            .uncompressedSize = entry->uncompressedSize,
+            .mode = (uint32_t)entry->mode,
+        };
+        if (isDirectory) {
+            strcat(path, "/");
+        } else if ((error = HIAHZipFindData(context, entry, &info.dataOffset))) {
+            break;
+        }
+        error = callback(userData, &info);
+    }
+
+    HIAHZipContextFree(context);
+    return error;
+}
+
+int HIAHZipCopyEntry(int archive, const HIAHZipEntryInfo *info, const char *name,
+                     const HIAHZipFilter *filter, int fd) {
+    if (!info || (info->method != HIAH_ZIP_METHOD_STORED &&
+                  info->method != HIAH_ZIP_METHOD_DEFLATE)) {
+        return ENOTSUP;
+    }
+    HIAHZipEntry entry = {
+        .method = info->method,
+        .crc = info->crc,
+        .compressedSize = info->compressedSize,
+        .uncompressedSize = info->uncompressedSize,
+    };
+
+    HIAHZipWorker worker = {0};
+    int error = HIAHZipWorkerInit(&worker, NULL)
+                    ? HIAHZipFilteredCopy(&worker, archive, &entry, info->dataOffset, name,
+                                          filter, fd)
+                    : ENOMEM;
+    HIAHZipWorkerDestroy(&worker);
+    return error;
+}
+
+int HIAHZipExtractEntry(int archive, const HIAHZipEntryInfo *entry, const char *path,
+                        const HIAHZipFilter *filter) {
+    if (!entry || !path) return EINVAL;
+
+    if (S_ISLNK(entry->mode)) {
+        char target[PATH_MAX];
+        int error = HIAHZipReadLinkTarget(archive, entry->method, entry->uncompressedSize,
+                                          entry->dataOffset, target);
+        if (error) return error;
+        unlink(path);
+        return symlink(target, path) == 0 ? 0 : errno;
+    }
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_NOFOLLOW,
+                  HIAHZipPermissions(entry->mode));
+    if (fd < 0) return errno;
+    int error = HIAHZipCopyEntry(archive, entry, path, filter, fd);
+    if (close(fd) != 0 && !error) error = errno;
+    if (error) unlink(path);
+    return error;
+}
+
+#pragma mark - App Bundles
+
+const char *HIAHZipBundleEntry(HIAHZipBundle *bundle, const char *name, size_t *length,
+                               bool *isDirectory) {
+    if (bundle->prefixLength == 0 && strncmp(name, "Payload/", 8) == 0) {
+        const char *end = strstr(name + 8, ".app/");
+        const char *slash = strchr(name + 8, '/');
+        if (end && slash == end + 4 && (size_t)(slash + 1 - name) < sizeof(bundle->prefix)) {
+            bundle->prefixLength = (size_t)(slash + 1 - name);
+            memcpy(bundle->prefix, name, bundle->prefixLength);
+            bundle->prefix[bundle->prefixLength] = '\0';
+        }
+    }
+    if (bundle->prefixLength == 0 || strncmp(name, bundle->prefix, bundle->prefixLength) != 0) {
+        return NULL;
+    }
+
+    const char *relative = name + bundle->prefixLength;
+    size_t relativeLength = strlen(relative);
+    bool directory = relativeLength > 0 && relative[relativeLength - 1] == '/';
+    if (directory) relativeLength--;
+    if (relativeLength == 0) return NULL;
+    *length = relativeLength;
+    if (isDirectory) *isDirectory = directory;
+    return relative;
+}
+
+int HIAHZipBundlePath(const HIAHZipBundle *bundle, const char *directory, char *path, size_t size) {
+    if (bundle->prefixLength == 0) return ENOENT;
+    // "Payload/<Name>.app/" -> "<directory>/<Name>.app"
+    int length = snprintf(path, size, "%s/%.*s", directory, (int)(bundle->prefixLength - 9),
+                          bundle->prefix + 8);
+    return length < 0 || (size_t)length >= size ? ENAMETOOLONG : 0;
+}
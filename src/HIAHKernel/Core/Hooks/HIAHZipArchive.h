@@ -0,0 +1,177 @@
+/**
+ * HIAHZipArchive.h
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Streaming extraction of .ipa / .zip archives.
+ *
+ * Entries are never held in memory whole: compressed data is read with
+ * pread in fixed chunks, inflated into a reused buffer and written straight
+ * to the destination file, with the CRC-32 checked as it goes. Peak memory
+ * is a couple of buffers per worker no matter how large an entry is, so
+ * multi-gigabyte game assets install without the installer being
+ * jetsammed.
+ *
+ * The central directory is parsed once into an entry table and every
+ * directory is created up front. The files are then handed out, largest
+ * first, to a pool of workers that inflate them concurrently with
+ * positional reads on one shared descriptor.
+ *
+ * ZIP64 archives (over 4 GB, or more than 65,535 entries), archive
+ * comments and entries written with data descriptors are all supported.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#ifndef HIAH_ZIP_ARCHIVE_H
+#define HIAH_ZIP_ARCHIVE_H
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Size of each of the read and inflate buffers
+#define HIAH_ZIP_BUFFER_SIZE (256 * 1024)
+
+typedef struct {
+    uint64_t files;               // Regular files and symlinks written
+    uint64_t directories;
+    uint64_t bytesRead;           // Compressed bytes read from the archive
+    uint64_t bytesWritten;        // Uncompressed bytes written
+    uint64_t wallNs;
+    unsigned threads;             // Workers that ran
+} HIAHZipStats;
+
+/**
+ * Rewrites file data on its way to disk (see HIAHMachOPrepare). Callbacks
+ * run on the extraction workers, several at a time.
+ */
+typedef struct {
+    /// Called before a regular file's data with the descriptor it goes to;
+    /// returns per-file state, or NULL to write the file unchanged
+    void *(*begin)(void *userData, const char *name, uint64_t size, int fd);
+    /// Takes the next piece of the file's uncompressed data; 0 or an errno value
+    int (*write)(void *state, const void *data, size_t length);
+    /// Ends the file (`error` is non-zero if extraction failed) and frees
+    /// `state`; returns 0 or an errno value
+    int (*finish)(void *state, int error);
+    void *userData;
+} HIAHZipFilter;
+
+/**
+ * Extracts every entry of `archivePath` under `destination`, creating it if
+ * needed. Unix permissions stored in the archive are kept (so executables
+ * stay executable). Entries with absolute paths or ".." components are
+ * rejected.
+ *
+ * `threads` is the number of workers; 0 picks one per core (at most 8).
+ * `filter` and `stats` may be NULL. Sizes and CRCs are checked against the
+ * data before it is filtered.
+ *
+ * @return 0 on success, or an errno value: EILSEQ for a malformed archive
+ *         or CRC mismatch, ENOTSUP for encrypted entries or compression
+ *         methods other than stored and deflate.
+ */
+int HIAHZipExtract(const char *archivePath, const char *destination, unsigned threads,
+                   const HIAHZipFilter *filter, HIAHZipStats *stats);
+
+typedef struct {
+    const char *name;             // Directories end in '/'; valid during the callback
+    uint16_t method;              // 0 stored, 8 deflate
+    uint32_t crc;
+    uint64_t compressedSize;
+    uint64_t uncompressedSize;
+    uint64_t dataOffset;          // Where a file's data starts in the archive
+    uint32_t mode;                // Unix type and permission bits; 0 if not recorded
+} HIAHZipEntryInfo;
+
+/// Return non-zero to stop enumerating; that value is returned
+typedef int (*HIAHZipEntryCallback)(void *userData, const HIAHZipEntryInfo *entry);
+
+/**
+ * Calls `callback` for each entry of the archive, in central directory
+ * order, after the same validation HIAHZipExtract applies.
+ *
+ * @return 0, the callback's non-zero result, or an errno value.
+ */
+int HIAHZipEnumerate(const char *archivePath, HIAHZipEntryCallback callback, void *userData);
+
+/**
+ * Streams one file entry from an open archive to `fd`, checking its size
+ * and CRC-32, using the same bounded buffers as extraction. `filter` may be
+ * NULL; `name` is what its begin callback sees.
+ *
+ * @return 0 or an errno value, as for HIAHZipExtract.
+ */
+int HIAHZipCopyEntry(int archive, const HIAHZipEntryInfo *entry, const char *name,
+                     const HIAHZipFilter *filter, int fd);
+
+/**
+ * Writes one file or symlink entry to `path`, replacing whatever is there,
+ * with the checks HIAHZipExtract applies: symlinks must be stored with a
+ * relative target that stays inside the bundle, files must match their
+ * size and CRC-32. Files get the entry's permissions (0644 if none were
+ * recorded) plus owner read and write. `filter` may be NULL.
+ *
+ * @return 0 or an errno value, as for HIAHZipExtract; on failure nothing
+ *         is left at `path`.
+ */
+int HIAHZipExtractEntry(int archive, const HIAHZipEntryInfo *entry, const char *path,
+                        const HIAHZipFilter *filter);
+
+/**
+ * The app bundle of an .ipa, found while its entries are enumerated:
+ * the first "Payload/<Name>.app/" seen decides which bundle is installed.
+ * Zero-initialize it before the first entry.
+ */
+typedef struct {
+    char prefix[PATH_MAX];        // "Payload/<Name>.app/"
+    size_t prefixLength;          // 0 until found
+} HIAHZipBundle;
+
+/**
+ * Returns the path of the enumerated entry `name` below the bundle root,
+ * without a directory's trailing slash, with its length in `length`, and
+ * whether it is a directory in `isDirectory` (may be NULL). Returns NULL
+ * for entries outside the bundle and for the root itself.
+ */
+const char *HIAHZipBundleEntry(HIAHZipBundle *bundle, const char *name, size_t *length,
+                               bool *isDirectory);
+
+/**
+ * Writes "<directory>/<Name>.app" to `path`.
+ *
+ * @return 0, ENOENT if no bundle was found, or ENAMETOOLONG.
+ */
+int HIAHZipBundlePath(const HIAHZipBundle *bundle, const char *directory, char *path, size_t size);
+
+/**
+ * mkdir -p. `path` is modified during the call and restored.
+ *
+ * @return 0 or an errno value.
+ */
+int HIAHZipMakeDirectories(char *path);
+
+/**
+ * Creates the directories above `path` (mkdir -p of its parent); `path` is
+ * modified during the call and restored.
+ *
+ * @return 0 or an errno value.
+ */
+int HIAHZipMakeParent(char *path);
+
+/**
+ * Monotonic time in nanoseconds, for the installers' wallNs statistics.
+ */
+uint64_t HIAHZipNowNs(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HIAH_ZIP_ARCHIVE_H */
@@ -3,14 +3,26 @@
  * HIAHKernel – House in a House Virtual Kernel (for iOS)
  *
  * Centralized logging implementation.
- * All logs output to stdout.
+ *
+ * Each logging thread owns a single-producer ring. A record holds the
+ * format pointer, a timestamp and the raw arguments (strings copied), so the
+ * calling thread never runs printf. The logger thread drains every ring at
+ * a fixed interval, orders records by timestamp, formats them and passes
+ * them to the sink. Errors and faults drain on the calling thread instead.
  *
  * Copyright (c) 2025 Alex Spaulding
  * Licensed under MIT License
  */
 
 #import "HIAHLogging.h"
+#import <dispatch/dispatch.h>
+#import <mach/mach_time.h>
+#import <pthread.h>
 #import <stdarg.h>
+#import <stdatomic.h>
+#import <stdbool.h>
+#import <stdlib.h>
+#import <string.h>
 
 HIAHLogSubsystem HIAHLogKernel(void) {
     return "HIAHKernel";
@@ -32,3 +44,636 @@ HIAHLogSubsystem HIAHLogProcessManager(void) {
     return "HIAHProcessManager";
 }
 
+#pragma mark - Records
+
+#define HIAH_LOG_RING_SIZE (64 * 1024)      // Per thread; power of two
+#define HIAH_LOG_MAX_RECORD 2048
+#define HIAH_LOG_MAX_ARGS 16
+#define HIAH_LOG_DRAIN_INTERVAL_MS 50
+#define HIAH_LOG_PADDING 0xFF               // Record level marking wrap padding
+
+typedef enum {
+    HIAHArgSigned,
+    HIAHArgUnsigned,
+    HIAHArgDouble,
+    HIAHArgString,                          // uint16 length (with NUL) + bytes
+    HIAHArgPointer,
+} HIAHArgType;
+
+typedef struct {
+    uint32_t size;                          // Whole record, 8-byte aligned
+    uint8_t level;
+    uint8_t argCount;
+    uint16_t reserved;
+    uint64_t timestamp;
+    const char *format;
+    char subsystem[32];
+    // Arguments follow: type byte + payload each
+} HIAHLogRecordHeader;
+
+typedef enum {
+    HIAHLengthNone,
+    HIAHLengthChar,                         // hh
+    HIAHLengthShort,                        // h
+    HIAHLengthLong,                         // l
+    HIAHLengthLongLong,                     // ll, q
+    HIAHLengthIntMax,                       // j
+    HIAHLengthSize,                         // z
+    HIAHLengthPtrDiff,                      // t
+    HIAHLengthLongDouble,                   // L
+} HIAHLength;
+
+typedef struct {
+    char flags[8];
+    int width;                              // -1: none, -2: '*'
+    int precision;                          // -1: none, -2: '*'
+    HIAHLength length;
+    char conversion;
+} HIAHSpec;
+
+// Parses the conversion after '%'. Returns the character after it.
+static const char *HIAHParseSpec(const char *p, HIAHSpec *spec) {
+    memset(spec, 0, sizeof(*spec));
+    spec->width = -1;
+    spec->precision = -1;
+
+    // os_log privacy annotations ("%{public}s") carry no formatting
+    if (*p == '{') {
+        const char *close = strchr(p, '}');
+        if (close) p = close + 1;
+    }
+
+    size_t nflags = 0;
+    while (*p && strchr("-+ #0'", *p)) {
+        if (nflags < sizeof(spec->flags) - 1) spec->flags[nflags++] = *p;
+        p++;
+    }
+    if (*p == '*') {
+        spec->width = -2;
+        p++;
+    } else if (*p >= '0' && *p <= '9') {
+        spec->width = 0;
+        while (*p >= '0' && *p <= '9') spec->width = spec->width * 10 + (*p++ - '0');
+    }
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            spec->precision = -2;
+            p++;
+        } else {
+            spec->precision = 0;
+            while (*p >= '0' && *p <= '9') spec->precision = spec->precision * 10 + (*p++ - '0');
+        }
+    }
+    switch (*p) {
+        case 'h': p++; spec->length = HIAHLengthShort;
+            if (*p == 'h') { p++; spec->length = HIAHLengthChar; }
+            break;
+        case 'l': p++; spec->length = HIAHLengthLong;
+            if (*p == 'l') { p++; spec->length = HIAHLengthLongLong; }
+            break;
+        case 'q': p++; spec->length = HIAHLengthLongLong; break;
+        case 'j': p++; spec->length = HIAHLengthIntMax; break;
+        case 'z': p++; spec->length = HIAHLengthSize; break;
+        case 't': p++; spec->length = HIAHLengthPtrDiff; break;
+        case 'L': p++; spec->length = HIAHLengthLongDouble; break;
+        default: break;
+    }
+    spec->conversion = *p;
+    return *p ? p + 1 : p;
+}
+
+typedef struct {
+    char *cursor;
+    char *end;
+    uint8_t count;
+    BOOL overflow;
+} HIAHArgWriter;
+
+static void HIAHPutNumber(HIAHArgWriter *w, HIAHArgType type, const void *value) {
+    if (w->count >= HIAH_LOG_MAX_ARGS || w->end - w->cursor < 9) {
+        w->overflow = YES;
+        return;
+    }
+    *w->cursor++ = (char)type;
+    memcpy(w->cursor, value, 8);
+    w->cursor += 8;
+    w->count++;
+}
+
+static void HIAHPutString(HIAHArgWriter *w, const char *string) {
+    if (!string) string = "(null)";
+    if (w->count >= HIAH_LOG_MAX_ARGS || w->end - w->cursor < 4) {
+        w->overflow = YES;
+        return;
+    }
+    // Truncate rather than drop when the record is nearly full
+    size_t room = (size_t)(w->end - w->cursor) - 3;
+    size_t length = strnlen(string, room - 1);
+    uint16_t stored = (uint16_t)(length + 1);
+
+    *w->cursor++ = HIAHArgString;
+    memcpy(w->cursor, &stored, 2);
+    w->cursor += 2;
+    memcpy(w->cursor, string, length);
+    w->cursor[length] = '\0';
+    w->cursor += stored;
+    w->count++;
+}
+
+static void HIAHPutSigned(HIAHArgWriter *w, int64_t value) {
+    HIAHPutNumber(w, HIAHArgSigned, &value);
+}
+
+static void HIAHPutUnsigned(HIAHArgWriter *w, uint64_t value) {
+    HIAHPutNumber(w, HIAHArgUnsigned, &value);
+}
+
+// Captures the arguments `fmt` consumes. Returns NO for conversions that
+// cannot be deferred (%n, wide strings), in which case the caller formats
+// eagerly.
+static BOOL HIAHCaptureArgs(HIAHArgWriter *w, const char *fmt, va_list args) {
+    const char *p = fmt;
+    while ((p = strchr(p, '%'))) {
+        p++;
+        if (*p == '%') {
+            p++;
+            continue;
+        }
+        HIAHSpec spec;
+        p = HIAHParseSpec(p, &spec);
+        if (spec.width == -2) HIAHPutSigned(w, va_arg(args, int));
+        if (spec.precision == -2) HIAHPutSigned(w, va_arg(args, int));
+
+        switch (spec.conversion) {
+            case 'd':
+            case 'i':
+                switch (spec.length) {
+                    case HIAHLengthLong: HIAHPutSigned(w, va_arg(args, long)); break;
+                    case HIAHLengthLongLong: HIAHPutSigned(w, va_arg(args, long long)); break;
+                    case HIAHLengthIntMax: HIAHPutSigned(w, va_arg(args, intmax_t)); break;
+                    case HIAHLengthSize: HIAHPutSigned(w, va_arg(args, ssize_t)); break;
+                    case HIAHLengthPtrDiff: HIAHPutSigned(w, va_arg(args, ptrdiff_t)); break;
+                    case HIAHLengthChar: HIAHPutSigned(w, (signed char)va_arg(args, int)); break;
+                    case HIAHLengthShort: HIAHPutSigned(w, (short)va_arg(args, int)); break;
+                    default: HIAHPutSigned(w, va_arg(args, int)); break;
+                }
+                break;
+            case 'o':
+            case 'u':
+            case 'x':
+            case 'X':
+                switch (spec.length) {
+                    case HIAHLengthLong: HIAHPutUnsigned(w, va_arg(args, unsigned long)); break;
+                    case HIAHLengthLongLong: HIAHPutUnsigned(w, va_arg(args, unsigned long long)); break;
+                    case HIAHLengthIntMax: HIAHPutUnsigned(w, va_arg(args, uintmax_t)); break;
+                    case HIAHLengthSize: HIAHPutUnsigned(w, va_arg(args, size_t)); break;
+                    case HIAHLengthPtrDiff: HIAHPutUnsigned(w, (uint64_t)va_arg(args, ptrdiff_t)); break;
+                    case HIAHLengthChar: HIAHPutUnsigned(w, (unsigned char)va_arg(args, unsigned int)); break;
+                    case HIAHLengthShort: HIAHPutUnsigned(w, (unsigned short)va_arg(args, unsigned int)); break;
+                    default: HIAHPutUnsigned(w, va_arg(args, unsigned int)); break;
+                }
+                break;
+            case 'c':
+                if (spec.length == HIAHLengthLong) return NO;
+                HIAHPutSigned(w, va_arg(args, int));
+                break;
+            case 'e': case 'E': case 'f': case 'F':
+            case 'g': case 'G': case 'a': case 'A': {
+                double value = spec.length == HIAHLengthLongDouble
+                                   ? (double)va_arg(args, long double)
+                                   : va_arg(args, double);
+                HIAHPutNumber(w, HIAHArgDouble, &value);
+                break;
+            }
+            case 's':
+                if (spec.length == HIAHLengthLong) return NO;
+                HIAHPutString(w, va_arg(args, const char *));
+                break;
+#ifdef __OBJC__
+            case '@': {
+                id object = va_arg(args, id);
+                HIAHPutString(w, object ? [[object description] UTF8String] : "(null)");
+                break;
+            }
+#endif
+            case 'p': {
+                uint64_t value = (uintptr_t)va_arg(args, void *);
+                HIAHPutNumber(w, HIAHArgPointer, &value);
+                break;
+            }
+            default:
+                return NO;
+        }
+    }
+    return !w->overflow;
+}
+
+#pragma mark - Per-Thread Rings
+
+typedef struct HIAHLogRing {
+    _Atomic(uint64_t) head;                 // Consumer position
+    _Atomic(uint64_t) tail;                 // Producer position
+    _Atomic(bool) retired;                  // Owning thread exited
+    struct HIAHLogRing *next;
+    char data[HIAH_LOG_RING_SIZE];
+} HIAHLogRing;
+
+HIAHLogLevel _HIAHLogMinimumLevel = HIAH_LOG_MIN_LEVEL;
+
+static pthread_mutex_t g_ringsLock = PTHREAD_MUTEX_INITIALIZER;
+static HIAHLogRing *g_rings = NULL;
+static pthread_key_t g_ringKey;
+static __thread HIAHLogRing *t_ring = NULL;
+static __thread bool t_draining = false;    // Sink running on this thread
+static _Atomic(uint64_t) g_dropped = 0;
+
+static pthread_mutex_t g_drainLock = PTHREAD_MUTEX_INITIALIZER;
+static HIAHLogSink g_sink = HIAHLogStdoutSink;
+static void *g_sinkContext = NULL;
+static dispatch_semaphore_t g_wake = NULL;
+static pthread_once_t g_once = PTHREAD_ONCE_INIT;
+static mach_timebase_info_data_t g_timebase;
+
+static void HIAHRetireRing(void *data) {
+    HIAHLogRing *ring = data;
+    atomic_store_explicit(&ring->retired, true, memory_order_release);
+    // Logging from later TLS destructors gets a fresh ring
+    t_ring = NULL;
+}
+
+static void HIAHLogStart(void);
+
+static HIAHLogRing *HIAHThreadRing(void) {
+    if (t_ring) return t_ring;
+
+    pthread_once(&g_once, HIAHLogStart);
+    HIAHLogRing *ring = calloc(1, sizeof(HIAHLogRing));
+    if (!ring) return NULL;
+
+    pthread_mutex_lock(&g_ringsLock);
+    ring->next = g_rings;
+    g_rings = ring;
+    pthread_mutex_unlock(&g_ringsLock);
+
+    pthread_setspecific(g_ringKey, ring);
+    t_ring = ring;
+    return ring;
+}
+
+static BOOL HIAHRingWrite(HIAHLogRing *ring, const void *record, uint32_t size) {
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    size_t offset = (size_t)(tail & (HIAH_LOG_RING_SIZE - 1));
+    size_t toEnd = HIAH_LOG_RING_SIZE - offset;
+    size_t needed = size + (toEnd < size ? toEnd : 0);
+
+    if (HIAH_LOG_RING_SIZE - (tail - head) < needed) {
+        return NO;
+    }
+    if (toEnd < size) {
+        HIAHLogRecordHeader *padding = (HIAHLogRecordHeader *)(ring->data + offset);
+        padding->size = (uint32_t)toEnd;
+        padding->level = HIAH_LOG_PADDING;
+        tail += toEnd;
+        offset = 0;
+    }
+    memcpy(ring->data + offset, record, size);
+    atomic_store_explicit(&ring->tail, tail + size, memory_order_release);
+
+    if (tail + size - head > HIAH_LOG_RING_SIZE / 2) {
+        dispatch_semaphore_signal(g_wake);
+    }
+    return YES;
+}
+
+static void HIAHDrainAll(void);
+
+void _HIAHLogRecord(HIAHLogSubsystem subsystem, HIAHLogLevel level, const char *fmt, ...) {
+    HIAHLogRing *ring = HIAHThreadRing();
+    if (!ring || !fmt) return;
+
+    _Alignas(8) char record[HIAH_LOG_MAX_RECORD];
+    HIAHLogRecordHeader *header = (HIAHLogRecordHeader *)record;
+    header->level = (uint8_t)level;
+    header->reserved = 0;
+    header->timestamp = mach_absolute_time();
+    header->format = fmt;
+    strlcpy(header->subsystem, subsystem ? subsystem : "?", sizeof(header->subsystem));
+
+    HIAHArgWriter writer = {record + sizeof(*header), record + sizeof(record), 0, NO};
+    va_list args;
+    va_start(args, fmt);
+    va_list copy;
+    va_copy(copy, args);
+    if (!HIAHCaptureArgs(&writer, fmt, copy)) {
+        // Not deferrable: format now and log the result as "%s"
+        char message[HIAH_LOG_MAX_RECORD - sizeof(HIAHLogRecordHeader) - 4];
+        vsnprintf(message, sizeof(message), fmt, args);
+        header->format = "%s";
+        writer = (HIAHArgWriter){record + sizeof(*header), record + sizeof(record), 0, NO};
+        HIAHPutString(&writer, message);
+    }
+    va_end(copy);
+    va_end(args);
+
+    header->argCount = writer.count;
+    header->size = (uint32_t)((writer.cursor - record + 7) & ~7);
+
+    // Errors usually precede a crash or abort that would lose the ring, so
+    // they are delivered now (not from inside a sink, which holds the drain)
+    BOOL urgent = level >= HIAHLogLevelError && !t_draining;
+    BOOL written = HIAHRingWrite(ring, record, header->size);
+    if (!written && urgent) {
+        HIAHDrainAll();
+        written = HIAHRingWrite(ring, record, header->size);
+    }
+    if (!written) {
+        atomic_fetch_add_explicit(&g_dropped, 1, memory_order_relaxed);
+    }
+    if (urgent) {
+        HIAHDrainAll();
+    }
+}
+
+#pragma mark - Formatting
+
+typedef struct {
+    const char *cursor;
+    uint8_t remaining;
+} HIAHArgReader;
+
+static BOOL HIAHNextArg(HIAHArgReader *r, HIAHArgType *type, uint64_t *number, const char **string) {
+    if (r->remaining == 0) return NO;
+    r->remaining--;
+    *type = (HIAHArgType)*r->cursor++;
+    if (*type == HIAHArgString) {
+        uint16_t length;
+        memcpy(&length, r->cursor, 2);
+        *string = r->cursor + 2;
+        r->cursor += 2 + length;
+    } else {
+        memcpy(number, r->cursor, 8);
+        r->cursor += 8;
+    }
+    return YES;
+}
+
+// Rebuilds a conversion with resolved '*' values and a normalized length
+static void HIAHBuildSpec(char out[48], const HIAHSpec *spec, int width, int precision,
+                          const char *length, char conversion) {
+    int n = snprintf(out, 48, "%%%s", spec->flags);
+    if (spec->width != -1) n += snprintf(out + n, 48 - n, "%d", width);
+    if (spec->precision != -1) n += snprintf(out + n, 48 - n, ".%d", precision);
+    snprintf(out + n, 48 - n, "%s%c", length, conversion);
+}
+
+// Renders a record into `out`; returns the message length.
+static size_t HIAHRender(const HIAHLogRecordHeader *header, char *out, size_t capacity) {
+    HIAHArgReader reader = {(const char *)(header + 1), header->argCount};
+    const char *p = header->format;
+    size_t used = 0;
+
+#define HIAH_EMIT(...)                                                          \
+    do {                                                                        \
+        int _n = snprintf(out + used, capacity - used, __VA_ARGS__);            \
+        if (_n > 0) used += (size_t)_n < capacity - used ? (size_t)_n : capacity - used - 1; \
+    } while (0)
+
+    while (*p && used + 1 < capacity) {
+        if (*p != '%') {
+            out[used++] = *p++;
+            continue;
+        }
+        p++;
+        if (*p == '%') {
+            out[used++] = '%';
+            p++;
+            continue;
+        }
+
+        HIAHSpec spec;
+        p = HIAHParseSpec(p, &spec);
+        HIAHArgType type;
+        uint64_t number = 0;
+        const char *string = NULL;
+        int width = spec.width, precision = spec.precision;
+        if (spec.width == -2) {
+            if (!HIAHNextArg(&reader, &type, &number, &string)) break;
+            width = (int)(int64_t)number;
+        }
+        if (spec.precision == -2) {
+            if (!HIAHNextArg(&reader, &type, &number, &string)) break;
+            precision = (int)(int64_t)number;
+        }
+        if (!HIAHNextArg(&reader, &type, &number, &string)) break;
+
+        char format[48];
+        switch (type) {
+            case HIAHArgSigned:
+                if (spec.conversion == 'c') {
+                    HIAHBuildSpec(format, &spec, width, precision, "", 'c');
+                    HIAH_EMIT(format, (int)(int64_t)number);
+                } else {
+                    HIAHBuildSpec(format, &spec, width, precision, "ll", spec.conversion);
+                    HIAH_EMIT(format, (long long)number);
+                }
+                break;
+            case HIAHArgUnsigned:
+                HIAHBuildSpec(format, &spec, width, precision, "ll", spec.conversion);
+                HIAH_EMIT(format, (unsigned long long)number);
+                break;
+            case HIAHArgDouble: {
+                double value;
+                memcpy(&value, &number, sizeof(value));
+                HIAHBuildSpec(format, &spec, width, precision, "", spec.conversion);
+                HIAH_EMIT(format, value);
+                break;
+            }
+            case HIAHArgString:
+                HIAHBuildSpec(format, &spec, width, precision, "", 's');
+                HIAH_EMIT(format, string);
+                break;
+            case HIAHArgPointer:
+                HIAHBuildSpec(format, &spec, width, precision, "", 'p');
+                HIAH_EMIT(format, (void *)(uintptr_t)number);
+                break;
+        }
+    }
+#undef HIAH_EMIT
+
+    out[used] = '\0';
+    return used;
+}
+
+#pragma mark - Logger Thread
+
+static int HIAHCompareRecords(const void *a, const void *b) {
+    uint64_t ta = (*(HIAHLogRecordHeader *const *)a)->timestamp;
+    uint64_t tb = (*(HIAHLogRecordHeader *const *)b)->timestamp;
+    return ta < tb ? -1 : ta > tb;
+}
+
+static void HIAHDrainAll(void) {
+    static char *batch = NULL;
+    static size_t batchCapacity = 0;
+    static HIAHLogRecordHeader **records = NULL;
+    static size_t recordCapacity = 0;
+    static uint64_t reportedDrops = 0;
+
+    pthread_mutex_lock(&g_drainLock);
+    t_draining = true;
+
+    size_t batchUsed = 0;
+    size_t recordCount = 0;
+
+    pthread_mutex_lock(&g_ringsLock);
+    for (HIAHLogRing **it = &g_rings; *it;) {
+        HIAHLogRing *ring = *it;
+        BOOL retired = atomic_load_explicit(&ring->retired, memory_order_acquire);
+        uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+        uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+        // Copy the pending span out so the producer can reuse it right away
+        size_t pending = (size_t)(tail - head);
+        if (batchUsed + pending > batchCapacity) {
+            size_t capacity = (batchUsed + pending) * 2;
+            char *grown = realloc(batch, capacity);
+            if (!grown) break;
+            batch = grown;
+            batchCapacity = capacity;
+        }
+        while (head < tail) {
+            const HIAHLogRecordHeader *header =
+                (const HIAHLogRecordHeader *)(ring->data + (head & (HIAH_LOG_RING_SIZE - 1)));
+            if (header->level != HIAH_LOG_PADDING) {
+                memcpy(batch + batchUsed, header, header->size);
+                batchUsed += header->size;
+            }
+            head += header->size;
+        }
+        atomic_store_explicit(&ring->head, head, memory_order_release);
+
+        if (retired) {
+            *it = ring->next;
+            free(ring);
+        } else {
+            it = &ring->next;
+        }
+    }
+    pthread_mutex_unlock(&g_ringsLock);
+
+    // Index and order by time across threads
+    for (size_t offset = 0; offset < batchUsed;) {
+        if (recordCount == recordCapacity) {
+            size_t capacity = recordCapacity ? recordCapacity * 2 : 256;
+            HIAHLogRecordHeader **grown = realloc(records, capacity * sizeof(*records));
+            if (!grown) break;
+            records = grown;
+            recordCapacity = capacity;
+        }
+        HIAHLogRecordHeader *header = (HIAHLogRecordHeader *)(batch + offset);
+        records[recordCount++] = header;
+        offset += header->size;
+    }
+    qsort(records, recordCount, sizeof(*records), HIAHCompareRecords);
+
+    char message[4096];
+    for (size_t i = 0; i < recordCount; i++) {
+        HIAHLogRecordHeader *header = records[i];
+        HIAHLogEntry entry = {
+            .level = header->level,
+            .subsystem = header->subsystem,
+            .message = message,
+            .length = HIAHRender(header, message, sizeof(message)),
+            .timestampNs = header->timestamp * g_timebase.numer / g_timebase.denom,
+        };
+        g_sink(g_sinkContext, &entry);
+    }
+
+    BOOL delivered = recordCount > 0;
+    uint64_t dropped = atomic_load_explicit(&g_dropped, memory_order_relaxed);
+    if (dropped != reportedDrops) {
+        int length = snprintf(message, sizeof(message),
+                              "%llu messages dropped (thread buffers full)",
+                              (unsigned long long)(dropped - reportedDrops));
+        HIAHLogEntry entry = {HIAHLogLevelWarning, "HIAHLogging", message, (size_t)length, 0};
+        g_sink(g_sinkContext, &entry);
+        reportedDrops = dropped;
+        delivered = YES;
+    }
+    if (delivered) {
+        g_sink(g_sinkContext, NULL);
+    }
+
+    t_draining = false;
+    pthread_mutex_unlock(&g_drainLock);
+}
+
+static void *HIAHLoggerMain(void *unused) {
+    (void)unused;
+    pthread_setname_np("hiah.logger");
+    for (;;) {
+        dispatch_semaphore_wait(g_wake, dispatch_time(DISPATCH_TIME_NOW,
+                                                      HIAH_LOG_DRAIN_INTERVAL_MS * NSEC_PER_MSEC));
+        HIAHDrainAll();
+    }
+    return NULL;
+}
+
+static void HIAHLogStart(void) {
+    mach_timebase_info(&g_timebase);
+    pthread_key_create(&g_ringKey, HIAHRetireRing);
+    g_wake = dispatch_semaphore_create(0);
+    atexit(HIAHLogFlush);
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_attr_set_qos_class_np(&attr, QOS_CLASS_UTILITY, 0);
+    pthread_t thread;
+    pthread_create(&thread, &attr, HIAHLoggerMain, NULL);
+    pthread_attr_destroy(&attr);
+}
+
+void HIAHLogFlush(void) {
+    pthread_once(&g_once, HIAHLogStart);
+    HIAHDrainAll();
+}
+
+void HIAHLogSetMinimumLevel(HIAHLogLevel level) {
+    _HIAHLogMinimumLevel = level < HIAH_LOG_MIN_LEVEL ? HIAH_LOG_MIN_LEVEL : level;
+}
+
+uint64_t HIAHLogDroppedCount(void) {
+    return atomic_load_explicit(&g_dropped, memory_order_relaxed);
+}
+
+#pragma mark - Sinks
+
+static const char *HIAHLevelName(HIAHLogLevel level) {
+    switch (level) {
+        case HIAHLogLevelInfo: return "INFO";
+        case HIAHLogLevelWarning: return "WARNING";
+        case HIAHLogLevelError: return "ERROR";
+        case HIAHLogLevelFault: return "FAULT";
+        default: return "DEBUG";
+    }
+}
+
+void HIAHLogSetSink(HIAHLogSink sink, void *context) {
+    pthread_mutex_lock(&g_drainLock);
+    g_sink = sink ? sink : HIAHLogStdoutSink;
+    g_sinkContext = context;
+    pthread_mutex_unlock(&g_drainLock);
+}
+
+void HIAHLogStdoutSink(void *context, const HIAHLogEntry *entry) {
+    (void)context;
+    if (!entry) {
+        fflush(stdout);
+        return;
+    }
+    fprintf(stdout, "[%s][%s] %.*s\n", entry->subsystem, HIAHLevelName(entry->level),
+            (int)entry->length, entry->message);
+}
@@ -120,10 +120,11 @@ typedef NS_ENUM(NSInteger, HIAHKernelError) {
 /**
  * Enables JIT for an extension process with retry logic.
  * 
- * This method attempts to enable JIT for the specified extension process PID,
- * retrying up to 4 times with increasing delays if the initial attempt fails.
- * This is necessary because JIT enablement via minimuxer can be flaky and
- * may require multiple attempts.
+ * Hands the PID to the host app's HIAHJITManager work queue, which merges
+ * repeated requests for the same PID into one job, limits concurrent
+ * debugger attaches, retries failed attempts with jittered exponential
+ * backoff (JIT enablement via minimuxer can be flaky) and drops the job if
+ * the process exits.
  *
  * @param pid The physical PID of the extension process
  */
@@ -150,6 +151,12 @@ typedef NS_ENUM(NSInteger, HIAHKernelError) {
                         environment:(nullable NSDictionary<NSString *, NSString *> *)environment
                          completion:(void (^)(pid_t pid, NSError * _Nullable error))completion;
 
+/// Called with the executable path before each spawn; the spawn goes ahead
+/// once `proceed` is called (on any queue). Lets the host hold spawns until
+/// the files they need are in place, e.g. bundled tools still being
+/// installed. Spawns go ahead at once when nil.
+@property (nonatomic, copy, nullable) void (^spawnReadinessHandler)(NSString *path, dispatch_block_t proceed);
+
 #pragma mark - Output Observation
 
 /// Callback invoked when a guest process produces output.
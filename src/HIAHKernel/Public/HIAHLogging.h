@@ -3,13 +3,16 @@
  * HIAHKernel – House in a House Virtual Kernel (for iOS)
  *
  * Centralized logging system for HIAH components.
- * All logs go to stdout for visibility.
+ * Messages are captured unformatted into per-thread buffers and written by
+ * a background logger thread to a pluggable sink (stdout by default).
+ * Errors and faults are delivered before the logging call returns.
  *
  * Copyright (c) 2025 Alex Spaulding
  * Licensed under MIT License
  */
 
 #import <Foundation/Foundation.h>
+#import <stdint.h>
 #import <stdio.h>
 
 NS_ASSUME_NONNULL_BEGIN
@@ -36,66 +39,116 @@ typedef NS_ENUM(NSInteger, HIAHLogLevel) {
   HIAHLogLevelFault
 };
 
+#ifdef __OBJC__
 /**
  * Helper to convert NSString to C string for logging
  */
 static inline const char *_HIAHLogString(NSString *str) {
   return str ? [str UTF8String] : "(null)";
 }
+#endif
 
 /**
- * Internal logging function
- */
-static inline void _HIAHLogPrint(HIAHLogSubsystem subsystem, HIAHLogLevel level,
-                                 const char *fmt, ...) {
-  const char *levelStr = "DEBUG";
-  switch (level) {
-  case HIAHLogLevelInfo:
-    levelStr = "INFO";
-    break;
-  case HIAHLogLevelWarning:
-    levelStr = "WARNING";
-    break;
-  case HIAHLogLevelError:
-    levelStr = "ERROR";
-    break;
-  case HIAHLogLevelFault:
-    levelStr = "FAULT";
-    break;
-  default:
-    break;
-  }
-
-  fprintf(stdout, "[%s][%s] ", subsystem, levelStr);
-
-  va_list args;
-  va_start(args, fmt);
-  vfprintf(stdout, fmt, args);
-  va_end(args);
-
-  fprintf(stdout, "\n");
-  fflush(stdout);
-}
+ * Compile-time minimum level. Calls below it compile to nothing (their
+ * arguments are not evaluated). Defaults to Debug in DEBUG builds and Info
+ * otherwise; override with -DHIAH_LOG_MIN_LEVEL=<0-4>.
+ */
+#ifndef HIAH_LOG_MIN_LEVEL
+#if DEBUG
+#define HIAH_LOG_MIN_LEVEL 0
+#else
+#define HIAH_LOG_MIN_LEVEL 1
+#endif
+#endif
+
+/**
+ * Runtime minimum level (never below HIAH_LOG_MIN_LEVEL).
+ */
+extern HIAHLogLevel _HIAHLogMinimumLevel;
+extern void HIAHLogSetMinimumLevel(HIAHLogLevel level);
+
+/**
+ * Records a message without formatting it.
+ *
+ * Arguments are captured raw into a per-thread buffer (strings are
+ * copied) and formatted later on the logger thread, which hands complete
+ * lines to the active sink. `fmt` must be a string literal: only the
+ * pointer is kept.
+ *
+ * Error and Fault records are not deferred: the calling thread drains
+ * every buffer to the sink before returning, so they survive a crash or
+ * abort that follows them.
+ */
+extern void _HIAHLogRecord(HIAHLogSubsystem subsystem, HIAHLogLevel level,
+                           const char *fmt, ...)
+    __attribute__((__format__(__printf__, 3, 4)));
+
+#define _HIAHLogIf(level, subsystem, fmt, ...)                                 \
+  do {                                                                         \
+    if ((level) >= HIAH_LOG_MIN_LEVEL && (level) >= _HIAHLogMinimumLevel) {    \
+      _HIAHLogRecord((subsystem), (level), fmt, ##__VA_ARGS__);                \
+    }                                                                          \
+  } while (0)
 
 /**
- * Structured logging macros (all output to stdout)
+ * Structured logging macros (delivered to the active sink)
  * Note: For NSString objects, use %s and pass [string UTF8String] or use
  * HIAHLogString() helper
  */
 #define HIAHLogDebug(subsystem, fmt, ...)                                      \
-  _HIAHLogPrint(subsystem(), HIAHLogLevelDebug, fmt, ##__VA_ARGS__)
+  _HIAHLogIf(HIAHLogLevelDebug, subsystem(), fmt, ##__VA_ARGS__)
 
 #define HIAHLogInfo(subsystem, fmt, ...)                                       \
-  _HIAHLogPrint(subsystem(), HIAHLogLevelInfo, fmt, ##__VA_ARGS__)
+  _HIAHLogIf(HIAHLogLevelInfo, subsystem(), fmt, ##__VA_ARGS__)
 
 #define HIAHLogWarning(subsystem, fmt, ...)                                    \
-  _HIAHLogPrint(subsystem(), HIAHLogLevelWarning, fmt, ##__VA_ARGS__)
+  _HIAHLogIf(HIAHLogLevelWarning, subsystem(), fmt, ##__VA_ARGS__)
 
 #define HIAHLogError(subsystem, fmt, ...)                                      \
-  _HIAHLogPrint(subsystem(), HIAHLogLevelError, fmt, ##__VA_ARGS__)
+  _HIAHLogIf(HIAHLogLevelError, subsystem(), fmt, ##__VA_ARGS__)
 
 #define HIAHLogFault(subsystem, fmt, ...)                                      \
-  _HIAHLogPrint(subsystem(), HIAHLogLevelFault, fmt, ##__VA_ARGS__)
+  _HIAHLogIf(HIAHLogLevelFault, subsystem(), fmt, ##__VA_ARGS__)
+
+/**
+ * A formatted message as delivered to a sink
+ */
+typedef struct {
+  HIAHLogLevel level;
+  const char *subsystem;
+  const char *message;    // Not newline-terminated
+  size_t length;
+  uint64_t timestampNs;   // mach_absolute_time, in nanoseconds
+} HIAHLogEntry;
+
+/**
+ * Sink callback. Runs on whichever thread drains (the logger thread, a
+ * flushing caller or a thread logging an error), one drain at a time;
+ * `entry` is NULL at the end of each batch so buffered sinks can flush.
+ */
+typedef void (*HIAHLogSink)(void *_Nullable context,
+                            const HIAHLogEntry *_Nullable entry);
+
+/**
+ * Replaces the active sink (stdout by default).
+ */
+extern void HIAHLogSetSink(HIAHLogSink sink, void *_Nullable context);
+
+/**
+ * The default sink: "[subsystem][LEVEL] message" lines on stdout.
+ */
+extern void HIAHLogStdoutSink(void *_Nullable context,
+                              const HIAHLogEntry *_Nullable entry);
+
+/**
+ * Formats and delivers everything recorded so far before returning.
+ */
+extern void HIAHLogFlush(void);
+
+/**
+ * Messages dropped because a thread's buffer was full.
+ */
+extern uint64_t HIAHLogDroppedCount(void);
 
 /**
  * Convenience macro for logging NSString objects
@@ -111,14 +164,14 @@ static inline void _HIAHLogPrint(HIAHLogSubsystem subsystem, HIAHLogLevel level,
 
 /**
  * Extended logging macro supporting NSString format and dynamic subsystem
- * strings.
+ * strings. The NSString is only built when the level is enabled.
  */
 #define HIAHLogEx(level, subsystem, fmt, ...)                                  \
   do {                                                                         \
-    if ((level) >= HIAHLogLevelDebug) {                                        \
+    if ((level) >= HIAH_LOG_MIN_LEVEL && (level) >= _HIAHLogMinimumLevel) {    \
       NSString *_msg = [NSString stringWithFormat:(fmt), ##__VA_ARGS__];       \
       const char *_sub = [(subsystem) UTF8String];                             \
-      _HIAHLogPrint(_sub, (level), "%s", [_msg UTF8String]);                   \
+      _HIAHLogRecord(_sub, (level), "%s", [_msg UTF8String]);                  \
     }                                                                          \
   } while (0)
 
@@ -8,6 +8,7 @@
  */
 
 #import <Foundation/Foundation.h>
+#import "HIAHJITQueue.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -15,9 +16,19 @@ NS_ASSUME_NONNULL_BEGIN
 
 + (instancetype)sharedManager;
 
+/// Queues JIT enablement for `pid`. Requests for a PID that is already
+/// pending share one attach job; failed attempts are retried with backoff.
+/// The completion runs on a background thread.
 - (void)enableJITForPID:(pid_t)pid
              completion:(void (^)(BOOL success, NSError * _Nullable error))completion;
 
+/// Drops pending JIT work for `pid`. Done automatically when the process
+/// posts that it declined JIT (see HIAHJITPostDeclined).
+- (void)cancelJITForPID:(pid_t)pid;
+
+/// Queue depth, attempt counts and attach latency histograms
+- (HIAHJITQueueMetrics)queueMetrics;
+
 - (void)mountDeveloperDiskImageWithCompletion:
     (void (^)(BOOL success, NSError * _Nullable error))completion;
 
@@ -9,11 +9,31 @@
 
 #import "HIAHJITManager.h"
 #import "HIAHJITEnablerHelper.h"
+#import "HIAHJITQueue.h"
+#import "../../HIAHKernel/Core/Hooks/HIAHJITReadiness.h"
 #import "../../HIAHDesktop/HIAHLogging.h"
 #import "../VPN/HIAHVPNManager.h"
 #import "../VPN/MinimuxerBridge.h"
 #import <Foundation/Foundation.h>
 
+// Completions and minimuxer calls can take this long before an attempt
+// is counted as failed
+static const int64_t kJITAttemptTimeout = 10 * NSEC_PER_SEC;
+
+// How long an attach minimuxer accepted may take to show up as CS_DEBUGGED
+static const int64_t kJITAttachSettleTimeout = 2 * NSEC_PER_SEC;
+
+static bool HIAHJITManagerAttach(pid_t pid, void *context);
+static void HIAHJITManagerComplete(pid_t pid, HIAHJITResult result, void *context);
+
+@interface HIAHJITManager ()
+@property (nonatomic, assign) HIAHJITQueue *queue;
+// PID -> token of the handler that cancels its job when it declines JIT
+@property (nonatomic, strong) NSMutableDictionary<NSNumber *, NSNumber *> *declinedTokens;
+- (BOOL)attemptJITForPID:(pid_t)pid;
+- (void)stopWatchingDeclinesForPID:(pid_t)pid;
+@end
+
 @implementation HIAHJITManager
 
 + (instancetype)sharedManager {
@@ -25,25 +45,183 @@
   return shared;
 }
 
+- (instancetype)init {
+  self = [super init];
+  if (self) {
+    // The manager is a process-lifetime singleton, so the unretained
+    // context stays valid for the queue's lifetime
+    HIAHJITQueueConfig config = {
+      .maxConcurrent = 2,
+      .attach = HIAHJITManagerAttach,
+      .context = (__bridge void *)self,
+    };
+    _queue = HIAHJITQueueCreate(&config);
+    _declinedTokens = [NSMutableDictionary dictionary];
+  }
+  return self;
+}
+
 - (void)enableJITForPID:(pid_t)pid
              completion:(void (^)(BOOL success, NSError * _Nullable error))completion {
   HIAHLogEx(HIAH_LOG_INFO, @"JITManager", @"Requesting JIT for PID: %d", pid);
 
-  // Check if JIT is already enabled
+  void *context = completion ? (void *)CFBridgingRetain([completion copy]) : NULL;
+  if (!self.queue) {
+    HIAHJITManagerComplete(pid, HIAHJITResultCancelled, context);
+    return;
+  }
+
+  // A process that settles on JIT-less mode no longer needs the attach
+  @synchronized(self.declinedTokens) {
+    if (!self.declinedTokens[@(pid)]) {
+      __weak HIAHJITManager *weakSelf = self;
+      int token = HIAHJITRegisterDeclinedHandler(
+          pid, dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+            HIAHLogEx(HIAH_LOG_INFO, @"JITManager", @"PID %d declined JIT - cancelling", pid);
+            [weakSelf cancelJITForPID:pid];
+          });
+      if (token >= 0) {
+        self.declinedTokens[@(pid)] = @(token);
+      }
+    }
+  }
+
+  BOOL queued = HIAHJITQueueSubmit(self.queue, pid, HIAHJITManagerComplete, context);
+  HIAHJITQueueMetrics metrics = [self queueMetrics];
+  HIAHLogEx(HIAH_LOG_DEBUG, @"JITManager", @"%@ JIT for PID %d (depth %u, in flight %u)",
+            queued ? @"Queued" : @"Coalesced", pid, metrics.depth, metrics.inFlight);
+}
+
+- (void)cancelJITForPID:(pid_t)pid {
+  HIAHJITQueueCancel(self.queue, pid);
+}
+
+- (void)stopWatchingDeclinesForPID:(pid_t)pid {
+  @synchronized(self.declinedTokens) {
+    NSNumber *token = self.declinedTokens[@(pid)];
+    if (token) {
+      HIAHJITCancelReadyHandler(token.intValue);
+      [self.declinedTokens removeObjectForKey:@(pid)];
+    }
+  }
+}
+
+- (HIAHJITQueueMetrics)queueMetrics {
+  HIAHJITQueueMetrics metrics = {0};
+  HIAHJITQueueGetMetrics(self.queue, &metrics);
+  return metrics;
+}
+
+#pragma mark - Attach Attempts
+
+static void HIAHJITManagerComplete(pid_t pid, HIAHJITResult result, void *context) {
+  void (^completion)(BOOL, NSError *) = context ? CFBridgingRelease(context) : nil;
+  [[HIAHJITManager sharedManager] stopWatchingDeclinesForPID:pid];
+
+  switch (result) {
+    case HIAHJITResultEnabled:
+      if (completion) {
+        completion(YES, nil);
+      }
+      break;
+    case HIAHJITResultFailed:
+      HIAHLogEx(HIAH_LOG_WARNING, @"JITManager", @"JIT not enabled for PID: %d - will use signing fallback", pid);
+      // Return success - signing fallback will work
+      if (completion) {
+        completion(YES, nil);
+      }
+      break;
+    case HIAHJITResultProcessExited:
+    case HIAHJITResultCancelled: {
+      NSString *reason = result == HIAHJITResultProcessExited ? @"Process exited before JIT was enabled"
+                                                               : @"JIT request cancelled";
+      HIAHLogEx(HIAH_LOG_INFO, @"JITManager", @"%@ (PID: %d)", reason, pid);
+      if (completion) {
+        completion(NO, [NSError errorWithDomain:@"HIAHJITManager"
+                                           code:(NSInteger)result
+                                       userInfo:@{NSLocalizedDescriptionKey: reason}]);
+      }
+      break;
+    }
+  }
+}
+
+static bool HIAHJITManagerAttach(pid_t pid, void *context) {
+  @autoreleasepool {
+    HIAHJITManager *manager = (__bridge HIAHJITManager *)context;
+    return [manager attemptJITForPID:pid];
+  }
+}
+
+static BOOL HIAHJITManagerIsDebugged(pid_t pid) {
   extern int csops(pid_t pid, unsigned int ops, void *useraddr, size_t usersize);
   #define CS_OPS_STATUS 0
   #define CS_DEBUGGED 0x10000000
-  
+
   int flags = 0;
-  if (csops(pid, CS_OPS_STATUS, &flags, sizeof(flags)) == 0) {
-    if ((flags & CS_DEBUGGED) != 0) {
-      HIAHLogEx(HIAH_LOG_INFO, @"JITManager", @"JIT already enabled for PID: %d", pid);
-      if (completion) {
-        completion(YES, nil);
+  return csops(pid, CS_OPS_STATUS, &flags, sizeof(flags)) == 0 && (flags & CS_DEBUGGED) != 0;
+}
+
+// Waits for an accepted attach to land. The target posts the readiness
+// notification once it sees CS_DEBUGGED; csops is also re-checked every
+// 100ms in case it is not watching.
+static BOOL HIAHJITManagerWaitForDebugged(pid_t pid) {
+  dispatch_semaphore_t wake = dispatch_semaphore_create(0);
+  int token = HIAHJITRegisterReadyHandler(
+      pid, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        dispatch_semaphore_signal(wake);
+      });
+
+  dispatch_time_t deadline = dispatch_time(DISPATCH_TIME_NOW, kJITAttachSettleTimeout);
+  BOOL debugged;
+  while (!(debugged = HIAHJITManagerIsDebugged(pid))) {
+    dispatch_time_t slice = dispatch_time(DISPATCH_TIME_NOW, 100 * NSEC_PER_MSEC);
+    if (dispatch_semaphore_wait(wake, MIN(slice, deadline)) != 0 &&
+        dispatch_time(DISPATCH_TIME_NOW, 0) >= deadline) {
+      debugged = HIAHJITManagerIsDebugged(pid);
+      break;
+    }
+  }
+  HIAHJITCancelReadyHandler(token);
+  return debugged;
+}
+
+- (void)didEnableJITForPID:(pid_t)pid {
+  // Wake the process if it is waiting for JIT
+  HIAHJITPostReady(pid);
+  // Update coordinator
+  Class coordinatorClass = NSClassFromString(@"HIAHBypassCoordinator");
+  if (coordinatorClass) {
+    SEL coordSel = NSSelectorFromString(@"sharedCoordinator");
+    if ([coordinatorClass respondsToSelector:coordSel]) {
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Warc-performSelector-leaks"
+      id coordinator = [coordinatorClass performSelector:coordSel];
+#pragma clang diagnostic pop
+      if (coordinator) {
+        SEL updateSel = NSSelectorFromString(@"updateJITStatus:");
+        if ([coordinator respondsToSelector:updateSel]) {
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Warc-performSelector-leaks"
+          [coordinator performSelector:updateSel withObject:@(YES)];
+#pragma clang diagnostic pop
+        }
       }
-      return;
     }
   }
+}
+
+// One attempt, run on a queue worker. The queue coalesces requests, limits
+// concurrent attaches and schedules retries with backoff, so a NO here just
+// means "try again later".
+- (BOOL)attemptJITForPID:(pid_t)pid {
+  // Check if JIT is already enabled (also catches an attach from the
+  // previous attempt that landed after it returned)
+  if (HIAHJITManagerIsDebugged(pid)) {
+    HIAHLogEx(HIAH_LOG_INFO, @"JITManager", @"JIT already enabled for PID: %d", pid);
+    [self didEnableJITForPID:pid];
+    return YES;
+  }
 
   // Ensure VPN is active (required for JIT enablement)
   // Use the reliable detectHIAHVPNConnected method instead of isVPNActive
@@ -72,30 +250,26 @@
   if (!vpnConnected) {
     HIAHLogEx(HIAH_LOG_WARNING, @"JITManager", @"VPN not active (reliable check) - starting VPN for JIT...");
     
-    HIAHVPNManager *vpnManager = [HIAHVPNManager sharedManager];
-    [vpnManager startVPNWithCompletion:^(NSError * _Nullable error) {
-      if (error) {
-        HIAHLogEx(HIAH_LOG_ERROR, @"JITManager", @"Failed to start VPN: %@", error);
-        if (completion) {
-          completion(NO, error);
-        }
-        return;
-      }
-      
-      // VPN started, now enable JIT
-      [self enableJITForPID:pid completion:completion];
+    dispatch_semaphore_t vpnSem = dispatch_semaphore_create(0);
+    __block NSError *vpnError = nil;
+    [[HIAHVPNManager sharedManager] startVPNWithCompletion:^(NSError * _Nullable error) {
+      vpnError = error;
+      dispatch_semaphore_signal(vpnSem);
     }];
-    return;
+    if (dispatch_semaphore_wait(vpnSem, dispatch_time(DISPATCH_TIME_NOW, kJITAttemptTimeout)) != 0) {
+      HIAHLogEx(HIAH_LOG_ERROR, @"JITManager", @"Timed out starting VPN");
+      return NO;
+    }
+    if (vpnError) {
+      HIAHLogEx(HIAH_LOG_ERROR, @"JITManager", @"Failed to start VPN: %@", vpnError);
+      return NO;
+    }
   }
 
   // Use Minimuxer to enable JIT via lockdown protocol
   // Minimuxer communicates with lockdownd through the VPN tunnel
-  HIAHLogEx(HIAH_LOG_INFO, @"JITManager", @"Enabling JIT via Minimuxer for PID: %d", pid);
-  
-  // Enable JIT via Minimuxer through VPN tunnel
   // The VPN loopback makes iOS think requests come from a computer,
   // which allows Minimuxer to communicate with lockdownd to enable JIT
-  
   HIAHLogEx(HIAH_LOG_INFO, @"JITManager", @"Attempting to enable JIT via Minimuxer for PID: %d", pid);
   
   // Use HIAHMinimuxerJIT to enable JIT by PID (works for any process)
@@ -145,52 +319,15 @@
               [minimuxerJIT performSelector:enablePIDSel withObject:@(pid32)];
 #pragma clang diagnostic pop
               
-              // Wait a moment for JIT to take effect
-              dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.5 * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
-                // Verify JIT is actually enabled
-                extern int csops(pid_t pid, unsigned int ops, void *useraddr, size_t usersize);
-                #define CS_OPS_STATUS 0
-                #define CS_DEBUGGED 0x10000000
-                
-                int flags = 0;
-                BOOL jitActive = NO;
-                if (csops(pid, CS_OPS_STATUS, &flags, sizeof(flags)) == 0) {
-                  jitActive = (flags & CS_DEBUGGED) != 0;
-                }
-                
-                if (jitActive) {
-                  HIAHLogEx(HIAH_LOG_INFO, @"JITManager", @"✅ JIT enabled successfully for PID: %d", pid);
-                  // Update coordinator
-                  Class coordinatorClass = NSClassFromString(@"HIAHBypassCoordinator");
-                  if (coordinatorClass) {
-                    SEL coordSel = NSSelectorFromString(@"sharedCoordinator");
-                    if ([coordinatorClass respondsToSelector:coordSel]) {
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Warc-performSelector-leaks"
-                      id coordinator = [coordinatorClass performSelector:coordSel];
-#pragma clang diagnostic pop
-                      if (coordinator) {
-                        SEL updateSel = NSSelectorFromString(@"updateJITStatus:");
-                        if ([coordinator respondsToSelector:updateSel]) {
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Warc-performSelector-leaks"
-                          [coordinator performSelector:updateSel withObject:@(YES)];
-#pragma clang diagnostic pop
-                        }
-                      }
-                    }
-                  }
-                  if (completion) {
-                    completion(YES, nil);
-                  }
-                } else {
-                  HIAHLogEx(HIAH_LOG_WARNING, @"JITManager", @"JIT enablement reported success but CS_DEBUGGED not set for PID: %d", pid);
-                  if (completion) {
-                    completion(YES, nil); // Still return success - signing fallback
-                  }
-                }
-              });
-              return;
+              // Verify JIT is actually enabled. Only give up (and let the
+              // queue retry the attach) once the attach has had time to land.
+              if (HIAHJITManagerWaitForDebugged(pid)) {
+                HIAHLogEx(HIAH_LOG_INFO, @"JITManager", @"✅ JIT enabled successfully for PID: %d", pid);
+                [self didEnableJITForPID:pid];
+                return YES;
+              }
+              HIAHLogEx(HIAH_LOG_WARNING, @"JITManager", @"JIT enablement reported success but CS_DEBUGGED not set for PID: %d", pid);
+              return NO;
             } @catch (NSException *exception) {
               HIAHLogEx(HIAH_LOG_WARNING, @"JITManager", @"Failed to enable JIT via Minimuxer for PID %d: %@", pid, exception);
             }
@@ -216,97 +353,41 @@
           // Call enableJITForCurrentProcess (async)
           SEL enableSel = NSSelectorFromString(@"enableJITForCurrentProcessWithCompletion:");
           if ([enabler respondsToSelector:enableSel]) {
+            dispatch_semaphore_t enablerSem = dispatch_semaphore_create(0);
             void (^swiftCompletion)(BOOL, NSError *) = ^(BOOL success, NSError *error) {
-              // Verify JIT is actually enabled
-              BOOL jitActive = HIAHJITEnablerHelper_isJITEnabled();
-              
-              if (jitActive) {
-                HIAHLogEx(HIAH_LOG_INFO, @"JITManager", @"JIT enabled successfully for PID: %d", pid);
-                // Update coordinator
-                Class coordinatorClass = NSClassFromString(@"HIAHBypassCoordinator");
-                if (coordinatorClass) {
-                  SEL coordSel = NSSelectorFromString(@"sharedCoordinator");
-                  if ([coordinatorClass respondsToSelector:coordSel]) {
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Warc-performSelector-leaks"
-                    id coordinator = [coordinatorClass performSelector:coordSel];
-#pragma clang diagnostic pop
-                    if (coordinator) {
-                      SEL updateSel = NSSelectorFromString(@"updateJITStatus:");
-                      if ([coordinator respondsToSelector:updateSel]) {
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Warc-performSelector-leaks"
-                        [coordinator performSelector:updateSel withObject:@(YES)];
-#pragma clang diagnostic pop
-                      }
-                    }
-                  }
-                }
-                if (completion) {
-                  completion(YES, nil);
-                }
-              } else {
-                HIAHLogEx(HIAH_LOG_WARNING, @"JITManager", @"JIT enablement reported success but CS_DEBUGGED not set");
-                if (completion) {
-                  completion(YES, nil); // Still return success - signing fallback
-                }
-              }
+              dispatch_semaphore_signal(enablerSem);
             };
             
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Warc-performSelector-leaks"
             [enabler performSelector:enableSel withObject:swiftCompletion];
 #pragma clang diagnostic pop
-            return;
+            dispatch_semaphore_wait(enablerSem, dispatch_time(DISPATCH_TIME_NOW, kJITAttemptTimeout));
+            
+            // Verify JIT is actually enabled
+            if (HIAHJITEnablerHelper_isJITEnabled()) {
+              HIAHLogEx(HIAH_LOG_INFO, @"JITManager", @"JIT enabled successfully for PID: %d", pid);
+              [self didEnableJITForPID:pid];
+              return YES;
+            }
+            HIAHLogEx(HIAH_LOG_WARNING, @"JITManager", @"JIT enablement reported success but CS_DEBUGGED not set");
+            return NO;
           }
         }
       }
     }
   }
   
-  // Fallback: Check if JIT is already enabled or can be enabled
-  // With VPN active, JIT might be enabled automatically in some cases
-  dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
-    // Wait for VPN to stabilize
-    [NSThread sleepForTimeInterval:1.5];
-    
-    // Check if JIT got enabled
-    BOOL jitEnabled = HIAHJITEnablerHelper_isJITEnabled();
-    
-    if (jitEnabled) {
-      HIAHLogEx(HIAH_LOG_INFO, @"JITManager", @"JIT enabled (verified) for PID: %d", pid);
-      // Update coordinator
-      Class coordinatorClass = NSClassFromString(@"HIAHBypassCoordinator");
-      if (coordinatorClass) {
-        SEL coordSel = NSSelectorFromString(@"sharedCoordinator");
-        if ([coordinatorClass respondsToSelector:coordSel]) {
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Warc-performSelector-leaks"
-          id coordinator = [coordinatorClass performSelector:coordSel];
-#pragma clang diagnostic pop
-          if (coordinator) {
-            SEL updateSel = NSSelectorFromString(@"updateJITStatus:");
-            if ([coordinator respondsToSelector:updateSel]) {
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Warc-performSelector-leaks"
-              [coordinator performSelector:updateSel withObject:@(YES)];
-#pragma clang diagnostic pop
-            }
-          }
-        }
-      }
-      if (completion) {
-        completion(YES, nil);
-      }
-    } else {
-      HIAHLogEx(HIAH_LOG_WARNING, @"JITManager", @"JIT not enabled for PID: %d - will use signing fallback", pid);
-      HIAHLogEx(HIAH_LOG_INFO, @"JITManager", @"Note: Full Minimuxer integration needed for automatic JIT enablement");
-      // Return success - signing fallback will work
-      if (completion) {
-          completion(YES, nil);
-      }
-    }
-      });
+  // Fallback: With VPN active, JIT might be enabled automatically in some
+  // cases. The queue's backoff gives the VPN time to stabilize between
+  // checks instead of sleeping here.
+  if (HIAHJITManagerIsDebugged(pid)) {
+    HIAHLogEx(HIAH_LOG_INFO, @"JITManager", @"JIT enabled (verified) for PID: %d", pid);
+    [self didEnableJITForPID:pid];
+    return YES;
+  }
+  HIAHLogEx(HIAH_LOG_DEBUG, @"JITManager", @"JIT not enabled yet for PID: %d", pid);
+  return NO;
 }
 
 - (void)mountDeveloperDiskImageWithCompletion:
@@ -0,0 +1,332 @@
+/**
+ * HIAHJITQueue.c
+ * HIAH LoginWindow - JIT Enablement Work Queue
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under AGPLv3
+ */
+
+#include "HIAHJITQueue.h"
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef struct HIAHJITWaiter {
+    HIAHJITCompletion completion;
+    void *context;
+    struct HIAHJITWaiter *next;
+} HIAHJITWaiter;
+
+typedef struct HIAHJITJob {
+    pid_t pid;
+    unsigned attempts;
+    bool running;
+    bool cancelled;
+    uint64_t submittedNs;
+    uint64_t readyAtNs;           // Not picked up before this (backoff)
+    HIAHJITWaiter *waiters;
+    struct HIAHJITJob *next;
+} HIAHJITJob;
+
+struct HIAHJITQueue {
+    HIAHJITQueueConfig config;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    HIAHJITJob *jobs;             // FIFO, one per PID
+    bool shutdown;
+    uint64_t random;
+    HIAHJITQueueMetrics metrics;  // depth is computed on read
+    pthread_t *workers;
+    unsigned workerCount;
+};
+
+#pragma mark - Helpers
+
+static uint64_t HIAHNowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static bool HIAHDefaultIsAlive(pid_t pid, void *context) {
+    (void)context;
+    return kill(pid, 0) == 0 || errno != ESRCH;
+}
+
+static void HIAHRecordLatency(uint64_t *histogram, uint64_t ns) {
+    uint64_t ms = ns / 1000000ull;
+    int bucket = ms ? 63 - __builtin_clzll(ms) : 0;
+    if (bucket >= HIAH_JIT_QUEUE_LATENCY_BUCKETS) bucket = HIAH_JIT_QUEUE_LATENCY_BUCKETS - 1;
+    histogram[bucket]++;
+}
+
+// Lock held. Equal jitter: half the exponential delay plus a random half,
+// so retries for PIDs that failed together spread out.
+static uint64_t HIAHBackoffNs(HIAHJITQueue *queue, unsigned attempts) {
+    uint64_t delay = queue->config.baseDelayMs;
+    for (unsigned i = 1; i < attempts && delay < queue->config.maxDelayMs; i++) delay *= 2;
+    if (delay > queue->config.maxDelayMs) delay = queue->config.maxDelayMs;
+
+    // xorshift64
+    queue->random ^= queue->random << 13;
+    queue->random ^= queue->random >> 7;
+    queue->random ^= queue->random << 17;
+
+    uint64_t half = delay / 2;
+    uint64_t ms = half + queue->random % (delay - half + 1);
+    return ms * 1000000ull;
+}
+
+static HIAHJITJob *HIAHFindJob(HIAHJITQueue *queue, pid_t pid) {
+    for (HIAHJITJob *job = queue->jobs; job; job = job->next) {
+        if (job->pid == pid) return job;
+    }
+    return NULL;
+}
+
+static void HIAHUnlinkJob(HIAHJITQueue *queue, HIAHJITJob *job) {
+    for (HIAHJITJob **it = &queue->jobs; *it; it = &(*it)->next) {
+        if (*it == job) {
+            *it = job->next;
+            return;
+        }
+    }
+}
+
+// Lock held on entry and exit; dropped while completions run so they may
+// submit again
+static void HIAHFinishJob(HIAHJITQueue *queue, HIAHJITJob *job, HIAHJITResult result) {
+    HIAHUnlinkJob(queue, job);
+    switch (result) {
+        case HIAHJITResultEnabled:       queue->metrics.enabled++; break;
+        case HIAHJITResultFailed:        queue->metrics.failed++; break;
+        case HIAHJITResultProcessExited: queue->metrics.exited++; break;
+        case HIAHJITResultCancelled:     queue->metrics.cancelled++; break;
+    }
+
+    pthread_mutex_unlock(&queue->lock);
+    HIAHJITWaiter *waiter = job->waiters;
+    while (waiter) {
+        HIAHJITWaiter *next = waiter->next;
+        if (waiter->completion) waiter->completion(job->pid, result, waiter->context);
+        free(waiter);
+        waiter = next;
+    }
+    free(job);
+    pthread_mutex_lock(&queue->lock);
+}
+
+#pragma mark - Workers
+
+static void *HIAHJITWorkerMain(void *argument) {
+    HIAHJITQueue *queue = argument;
+    pthread_mutex_lock(&queue->lock);
+
+    while (!queue->shutdown) {
+        uint64_t now = HIAHNowNs();
+        uint64_t nextReady = UINT64_MAX;
+        HIAHJITJob *job = NULL;
+        for (HIAHJITJob *it = queue->jobs; it; it = it->next) {
+            if (it->running) continue;
+            if (it->readyAtNs <= now) {
+                job = it;
+                break;
+            }
+            if (it->readyAtNs < nextReady) nextReady = it->readyAtNs;
+        }
+
+        if (!job) {
+            if (nextReady == UINT64_MAX) {
+                pthread_cond_wait(&queue->cond, &queue->lock);
+            } else {
+                struct timespec deadline = {
+                    .tv_sec = (time_t)(nextReady / 1000000000ull),
+                    .tv_nsec = (long)(nextReady % 1000000000ull),
+                };
+                pthread_cond_timedwait(&queue->cond, &queue->lock, &deadline);
+            }
+            continue;
+        }
+
+        job->running = true;
+        job->attempts++;
+        queue->metrics.inFlight++;
+        pid_t pid = job->pid;
+        pthread_mutex_unlock(&queue->lock);
+
+        bool alive = queue->config.isAlive(pid, queue->config.context);
+        bool enabled = false;
+        uint64_t start = HIAHNowNs();
+        if (alive) enabled = queue->config.attach(pid, queue->config.context);
+        uint64_t end = HIAHNowNs();
+
+        pthread_mutex_lock(&queue->lock);
+        queue->metrics.inFlight--;
+        job->running = false;
+
+        if (!alive) {
+            HIAHFinishJob(queue, job, HIAHJITResultProcessExited);
+            continue;
+        }
+
+        queue->metrics.attempts++;
+        HIAHRecordLatency(queue->metrics.attachLatency, end - start);
+        if (enabled) {
+            uint64_t total = end - job->submittedNs;
+            HIAHRecordLatency(queue->metrics.enableLatency, total);
+            if (total / 1000000ull > queue->metrics.maxEnableMs) {
+                queue->metrics.maxEnableMs = total / 1000000ull;
+            }
+            HIAHFinishJob(queue, job, HIAHJITResultEnabled);
+        } else if (job->cancelled) {
+            HIAHFinishJob(queue, job, HIAHJITResultCancelled);
+        } else if (job->attempts >= queue->config.maxAttempts) {
+            HIAHFinishJob(queue, job, HIAHJITResultFailed);
+        } else {
+            job->readyAtNs = end + HIAHBackoffNs(queue, job->attempts);
+            // Idle workers may be sleeping until a later deadline
+            pthread_cond_broadcast(&queue->cond);
+        }
+    }
+
+    pthread_mutex_unlock(&queue->lock);
+    return NULL;
+}
+
+#pragma mark - Queue
+
+HIAHJITQueue *HIAHJITQueueCreate(const HIAHJITQueueConfig *config) {
+    if (!config || !config->attach) return NULL;
+
+    HIAHJITQueue *queue = calloc(1, sizeof(HIAHJITQueue));
+    if (!queue) return NULL;
+
+    queue->config = *config;
+    if (!queue->config.maxConcurrent) queue->config.maxConcurrent = 2;
+    if (!queue->config.maxAttempts) queue->config.maxAttempts = 5;
+    if (!queue->config.baseDelayMs) queue->config.baseDelayMs = 250;
+    if (!queue->config.maxDelayMs) queue->config.maxDelayMs = 4000;
+    if (!queue->config.isAlive) queue->config.isAlive = HIAHDefaultIsAlive;
+    queue->random = HIAHNowNs() | 1;
+
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->cond, NULL);
+
+    queue->workers = calloc(queue->config.maxConcurrent, sizeof(pthread_t));
+    if (!queue->workers) {
+        HIAHJITQueueDestroy(queue);
+        return NULL;
+    }
+    for (unsigned i = 0; i < queue->config.maxConcurrent; i++) {
+        if (pthread_create(&queue->workers[i], NULL, HIAHJITWorkerMain, queue) != 0) break;
+        queue->workerCount++;
+    }
+    if (queue->workerCount == 0) {
+        HIAHJITQueueDestroy(queue);
+        return NULL;
+    }
+    return queue;
+}
+
+void HIAHJITQueueDestroy(HIAHJITQueue *queue) {
+    if (!queue) return;
+
+    pthread_mutex_lock(&queue->lock);
+    queue->shutdown = true;
+    for (HIAHJITJob *job = queue->jobs; job; job = job->next) job->cancelled = true;
+    pthread_cond_broadcast(&queue->cond);
+    pthread_mutex_unlock(&queue->lock);
+
+    // Workers finish (and complete) whatever they are attaching
+    for (unsigned i = 0; i < queue->workerCount; i++) {
+        pthread_join(queue->workers[i], NULL);
+    }
+
+    pthread_mutex_lock(&queue->lock);
+    while (queue->jobs) HIAHFinishJob(queue, queue->jobs, HIAHJITResultCancelled);
+    pthread_mutex_unlock(&queue->lock);
+
+    pthread_cond_destroy(&queue->cond);
+    pthread_mutex_destroy(&queue->lock);
+    free(queue->workers);
+    free(queue);
+}
+
+bool HIAHJITQueueSubmit(HIAHJITQueue *queue, pid_t pid, HIAHJITCompletion completion,
+                        void *context) {
+    if (!queue || pid <= 0) return false;
+
+    HIAHJITWaiter *waiter = calloc(1, sizeof(HIAHJITWaiter));
+    if (!waiter) return false;
+    waiter->completion = completion;
+    waiter->context = context;
+
+    pthread_mutex_lock(&queue->lock);
+    if (queue->shutdown) {
+        pthread_mutex_unlock(&queue->lock);
+        free(waiter);
+        return false;
+    }
+    queue->metrics.submitted++;
+
+    HIAHJITJob *job = HIAHFindJob(queue, pid);
+    if (job) {
+        // A cancelled job is still running its last attempt; revive it
+        // rather than attaching to the same PID twice
+        job->cancelled = false;
+        waiter->next = job->waiters;
+        job->waiters = waiter;
+        queue->metrics.coalesced++;
+        pthread_mutex_unlock(&queue->lock);
+        return false;
+    }
+
+    job = calloc(1, sizeof(HIAHJITJob));
+    if (!job) {
+        queue->metrics.submitted--;
+        pthread_mutex_unlock(&queue->lock);
+        free(waiter);
+        return false;
+    }
+    job->pid = pid;
+    job->submittedNs = HIAHNowNs();
+    job->readyAtNs = job->submittedNs;
+    job->waiters = waiter;
+
+    HIAHJITJob **tail = &queue->jobs;
+    while (*tail) tail = &(*tail)->next;
+    *tail = job;
+
+    pthread_cond_signal(&queue->cond);
+    pthread_mutex_unlock(&queue->lock);
+    return true;
+}
+
+void HIAHJITQueueCancel(HIAHJITQueue *queue, pid_t pid) {
+    if (!queue) return;
+
+    pthread_mutex_lock(&queue->lock);
+    HIAHJITJob *job = HIAHFindJob(queue, pid);
+    if (job) {
+        if (job->running) {
+            job->cancelled = true;
+        } else {
+            HIAHFinishJob(queue, job, HIAHJITResultCancelled);
+        }
+    }
+    pthread_mutex_unlock(&queue->lock);
+}
+
+void HIAHJITQueueGetMetrics(HIAHJITQueue *queue, HIAHJITQueueMetrics *out) {
+    if (!queue || !out) return;
+
+    pthread_mutex_lock(&queue->lock);
+    *out = queue->metrics;
+    out->depth = 0;
+    for (HIAHJITJob *job = queue->jobs; job; job = job->next) {
+        if (!job->running) out->depth++;
+    }
+    pthread_mutex_unlock(&queue->lock);
+}
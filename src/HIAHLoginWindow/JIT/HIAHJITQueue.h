@@ -0,0 +1,112 @@
+/**
+ * HIAHJITQueue.h
+ * HIAH LoginWindow - JIT Enablement Work Queue
+ *
+ * Serializes debugger-attach work per PID. Repeated requests for a PID that
+ * is already queued, attaching or backing off are coalesced into the
+ * existing job, at most `maxConcurrent` attaches run at once, failed
+ * attempts are retried after a jittered exponential backoff, and jobs for
+ * processes that have exited are cancelled. The attach and liveness checks
+ * are injected, so the queue itself is plain C and pthreads.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under AGPLv3
+ */
+
+#ifndef HIAH_JIT_QUEUE_H
+#define HIAH_JIT_QUEUE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    HIAHJITResultEnabled = 0,     // Attach succeeded (CS_DEBUGGED confirmed)
+    HIAHJITResultFailed,          // Every attempt failed
+    HIAHJITResultProcessExited,   // The PID went away before JIT was enabled
+    HIAHJITResultCancelled,       // HIAHJITQueueCancel or queue destroyed
+} HIAHJITResult;
+
+/**
+ * One blocking attach attempt. Returns true once JIT is confirmed for `pid`.
+ * Called on a queue worker thread; never concurrently for the same PID.
+ */
+typedef bool (*HIAHJITAttachFunction)(pid_t pid, void *context);
+
+/**
+ * Whether `pid` still exists. NULL uses kill(pid, 0).
+ */
+typedef bool (*HIAHJITAliveFunction)(pid_t pid, void *context);
+
+/**
+ * Called once per submission, on a worker thread, after the job finishes.
+ */
+typedef void (*HIAHJITCompletion)(pid_t pid, HIAHJITResult result, void *context);
+
+typedef struct {
+    unsigned maxConcurrent;       // Simultaneous attaches (default 2)
+    unsigned maxAttempts;         // Attempts per job (default 5)
+    uint32_t baseDelayMs;         // First retry delay (default 250)
+    uint32_t maxDelayMs;          // Backoff cap (default 4000)
+    HIAHJITAttachFunction attach;
+    HIAHJITAliveFunction isAlive;
+    void *context;                // Passed to attach and isAlive
+} HIAHJITQueueConfig;
+
+/// Bucket i counts latencies in [2^i, 2^(i+1)) ms; the last bucket is open-ended
+#define HIAH_JIT_QUEUE_LATENCY_BUCKETS 16
+
+typedef struct {
+    uint32_t depth;               // Jobs waiting to run or backing off
+    uint32_t inFlight;            // Attaches currently running
+    uint64_t submitted;
+    uint64_t coalesced;           // Submissions merged into an existing job
+    uint64_t attempts;
+    uint64_t enabled;
+    uint64_t failed;
+    uint64_t exited;
+    uint64_t cancelled;
+    uint64_t attachLatency[HIAH_JIT_QUEUE_LATENCY_BUCKETS];   // Per attempt
+    uint64_t enableLatency[HIAH_JIT_QUEUE_LATENCY_BUCKETS];   // Submit to enabled
+    uint64_t maxEnableMs;
+} HIAHJITQueueMetrics;
+
+typedef struct HIAHJITQueue HIAHJITQueue;
+
+/**
+ * Creates a queue and its worker threads. Zero config fields take the
+ * defaults; `attach` is required.
+ */
+HIAHJITQueue *HIAHJITQueueCreate(const HIAHJITQueueConfig *config);
+
+/**
+ * Cancels outstanding jobs (their completions run with
+ * HIAHJITResultCancelled), waits for running attaches and frees the queue.
+ */
+void HIAHJITQueueDestroy(HIAHJITQueue *queue);
+
+/**
+ * Requests JIT for `pid`. `completion` may be NULL.
+ *
+ * @return true if a new job was created, false if the request was coalesced
+ *         into an existing one (or the queue is shutting down).
+ */
+bool HIAHJITQueueSubmit(HIAHJITQueue *queue, pid_t pid, HIAHJITCompletion completion,
+                        void *context);
+
+/**
+ * Drops the job for `pid`. A running attempt finishes first; no retry follows.
+ */
+void HIAHJITQueueCancel(HIAHJITQueue *queue, pid_t pid);
+
+void HIAHJITQueueGetMetrics(HIAHJITQueue *queue, HIAHJITQueueMetrics *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HIAH_JIT_QUEUE_H */
@@ -4,7 +4,9 @@
  *
  * Coordinates VPN/JIT status between main app and ProcessRunner extension
  * using App Group shared storage. This allows the extension to know when
- * bypass is ready without direct class access.
+ * bypass is ready without direct class access. Updates are published to a
+ * shared-memory status page (HIAHBypassStatusPage); the plist is kept as a
+ * debugging mirror.
  *
  * Based on SideStore (AGPLv3)
  * Copyright (c) 2025 Alex Spaulding
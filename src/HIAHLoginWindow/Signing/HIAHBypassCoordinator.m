@@ -12,6 +12,7 @@
 
 #import "HIAHBypassCoordinator.h"
 #import "../../HIAHDesktop/HIAHLogging.h"
+#import "../../HIAHKernel/Core/Hooks/HIAHBypassStatusPage.h"
 #import <sys/sysctl.h>
 
 static NSString * const kAppGroupIdentifier = @"group.com.aspauldingcode.HIAHDesktop";
@@ -27,6 +28,7 @@ static NSString * const kLastUpdateKey = @"LastUpdate";
 @property (nonatomic, assign) BOOL isJITEnabled;
 @property (nonatomic, assign) BOOL isBypassReady;
 @property (nonatomic, strong) NSURL *statusFileURL;
+@property (nonatomic, assign) HIAHBypassStatusPage *statusPage;
 @property (nonatomic, strong) dispatch_queue_t queue;
 
 @end
@@ -54,6 +56,13 @@ static NSString * const kLastUpdateKey = @"LastUpdate";
             _statusFileURL = [groupURL URLByAppendingPathComponent:kBypassStatusFile];
             // Ensure directory exists
             [fm createDirectoryAtPath:groupURL.path withIntermediateDirectories:YES attributes:nil error:nil];
+            
+            // Shared-memory page the extension reads; the plist is only a mirror
+            NSURL *pageURL = [groupURL URLByAppendingPathComponent:@HIAH_BYPASS_STATUS_PAGE_FILE];
+            _statusPage = HIAHBypassStatusPageMap(pageURL.fileSystemRepresentation, true);
+            if (!_statusPage) {
+                HIAHLogEx(HIAH_LOG_WARNING, @"BypassCoordinator", @"Could not map status page, using plist only");
+            }
         }
         
         // Load initial status
@@ -63,6 +72,21 @@ static NSString * const kLastUpdateKey = @"LastUpdate";
 }
 
 - (void)loadStatus {
+    HIAHBypassStatusSnapshot snapshot;
+    if (self.statusPage && HIAHBypassStatusPageRead(self.statusPage, &snapshot)) {
+        _isVPNActive = snapshot.vpnActive;
+        _isJITEnabled = snapshot.jitEnabled;
+        _isBypassReady = snapshot.bypassReady;
+        
+        if (HIAHBypassStatusSnapshotAge(&snapshot) > 30.0) {
+            HIAHLogEx(HIAH_LOG_WARNING, @"BypassCoordinator", @"Status is stale, resetting");
+            _isVPNActive = NO;
+            _isJITEnabled = NO;
+            _isBypassReady = NO;
+        }
+        return;
+    }
+    
     if (!self.statusFileURL) return;
     
     NSDictionary *status = [NSDictionary dictionaryWithContentsOfURL:self.statusFileURL];
@@ -82,9 +106,20 @@ static NSString * const kLastUpdateKey = @"LastUpdate";
     }
 }
 
+// Called on self.queue, which keeps the page single-writer
 - (void)saveStatus {
+    if (self.statusPage) {
+        HIAHBypassStatusSnapshot snapshot = {
+            .vpnActive = self.isVPNActive,
+            .jitEnabled = self.isJITEnabled,
+            .bypassReady = self.isBypassReady,
+        };
+        HIAHBypassStatusPageWrite(self.statusPage, &snapshot);
+    }
+    
     if (!self.statusFileURL) return;
     
+    // Debugging mirror only; readers use the page
     NSDictionary *status = @{
         kVPNActiveKey: @(self.isVPNActive),
         kJITEnabledKey: @(self.isJITEnabled),
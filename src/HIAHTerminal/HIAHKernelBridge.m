@@ -5,6 +5,7 @@
 
 #import "HIAHKernelBridge.h"
 #import "../HIAHKernel.h"
+#import "../HIAHDesktop/HIAHFilesystem.h"
 
 @implementation HIAHKernelBridge
 
@@ -23,6 +24,20 @@
                    workingDirectory:(NSString *)workingDirectory
                          completion:(void (^)(NSString * _Nullable output, NSString * _Nullable error, NSNumber * _Nullable exitCode))completion {
     
+    // Commands are looked up in /bin and /usr/bin, which are filled in the
+    // background at launch; wait for them rather than report "not found"
+    HIAHFilesystem *fs = [HIAHFilesystem shared];
+    if (!fs.bundledContentReady) {
+        [fs notifyWhenBundledContentReady:^{
+            [self spawnProcessWithExecutable:executable
+                                   arguments:arguments
+                                 environment:environment
+                            workingDirectory:workingDirectory
+                                  completion:completion];
+        }];
+        return;
+    }
+    
     HIAHKernel *kernel = [HIAHKernel sharedKernel];
     
     // Resolve executable path in virtual filesystem
@@ -104,10 +104,9 @@ class TerminalViewModel: ObservableObject {
         addOutput("Accessing virtual filesystem via HIAH Kernel...", color: .gray)
         addOutput("", color: .white)
         
-        // Try to run pfetch if available
-        DispatchQueue.main.asyncAfter(deadline: .now() + 0.5) {
-            self.executeCommand("pfetch", addToHistory: false)
-        }
+        // Try to run pfetch if available; the spawn waits for bundled
+        // tools to be installed (see HIAHKernelBridge)
+        executeCommand("pfetch", addToHistory: false)
     }
     
     func executeCommand() {
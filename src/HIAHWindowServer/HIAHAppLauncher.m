@@ -5,6 +5,7 @@
 
 #import "HIAHAppLauncher.h"
 #import "../HIAHDesktop/HIAHFilesystem.h"
+#import "HIAHPlistReader.h"
 #import <sys/event.h>
 #import <sys/time.h>
 #import <fcntl.h>
@@ -117,11 +118,15 @@ static const CGFloat kDrawerHeight = 320.0;
         
         NSString *appPath = [appsPath stringByAppendingPathComponent:item];
         NSString *infoPlistPath = [appPath stringByAppendingPathComponent:@"Info.plist"];
-        NSDictionary *info = [NSDictionary dictionaryWithContentsOfFile:infoPlistPath];
+        HIAHPlist *info = HIAHPlistOpen(infoPlistPath.fileSystemRepresentation);
         
         if (info) {
-            NSString *name = info[@"CFBundleDisplayName"] ?: info[@"CFBundleName"] ?: [item stringByReplacingOccurrencesOfString:@".app" withString:@""];
-            NSString *bundleID = info[@"CFBundleIdentifier"] ?: @"unknown";
+            static const char *const kLauncherKeys[] = {"CFBundleDisplayName", "CFBundleName", "CFBundleIdentifier"};
+            HIAHPlistValue values[3];
+            HIAHPlistGetKeys(info, kLauncherKeys, values, 3);
+            NSString *name = HIAHPlistValueString(&values[0]) ?: HIAHPlistValueString(&values[1]) ?: [item stringByReplacingOccurrencesOfString:@".app" withString:@""];
+            NSString *bundleID = HIAHPlistValueString(&values[2]) ?: @"unknown";
+            HIAHPlistClose(info);
             
             // Determine icon based on app name or bundle ID
             NSString *icon = @"app.fill";
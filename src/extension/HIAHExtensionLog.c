@@ -0,0 +1,331 @@
+/**
+ * HIAHExtensionLog.c
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Asynchronous extension log writer implementation.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#include "HIAHExtensionLog.h"
+#include <dispatch/dispatch.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#define HIAH_LOG_SLOTS 1024                // Power of two
+#define HIAH_LOG_SLOT_DATA 240             // Payload bytes per slot
+#define HIAH_LOG_MAX_SLOTS_PER_LINE 8      // Longer lines are truncated
+#define HIAH_LOG_DRAIN_INTERVAL_MS 100
+#define HIAH_LOG_ROTATE_SIZE (2 * 1024 * 1024)
+#define HIAH_LOG_ARCHIVES 3
+#define HIAH_LOG_FLUSH_WAIT_YIELDS 10000   // Bound on waiting for the writer's drain
+
+typedef struct {
+    // Vyukov sequence: == position when free, position + 1 when published
+    _Atomic(uint64_t) seq;
+    uint16_t length;
+    char data[HIAH_LOG_SLOT_DATA];
+} HIAHLogSlot;
+
+static HIAHLogSlot g_slots[HIAH_LOG_SLOTS];
+static _Atomic(uint64_t) g_tail = 0;       // Next position producers claim
+static _Atomic(uint64_t) g_head = 0;       // Next position the consumer reads
+static atomic_flag g_draining = ATOMIC_FLAG_INIT;
+
+static _Atomic(uint64_t) g_droppedLines = 0;
+static _Atomic(uint64_t) g_droppedBytes = 0;
+static uint64_t g_reportedLines = 0;       // Writer thread only
+
+static _Atomic(int) g_fd = -1;
+static char g_path[PATH_MAX];
+static FILE *g_stream = NULL;
+static dispatch_semaphore_t g_wake = NULL;
+static _Atomic(bool) g_wakePending = false;
+static pthread_once_t g_once = PTHREAD_ONCE_INIT;
+
+#pragma mark - Ring Buffer
+
+void HIAHExtensionLogAppend(const char *data, size_t length) {
+    if (length == 0 || atomic_load_explicit(&g_fd, memory_order_relaxed) < 0) return;
+
+    size_t maxLength = (size_t)HIAH_LOG_SLOT_DATA * HIAH_LOG_MAX_SLOTS_PER_LINE;
+    if (length > maxLength) length = maxLength;
+    uint64_t count = (length + HIAH_LOG_SLOT_DATA - 1) / HIAH_LOG_SLOT_DATA;
+
+    // Claim `count` consecutive slots. The consumer frees slots in order, so
+    // the run is free once its last slot is.
+    uint64_t pos = atomic_load_explicit(&g_tail, memory_order_relaxed);
+    for (;;) {
+        HIAHLogSlot *last = &g_slots[(pos + count - 1) & (HIAH_LOG_SLOTS - 1)];
+        uint64_t seq = atomic_load_explicit(&last->seq, memory_order_acquire);
+        int64_t diff = (int64_t)(seq - (pos + count - 1));
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&g_tail, &pos, pos + count,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Full: never block the caller
+            atomic_fetch_add_explicit(&g_droppedLines, 1, memory_order_relaxed);
+            atomic_fetch_add_explicit(&g_droppedBytes, length, memory_order_relaxed);
+            return;
+        } else {
+            pos = atomic_load_explicit(&g_tail, memory_order_relaxed);
+        }
+    }
+
+    for (uint64_t i = 0; i < count; i++) {
+        HIAHLogSlot *slot = &g_slots[(pos + i) & (HIAH_LOG_SLOTS - 1)];
+        size_t chunk = length > HIAH_LOG_SLOT_DATA ? HIAH_LOG_SLOT_DATA : length;
+        memcpy(slot->data, data, chunk);
+        slot->length = (uint16_t)chunk;
+        data += chunk;
+        length -= chunk;
+        atomic_store_explicit(&slot->seq, pos + i + 1, memory_order_release);
+    }
+
+    // Wake the writer early once the ring is half full
+    uint64_t pending = pos + count - atomic_load_explicit(&g_head, memory_order_relaxed);
+    if (pending > HIAH_LOG_SLOTS / 2 && g_wake &&
+        !atomic_exchange_explicit(&g_wakePending, true, memory_order_relaxed)) {
+        dispatch_semaphore_signal(g_wake);
+    }
+}
+
+void HIAHExtensionLogDropped(uint64_t *lines, uint64_t *bytes) {
+    if (lines) *lines = atomic_load_explicit(&g_droppedLines, memory_order_relaxed);
+    if (bytes) *bytes = atomic_load_explicit(&g_droppedBytes, memory_order_relaxed);
+}
+
+#pragma mark - Draining
+
+static void HIAHWriteAll(int fd, const char *data, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        data += written;
+        length -= (size_t)written;
+    }
+}
+
+// Caller holds g_draining. Returns the number of bytes written.
+static size_t HIAHDrain(char *batch, size_t capacity) {
+    int fd = atomic_load_explicit(&g_fd, memory_order_relaxed);
+    uint64_t head = atomic_load_explicit(&g_head, memory_order_relaxed);
+    size_t used = 0;
+    size_t total = 0;
+
+    for (;;) {
+        HIAHLogSlot *slot = &g_slots[head & (HIAH_LOG_SLOTS - 1)];
+        if (atomic_load_explicit(&slot->seq, memory_order_acquire) != head + 1) break;
+
+        if (used + slot->length > capacity) {
+            HIAHWriteAll(fd, batch, used);
+            total += used;
+            used = 0;
+        }
+        memcpy(batch + used, slot->data, slot->length);
+        used += slot->length;
+
+        atomic_store_explicit(&slot->seq, head + HIAH_LOG_SLOTS, memory_order_release);
+        head++;
+        atomic_store_explicit(&g_head, head, memory_order_relaxed);
+    }
+
+    if (used > 0) {
+        HIAHWriteAll(fd, batch, used);
+        total += used;
+    }
+    return total;
+}
+
+void HIAHExtensionLogFlushSync(void) {
+    static char batch[16 * 1024];
+
+    if (atomic_load_explicit(&g_fd, memory_order_relaxed) < 0) return;
+
+    // Wait for an in-progress drain (it only covers writing and renaming,
+    // never compression). Draining alongside it would write lines twice or
+    // out of order, so if it doesn't finish (e.g. the writer itself
+    // crashed mid-drain) the flush is skipped.
+    for (int i = 0; atomic_flag_test_and_set(&g_draining); i++) {
+        if (i == HIAH_LOG_FLUSH_WAIT_YIELDS) return;
+        sched_yield();
+    }
+    HIAHDrain(batch, sizeof(batch));
+    atomic_flag_clear(&g_draining);
+}
+
+#pragma mark - Rotation
+
+static int HIAHOpenLog(void) {
+    int fd = open(g_path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0 && errno == ENOENT) {
+        // The container directory may not exist yet
+        char directory[PATH_MAX];
+        strlcpy(directory, g_path, sizeof(directory));
+        char *slash = strrchr(directory, '/');
+        if (slash && slash != directory) {
+            *slash = '\0';
+            mkdir(directory, 0755);
+            fd = open(g_path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        }
+    }
+    return fd;
+}
+
+static void HIAHCompress(const char *source, const char *destination) {
+    int in = open(source, O_RDONLY | O_CLOEXEC);
+    if (in < 0) return;
+
+    gzFile out = gzopen(destination, "wb");
+    if (out) {
+        char buffer[64 * 1024];
+        ssize_t n;
+        while ((n = read(in, buffer, sizeof(buffer))) > 0) {
+            gzwrite(out, buffer, (unsigned)n);
+        }
+        gzclose(out);
+    }
+    close(in);
+}
+
+// Caller holds g_draining. Returns true if g_path.1 was created and still
+// needs compressing (done by HIAHCompressRotated without the flag held).
+static bool HIAHRotateIfNeeded(void) {
+    int fd = atomic_load_explicit(&g_fd, memory_order_relaxed);
+    struct stat current, onDisk;
+    if (fstat(fd, &current) != 0) return false;
+
+    // Several extension processes share the file; follow a rotation done
+    // by another one
+    if (stat(g_path, &onDisk) != 0 || onDisk.st_ino != current.st_ino) {
+        int reopened = HIAHOpenLog();
+        if (reopened >= 0) {
+            atomic_store_explicit(&g_fd, reopened, memory_order_relaxed);
+            close(fd);
+        }
+        return false;
+    }
+    if (current.st_size < HIAH_LOG_ROTATE_SIZE) return false;
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0) return false;
+
+    char from[PATH_MAX + 8], to[PATH_MAX + 8];
+    for (int i = HIAH_LOG_ARCHIVES - 1; i >= 1; i--) {
+        snprintf(from, sizeof(from), "%s.%d.gz", g_path, i);
+        snprintf(to, sizeof(to), "%s.%d.gz", g_path, i + 1);
+        rename(from, to);
+    }
+
+    char rotated[PATH_MAX + 8];
+    snprintf(rotated, sizeof(rotated), "%s.1", g_path);
+    if (rename(g_path, rotated) == 0) {
+        int reopened = HIAHOpenLog();
+        if (reopened >= 0) {
+            atomic_store_explicit(&g_fd, reopened, memory_order_relaxed);
+        }
+        flock(fd, LOCK_UN);
+        close(fd);
+        return true;
+    }
+    flock(fd, LOCK_UN);
+    return false;
+}
+
+static void HIAHCompressRotated(void) {
+    char rotated[PATH_MAX + 8], archive[PATH_MAX + 8];
+    snprintf(rotated, sizeof(rotated), "%s.1", g_path);
+    snprintf(archive, sizeof(archive), "%s.1.gz", g_path);
+    HIAHCompress(rotated, archive);
+    unlink(rotated);
+}
+
+#pragma mark - Writer Thread
+
+static void HIAHReportDrops(void) {
+    uint64_t lines = atomic_load_explicit(&g_droppedLines, memory_order_relaxed);
+    if (lines == g_reportedLines) return;
+
+    uint64_t bytes = atomic_load_explicit(&g_droppedBytes, memory_order_relaxed);
+    char message[160];
+    int length = snprintf(message, sizeof(message),
+                          "[HIAHExtension] Log overflow: dropped %llu lines (%llu bytes) so far\n",
+                          (unsigned long long)lines, (unsigned long long)bytes);
+    HIAHWriteAll(atomic_load_explicit(&g_fd, memory_order_relaxed), message, (size_t)length);
+    g_reportedLines = lines;
+}
+
+static void *HIAHWriterMain(void *unused) {
+    (void)unused;
+    static char batch[64 * 1024];
+    pthread_setname_np("hiah.extension.log");
+
+    for (;;) {
+        dispatch_semaphore_wait(g_wake, dispatch_time(DISPATCH_TIME_NOW,
+                                                      HIAH_LOG_DRAIN_INTERVAL_MS * NSEC_PER_MSEC));
+        atomic_store_explicit(&g_wakePending, false, memory_order_relaxed);
+
+        if (atomic_flag_test_and_set(&g_draining)) continue;
+        size_t written = HIAHDrain(batch, sizeof(batch));
+        HIAHReportDrops();
+        bool rotated = written > 0 && HIAHRotateIfNeeded();
+        atomic_flag_clear(&g_draining);
+        if (rotated) HIAHCompressRotated();
+    }
+    return NULL;
+}
+
+static int HIAHStreamWrite(void *cookie, const char *data, int length) {
+    (void)cookie;
+    HIAHExtensionLogAppend(data, (size_t)length);
+    return length;
+}
+
+static void HIAHStart(void) {
+    int fd = HIAHOpenLog();
+    if (fd < 0) return;
+    atomic_store_explicit(&g_fd, fd, memory_order_relaxed);
+
+    for (uint64_t i = 0; i < HIAH_LOG_SLOTS; i++) {
+        atomic_store_explicit(&g_slots[i].seq, i, memory_order_relaxed);
+    }
+
+    g_wake = dispatch_semaphore_create(0);
+    g_stream = funopen(NULL, NULL, HIAHStreamWrite, NULL, NULL);
+    // The ring is the buffer: stdio buffering would hold lines back until an
+    // fflush the callers may never make
+    if (g_stream) setvbuf(g_stream, NULL, _IONBF, 0);
+    atexit(HIAHExtensionLogFlushSync);
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_attr_set_qos_class_np(&attr, QOS_CLASS_UTILITY, 0);
+    pthread_t thread;
+    pthread_create(&thread, &attr, HIAHWriterMain, NULL);
+    pthread_attr_destroy(&attr);
+}
+
+FILE *HIAHExtensionLogOpen(const char *path) {
+    if (!g_path[0]) {
+        strlcpy(g_path, path, sizeof(g_path));
+    }
+    pthread_once(&g_once, HIAHStart);
+    return g_stream;
+}
@@ -0,0 +1,67 @@
+/**
+ * HIAHExtensionLog.h
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Asynchronous writer for the extension's App Group log file.
+ *
+ * Log lines are copied into a fixed, lock-free ring buffer and a background
+ * thread drains it to HIAHExtension.log every 100 ms (sooner when the ring
+ * is half full), so the launch path never waits on the container volume.
+ * When the ring is full, lines are dropped and counted rather than blocking,
+ * and the writer logs the count once it catches up. Crash handlers call
+ * HIAHExtensionLogFlushSync, which drains with plain write(2) calls. When
+ * the file passes 2 MB it is gzip-compressed to HIAHExtension.log.1.gz and
+ * up to three archives are kept.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#ifndef HIAH_EXTENSION_LOG_H
+#define HIAH_EXTENSION_LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Opens (appending) the log at `path` and starts the writer thread. A
+ * missing parent directory is created.
+ *
+ * Subsequent calls return the same stream. The returned FILE is unbuffered
+ * and backed by the ring buffer: each fprintf on it is queued at once, and
+ * never touches the disk directly.
+ *
+ * @return The stream, or NULL if the file could not be opened.
+ */
+FILE *HIAHExtensionLogOpen(const char *path);
+
+/**
+ * Queues `length` bytes for the log file. Never blocks.
+ */
+void HIAHExtensionLogAppend(const char *data, size_t length);
+
+/**
+ * Writes everything queued so far, on the calling thread.
+ *
+ * Waits (briefly, by yielding) for a drain already in progress on the
+ * writer thread; if that drain never finishes, nothing is written. Uses
+ * only write(2), sched_yield and atomics, so it may be called from a
+ * signal handler.
+ */
+void HIAHExtensionLogFlushSync(void);
+
+/**
+ * Lines and bytes discarded because the ring was full.
+ */
+void HIAHExtensionLogDropped(uint64_t *lines, uint64_t *bytes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HIAH_EXTENSION_LOG_H */
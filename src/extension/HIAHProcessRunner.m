@@ -14,20 +14,39 @@
 #ifdef HIAH_LIBRARY_MODE
 #import <HIAHKernel/HIAHBypassStatus.h>
 #import <HIAHKernel/HIAHDyldBypass.h>
+#import <HIAHKernel/HIAHExtensionRegistry.h>
 #import <HIAHKernel/HIAHHook.h>
+#import <HIAHKernel/HIAHHookStats.h>
+#import <HIAHKernel/HIAHJITReadiness.h>
+#import <HIAHKernel/HIAHLaunchMetadata.h>
+#import <HIAHKernel/HIAHLazyBundle.h>
+#import <HIAHKernel/HIAHMachOPrepare.h>
 #import <HIAHKernel/HIAHLogging.h>
 #import <HIAHKernel/HIAHMachOUtils.h>
+#import <HIAHKernel/HIAHMountTable.h>
+#import <HIAHKernel/HIAHPrefetch.h>
 #else
 #import "../HIAHDesktop/HIAHLogging.h"
 #import "../HIAHDesktop/HIAHMachOUtils.h"
 #import "../hooks/HIAHDyldBypass.h"
+#import "../hooks/HIAHExtensionRegistry.h"
 #import "../hooks/HIAHHook.h"
+#import "../hooks/HIAHHookStats.h"
+#import "../hooks/HIAHJITReadiness.h"
+#import "../hooks/HIAHLaunchMetadata.h"
+#import "../hooks/HIAHLazyBundle.h"
+#import "../hooks/HIAHMachOPrepare.h"
+#import "../hooks/HIAHMountTable.h"
+#import "../hooks/HIAHPrefetch.h"
 #import "HIAHBypassStatus.h"
 #endif
 
 #ifndef HIAH_LIBRARY_MODE
 #import "HIAHSigner.h"
 #endif
+#import "HIAHExtensionLog.h"
+#import "HIAHStartupTrace.h"
+#import <copyfile.h>
 #import <dlfcn.h>
 #import <mach-o/dyld.h>
 #import <mach-o/loader.h>
@@ -36,6 +55,8 @@
 #import <signal.h>
 #import <spawn.h>
 #import <stdarg.h>
+#import <stdatomic.h>
+#import <sys/stat.h>
 #import <sys/sysctl.h>
 
 #pragma mark - Logging
@@ -45,17 +66,90 @@ static HIAHLogSubsystem GetExtensionLog(void) { return HIAHLogExtension(); }
 // Forward declaration
 static FILE *GetExtensionLogFile(void);
 
+// App Group container path, looked up once; nil without an App Group
+static NSString *ExtensionGroupPath(void) {
+  static NSString *groupPath = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    uint64_t begin = HIAHStartupTraceBegin();
+    NSURL *groupURL = [[NSFileManager defaultManager]
+        containerURLForSecurityApplicationGroupIdentifier:
+            @"group.com.aspauldingcode.HIAHDesktop"];
+    groupPath = groupURL.path ?: @"";
+    HIAHStartupTraceEnd("App Group lookup", begin);
+  });
+  return groupPath.length ? groupPath : nil;
+}
+
+static NSString *ExtensionLogPath(void) {
+  NSString *groupPath = ExtensionGroupPath();
+  if (groupPath) {
+    return [[groupPath stringByAppendingPathComponent:@"HIAHExtension.log"]
+        stringByStandardizingPath];
+  }
+  return [NSTemporaryDirectory()
+      stringByAppendingPathComponent:@"HIAHExtension.log"];
+}
+
+// Set once the log file exists and has been caught up on the trace
+static _Atomic bool gExtensionLogOpened = false;
+
+// Writes the startup trace to the log file and stderr
+static void DumpStartupTrace(void) {
+  char trace[8192];
+  size_t length = HIAHStartupTraceFormat(trace, sizeof(trace));
+  if (length >= sizeof(trace)) {
+    length = sizeof(trace) - 1;
+  }
+  // Opening the log appends the trace itself; only write it here if the
+  // log was already open
+  bool wasOpen = atomic_load(&gExtensionLogOpened);
+  if (GetExtensionLogFile() && wasOpen) {
+    HIAHExtensionLogAppend(trace, length);
+  }
+  fwrite(trace, 1, length, stderr);
+  fflush(stderr);
+}
+
+static void DumpStartupTraceNotification(CFNotificationCenterRef center,
+                                         void *observer, CFStringRef name,
+                                         const void *object,
+                                         CFDictionaryRef userInfo) {
+  DumpStartupTrace();
+}
+
+// Publishes this process's hook stats for the kernel's hookstats command
+static void PublishHookStatsNotification(CFNotificationCenterRef center,
+                                         void *observer, CFStringRef name,
+                                         const void *object,
+                                         CFDictionaryRef userInfo) {
+  HIAHHookStatsExportPublish();
+}
+
+// When the spawn request arrived, for the request-to-guest-main span
+static uint64_t gRequestBegin = 0;
+
+// Shared table the kernel scans on ExtensionStarted notifications
+static HIAHExtensionRegistry *gExtensionRegistry = NULL;
+
+static void UnregisterExtension(void) {
+  HIAHExtensionRegistryUnregister(gExtensionRegistry, getpid());
+}
+
 // Force linkage of HIAHExtensionHandler class by referencing it
 static Class gHIAHExtensionHandlerClass = nil;
 
 // Signal handler to catch crashes
 static void signalHandler(int sig) {
-  FILE *logFile = GetExtensionLogFile();
-  if (logFile) {
-    fprintf(logFile, "[HIAHExtension] CRASH: Signal %d received (PID=%d)\n",
-            sig, getpid());
-    fflush(logFile);
-  }
+  // Queue the crash line behind everything still buffered, then write it
+  // all out synchronously before the process dies
+  char crashLine[96];
+  int crashLength =
+      snprintf(crashLine, sizeof(crashLine),
+               "[HIAHExtension] CRASH: Signal %d received (PID=%d)\n", sig,
+               getpid());
+  HIAHExtensionLogAppend(crashLine, (size_t)crashLength);
+  HIAHExtensionLogFlushSync();
   fprintf(stderr, "[HIAHExtension] CRASH: Signal %d received (PID=%d)\n", sig,
           getpid());
   fprintf(stdout, "[HIAHExtension] CRASH: Signal %d received (PID=%d)\n", sig,
@@ -68,6 +162,8 @@ static void signalHandler(int sig) {
 }
 
 __attribute__((constructor(101))) static void ExtensionStartup(void) {
+  uint64_t constructorBegin = HIAHStartupTraceBegin();
+
   // Install signal handlers to catch crashes
   signal(SIGABRT, signalHandler);
   signal(SIGSEGV, signalHandler);
@@ -75,33 +171,14 @@ __attribute__((constructor(101))) static void ExtensionStartup(void) {
   signal(SIGILL, signalHandler);
   signal(SIGFPE, signalHandler);
 
-  // Log to file immediately
-  NSFileManager *fm = [NSFileManager defaultManager];
-  NSURL *groupURL = [fm containerURLForSecurityApplicationGroupIdentifier:
-                            @"group.com.aspauldingcode.HIAHDesktop"];
-  NSString *logPath = nil;
-  if (groupURL) {
-    logPath =
-        [[groupURL.path stringByAppendingPathComponent:@"HIAHExtension.log"]
-            stringByStandardizingPath];
-    [fm createDirectoryAtPath:groupURL.path
-        withIntermediateDirectories:YES
-                         attributes:nil
-                              error:nil];
-  } else {
-    logPath = [NSTemporaryDirectory()
-        stringByAppendingPathComponent:@"HIAHExtension.log"];
-  }
-
-  FILE *logFile = fopen([logPath UTF8String], "a");
-  if (logFile) {
-    fprintf(logFile,
-            "[HIAHExtension] Extension loaded (constructor) (PID=%d)\n",
-            getpid());
-    fprintf(logFile, "[HIAHExtension] Log file: %s\n", [logPath UTF8String]);
-    fprintf(logFile, "[HIAHExtension] About to initialize dyld bypass...\n");
-    fflush(logFile);
-  }
+  // The log file is opened on first use (normally the spawn request); what
+  // happens before that is covered by the startup trace, which is written
+  // to the log when it opens
+  CFNotificationCenterAddObserver(
+      CFNotificationCenterGetDarwinNotifyCenter(), NULL,
+      DumpStartupTraceNotification,
+      CFSTR(HIAH_STARTUP_TRACE_DUMP_NOTIFICATION), NULL,
+      CFNotificationSuspensionBehaviorDeliverImmediately);
 
   fprintf(stderr, "[HIAHExtension] Extension loaded (PID=%d)\n", getpid());
   fprintf(stdout, "[HIAHExtension] Extension loaded (PID=%d)\n", getpid());
@@ -111,43 +188,52 @@ __attribute__((constructor(101))) static void ExtensionStartup(void) {
               getpid());
 
   // Notify main app that extension has started so it can enable JIT immediately
-  // Write PID to App Group storage with unique filename (PID-specific) to avoid
-  // overwrites Then post Darwin notification
+  // Register our PID in the shared extension registry (the kernel picks up
+  // only entries it has not handled yet), then post Darwin notification
   pid_t currentPID = getpid();
-  // Reuse existing fm and groupURL variables from above
-  if (groupURL) {
-    // Write to both the shared file (for backward compatibility) and a unique
-    // file
+  uint64_t registryBegin = HIAHStartupTraceBegin();
+  NSString *groupPath = ExtensionGroupPath();
+  if (groupPath) {
+    NSString *registryPath = [groupPath
+        stringByAppendingPathComponent:@HIAH_EXTENSION_REGISTRY_FILE];
+    gExtensionRegistry =
+        HIAHExtensionRegistryMap(registryPath.fileSystemRepresentation);
+    if (HIAHExtensionRegistryRegister(gExtensionRegistry, currentPID)) {
+      atexit(UnregisterExtension);
+    } else {
+      fprintf(stdout, "[HIAHExtension] WARNING: Could not register in "
+                      "extension registry\n");
+    }
+
+    // Hook stats are published only when the kernel asks for them
+    NSString *hookStatsDir =
+        [groupPath stringByAppendingPathComponent:@HIAH_HOOK_STATS_EXPORT_DIR];
+    if (HIAHHookStatsExportOpen(hookStatsDir.fileSystemRepresentation)) {
+      CFNotificationCenterAddObserver(
+          CFNotificationCenterGetDarwinNotifyCenter(), NULL,
+          PublishHookStatsNotification,
+          CFSTR(HIAH_HOOK_STATS_PUBLISH_NOTIFICATION), NULL,
+          CFNotificationSuspensionBehaviorDeliverImmediately);
+    }
+
+    // Shared PID file, read by the kernel only when the registry is
+    // unavailable
     NSString *pidFile =
-        [[groupURL.path stringByAppendingPathComponent:@"extension.pid"]
+        [[groupPath stringByAppendingPathComponent:@"extension.pid"]
             stringByStandardizingPath];
-    NSString *pidFileUnique = [[groupURL.path
-        stringByAppendingPathComponent:[NSString
-                                           stringWithFormat:@"extension.%d.pid",
-                                                            currentPID]]
-        stringByStandardizingPath];
-
-    // Write to shared file (may be overwritten by other extensions, but that's
-    // OK)
     [[NSString stringWithFormat:@"%d", currentPID]
         writeToFile:pidFile
          atomically:YES
            encoding:NSUTF8StringEncoding
               error:nil];
 
-    // Also write to unique file (won't be overwritten)
-    [[NSString stringWithFormat:@"%d", currentPID]
-        writeToFile:pidFileUnique
-         atomically:YES
-           encoding:NSUTF8StringEncoding
-              error:nil];
-
     fprintf(stdout,
-            "[HIAHExtension] Wrote PID to App Group storage (PID: %d, shared "
-            "file + unique file)\n",
+            "[HIAHExtension] Registered extension PID in App Group storage "
+            "(PID: %d)\n",
             currentPID);
     fflush(stdout);
   }
+  HIAHStartupTraceEnd("extension registry", registryBegin);
 
   // Post Darwin notification (main app will read PID from App Group storage)
   CFNotificationCenterRef center = CFNotificationCenterGetDarwinNotifyCenter();
@@ -167,53 +253,27 @@ __attribute__((constructor(101))) static void ExtensionStartup(void) {
   fprintf(stdout, "[HIAHExtension] Initializing dyld bypass...\n");
   fflush(stdout);
 
-  if (logFile) {
-    fprintf(logFile, "[HIAHExtension] Calling HIAHInitDyldBypass()...\n");
-    fflush(logFile);
-  }
-
+  uint64_t bypassBegin = HIAHStartupTraceBegin();
   @try {
     HIAHInitDyldBypass();
     fprintf(stdout, "[HIAHExtension] Dyld bypass initialized\n");
-    if (logFile) {
-      fprintf(logFile,
-              "[HIAHExtension] Dyld bypass initialized successfully\n");
-      fflush(logFile);
-    }
   } @catch (NSException *ex) {
     fprintf(stdout, "[HIAHExtension] ERROR: Dyld bypass failed: %s\n",
             [[ex description] UTF8String]);
-    if (logFile) {
-      fprintf(logFile, "[HIAHExtension] ERROR: Dyld bypass failed: %s\n",
-              [[ex description] UTF8String]);
-      fflush(logFile);
-    }
   }
   fflush(stdout);
+  HIAHStartupTraceEnd("dyld bypass", bypassBegin);
 
   // Check JIT status
   BOOL jitEnabled = HIAHIsJITEnabled();
   if (jitEnabled) {
     fprintf(stdout, "[HIAHExtension] ✓ JIT/CS_DEBUGGED enabled\n");
-    if (logFile) {
-      fprintf(logFile, "[HIAHExtension] ✓ JIT/CS_DEBUGGED enabled\n");
-      fflush(logFile);
-    }
   } else {
     fprintf(stdout, "[HIAHExtension] ⚠️  JIT not enabled - may have issues "
                     "loading .ipa apps\n");
-    if (logFile) {
-      fprintf(logFile, "[HIAHExtension] ⚠️  JIT not enabled - may have issues "
-                       "loading .ipa apps\n");
-      fflush(logFile);
-    }
   }
   fflush(stdout);
 
-  if (logFile) {
-    fclose(logFile);
-  }
-
   // Force class to load by referencing it (this ensures it's linked)
   gHIAHExtensionHandlerClass = NSClassFromString(@"HIAHExtensionHandler");
   if (gHIAHExtensionHandlerClass) {
@@ -231,6 +291,7 @@ __attribute__((constructor(101))) static void ExtensionStartup(void) {
     fflush(stdout);
     fflush(stderr);
   }
+  HIAHStartupTraceEnd("constructor", constructorBegin);
 }
 
 #pragma mark - UIApplicationMain Interception
@@ -279,6 +340,7 @@ static void InstallUIApplicationMainHook(void) {
   fprintf(stdout, "[HIAHExtension] Installing UIApplicationMain hook...\n");
   fflush(stdout);
 
+  uint64_t begin = HIAHStartupTraceBegin();
   gOriginalUIApplicationMain = dlsym(RTLD_DEFAULT, "UIApplicationMain");
 
   if (!gOriginalUIApplicationMain) {
@@ -287,6 +349,7 @@ static void InstallUIApplicationMainHook(void) {
     fflush(stdout);
     HIAHLogError(GetExtensionLog,
                  "UIApplicationMain not found (UIKit may not be loaded)");
+    HIAHStartupTraceEnd("UIApplicationMain hook", begin);
     return;
   }
 
@@ -310,6 +373,7 @@ static void InstallUIApplicationMainHook(void) {
     fflush(stdout);
     HIAHLogError(GetExtensionLog, "Failed to install hook (code: %d)", result);
   }
+  HIAHStartupTraceEnd("UIApplicationMain hook", begin);
 }
 
 #pragma mark - Bundle Override Support
@@ -356,29 +420,88 @@ static void OverrideMainBundle(NSBundle *guestBundle) {
 }
 
 /**
- * Override CFBundleGetMainBundle to point to the guest app's CFBundle.
- * This ensures CF-level bundle APIs also work correctly.
+ * Points NSBundle.mainBundle at the guest bundle without creating it; the
+ * NSBundle is built the first time something asks for it. Used for guests
+ * that don't link UIKit, many of which never ask.
  */
-static void OverrideCFBundle(NSBundle *guestBundle) {
-  if (!guestBundle)
-    return;
-
-  // Get the CFBundle from NSBundle using CFBundleCreate
-  CFBundleRef guestCFBundle = CFBundleCreate(
-      kCFAllocatorDefault,
-      (__bridge CFURLRef)[NSURL fileURLWithPath:guestBundle.bundlePath]);
-  if (!guestCFBundle) {
+static void OverrideMainBundleLazily(NSString *bundlePath) {
+  Method originalMethod =
+      class_getClassMethod([NSBundle class], @selector(mainBundle));
+  if (!originalMethod) {
     fprintf(stderr,
-            "[HIAHExtension] WARNING: Could not create CFBundle from path\n");
+            "[HIAHExtension] ERROR: Could not find mainBundle method\n");
+    fflush(stderr);
     return;
   }
 
-  fprintf(stdout, "[HIAHExtension] Created CFBundle for guest app\n");
+  static NSBundle *guestBundle = nil;
+  NSString *path = [bundlePath copy];
+  IMP newImplementation = imp_implementationWithBlock(^NSBundle * {
+    @synchronized(path) {
+      if (!guestBundle) {
+        uint64_t begin = HIAHStartupTraceBegin();
+        guestBundle = [NSBundle bundleWithPath:path];
+        HIAHStartupTraceEnd("lazy main bundle", begin);
+      }
+      return guestBundle;
+    }
+  });
+  method_setImplementation(originalMethod, newImplementation);
+
+  fprintf(stdout,
+          "[HIAHExtension] NSBundle.mainBundle will resolve to %s on first "
+          "use\n",
+          path.UTF8String);
   fflush(stdout);
+}
 
-  // Note: Actual override of CFBundleGetMainBundle would require hooking,
-  // which is complex. For now, we rely on NSBundle.mainBundle override.
-  CFRelease(guestCFBundle);
+/**
+ * Points CFBundleGetMainBundle at the guest bundle. The CFBundle is created
+ * the first time something asks for it, so guests that never do pay
+ * nothing. If no bundle can be created there, the host's is returned.
+ */
+static CFBundleRef (*gOriginalCFBundleGetMainBundle)(void) = NULL;
+static NSString *gGuestCFBundlePath = nil;
+
+static CFBundleRef InterceptedCFBundleGetMainBundle(void) {
+  static CFBundleRef guestCFBundle = NULL;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    uint64_t begin = HIAHStartupTraceBegin();
+    guestCFBundle = CFBundleCreate(
+        kCFAllocatorDefault,
+        (__bridge CFURLRef)[NSURL fileURLWithPath:gGuestCFBundlePath]);
+    HIAHStartupTraceEnd("lazy main CFBundle", begin);
+  });
+  return guestCFBundle ?: gOriginalCFBundleGetMainBundle();
+}
+
+// Rebinds the guest binary (and any later image) as well as those loaded now
+static void HookCFBundleGetMainBundleInImage(const struct mach_header *header,
+                                             intptr_t slide) {
+  HIAHHookIntercept(HIAHHookScopeImage, (const HIAHMachHeader *)header,
+                    gOriginalCFBundleGetMainBundle,
+                    InterceptedCFBundleGetMainBundle);
+}
+
+static void OverrideCFBundleLazily(NSString *bundlePath) {
+  if (!bundlePath || gOriginalCFBundleGetMainBundle) {
+    return;
+  }
+  gOriginalCFBundleGetMainBundle = dlsym(RTLD_DEFAULT, "CFBundleGetMainBundle");
+  if (!gOriginalCFBundleGetMainBundle) {
+    fprintf(stderr, "[HIAHExtension] ERROR: CFBundleGetMainBundle not found\n");
+    fflush(stderr);
+    return;
+  }
+  gGuestCFBundlePath = [bundlePath copy];
+  _dyld_register_func_for_add_image(HookCFBundleGetMainBundleInImage);
+
+  fprintf(stdout,
+          "[HIAHExtension] CFBundleGetMainBundle will resolve to %s on first "
+          "use\n",
+          gGuestCFBundlePath.UTF8String);
+  fflush(stdout);
 }
 
 #pragma mark - Environment Management
@@ -414,7 +537,7 @@ static void SetupEnvironment(NSDictionary *environment) {
     }
   }
 
-  HIAHLogDebug(GetExtensionLog, "Configured %{public}lu environment variables",
+  HIAHLogDebug(GetExtensionLog, "Configured %lu environment variables",
                (unsigned long)environment.count);
 }
 
@@ -424,7 +547,7 @@ static void *FindEntryPoint(void *dlHandle, NSString *binaryPath) {
   // Try dlsym first
   void *mainSymbol = dlsym(dlHandle, "main");
   if (mainSymbol) {
-    HIAHLogDebug(GetExtensionLog, "Found main() via dlsym at %{public}p",
+    HIAHLogDebug(GetExtensionLog, "Found main() via dlsym at %p",
                  mainSymbol);
     return mainSymbol;
   }
@@ -473,39 +596,49 @@ static FILE *GetExtensionLogFile(void) {
   static FILE *logFile = NULL;
   static dispatch_once_t onceToken;
   dispatch_once(&onceToken, ^{
-    NSFileManager *fm = [NSFileManager defaultManager];
-    NSURL *groupURL = [fm containerURLForSecurityApplicationGroupIdentifier:
-                              @"group.com.aspauldingcode.HIAHDesktop"];
-    NSString *logPath = nil;
-    if (groupURL) {
-      logPath =
-          [[groupURL.path stringByAppendingPathComponent:@"HIAHExtension.log"]
-              stringByStandardizingPath];
-      [fm createDirectoryAtPath:groupURL.path
-          withIntermediateDirectories:YES
-                           attributes:nil
-                                error:nil];
-    } else {
-      logPath = [NSTemporaryDirectory()
-          stringByAppendingPathComponent:@"HIAHExtension.log"];
+    uint64_t begin = HIAHStartupTraceBegin();
+    // Lines are queued in memory and written by a background thread; a
+    // missing container directory is created by the open itself
+    logFile = HIAHExtensionLogOpen(ExtensionLogPath().fileSystemRepresentation);
+    HIAHStartupTraceEnd("log file open", begin);
+
+    // Catch the log up on everything that ran before it existed
+    if (logFile) {
+      char opened[1024];
+      int openedLength = snprintf(opened, sizeof(opened),
+                                  "[HIAHExtension] Log file opened (PID=%d): %s\n",
+                                  getpid(), ExtensionLogPath().UTF8String);
+      if (openedLength > 0) {
+        HIAHExtensionLogAppend(opened, MIN((size_t)openedLength, sizeof(opened) - 1));
+      }
+      char trace[8192];
+      size_t length = HIAHStartupTraceFormat(trace, sizeof(trace));
+      HIAHExtensionLogAppend(trace, MIN(length, sizeof(trace) - 1));
     }
-    logFile = fopen([logPath UTF8String], "a");
+    atomic_store(&gExtensionLogOpened, true);
   });
   return logFile;
 }
 
 static void ExtLog(FILE *logFile, const char *fmt, ...) {
+  char line[1024];
   va_list args;
   va_start(args, fmt);
-  vfprintf(stdout, fmt, args);
+  int length = vsnprintf(line, sizeof(line), fmt, args);
   va_end(args);
+  if (length < 0) {
+    return;
+  }
+  if ((size_t)length >= sizeof(line)) {
+    length = sizeof(line) - 1;
+  }
+
+  fwrite(line, 1, (size_t)length, stdout);
   fflush(stdout);
 
+  // Bypass the stdio stream: straight into the log ring buffer
   if (logFile) {
-    va_start(args, fmt);
-    vfprintf(logFile, fmt, args);
-    va_end(args);
-    fflush(logFile);
+    HIAHExtensionLogAppend(line, (size_t)length);
   }
 }
 
@@ -513,9 +646,147 @@ static void ExtLog(FILE *logFile, const char *fmt, ...) {
 static void continueBinaryLoadingWithBypass(NSString *executablePath,
                                             FILE *logFile, BOOL vpnActive,
                                             BOOL jitActive, BOOL useJITLessMode,
+                                            BOOL jitLessPrepared,
                                             NSFileManager *fm,
+                                            HIAHLaunchMetadata *launchMetadata,
                                             NSArray *arguments);
 
+// Patches and signs a binary for JIT-less loading (MH_EXECUTE to MH_BUNDLE,
+// certificate or ad-hoc signature). Returns NO if every signing attempt
+// failed.
+static BOOL PrepareBinaryForJITLessMode(NSString *executablePath,
+                                        FILE *logFile) {
+  // Installs prepare binaries while extracting them (see HIAHMachOPrepare)
+  if (HIAHMachOIsPrepared(executablePath.fileSystemRepresentation)) {
+    ExtLog(logFile, "[HIAHExtension] ✅ Binary was prepared at install time "
+                    "(MH_BUNDLE + __PAGEZERO + ad-hoc signature)\n");
+    return YES;
+  }
+
+  // Step 1: Patch binary for JIT-less mode (MH_EXECUTE to MH_BUNDLE, patch
+  // __PAGEZERO)
+  ExtLog(logFile,
+         "[HIAHExtension] Step 1: Patching binary for JIT-less mode...\n");
+  if ([HIAHMachOUtils patchBinaryForJITLessMode:executablePath]) {
+    ExtLog(logFile, "[HIAHExtension] ✅ Binary patched for JIT-less mode "
+                    "(MH_BUNDLE + __PAGEZERO)\n");
+  } else {
+    ExtLog(
+        logFile,
+        "[HIAHExtension] ⚠️ Binary patching failed - trying basic patch...\n");
+    // Fallback to basic patch
+    [HIAHMachOUtils patchBinaryToDylib:executablePath];
+  }
+
+  // Step 2: Remove existing signature (required before signing)
+  ExtLog(logFile,
+         "[HIAHExtension] Step 2: Removing existing code signature...\n");
+  BOOL signatureRemoved = [HIAHMachOUtils removeCodeSignature:executablePath];
+  if (signatureRemoved) {
+    ExtLog(logFile, "[HIAHExtension] ✅ Code signature removed\n");
+  } else {
+    ExtLog(logFile,
+           "[HIAHExtension] ⚠️ Code signature removal failed or not found\n");
+  }
+
+  // Step 3: Sign with certificate from SideStore (or ad-hoc if certificate
+  // not available)
+  ExtLog(logFile, "[HIAHExtension] Step 3: Signing binary with certificate "
+                  "from SideStore...\n");
+  BOOL signingSuccess = NO;
+#ifndef HIAH_LIBRARY_MODE
+  signingSuccess = [HIAHSigner signBinaryAtPath:executablePath];
+#else
+  ExtLog(logFile, "[HIAHExtension] HIAH_LIBRARY_MODE active: HIAHSigner "
+                  "disabled. Skipping cert signing.\n");
+#endif
+
+  if (signingSuccess) {
+    ExtLog(logFile, "[HIAHExtension] ✅ Binary signed successfully (JIT-less "
+                    "mode ready)\n");
+  } else {
+    ExtLog(logFile, "[HIAHExtension] ❌ Binary signing failed - trying "
+                    "ad-hoc signing...\n");
+    // Try ad-hoc signing as last resort
+    NSString *codesignPath = @"/usr/bin/codesign";
+    if ([[NSFileManager defaultManager] fileExistsAtPath:codesignPath]) {
+      const char *codesignPathC = [codesignPath UTF8String];
+      const char *pathC = [executablePath UTF8String];
+
+      char *argv[] = {(char *)codesignPathC,
+                      "--force",
+                      "--sign",
+                      "-", // Ad-hoc signing
+                      (char *)pathC,
+                      NULL};
+
+      pid_t pid;
+      int status_code;
+      int result = posix_spawn(&pid, codesignPathC, NULL, NULL, argv, NULL);
+
+      if (result == 0) {
+        waitpid(pid, &status_code, 0);
+        if (WIFEXITED(status_code) && WEXITSTATUS(status_code) == 0) {
+          ExtLog(logFile,
+                 "[HIAHExtension] ✅ Binary ad-hoc signed successfully\n");
+          signingSuccess = YES;
+        } else {
+          ExtLog(logFile,
+                 "[HIAHExtension] ❌ Ad-hoc signing also failed (exit: %d)\n",
+                 WEXITSTATUS(status_code));
+        }
+      } else {
+        ExtLog(logFile, "[HIAHExtension] ❌ Failed to spawn codesign: %s\n",
+               strerror(result));
+      }
+    } else {
+      ExtLog(logFile, "[HIAHExtension] ❌ codesign not available\n");
+    }
+
+    if (!signingSuccess) {
+      ExtLog(logFile, "[HIAHExtension] ⚠️ All signing attempts failed - "
+                      "dlopen will likely fail\n");
+      ExtLog(logFile, "[HIAHExtension] ⚠️ Make sure you're signed into HIAH "
+                      "LoginWindow with SideStore\n");
+    }
+  }
+
+  return signingSuccess;
+}
+
+// Staged copies live next to the binary so the final rename stays on one
+// volume: <dir>/.hiah-jitless/<name>
+static NSString *JITLessStagingPath(NSString *executablePath) {
+  NSString *dir = [[executablePath stringByDeletingLastPathComponent]
+      stringByAppendingPathComponent:@".hiah-jitless"];
+  return [dir stringByAppendingPathComponent:executablePath.lastPathComponent];
+}
+
+// Speculative JIT-less preparation on a copy of the binary, so the original
+// stays usable if JIT attaches first. Gives up as soon as JIT is active.
+static BOOL StageJITLessBinary(NSString *executablePath, NSString *stagedPath,
+                               FILE *logFile) {
+  const char *staged = stagedPath.fileSystemRepresentation;
+  mkdir(stagedPath.stringByDeletingLastPathComponent.fileSystemRepresentation,
+        0755);
+  unlink(staged);
+
+  // APFS clones make the copy O(1); other volumes fall back to a full copy
+  if (copyfile(executablePath.fileSystemRepresentation, staged, NULL,
+               COPYFILE_ALL | COPYFILE_CLONE) != 0) {
+    ExtLog(logFile, "[HIAHExtension] ⚠️ Could not stage binary for JIT-less "
+                    "preparation: %s\n",
+           strerror(errno));
+    return NO;
+  }
+  if (HIAHJITIsActive(getpid())) {
+    return NO;
+  }
+
+  BOOL signedOK = PrepareBinaryForJITLessMode(stagedPath, logFile);
+  return signedOK && !HIAHJITIsActive(getpid());
+}
+
 static void ExecuteGuestApplication(NSDictionary *spawnRequest) {
   FILE *logFile = GetExtensionLogFile();
   ExtLog(logFile, "[HIAHExtension] ========================================\n");
@@ -601,81 +872,51 @@ static void ExecuteGuestApplication(NSDictionary *spawnRequest) {
     SetupEnvironment(environment);
   }
 
+  // Mount the desktop's virtual tree, so guests see the same /bin, /etc and
+  // /home here. The whole process is the guest: every thread is translated.
+  NSString *groupPath = ExtensionGroupPath();
+  if (groupPath) {
+    NSString *tablePath =
+        [groupPath stringByAppendingPathComponent:@HIAH_MOUNT_TABLE_FILE];
+    int mountError = HIAHMountLoad(tablePath.fileSystemRepresentation);
+    if (mountError) {
+      ExtLog(logFile, "[HIAHExtension] Mount table not loaded: %s\n",
+             strerror(mountError));
+    }
+    HIAHMountStats mountStats;
+    HIAHMountGetStats(&mountStats);
+    if (mountStats.mounts > 0) {
+      ExtLog(logFile, "[HIAHExtension] Mounted %u virtual directories\n",
+             mountStats.mounts);
+      HIAHMountInstallHooks();
+    }
+  }
+
   // Resolve the actual executable path
   // If we receive a path to a .app bundle, we need to find the executable
-  // inside it
+  // inside it. Bundle metadata is cached per Info.plist version in the App
+  // Group, so repeat launches skip the plist parse and candidate stats.
   NSFileManager *fm = [NSFileManager defaultManager];
-  NSString *actualExecutablePath = executablePath;
-
-  BOOL isDir = NO;
-  if ([fm fileExistsAtPath:executablePath isDirectory:&isDir] && isDir) {
-    // We were given a .app bundle, need to find the executable
-    ExtLog(
-        logFile,
-        "[HIAHExtension] Received .app bundle path, locating executable...\n");
-
-    NSString *infoPlistPath =
-        [executablePath stringByAppendingPathComponent:@"Info.plist"];
-    NSDictionary *infoPlist =
-        [NSDictionary dictionaryWithContentsOfFile:infoPlistPath];
-    NSString *executableName = infoPlist[@"CFBundleExecutable"];
-
-    if (executableName) {
-      // Try direct path: App.app/ExecutableName
-      NSString *candidatePath =
-          [executablePath stringByAppendingPathComponent:executableName];
-      if ([fm fileExistsAtPath:candidatePath]) {
-        actualExecutablePath = candidatePath;
-        ExtLog(logFile, "[HIAHExtension] Found executable at: %s\n",
-               [actualExecutablePath UTF8String]);
-      } else {
-        // Try macOS-style path: App.app/Contents/MacOS/ExecutableName
-        candidatePath =
-            [executablePath stringByAppendingPathComponent:@"Contents/MacOS"];
-        candidatePath =
-            [candidatePath stringByAppendingPathComponent:executableName];
-        if ([fm fileExistsAtPath:candidatePath]) {
-          actualExecutablePath = candidatePath;
-          ExtLog(logFile, "[HIAHExtension] Found executable at: %s\n",
-                 [actualExecutablePath UTF8String]);
-        } else {
-          ExtLog(logFile,
-                 "[HIAHExtension] ERROR: Could not find executable '%s' in "
-                 "bundle\n",
-                 [executableName UTF8String]);
-          HIAHLogError(GetExtensionLog, "Could not find executable in bundle");
-          return;
-        }
-      }
-    } else {
-      ExtLog(logFile,
-             "[HIAHExtension] ERROR: No CFBundleExecutable in Info.plist\n");
-      HIAHLogError(GetExtensionLog, "No CFBundleExecutable in Info.plist");
-      return;
-    }
-  } else if (![fm fileExistsAtPath:executablePath]) {
-    ExtLog(logFile, "[HIAHExtension] ERROR: Path does not exist: %s\n",
-           [executablePath UTF8String]);
-    HIAHLogError(GetExtensionLog, "Executable path does not exist: %s",
-                 [executablePath UTF8String]);
+  NSError *resolveError = nil;
+  uint64_t resolveBegin = HIAHStartupTraceBegin();
+  HIAHLaunchMetadata *launchMetadata = [HIAHLaunchMetadata
+         metadataForPath:executablePath
+      appGroupIdentifier:@"group.com.aspauldingcode.HIAHDesktop"
+                   error:&resolveError];
+  HIAHStartupTraceEnd("launch metadata", resolveBegin);
+  if (!launchMetadata) {
+    ExtLog(logFile, "[HIAHExtension] ERROR: %s\n",
+           resolveError.localizedDescription.UTF8String);
+    HIAHLogError(GetExtensionLog, "Could not resolve executable: %s",
+                 resolveError.localizedDescription.UTF8String);
     return;
   }
 
   // Update executablePath to the actual binary
-  executablePath = actualExecutablePath;
-  ExtLog(logFile, "[HIAHExtension] Final executable path: %s\n",
-         [executablePath UTF8String]);
-
-  BOOL exists = [fm fileExistsAtPath:executablePath];
-  ExtLog(logFile, "[HIAHExtension] Binary exists: %s\n", exists ? "YES" : "NO");
-
-  if (!exists) {
-    ExtLog(logFile, "[HIAHExtension] ERROR: Binary not found at: %s\n",
-           [executablePath UTF8String]);
-    HIAHLogError(GetExtensionLog, "Binary not found at: %s",
-                 [executablePath UTF8String]);
-    return;
-  }
+  executablePath = launchMetadata.executablePath;
+  ExtLog(logFile, "[HIAHExtension] Final executable path: %s (%s)\n",
+         [executablePath UTF8String],
+         launchMetadata.cached ? "cached metadata" : "resolved");
 
   // CRITICAL: Prepare binary for dlopen using signature bypass
   // This ensures VPN is active, JIT is enabled, and binary is signed if needed
@@ -709,9 +950,11 @@ static void ExecuteGuestApplication(NSDictionary *spawnRequest) {
   }
 
   // Check VPN status (can use bypass status for this)
+  uint64_t statusBegin = HIAHStartupTraceBegin();
   HIAHBypassStatus *bypassStatus = [HIAHBypassStatus sharedStatus];
   [bypassStatus refreshStatus];
   BOOL vpnActive = bypassStatus.isVPNActive;
+  HIAHStartupTraceEnd("bypass status", statusBegin);
 
   ExtLog(logFile,
          "[HIAHExtension] Initial bypass status - VPN: %s, JIT: %s (direct "
@@ -720,45 +963,93 @@ static void ExecuteGuestApplication(NSDictionary *spawnRequest) {
 
   // JIT-LESS MODE: If JIT is not available, use certificate signing instead
   // This allows apps to launch even without JIT enabled (like LiveContainer)
-  // We'll wait a short time for JIT, but if it doesn't come, we'll use JIT-less
-  // mode
+  // JIT attachment is delivered as a Darwin notification by the enabler while
+  // JIT-less preparation runs speculatively on a staged copy; whichever
+  // finishes first decides the mode, bounded by a 2 second deadline.
 
   BOOL useJITLessMode = NO;
+  BOOL jitLessPrepared = NO;
 
   if (vpnActive && !jitActive) {
-    // Wait a short time (2 seconds) for JIT to be enabled
-    // If JIT doesn't come, we'll use JIT-less mode with certificate signing
-    ExtLog(logFile, "[HIAHExtension] JIT not enabled yet - waiting briefly (2 "
-                    "seconds) for JIT...\n");
-
-    const int quickRetries = 4; // 4 * 500ms = 2 seconds
-    BOOL jitFound = NO;
-
-    for (int retry = 0; retry < quickRetries; retry++) {
-      usleep(500000); // 500ms delay
-
-      int checkFlags = 0;
-      if (csops(getpid(), CS_OPS_STATUS, &checkFlags, sizeof(checkFlags)) ==
-          0) {
-        if (checkFlags & CS_DEBUGGED) {
-          jitActive = YES;
-          jitFound = YES;
-          ExtLog(logFile,
-                 "[HIAHExtension] ✅ JIT enabled after %d retries - using JIT "
-                 "mode\n",
-                 retry + 1);
-          break;
-        }
+    ExtLog(logFile, "[HIAHExtension] JIT not enabled yet - waiting up to 2 "
+                    "seconds for JIT while preparing JIT-less mode...\n");
+
+    CFAbsoluteTime waitStart = CFAbsoluteTimeGetCurrent();
+    dispatch_semaphore_t wake = dispatch_semaphore_create(0);
+    int jitToken = HIAHJITRegisterReadyHandler(
+        currentPID, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+          dispatch_semaphore_signal(wake);
+        });
+
+    NSString *stagedPath = JITLessStagingPath(executablePath);
+    __block BOOL stagedReady = NO;
+    dispatch_group_t staging = dispatch_group_create();
+    dispatch_group_async(
+        staging, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+          stagedReady =
+              StageJITLessBinary(executablePath, stagedPath, logFile);
+          dispatch_semaphore_signal(wake);
+        });
+
+    // Re-check after registering so an attach in between is not missed.
+    // Debuggers attached by other tools never post, so csops is also
+    // re-checked on every wake and at least every 250ms.
+    dispatch_time_t deadline =
+        dispatch_time(DISPATCH_TIME_NOW, 2 * NSEC_PER_SEC);
+    BOOL stagingDone = NO;
+    while (!(jitActive = HIAHJITIsActive(currentPID))) {
+      if (dispatch_group_wait(staging, DISPATCH_TIME_NOW) == 0) {
+        stagingDone = YES;
+        break;
+      }
+      dispatch_time_t slice =
+          dispatch_time(DISPATCH_TIME_NOW, 250 * NSEC_PER_MSEC);
+      if (dispatch_semaphore_wait(wake, MIN(slice, deadline)) != 0 &&
+          dispatch_time(DISPATCH_TIME_NOW, 0) >= deadline) {
+        jitActive = HIAHJITIsActive(currentPID);
+        break;
       }
     }
+    HIAHJITCancelReadyHandler(jitToken);
+
+    double waitedMs = (CFAbsoluteTimeGetCurrent() - waitStart) * 1000.0;
+    if (jitActive) {
+      ExtLog(logFile,
+             "[HIAHExtension] ✅ JIT enabled after %.0f ms - using JIT mode\n",
+             waitedMs);
+      // The staged copy is unused; drop it once staging stops
+      dispatch_group_notify(
+          staging, dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+            unlink(stagedPath.fileSystemRepresentation);
+            rmdir(stagedPath.stringByDeletingLastPathComponent
+                      .fileSystemRepresentation);
+          });
+    } else {
+      if (!stagingDone) {
+        ExtLog(logFile, "[HIAHExtension] JIT not enabled after %.0f ms - "
+                        "finishing JIT-less preparation\n",
+               waitedMs);
+        dispatch_group_wait(staging, DISPATCH_TIME_FOREVER);
+      } else {
+        ExtLog(logFile,
+               "[HIAHExtension] JIT-less preparation finished first (%.0f ms) "
+               "- using JIT-less mode\n",
+               waitedMs);
+      }
 
-    if (!jitFound) {
-      ExtLog(logFile, "[HIAHExtension] JIT not enabled after 2 seconds - using "
-                      "JIT-less mode\n");
-      ExtLog(logFile, "[HIAHExtension] Will patch binary and sign with "
-                      "certificate from SideStore\n");
       useJITLessMode = YES;
+      if (stagedReady && rename(stagedPath.fileSystemRepresentation,
+                                executablePath.fileSystemRepresentation) == 0) {
+        jitLessPrepared = YES;
+      } else {
+        // Staging failed; prepare in place as before
+        unlink(stagedPath.fileSystemRepresentation);
+      }
+      rmdir(stagedPath.stringByDeletingLastPathComponent
+                .fileSystemRepresentation);
     }
+    HIAHLogInfo(GetExtensionLog, "JIT decision after %.0f ms: %s", waitedMs,
+                jitActive ? "JIT" : "JIT-less");
   } else if (!vpnActive) {
     // VPN not active - can't use JIT or JIT-less mode
     ExtLog(
@@ -766,6 +1057,16 @@ static void ExecuteGuestApplication(NSDictionary *spawnRequest) {
         "[HIAHExtension] ⚠️ VPN not active - cannot use JIT or JIT-less mode\n");
   }
 
+  if (jitActive) {
+    HIAHExtensionRegistrySetFlags(gExtensionRegistry, currentPID,
+                                  HIAHExtensionFlagJITEnabled);
+    // Wakes an enabler still waiting for its attach to land
+    HIAHJITPostReady(currentPID);
+  } else if (useJITLessMode) {
+    // Prepared for JIT-less mode; a late attach would only cost time
+    HIAHJITPostDeclined(currentPID);
+  }
+
   // If JIT is enabled, ensure dyld bypass is active
   if (jitActive && vpnActive) {
     ExtLog(
@@ -784,14 +1085,17 @@ static void ExecuteGuestApplication(NSDictionary *spawnRequest) {
 
   // Continue with binary loading
   continueBinaryLoadingWithBypass(executablePath, logFile, vpnActive, jitActive,
-                                  useJITLessMode, fm, arguments);
+                                  useJITLessMode, jitLessPrepared, fm,
+                                  launchMetadata, arguments);
 }
 
 // Helper function to continue binary loading after JIT check
 static void continueBinaryLoadingWithBypass(NSString *executablePath,
                                             FILE *logFile, BOOL vpnActive,
                                             BOOL jitActive, BOOL useJITLessMode,
+                                            BOOL jitLessPrepared,
                                             NSFileManager *fm,
+                                            HIAHLaunchMetadata *launchMetadata,
                                             NSArray *arguments) {
   BOOL canUseBypass = (jitActive && vpnActive);
 
@@ -805,92 +1109,11 @@ static void continueBinaryLoadingWithBypass(NSString *executablePath,
     ExtLog(logFile,
            "[HIAHExtension] ========================================\n");
 
-    // Step 1: Patch binary for JIT-less mode (MH_EXECUTE to MH_BUNDLE, patch
-    // __PAGEZERO)
-    ExtLog(logFile,
-           "[HIAHExtension] Step 1: Patching binary for JIT-less mode...\n");
-    if ([HIAHMachOUtils patchBinaryForJITLessMode:executablePath]) {
-      ExtLog(logFile, "[HIAHExtension] ✅ Binary patched for JIT-less mode "
-                      "(MH_BUNDLE + __PAGEZERO)\n");
-    } else {
-      ExtLog(
-          logFile,
-          "[HIAHExtension] ⚠️ Binary patching failed - trying basic patch...\n");
-      // Fallback to basic patch
-      [HIAHMachOUtils patchBinaryToDylib:executablePath];
-    }
-
-    // Step 2: Remove existing signature (required before signing)
-    ExtLog(logFile,
-           "[HIAHExtension] Step 2: Removing existing code signature...\n");
-    BOOL signatureRemoved = [HIAHMachOUtils removeCodeSignature:executablePath];
-    if (signatureRemoved) {
-      ExtLog(logFile, "[HIAHExtension] ✅ Code signature removed\n");
+    if (!jitLessPrepared) {
+      PrepareBinaryForJITLessMode(executablePath, logFile);
     } else {
-      ExtLog(logFile,
-             "[HIAHExtension] ⚠️ Code signature removal failed or not found\n");
-    }
-
-    // Step 3: Sign with certificate from SideStore (or ad-hoc if certificate
-    // not available)
-    ExtLog(logFile, "[HIAHExtension] Step 3: Signing binary with certificate "
-                    "from SideStore...\n");
-    BOOL signingSuccess = NO;
-#ifndef HIAH_LIBRARY_MODE
-    signingSuccess = [HIAHSigner signBinaryAtPath:executablePath];
-#else
-    ExtLog(logFile, "[HIAHExtension] HIAH_LIBRARY_MODE active: HIAHSigner "
-                    "disabled. Skipping cert signing.\n");
-#endif
-
-    if (signingSuccess) {
-      ExtLog(logFile, "[HIAHExtension] ✅ Binary signed successfully (JIT-less "
-                      "mode ready)\n");
-    } else {
-      ExtLog(logFile, "[HIAHExtension] ❌ Binary signing failed - trying "
-                      "ad-hoc signing...\n");
-      // Try ad-hoc signing as last resort
-      NSString *codesignPath = @"/usr/bin/codesign";
-      if ([[NSFileManager defaultManager] fileExistsAtPath:codesignPath]) {
-        const char *codesignPathC = [codesignPath UTF8String];
-        const char *pathC = [executablePath UTF8String];
-
-        char *argv[] = {(char *)codesignPathC,
-                        "--force",
-                        "--sign",
-                        "-", // Ad-hoc signing
-                        (char *)pathC,
-                        NULL};
-
-        pid_t pid;
-        int status_code;
-        int result = posix_spawn(&pid, codesignPathC, NULL, NULL, argv, NULL);
-
-        if (result == 0) {
-          waitpid(pid, &status_code, 0);
-          if (WIFEXITED(status_code) && WEXITSTATUS(status_code) == 0) {
-            ExtLog(logFile,
-                   "[HIAHExtension] ✅ Binary ad-hoc signed successfully\n");
-            signingSuccess = YES;
-          } else {
-            ExtLog(logFile,
-                   "[HIAHExtension] ❌ Ad-hoc signing also failed (exit: %d)\n",
-                   WEXITSTATUS(status_code));
-          }
-        } else {
-          ExtLog(logFile, "[HIAHExtension] ❌ Failed to spawn codesign: %s\n",
-                 strerror(result));
-        }
-      } else {
-        ExtLog(logFile, "[HIAHExtension] ❌ codesign not available\n");
-      }
-
-      if (!signingSuccess) {
-        ExtLog(logFile, "[HIAHExtension] ⚠️ All signing attempts failed - "
-                        "dlopen will likely fail\n");
-        ExtLog(logFile, "[HIAHExtension] ⚠️ Make sure you're signed into HIAH "
-                        "LoginWindow with SideStore\n");
-      }
+      ExtLog(logFile, "[HIAHExtension] Using speculatively prepared JIT-less "
+                      "binary\n");
     }
   } else if (canUseBypass) {
     // JIT MODE: Use signature bypass (remove signature, rely on dyld bypass
@@ -1015,85 +1238,50 @@ static void continueBinaryLoadingWithBypass(NSString *executablePath,
   // 2. iOS-style path: /path/to/App.app/Contents/MacOS/AppBinary (rare on iOS)
   // 3. Just the executable itself (for bundled apps)
 
-  NSString *appBundlePath = nil;
-
-  // Walk up the directory tree to find the .app bundle
-  NSString *searchPath = executablePath;
-  while (searchPath.length > 1) {
-    if ([searchPath hasSuffix:@".app"]) {
-      appBundlePath = searchPath;
-      break;
-    }
-    searchPath = [searchPath stringByDeletingLastPathComponent];
-
-    // Stop if we've gone too far up
-    if ([searchPath isEqualToString:@"/"] || searchPath.length == 0) {
-      break;
-    }
-  }
-
-  // If we couldn't find .app in the path, assume the executable is inside an
-  // .app bundle
+  NSString *appBundlePath = launchMetadata.bundlePath;
   if (!appBundlePath) {
-    // Try assuming it's directly in the .app bundle
-    appBundlePath = [executablePath stringByDeletingLastPathComponent];
-    if (![appBundlePath hasSuffix:@".app"]) {
-      // Not found, this might be a problem
-      ExtLog(logFile,
-             "[HIAHExtension] WARNING: Could not determine .app bundle path "
-             "from %s\n",
-             [executablePath UTF8String]);
-      appBundlePath = executablePath; // Fallback
-    }
+    // Not inside a .app, this might be a problem
+    ExtLog(logFile,
+           "[HIAHExtension] WARNING: Could not determine .app bundle path "
+           "from %s\n",
+           [executablePath UTF8String]);
+    appBundlePath = executablePath; // Fallback
   }
 
   ExtLog(logFile, "[HIAHExtension] Guest app bundle path: %s\n",
          [appBundlePath UTF8String]);
-
-  // Verify the bundle exists
-  BOOL isBundleDir = NO;
-  if (![fm fileExistsAtPath:appBundlePath isDirectory:&isBundleDir] ||
-      !isBundleDir) {
-    ExtLog(logFile,
-           "[HIAHExtension] ERROR: Bundle path does not exist or is not a "
-           "directory: %s\n",
-           [appBundlePath UTF8String]);
+  ExtLog(logFile, "[HIAHExtension]   Bundle ID: %s\n",
+         launchMetadata.bundleIdentifier
+             ? launchMetadata.bundleIdentifier.UTF8String
+             : "(none)");
+  ExtLog(logFile, "[HIAHExtension]   Bundle Name: %s\n",
+         launchMetadata.bundleName ? launchMetadata.bundleName.UTF8String
+                                   : "(none)");
+  ExtLog(logFile, "[HIAHExtension]   Entitlements: %lu keys\n",
+         (unsigned long)launchMetadata.entitlements.count);
+
+  // Bundles installed from an archive keep most resources in the .ipa;
+  // the file hooks extract them as the guest (or NSBundle) opens them
+  if (launchMetadata.bundlePath &&
+      HIAHLazyBundleMount(launchMetadata.bundlePath.fileSystemRepresentation)) {
+    ExtLog(logFile, "[HIAHExtension] Lazy bundle mounted - serving resources "
+                    "from the archive\n");
+    HIAHLazyBundleInstallHooks();
   }
 
-  // Load the Info.plist to get bundle information
-  NSString *infoPlistPath =
-      [appBundlePath stringByAppendingPathComponent:@"Info.plist"];
-  NSDictionary *bundleInfo = nil;
-  if ([fm fileExistsAtPath:infoPlistPath]) {
-    bundleInfo = [NSDictionary dictionaryWithContentsOfFile:infoPlistPath];
-    if (bundleInfo) {
-      ExtLog(logFile, "[HIAHExtension] Loaded Info.plist: %lu keys\n",
-             (unsigned long)bundleInfo.count);
-      ExtLog(logFile, "[HIAHExtension]   Bundle ID: %s\n",
-             bundleInfo[@"CFBundleIdentifier"]
-                 ? [bundleInfo[@"CFBundleIdentifier"] UTF8String]
-                 : "(none)");
-      ExtLog(logFile, "[HIAHExtension]   Bundle Name: %s\n",
-             bundleInfo[@"CFBundleName"]
-                 ? [bundleInfo[@"CFBundleName"] UTF8String]
-                 : "(none)");
-      ExtLog(logFile, "[HIAHExtension]   Executable: %s\n",
-             bundleInfo[@"CFBundleExecutable"]
-                 ? [bundleInfo[@"CFBundleExecutable"] UTF8String]
-                 : "(none)");
-    } else {
-      ExtLog(logFile,
-             "[HIAHExtension] WARNING: Could not parse Info.plist at %s\n",
-             [infoPlistPath UTF8String]);
+  // Load the app bundle to make resources available. Guests that don't
+  // link UIKit (command-line tools) get lazily created main bundles and no
+  // UIApplicationMain setup.
+  uint64_t bundleBegin = HIAHStartupTraceBegin();
+  NSBundle *guestBundle = nil;
+  if (!launchMetadata.usesUIKit) {
+    ExtLog(logFile, "[HIAHExtension] Guest does not link UIKit - deferring "
+                    "bundle setup\n");
+    if (launchMetadata.bundlePath) {
+      OverrideMainBundleLazily(launchMetadata.bundlePath);
+      OverrideCFBundleLazily(launchMetadata.bundlePath);
     }
-  } else {
-    ExtLog(logFile, "[HIAHExtension] WARNING: Info.plist not found at %s\n",
-           [infoPlistPath UTF8String]);
-  }
-
-  // Load the app bundle to make resources available
-  NSBundle *guestBundle = [NSBundle bundleWithPath:appBundlePath];
-  if (guestBundle) {
+  } else if ((guestBundle = [NSBundle bundleWithPath:appBundlePath])) {
     ExtLog(logFile, "[HIAHExtension] Guest bundle loaded successfully\n");
     ExtLog(logFile, "[HIAHExtension]   Bundle path: %s\n",
            [guestBundle.bundlePath UTF8String]);
@@ -1113,7 +1301,7 @@ static void continueBinaryLoadingWithBypass(NSString *executablePath,
     ExtLog(logFile, "[HIAHExtension] Overriding NSBundle.mainBundle to point "
                     "to guest app...\n");
     OverrideMainBundle(guestBundle);
-    OverrideCFBundle(guestBundle);
+    OverrideCFBundleLazily(guestBundle.bundlePath);
 
     // Preload the bundle to ensure resources are available
     [guestBundle load];
@@ -1123,11 +1311,14 @@ static void continueBinaryLoadingWithBypass(NSString *executablePath,
            "[HIAHExtension] WARNING: Could not create NSBundle for path: %s\n",
            [appBundlePath UTF8String]);
   }
+  HIAHStartupTraceEnd("bundle setup", bundleBegin);
 
   // Install UIApplicationMain hook BEFORE loading the guest binary
   // This ensures the hook is in place when the guest app's code runs
-  ExtLog(logFile, "[HIAHExtension] Installing UIApplicationMain hook...\n");
-  InstallUIApplicationMainHook();
+  if (launchMetadata.usesUIKit) {
+    ExtLog(logFile, "[HIAHExtension] Installing UIApplicationMain hook...\n");
+    InstallUIApplicationMainHook();
+  }
 
   // CRITICAL: Ensure dyld bypass is initialized before loading binary
   if (jitActive && vpnActive) {
@@ -1160,7 +1351,31 @@ static void continueBinaryLoadingWithBypass(NSString *executablePath,
          jitActive ? "ENABLED" : "DISABLED", vpnActive ? "ACTIVE" : "INACTIVE");
   HIAHLogInfo(GetExtensionLog, "Loading guest binary as dylib via dlopen");
 
+  // Read-ahead what dyld is about to fault in. A replayed profile carries
+  // the recording launch's numbers, so each launch logs before and after.
+  uint64_t dlopenBegin = HIAHStartupTraceBegin();
+  HIAHPrefetch *prefetch = HIAHPrefetchBegin(executablePath.UTF8String);
   void *guestHandle = dlopen(executablePath.UTF8String, RTLD_NOW | RTLD_GLOBAL);
+  HIAHPrefetchStats prefetchStats;
+  HIAHPrefetchFinish(prefetch, guestHandle != NULL, &prefetchStats);
+  HIAHStartupTraceEnd("dlopen", dlopenBegin);
+  ExtLog(logFile,
+         "[HIAHExtension] dlopen %.1f ms, %llu major / %llu minor faults "
+         "(prefetch: %u ranges, %llu KB, profile %s)\n",
+         prefetchStats.wallNs / 1e6, prefetchStats.majorFaults,
+         prefetchStats.minorFaults, prefetchStats.rangesAdvised,
+         prefetchStats.bytesAdvised / 1024,
+         prefetchStats.usedProfile
+             ? "replayed"
+             : (prefetchStats.recordedProfile ? "recorded" : "none"));
+  if (prefetchStats.usedProfile) {
+    ExtLog(logFile,
+           "[HIAHExtension] without prefetch: %.1f ms, %llu major / %llu "
+           "minor faults\n",
+           prefetchStats.baselineWallNs / 1e6,
+           prefetchStats.baselineMajorFaults,
+           prefetchStats.baselineMinorFaults);
+  }
 
   if (!guestHandle) {
     const char *error = dlerror();
@@ -1294,6 +1509,7 @@ static void continueBinaryLoadingWithBypass(NSString *executablePath,
 
       // Call main() - this will eventually call UIApplicationMain which our
       // hook intercepts
+      HIAHStartupTraceEnd("spawn request to guest main", gRequestBegin);
       guestExitCode = guestMain(guestArgc, guestArgv);
 
       fprintf(stdout, "[HIAHExtension] Guest main() returned with code: %d\n",
@@ -1370,34 +1586,9 @@ static void continueBinaryLoadingWithBypass(NSString *executablePath,
 @implementation HIAHExtensionHandler
 
 + (void)load {
-  // Log to file immediately when class loads
-  NSFileManager *fm = [NSFileManager defaultManager];
-  NSURL *groupURL =
-      [fm containerURLForSecurityApplicationGroupIdentifier:HIAH_APP_GROUP];
-  NSString *logPath = nil;
-  if (groupURL) {
-    logPath =
-        [[groupURL.path stringByAppendingPathComponent:@"HIAHExtension.log"]
-            stringByStandardizingPath];
-    [fm createDirectoryAtPath:groupURL.path
-        withIntermediateDirectories:YES
-                         attributes:nil
-                              error:nil];
-  } else {
-    logPath = [NSTemporaryDirectory()
-        stringByAppendingPathComponent:@"HIAHExtension.log"];
-  }
-
-  FILE *logFile = fopen([logPath UTF8String], "a");
-  if (logFile) {
-    fprintf(logFile,
-            "[HIAHExtension] HIAHExtensionHandler class loaded (PID=%d)\n",
-            getpid());
-    fprintf(logFile, "[HIAHExtension] Log file: %s\n", [logPath UTF8String]);
-    fflush(logFile);
-    fclose(logFile);
-  }
-
+  // Runs before the constructor; the log file is not opened here (see
+  // ExtensionStartup), the load is recorded in the startup trace instead
+  uint64_t begin = HIAHStartupTraceBegin();
   fprintf(stderr,
           "[HIAHExtension] HIAHExtensionHandler class loaded (PID=%d)\n",
           getpid());
@@ -1406,9 +1597,11 @@ static void continueBinaryLoadingWithBypass(NSString *executablePath,
           getpid());
   fflush(stdout);
   fflush(stderr);
+  HIAHStartupTraceEnd("+load", begin);
 }
 
 + (void)initialize {
+  uint64_t begin = HIAHStartupTraceBegin();
   fprintf(stderr,
           "[HIAHExtension] HIAHExtensionHandler class initialized (PID=%d)\n",
           getpid());
@@ -1417,6 +1610,7 @@ static void continueBinaryLoadingWithBypass(NSString *executablePath,
           getpid());
   fflush(stdout);
   fflush(stderr);
+  HIAHStartupTraceEnd("+initialize", begin);
 }
 
 - (instancetype)init {
@@ -1434,6 +1628,8 @@ static void continueBinaryLoadingWithBypass(NSString *executablePath,
 }
 
 - (void)beginRequestWithExtensionContext:(NSExtensionContext *)context {
+  gRequestBegin = HIAHStartupTraceBegin();
+
   // CRITICAL: Log immediately to stdout/stderr before anything else
   // This ensures we see logs even if file logging fails
   fprintf(stdout,
@@ -1452,21 +1648,8 @@ static void continueBinaryLoadingWithBypass(NSString *executablePath,
   fflush(stderr);
 
   // Log to App Group shared directory so host app can read it
-  NSFileManager *fm = [NSFileManager defaultManager];
-  NSURL *groupURL =
-      [fm containerURLForSecurityApplicationGroupIdentifier:HIAH_APP_GROUP];
-  NSString *logPath = nil;
-  if (groupURL) {
-    logPath =
-        [[groupURL.path stringByAppendingPathComponent:@"HIAHExtension.log"]
-            stringByStandardizingPath];
-  } else {
-    // Fallback to temp directory
-    logPath = [NSTemporaryDirectory()
-        stringByAppendingPathComponent:@"HIAHExtension.log"];
-  }
-
-  FILE *logFile = fopen([logPath UTF8String], "a");
+  NSString *logPath = ExtensionLogPath();
+  FILE *logFile = GetExtensionLogFile();
   if (logFile) {
     fprintf(logFile,
             "[HIAHExtension] ========================================\n");
@@ -1477,19 +1660,6 @@ static void continueBinaryLoadingWithBypass(NSString *executablePath,
     fprintf(logFile, "[HIAHExtension] Input items count: %lu\n",
             (unsigned long)context.inputItems.count);
     fflush(logFile);
-  } else {
-    // Try to create parent directory if it doesn't exist
-    NSString *logDir = [logPath stringByDeletingLastPathComponent];
-    [fm createDirectoryAtPath:logDir
-        withIntermediateDirectories:YES
-                         attributes:nil
-                              error:nil];
-    logFile = fopen([logPath UTF8String], "a");
-    if (logFile) {
-      fprintf(logFile,
-              "[HIAHExtension] Log file created after creating directory\n");
-      fflush(logFile);
-    }
   }
 
   // Log to both stdout and stderr (stderr is more likely to be captured)
@@ -1553,7 +1723,7 @@ static void continueBinaryLoadingWithBypass(NSString *executablePath,
     if (logFile) {
       fprintf(logFile, "[HIAHExtension] ERROR: No spawn request data in "
                        "extension context\n");
-      fclose(logFile);
+      fflush(logFile);
     }
     fprintf(
         stderr,
@@ -1618,7 +1788,7 @@ static void continueBinaryLoadingWithBypass(NSString *executablePath,
 
       if (logFile) {
         fprintf(logFile, "[HIAHExtension] ExecuteGuestApplication completed\n");
-        fclose(logFile);
+        fflush(logFile);
       }
     } @catch (NSException *exception) {
       if (logFile) {
@@ -1627,7 +1797,7 @@ static void continueBinaryLoadingWithBypass(NSString *executablePath,
                 "%s - %s\n",
                 exception.name ? [exception.name UTF8String] : "(null)",
                 exception.reason ? [exception.reason UTF8String] : "(null)");
-        fclose(logFile);
+        fflush(logFile);
       }
       fprintf(stderr,
               "[HIAHExtension] FATAL: Exception in ExecuteGuestApplication: %s "
@@ -0,0 +1,103 @@
+/**
+ * HIAHStartupTrace.c
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Startup trace implementation.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#include "HIAHStartupTrace.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __APPLE__
+#include <sys/sysctl.h>
+#endif
+
+typedef struct {
+    _Atomic(bool) ready;
+    HIAHStartupSpan span;
+} HIAHStartupSlot;
+
+static HIAHStartupSlot g_slots[HIAH_STARTUP_TRACE_CAPACITY];
+static _Atomic(uint32_t) g_count = 0;
+static uint64_t g_originNs = 0;          // Process start, on the monotonic clock
+static pthread_once_t g_originOnce = PTHREAD_ONCE_INIT;
+
+static uint64_t HIAHClockNs(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Maps the kernel's process start time (wall clock) onto the monotonic
+// clock; without it, spans are relative to the first one recorded
+static void HIAHFindOrigin(void) {
+    uint64_t now = HIAHClockNs(CLOCK_MONOTONIC);
+    g_originNs = now;
+#ifdef __APPLE__
+    struct kinfo_proc info;
+    size_t size = sizeof(info);
+    int mib[] = {CTL_KERN, KERN_PROC, KERN_PROC_PID, getpid()};
+    if (sysctl(mib, 4, &info, &size, NULL, 0) == 0 && size > 0) {
+        uint64_t started = (uint64_t)info.kp_proc.p_starttime.tv_sec * 1000000000ull +
+                           (uint64_t)info.kp_proc.p_starttime.tv_usec * 1000ull;
+        uint64_t wall = HIAHClockNs(CLOCK_REALTIME);
+        if (started <= wall && wall - started < now) g_originNs = now - (wall - started);
+    }
+#endif
+}
+
+uint64_t HIAHStartupTraceBegin(void) {
+    pthread_once(&g_originOnce, HIAHFindOrigin);
+    return HIAHClockNs(CLOCK_MONOTONIC);
+}
+
+void HIAHStartupTraceEnd(const char *name, uint64_t begin) {
+    uint64_t end = HIAHClockNs(CLOCK_MONOTONIC);
+    uint32_t index = atomic_fetch_add_explicit(&g_count, 1, memory_order_relaxed);
+    if (index >= HIAH_STARTUP_TRACE_CAPACITY) return;
+
+    pthread_once(&g_originOnce, HIAHFindOrigin);
+    HIAHStartupSlot *slot = &g_slots[index];
+    slot->span.name = name;
+    slot->span.startUs = begin > g_originNs ? (uint32_t)((begin - g_originNs) / 1000) : 0;
+    slot->span.durationUs = end > begin ? (uint32_t)((end - begin) / 1000) : 0;
+    atomic_store_explicit(&slot->ready, true, memory_order_release);
+}
+
+size_t HIAHStartupTraceCopy(HIAHStartupSpan *out, size_t capacity) {
+    uint32_t count = atomic_load_explicit(&g_count, memory_order_relaxed);
+    size_t copied = 0;
+    for (uint32_t i = 0; i < count && i < HIAH_STARTUP_TRACE_CAPACITY && copied < capacity; i++) {
+        // A span still being written is skipped rather than waited for
+        if (!atomic_load_explicit(&g_slots[i].ready, memory_order_acquire)) continue;
+        out[copied++] = g_slots[i].span;
+    }
+    return count;
+}
+
+size_t HIAHStartupTraceFormat(char *buffer, size_t size) {
+    HIAHStartupSpan spans[HIAH_STARTUP_TRACE_CAPACITY] = {{0}};
+    size_t count = HIAHStartupTraceCopy(spans, HIAH_STARTUP_TRACE_CAPACITY);
+    size_t kept = count < HIAH_STARTUP_TRACE_CAPACITY ? count : HIAH_STARTUP_TRACE_CAPACITY;
+
+    size_t length = 0;
+    int written = snprintf(buffer, size, "[HIAHExtension] Startup trace (PID=%d, %zu spans):\n",
+                           getpid(), count);
+    if (written > 0) length += (size_t)written;
+    for (size_t i = 0; i < kept && spans[i].name; i++) {
+        written = snprintf(length < size ? buffer + length : NULL,
+                           length < size ? size - length : 0,
+                           "[HIAHExtension]   %9.3f ms  %-32s %9.3f ms\n",
+                           spans[i].startUs / 1000.0, spans[i].name,
+                           spans[i].durationUs / 1000.0);
+        if (written > 0) length += (size_t)written;
+    }
+    return length;
+}
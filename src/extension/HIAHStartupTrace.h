@@ -0,0 +1,68 @@
+/**
+ * HIAHStartupTrace.h
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * In-memory startup trace for the ProcessRunner extension.
+ *
+ * Everything between exec and the guest's main() (constructors, +load,
+ * the request handler, bundle and hook setup, dlopen) records a named span
+ * into a fixed array. Recording is a clock read and an atomic increment,
+ * so it is safe before the log file exists; the trace is formatted only
+ * when someone asks for it (a Darwin notification, or the log file being
+ * opened). Times are relative to process start.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#ifndef HIAH_STARTUP_TRACE_H
+#define HIAH_STARTUP_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Spans past this many are counted but not kept
+#define HIAH_STARTUP_TRACE_CAPACITY 48
+
+/// Post to make every extension process write its trace to the log
+#define HIAH_STARTUP_TRACE_DUMP_NOTIFICATION \
+    "com.aspauldingcode.HIAHDesktop.DumpStartupTrace"
+
+typedef struct {
+    const char *name;             // Static string
+    uint32_t startUs;             // Since process start
+    uint32_t durationUs;
+} HIAHStartupSpan;
+
+/**
+ * Monotonic timestamp to pass to HIAHStartupTraceEnd.
+ */
+uint64_t HIAHStartupTraceBegin(void);
+
+/**
+ * Records the span from `begin` to now. `name` must outlive the process
+ * (a string literal).
+ */
+void HIAHStartupTraceEnd(const char *name, uint64_t begin);
+
+/**
+ * Copies up to `capacity` spans in the order they finished.
+ *
+ * @return The number of spans recorded, which may exceed `capacity`.
+ */
+size_t HIAHStartupTraceCopy(HIAHStartupSpan *out, size_t capacity);
+
+/**
+ * Formats the trace as log lines, like snprintf.
+ */
+size_t HIAHStartupTraceFormat(char *buffer, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HIAH_STARTUP_TRACE_H */
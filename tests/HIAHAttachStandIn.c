@@ -0,0 +1,136 @@
+/**
+ * HIAHAttachStandIn.c
+ * HIAH LoginWindow - Stand-in Debugger Attach Service
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under AGPLv3
+ */
+
+#include "HIAHAttachStandIn.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+typedef struct {
+    pid_t pid;
+    bool alive;
+    bool attaching;
+    uint32_t failuresLeft;
+    uint32_t latencyMs;
+    uint32_t attempts;
+} HIAHStandInProcess;
+
+struct HIAHAttachStandIn {
+    pthread_mutex_t lock;
+    HIAHStandInProcess processes[HIAH_STAND_IN_MAX_PROCESSES];
+    unsigned count;
+    uint32_t running;
+    uint32_t peak;
+    bool overlap;
+};
+
+// Lock held
+static HIAHStandInProcess *HIAHStandInFind(HIAHAttachStandIn *service, pid_t pid) {
+    for (unsigned i = 0; i < service->count; i++) {
+        if (service->processes[i].pid == pid) return &service->processes[i];
+    }
+    return NULL;
+}
+
+HIAHAttachStandIn *HIAHAttachStandInCreate(void) {
+    HIAHAttachStandIn *service = calloc(1, sizeof(HIAHAttachStandIn));
+    if (service) pthread_mutex_init(&service->lock, NULL);
+    return service;
+}
+
+void HIAHAttachStandInDestroy(HIAHAttachStandIn *service) {
+    if (!service) return;
+    pthread_mutex_destroy(&service->lock);
+    free(service);
+}
+
+void HIAHAttachStandInSpawn(HIAHAttachStandIn *service, pid_t pid, uint32_t failures,
+                            uint32_t latencyMs) {
+    pthread_mutex_lock(&service->lock);
+    if (service->count < HIAH_STAND_IN_MAX_PROCESSES) {
+        service->processes[service->count++] = (HIAHStandInProcess){
+            .pid = pid,
+            .alive = true,
+            .failuresLeft = failures,
+            .latencyMs = latencyMs,
+        };
+    }
+    pthread_mutex_unlock(&service->lock);
+}
+
+void HIAHAttachStandInExit(HIAHAttachStandIn *service, pid_t pid) {
+    pthread_mutex_lock(&service->lock);
+    HIAHStandInProcess *process = HIAHStandInFind(service, pid);
+    if (process) process->alive = false;
+    pthread_mutex_unlock(&service->lock);
+}
+
+uint32_t HIAHAttachStandInAttempts(HIAHAttachStandIn *service, pid_t pid) {
+    pthread_mutex_lock(&service->lock);
+    HIAHStandInProcess *process = HIAHStandInFind(service, pid);
+    uint32_t attempts = process ? process->attempts : 0;
+    pthread_mutex_unlock(&service->lock);
+    return attempts;
+}
+
+uint32_t HIAHAttachStandInPeakConcurrency(HIAHAttachStandIn *service) {
+    pthread_mutex_lock(&service->lock);
+    uint32_t peak = service->peak;
+    pthread_mutex_unlock(&service->lock);
+    return peak;
+}
+
+bool HIAHAttachStandInSawOverlap(HIAHAttachStandIn *service) {
+    pthread_mutex_lock(&service->lock);
+    bool overlap = service->overlap;
+    pthread_mutex_unlock(&service->lock);
+    return overlap;
+}
+
+bool HIAHAttachStandInAttach(pid_t pid, void *context) {
+    HIAHAttachStandIn *service = context;
+
+    pthread_mutex_lock(&service->lock);
+    HIAHStandInProcess *process = HIAHStandInFind(service, pid);
+    if (!process) {
+        pthread_mutex_unlock(&service->lock);
+        return false;
+    }
+    if (process->attaching) service->overlap = true;
+    process->attaching = true;
+    process->attempts++;
+    if (++service->running > service->peak) service->peak = service->running;
+    uint32_t latencyMs = process->latencyMs;
+    pthread_mutex_unlock(&service->lock);
+
+    // The real service round-trips through the VPN tunnel and lockdownd
+    usleep(latencyMs * 1000);
+
+    pthread_mutex_lock(&service->lock);
+    bool enabled = false;
+    if (process->alive) {
+        if (process->failuresLeft == 0) {
+            enabled = true;
+        } else if (process->failuresLeft != UINT32_MAX) {
+            process->failuresLeft--;
+        }
+    }
+    process->attaching = false;
+    service->running--;
+    pthread_mutex_unlock(&service->lock);
+    return enabled;
+}
+
+bool HIAHAttachStandInIsAlive(pid_t pid, void *context) {
+    HIAHAttachStandIn *service = context;
+    pthread_mutex_lock(&service->lock);
+    HIAHStandInProcess *process = HIAHStandInFind(service, pid);
+    bool alive = process && process->alive;
+    pthread_mutex_unlock(&service->lock);
+    return alive;
+}
@@ -0,0 +1,65 @@
+/**
+ * HIAHAttachStandIn.h
+ * HIAH LoginWindow - Stand-in Debugger Attach Service
+ *
+ * Replaces the minimuxer attach round trip behind HIAHJITQueue in tests.
+ * Each simulated process has a scripted number of failed attaches before
+ * one succeeds, a per-attach latency, and a liveness flag the test can
+ * clear to model the process exiting. The service records how many
+ * attaches ran at once overall and whether any PID was ever attached
+ * twice concurrently, which the queue promises never to do.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under AGPLv3
+ */
+
+#ifndef HIAH_ATTACH_STAND_IN_H
+#define HIAH_ATTACH_STAND_IN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#define HIAH_STAND_IN_MAX_PROCESSES 64
+
+typedef struct HIAHAttachStandIn HIAHAttachStandIn;
+
+HIAHAttachStandIn *HIAHAttachStandInCreate(void);
+void HIAHAttachStandInDestroy(HIAHAttachStandIn *service);
+
+/**
+ * Adds a live process whose first `failures` attaches fail, each attach
+ * taking `latencyMs`. Pass UINT32_MAX failures for a process that never
+ * gets JIT.
+ */
+void HIAHAttachStandInSpawn(HIAHAttachStandIn *service, pid_t pid, uint32_t failures,
+                            uint32_t latencyMs);
+
+/**
+ * Marks `pid` as exited; later liveness checks and attaches fail.
+ */
+void HIAHAttachStandInExit(HIAHAttachStandIn *service, pid_t pid);
+
+/**
+ * Attaches made to `pid` so far.
+ */
+uint32_t HIAHAttachStandInAttempts(HIAHAttachStandIn *service, pid_t pid);
+
+/**
+ * Most attaches observed running at the same time.
+ */
+uint32_t HIAHAttachStandInPeakConcurrency(HIAHAttachStandIn *service);
+
+/**
+ * True if two attaches for one PID ever overlapped.
+ */
+bool HIAHAttachStandInSawOverlap(HIAHAttachStandIn *service);
+
+/**
+ * HIAHJITAttachFunction and HIAHJITAliveFunction over the stand-in; pass
+ * the service as the queue's context.
+ */
+bool HIAHAttachStandInAttach(pid_t pid, void *service);
+bool HIAHAttachStandInIsAlive(pid_t pid, void *service);
+
+#endif /* HIAH_ATTACH_STAND_IN_H */
@@ -0,0 +1,208 @@
+/**
+ * HIAHBlobStoreTests.c
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * The portable SHA-256 against the FIPS 180-4 vectors, and the blob store
+ * on Linux: storing, sharing (reflink or hardlink), manifests, re-adding
+ * and collection.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#include "HIAHBlobStore.h"
+#include "HIAHSHA256.h"
+#include "HIAHTest.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static void Hex(const uint8_t *digest, char *hex) {
+    for (int i = 0; i < HIAH_SHA256_DIGEST_SIZE; i++) sprintf(hex + i * 2, "%02x", digest[i]);
+}
+
+// Hashes `data` fed in pieces of `chunk` bytes
+static void Digest(const void *data, size_t length, size_t chunk, char *hex) {
+    HIAHSHA256Context context;
+    HIAHSHA256Init(&context);
+    for (size_t done = 0; done < length; done += chunk) {
+        HIAHSHA256Update(&context, (const uint8_t *)data + done, length - done < chunk ? length - done : chunk);
+    }
+    uint8_t digest[HIAH_SHA256_DIGEST_SIZE];
+    HIAHSHA256Final(&context, digest);
+    Hex(digest, hex);
+}
+
+static void TestSHA256(void) {
+    char hex[HIAH_SHA256_DIGEST_SIZE * 2 + 1];
+    Digest("", 0, 1, hex);
+    HIAH_CHECK(strcmp(hex, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855") == 0);
+    Digest("abc", 3, 3, hex);
+    HIAH_CHECK(strcmp(hex, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad") == 0);
+
+    // 56 bytes: the length no longer fits in the first padded block
+    const char *twoBlocks = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    Digest(twoBlocks, strlen(twoBlocks), 56, hex);
+    HIAH_CHECK(strcmp(hex, "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1") == 0);
+
+    size_t million = 1000000;
+    char *as = malloc(million);
+    memset(as, 'a', million);
+    static const size_t chunks[] = { 1, 63, 64, 65, 4096, 1000000 };
+    for (size_t i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++) {
+        Digest(as, million, chunks[i], hex);
+        HIAH_CHECK(strcmp(hex, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0") == 0);
+    }
+    free(as);
+}
+
+static char g_root[] = "/tmp/hiah-blobs-XXXXXX";
+
+static void WriteFile(const char *relative, size_t size, unsigned seed, mode_t mode) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", g_root, relative);
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, mode);
+    HIAH_CHECK(fd >= 0);
+    uint8_t *data = malloc(size);
+    for (size_t i = 0; i < size; i++) data[i] = (uint8_t)(seed * 31 + i * 7 + i / 251);
+    HIAH_CHECK(write(fd, data, size) == (ssize_t)size);
+    free(data);
+    close(fd);
+}
+
+static void MakeDirectory(const char *relative) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", g_root, relative);
+    HIAH_CHECK(mkdir(path, 0755) == 0);
+}
+
+static struct stat Stat(const char *relative) {
+    char path[PATH_MAX];
+    struct stat st = {0};
+    snprintf(path, sizeof(path), "%s/%s", g_root, relative);
+    HIAH_CHECK(lstat(path, &st) == 0);
+    return st;
+}
+
+static bool SameContent(const char *a, const char *b) {
+    char pathA[PATH_MAX], pathB[PATH_MAX];
+    snprintf(pathA, sizeof(pathA), "%s/%s", g_root, a);
+    snprintf(pathB, sizeof(pathB), "%s/%s", g_root, b);
+    FILE *fileA = fopen(pathA, "rb"), *fileB = fopen(pathB, "rb");
+    bool same = fileA && fileB;
+    while (same) {
+        int byteA = fgetc(fileA), byteB = fgetc(fileB);
+        same = byteA == byteB;
+        if (byteA == EOF) break;
+    }
+    if (fileA) fclose(fileA);
+    if (fileB) fclose(fileB);
+    return same;
+}
+
+static int ManifestLines(const char *app) {
+    char path[PATH_MAX], line[PATH_MAX + 128];
+    snprintf(path, sizeof(path), "%s/Applications/%s/" HIAH_BLOB_MANIFEST, g_root, app);
+    FILE *file = fopen(path, "r");
+    if (!file) return -1;
+    int lines = 0;
+    while (fgets(line, sizeof(line), file)) lines++;
+    fclose(file);
+    return lines;
+}
+
+static void TestStore(void) {
+    char store[PATH_MAX], apps[PATH_MAX], path[PATH_MAX];
+    snprintf(store, sizeof(store), "%s/Store", g_root);
+    snprintf(apps, sizeof(apps), "%s/Applications", g_root);
+    MakeDirectory("Applications");
+    const char *names[] = { "One.app", "Two.app" };
+    for (int i = 0; i < 2; i++) {
+        snprintf(path, sizeof(path), "Applications/%s", names[i]);
+        MakeDirectory(path);
+        snprintf(path, sizeof(path), "Applications/%s/Frameworks", names[i]);
+        MakeDirectory(path);
+        snprintf(path, sizeof(path), "Applications/%s/Frameworks/libswiftCore.dylib", names[i]);
+        WriteFile(path, 300 * 1024 + 17, 1, 0755);
+        snprintf(path, sizeof(path), "Applications/%s/Own", names[i]);
+        WriteFile(path, 64 * 1024, 10 + i, 0755);
+        snprintf(path, sizeof(path), "Applications/%s/Small.plist", names[i]);
+        WriteFile(path, 1024, 1, 0644);
+        snprintf(path, sizeof(path), "Applications/%s/.hiah-lazy", names[i]);
+        WriteFile(path, 64 * 1024, 1, 0644);
+    }
+
+    HIAHBlobAddStats stats;
+    snprintf(path, sizeof(path), "%s/One.app", apps);
+    HIAH_CHECK(HIAHBlobStoreAdd(store, path, &stats) == 0);
+    HIAH_CHECK(stats.files == 2 && stats.stored == 2 && stats.shared == 0);
+    HIAH_CHECK(stats.hashedBytes == 300 * 1024 + 17 + 64 * 1024);
+    HIAH_CHECK(ManifestLines("One.app") == 2);
+
+    snprintf(path, sizeof(path), "%s/Two.app", apps);
+    HIAH_CHECK(HIAHBlobStoreAdd(store, path, &stats) == 0);
+    HIAH_CHECK(stats.files == 2 && stats.stored == 1 && stats.shared == 1);
+    HIAH_CHECK(stats.sharedBytes == 300 * 1024 + 17);
+    HIAH_CHECK(ManifestLines("Two.app") == 2);
+
+    // The shared file is a clone of the blob with its content and mode
+    // intact; on filesystems without reflinks it is the blob's inode
+    const char *one = "Applications/One.app/Frameworks/libswiftCore.dylib";
+    const char *two = "Applications/Two.app/Frameworks/libswiftCore.dylib";
+    HIAH_CHECK(SameContent(one, two));
+    struct stat stOne = Stat(one), stTwo = Stat(two);
+    HIAH_CHECK((stTwo.st_mode & 07777) == 0755);
+    HIAH_CHECK(stOne.st_ino == stTwo.st_ino || stTwo.st_nlink == 1);
+
+    // The manifest's digest names the blob holding the file's content
+    char line[PATH_MAX + 128], hex[HIAH_SHA256_DIGEST_SIZE * 2 + 1], blob[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/Two.app/" HIAH_BLOB_MANIFEST, apps);
+    FILE *manifest = fopen(path, "r");
+    bool found = false;
+    while (manifest && fgets(line, sizeof(line), manifest)) {
+        if (!strstr(line, "Frameworks/libswiftCore.dylib")) continue;
+        found = true;
+        memcpy(hex, line, sizeof(hex) - 1);
+        hex[sizeof(hex) - 1] = '\0';
+    }
+    if (manifest) fclose(manifest);
+    HIAH_CHECK(found);
+    snprintf(blob, sizeof(blob), "Store/%.2s/%s", hex, hex + 2);
+    HIAH_CHECK(SameContent(blob, two));
+
+    // Adding a bundle again finds its files already in the store
+    snprintf(path, sizeof(path), "%s/One.app", apps);
+    HIAH_CHECK(HIAHBlobStoreAdd(store, path, &stats) == 0);
+    HIAH_CHECK(stats.files == 2 && stats.stored == 0);
+    HIAH_CHECK(SameContent(one, two));
+
+    HIAHBlobStoreReport report;
+    HIAH_CHECK(HIAHBlobStoreCollect(store, apps, &report) == 0);
+    HIAH_CHECK(report.apps == 2 && report.blobs == 3 && report.removed == 0);
+    HIAH_CHECK(report.referencedBytes == 2 * (300 * 1024 + 17 + 64 * 1024));
+
+    // Uninstalling Two.app frees its own blob and an abandoned temporary
+    snprintf(path, sizeof(path), "%s/Two.app", apps);
+    HIAHTestRemoveTree(path);
+    WriteFile("Store/.tmp-1-0", 100, 0, 0644);
+    HIAH_CHECK(HIAHBlobStoreCollect(store, apps, &report) == 0);
+    HIAH_CHECK(report.apps == 1 && report.blobs == 2 && report.removed == 1);
+    HIAH_CHECK(report.removedBytes == 64 * 1024);
+    snprintf(path, sizeof(path), "%s/.tmp-1-0", store);
+    HIAH_CHECK(access(path, F_OK) != 0 && errno == ENOENT);
+    HIAH_CHECK(SameContent(blob, one));
+
+    HIAH_CHECK(HIAHBlobStoreCollect(store, "/nonexistent", NULL) == ENOENT);
+}
+
+int main(void) {
+    TestSHA256();
+    HIAH_CHECK(mkdtemp(g_root) != NULL);
+    TestStore();
+    HIAHTestRemoveTree(g_root);
+    return HIAHTestFinish("HIAHBlobStoreTests");
+}
@@ -0,0 +1,82 @@
+/**
+ * HIAHChildTableBench.c
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Parent CPU spent reaping thread-hosted children through the virtual
+ * child table, the spawn/exit/wait round trip, and how long a blocked
+ * waiter takes to return after a child exits.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#include "HIAHChildTable.h"
+#include "HIAHTest.h"
+#include <pthread.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+typedef struct {
+    pid_t vpid;
+    useconds_t delayUs;
+    uint64_t exitNs;
+} Child;
+
+static void *ChildMain(void *data) {
+    Child *child = data;
+    HIAHChildTableAttachThread(child->vpid);
+    if (child->delayUs) usleep(child->delayUs);
+    child->exitNs = HIAHTestNowNs();
+    HIAHChildTableExit(child->vpid, 0);
+    return NULL;
+}
+
+static pthread_t StartChild(Child *child, useconds_t delayUs) {
+    child->vpid = HIAHChildTableSpawn();
+    child->delayUs = delayUs;
+    pthread_t thread;
+    pthread_create(&thread, NULL, ChildMain, child);
+    return thread;
+}
+
+int main(void) {
+    // 100 children that run 20 ms each, reaped by one blocking waitpid(-1)
+    enum { CHILDREN = 100 };
+    Child children[CHILDREN];
+    pthread_t threads[CHILDREN];
+    for (int i = 0; i < CHILDREN; i++) threads[i] = StartChild(&children[i], 20000);
+    uint64_t cpuBegin = HIAHTestThreadCPUNs();
+    uint64_t wallBegin = HIAHTestNowNs();
+    int reaped = 0;
+    while (HIAHChildTableWait(-1, NULL, 0) > 0) reaped++;
+    uint64_t cpuNs = HIAHTestThreadCPUNs() - cpuBegin;
+    uint64_t wallNs = HIAHTestNowNs() - wallBegin;
+    for (int i = 0; i < CHILDREN; i++) pthread_join(threads[i], NULL);
+    printf("%d children reaped: %.2f ms parent CPU over %.1f ms\n", reaped, cpuNs / 1e6, wallNs / 1e6);
+
+    // Spawn, exit, blocking wait
+    enum { ROUNDS = 20000 };
+    uint64_t begin = HIAHTestNowNs();
+    for (int i = 0; i < ROUNDS; i++) {
+        Child child;
+        pthread_t thread = StartChild(&child, 0);
+        HIAHChildTableWait(child.vpid, NULL, 0);
+        pthread_join(thread, NULL);
+    }
+    double roundTripUs = (double)(HIAHTestNowNs() - begin) / ROUNDS / 1000;
+    printf("spawn + exit + waitpid: %.1f us per round trip (%.0f/s, thread creation included)\n",
+           roundTripUs, 1e6 / roundTripUs);
+
+    // Child exit to the blocked waiter returning
+    enum { WAKES = 2000 };
+    uint64_t totalWakeNs = 0;
+    for (int i = 0; i < WAKES; i++) {
+        Child child;
+        pthread_t thread = StartChild(&child, 200);
+        HIAHChildTableWait(child.vpid, NULL, 0);
+        totalWakeNs += HIAHTestNowNs() - child.exitNs;
+        pthread_join(thread, NULL);
+    }
+    printf("exit to waiter wake-up: %.1f us\n", (double)totalWakeNs / WAKES / 1000);
+    return 0;
+}
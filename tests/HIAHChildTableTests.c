@@ -0,0 +1,198 @@
+/**
+ * HIAHChildTableTests.c
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * waitpid() semantics of the virtual child table: exit statuses, WNOHANG,
+ * ownership, stop/continue reporting, orphaning, kernel-launched roots and
+ * timeouts.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#include "HIAHChildTable.h"
+#include "HIAHTest.h"
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+typedef struct {
+    pid_t vpid;
+    int exitCode;
+    useconds_t delayUs;
+} Child;
+
+static void *ChildMain(void *data) {
+    Child *child = data;
+    HIAHChildTableAttachThread(child->vpid);
+    usleep(child->delayUs);
+    HIAHChildTableExit(child->vpid, child->exitCode);
+    free(child);
+    return NULL;
+}
+
+static pid_t StartChild(int exitCode, useconds_t delayUs) {
+    Child *child = malloc(sizeof(Child));
+    child->vpid = HIAHChildTableSpawn();
+    child->exitCode = exitCode;
+    child->delayUs = delayUs;
+    pid_t vpid = child->vpid;
+    pthread_t thread;
+    pthread_create(&thread, NULL, ChildMain, child);
+    pthread_detach(thread);
+    return vpid;
+}
+
+static void TestReapAll(void) {
+    for (int i = 0; i < 50; i++) StartChild(i % 7, (useconds_t)(i % 5) * 1000);
+
+    int reaped = 0, status = 0;
+    pid_t vpid;
+    while ((vpid = HIAHChildTableWait(-1, &status, 0)) > 0) {
+        HIAH_CHECK(HIAHChildTableIsVirtualPID(vpid));
+        HIAH_CHECK(WIFEXITED(status));
+        reaped++;
+    }
+    HIAH_CHECK(reaped == 50);
+    HIAH_CHECK(errno == ECHILD);
+    HIAH_CHECK(!HIAHChildTableHasChildren());
+}
+
+static void TestExitStatus(void) {
+    pid_t vpid = StartChild(42, 0);
+    int status = 0;
+    HIAH_CHECK(HIAHChildTableWait(vpid, &status, 0) == vpid);
+    HIAH_CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 42);
+    HIAH_CHECK(!HIAHChildTableExists(vpid));
+    // Already reaped
+    HIAH_CHECK(HIAHChildTableWait(vpid, &status, 0) == -1 && errno == ECHILD);
+}
+
+static void TestNoHang(void) {
+    pid_t vpid = HIAHChildTableSpawn();
+    int status = 0;
+    HIAH_CHECK(HIAHChildTableWait(-1, &status, WNOHANG) == 0);
+    HIAHChildTableExit(vpid, 0);
+    HIAH_CHECK(HIAHChildTableWait(-1, &status, WNOHANG) == vpid);
+    HIAH_CHECK(HIAHChildTableWait(-1, &status, WNOHANG) == -1 && errno == ECHILD);
+}
+
+typedef struct {
+    pid_t other;
+    pid_t result;
+    int error;
+} OwnershipProbe;
+
+static void *OwnershipMain(void *data) {
+    OwnershipProbe *probe = data;
+    // A different virtual process may not wait for the host's child
+    HIAHChildTableAttachThread(HIAH_GUEST_PID_BASE - 1);
+    probe->result = HIAHChildTableWait(probe->other, NULL, WNOHANG);
+    probe->error = errno;
+    HIAHChildTableExit(HIAH_GUEST_PID_BASE - 1, 0);
+    return NULL;
+}
+
+static void TestOwnership(void) {
+    pid_t vpid = HIAHChildTableSpawn();
+    OwnershipProbe probe = { .other = vpid };
+    pthread_t thread;
+    pthread_create(&thread, NULL, OwnershipMain, &probe);
+    pthread_join(thread, NULL);
+    HIAH_CHECK(probe.result == -1 && probe.error == ECHILD);
+    HIAHChildTableExit(vpid, 0);
+    HIAH_CHECK(HIAHChildTableWait(vpid, NULL, 0) == vpid);
+}
+
+static void TestStopContinue(void) {
+    pid_t vpid = HIAHChildTableSpawn();
+    int status = 0;
+    HIAH_CHECK(HIAHChildTableStop(vpid, SIGTSTP));
+    // Only WUNTRACED waiters see stops, and only once
+    HIAH_CHECK(HIAHChildTableWait(vpid, &status, WNOHANG) == 0);
+    HIAH_CHECK(HIAHChildTableWait(vpid, &status, WUNTRACED) == vpid);
+    HIAH_CHECK(WIFSTOPPED(status) && WSTOPSIG(status) == SIGTSTP);
+    HIAH_CHECK(HIAHChildTableWait(vpid, &status, WUNTRACED | WNOHANG) == 0);
+
+    HIAH_CHECK(HIAHChildTableContinue(vpid));
+    HIAH_CHECK(HIAHChildTableWait(vpid, &status, WCONTINUED) == vpid);
+    HIAH_CHECK(WIFCONTINUED(status));
+    HIAH_CHECK(HIAHChildTableWait(vpid, &status, WCONTINUED | WNOHANG) == 0);
+
+    HIAHChildTableExit(vpid, 3);
+    HIAH_CHECK(HIAHChildTableWait(vpid, &status, 0) == vpid && WEXITSTATUS(status) == 3);
+    HIAH_CHECK(!HIAHChildTableStop(vpid, SIGSTOP));
+}
+
+typedef struct {
+    pid_t self;
+    pid_t grandchild;
+} Parent;
+
+static void *ParentMain(void *data) {
+    Parent *parent = data;
+    HIAHChildTableAttachThread(parent->self);
+    parent->grandchild = HIAHChildTableSpawn();
+    HIAHChildTableExit(parent->self, 0);
+    return NULL;
+}
+
+static void TestOrphans(void) {
+    Parent parent = { .self = HIAHChildTableSpawn() };
+    pthread_t thread;
+    pthread_create(&thread, NULL, ParentMain, &parent);
+    pthread_join(thread, NULL);
+
+    // The host reaps its child but never sees the grandchild
+    HIAH_CHECK(HIAHChildTableWait(-1, NULL, 0) == parent.self);
+    HIAH_CHECK(HIAHChildTableExists(parent.grandchild));
+    HIAH_CHECK(!HIAHChildTableHasChildren());
+    // The orphan is reaped as soon as it exits
+    HIAHChildTableExit(parent.grandchild, 0);
+    HIAH_CHECK(!HIAHChildTableExists(parent.grandchild));
+}
+
+static void *RootMain(void *data) {
+    pid_t *grandchild = data;
+    // A kernel-launched guest: its PID is not in the table
+    HIAHChildTableAttachThread(1000);
+    *grandchild = HIAHChildTableSpawn();
+    HIAH_CHECK(HIAHChildTableHasChildren());
+    HIAHChildTableExit(1000, 0);
+    HIAH_CHECK(!HIAHChildTableHasChildren());
+    return NULL;
+}
+
+static void TestKernelRoot(void) {
+    pid_t grandchild = 0;
+    pthread_t thread;
+    pthread_create(&thread, NULL, RootMain, &grandchild);
+    pthread_join(thread, NULL);
+    HIAH_CHECK(!HIAHChildTableExists(1000));
+    HIAH_CHECK(HIAHChildTableExists(grandchild));
+    HIAHChildTableExit(grandchild, 0);
+    HIAH_CHECK(!HIAHChildTableExists(grandchild));
+}
+
+static void TestTimeout(void) {
+    pid_t vpid = HIAHChildTableSpawn();
+    uint64_t start = HIAHTestNowNs();
+    HIAH_CHECK(HIAHChildTableWaitTimeout(-1, NULL, 0, 20) == 0);
+    HIAH_CHECK(HIAHTestNowNs() - start >= 15 * 1000000ull);
+    HIAHChildTableExit(vpid, 0);
+    HIAH_CHECK(HIAHChildTableWaitTimeout(-1, NULL, 0, 20) == vpid);
+}
+
+int main(void) {
+    TestReapAll();
+    TestExitStatus();
+    TestNoHang();
+    TestOwnership();
+    TestStopContinue();
+    TestOrphans();
+    TestKernelRoot();
+    TestTimeout();
+    return HIAHTestFinish("HIAHChildTableTests");
+}
@@ -0,0 +1,151 @@
+/**
+ * HIAHDeltaUpdateTests.c
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Delta updates between the fixture versions (fixtures/gen_ipas.py): kept,
+ * extracted and removed files, symlinks, files the app wrote itself, the
+ * error cases, and updates of two apps at once.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#include "HIAHDeltaUpdate.h"
+#include "HIAHTest.h"
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#define HIAH_FIXTURES "fixtures/"
+
+static char g_root[] = "/tmp/hiah-delta-XXXXXX";
+
+// A full install: extract, move the bundle into place, record the manifest
+static void Install(const char *app, const char *applications) {
+    char archive[PATH_MAX], extracted[PATH_MAX], from[PATH_MAX], to[PATH_MAX];
+    snprintf(archive, sizeof(archive), HIAH_FIXTURES "%s-v1.ipa", app);
+    snprintf(extracted, sizeof(extracted), "%s/extract-%s", g_root, app);
+    snprintf(from, sizeof(from), "%s/Payload/%s.app", extracted, app);
+    snprintf(to, sizeof(to), "%s/%s.app", applications, app);
+    HIAH_CHECK(HIAHZipExtract(archive, extracted, 1, NULL, NULL) == 0);
+    HIAH_CHECK(rename(from, to) == 0);
+    HIAH_CHECK(HIAHDeltaRecordManifest(archive, to) == 0);
+    HIAHTestRemoveTree(extracted);
+}
+
+static void CheckUpdated(const char *bundle, const char *app, const HIAHDeltaStats *stats) {
+    char path[PATH_MAX], target[PATH_MAX] = {0};
+    // A, Info.plist, keep.png, new.png, F, link
+    HIAH_CHECK(stats->files == 6 && stats->unchanged == 3 && stats->extracted == 3);
+    HIAH_CHECK(stats->removed == 2);
+    HIAH_CHECK(stats->bytesWritten == 4000 + 3 + 10);
+
+    char executable[4000];
+    for (int i = 0; i < 1000; i++) memcpy(executable + i * 4, "exe2", 4);
+    snprintf(path, sizeof(path), "%s/%s", bundle, app);
+    HIAH_CHECK(HIAHTestFileEquals(path, executable, sizeof(executable)));
+    struct stat st;
+    HIAH_CHECK(stat(path, &st) == 0 && (st.st_mode & 0111));
+    snprintf(path, sizeof(path), "%s/res/new.png", bundle);
+    HIAH_CHECK(HIAHTestFileEquals(path, "new", 3));
+    snprintf(path, sizeof(path), "%s/res/gone.png", bundle);
+    HIAH_CHECK(access(path, F_OK) != 0);
+    snprintf(path, sizeof(path), "%s/old", bundle);
+    HIAH_CHECK(access(path, F_OK) != 0);
+    snprintf(path, sizeof(path), "%s/link", bundle);
+    HIAH_CHECK(readlink(path, target, sizeof(target) - 1) == 10 && strcmp(target, "Info.plist") == 0);
+}
+
+static void TestUpdate(void) {
+    char applications[PATH_MAX], bundle[PATH_MAX], path[PATH_MAX];
+    snprintf(applications, sizeof(applications), "%s/Applications", g_root);
+    mkdir(applications, 0755);
+
+    HIAHDeltaStats stats;
+    HIAH_CHECK(HIAHDeltaUpdate(HIAH_FIXTURES "A-v2.ipa", applications, NULL, bundle, sizeof(bundle),
+                               &stats) == ESRCH);
+    HIAH_CHECK(HIAHDeltaUpdate(HIAH_FIXTURES "Info.bplist", applications, NULL, bundle, sizeof(bundle),
+                               &stats) == EILSEQ);
+
+    Install("A", applications);
+    // Written by the app itself; its directory is kept
+    snprintf(path, sizeof(path), "%s/A.app/old/user-data", applications);
+    HIAHTestWriteFile(path, "mine", 4, 0644);
+
+    HIAH_CHECK(HIAHDeltaUpdate(HIAH_FIXTURES "A-v2.ipa", applications, NULL, bundle, sizeof(bundle),
+                               &stats) == 0);
+    snprintf(path, sizeof(path), "%s/A.app", applications);
+    HIAH_CHECK(strcmp(bundle, path) == 0);
+    HIAH_CHECK(stats.files == 6 && stats.unchanged == 3 && stats.extracted == 3 && stats.removed == 2);
+    snprintf(path, sizeof(path), "%s/A.app/old/user-data", applications);
+    HIAH_CHECK(HIAHTestFileEquals(path, "mine", 4));
+    snprintf(path, sizeof(path), "%s/A.app/old/x", applications);
+    HIAH_CHECK(access(path, F_OK) != 0);
+    snprintf(path, sizeof(path), "%s/A.app/old/user-data", applications);
+    unlink(path);
+    snprintf(path, sizeof(path), "%s/A.app/old", applications);
+    rmdir(path);
+    CheckUpdated(bundle, "A", &stats);
+
+    // The same version again changes nothing
+    HIAH_CHECK(HIAHDeltaUpdate(HIAH_FIXTURES "A-v2.ipa", applications, NULL, bundle, sizeof(bundle),
+                               &stats) == 0);
+    HIAH_CHECK(stats.files == 6 && stats.unchanged == 6 && stats.extracted == 0 && stats.removed == 0);
+
+    // No update directories are left behind
+    DIR *directory = opendir(applications);
+    struct dirent *item;
+    while (directory && (item = readdir(directory))) {
+        HIAH_CHECK(item->d_name[0] == '.' ? strncmp(item->d_name, ".update-", 8) != 0
+                                          : strcmp(item->d_name, "A.app") == 0);
+    }
+    if (directory) closedir(directory);
+    HIAHTestRemoveTree(applications);
+}
+
+typedef struct {
+    const char *app;
+    char applications[PATH_MAX];
+    int result;
+    HIAHDeltaStats stats;
+    char bundle[PATH_MAX];
+} UpdateJob;
+
+static void *UpdateMain(void *data) {
+    UpdateJob *job = data;
+    char archive[PATH_MAX];
+    snprintf(archive, sizeof(archive), HIAH_FIXTURES "%s-v2.ipa", job->app);
+    job->result = HIAHDeltaUpdate(archive, job->applications, NULL, job->bundle, sizeof(job->bundle),
+                                  &job->stats);
+    return NULL;
+}
+
+// Two apps updated at once, each planning and staging on its own thread
+static void TestConcurrentUpdates(void) {
+    UpdateJob jobs[2] = {{.app = "A"}, {.app = "B"}};
+    pthread_t threads[2];
+    for (int round = 0; round < 10; round++) {
+        for (int i = 0; i < 2; i++) {
+            snprintf(jobs[i].applications, sizeof(jobs[i].applications), "%s/Concurrent%d", g_root, i);
+            mkdir(jobs[i].applications, 0755);
+            Install(jobs[i].app, jobs[i].applications);
+        }
+        for (int i = 0; i < 2; i++) pthread_create(&threads[i], NULL, UpdateMain, &jobs[i]);
+        for (int i = 0; i < 2; i++) {
+            pthread_join(threads[i], NULL);
+            HIAH_CHECK(jobs[i].result == 0);
+            CheckUpdated(jobs[i].bundle, jobs[i].app, &jobs[i].stats);
+            HIAHTestRemoveTree(jobs[i].applications);
+        }
+    }
+}
+
+int main(void) {
+    HIAH_CHECK(mkdtemp(g_root) != NULL);
+    TestUpdate();
+    TestConcurrentUpdates();
+    HIAHTestRemoveTree(g_root);
+    return HIAHTestFinish("HIAHDeltaUpdateTests");
+}
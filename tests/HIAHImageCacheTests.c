@@ -0,0 +1,141 @@
+/**
+ * HIAHImageCacheTests.c
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Reuse of loaded guest images, entry-point lookup, and replacing a binary
+ * on disk while an old image is idle or still running.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#include "HIAHImageCache.h"
+#include "HIAHTest.h"
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+static const char *const kEntryNames[] = { "ssh_main", "hello_entry", "main", NULL };
+
+static char g_dir[] = "/tmp/hiah-image-XXXXXX";
+
+static void CopyFile(const char *from, const char *to) {
+    FILE *in = fopen(from, "rb");
+    FILE *out = fopen(to, "wb");
+    HIAH_CHECK(in && out);
+    char buffer[65536];
+    size_t n;
+    while (in && out && (n = fread(buffer, 1, sizeof(buffer), in)) > 0) fwrite(buffer, 1, n, out);
+    if (in) fclose(in);
+    if (out) fclose(out);
+}
+
+// Replaces `path` with the given guest version the way an installer does:
+// a new file renamed over the old one
+static void InstallGuest(const char *path, int version) {
+    char built[PATH_MAX], staged[PATH_MAX];
+    snprintf(built, sizeof(built), "build/HIAHGuestImage%d.so", version);
+    snprintf(staged, sizeof(staged), "%s.new", path);
+    CopyFile(built, staged);
+    HIAH_CHECK(rename(staged, path) == 0);
+}
+
+static int Run(HIAHImage *image) {
+    HIAHImageEntryPoint entry = HIAHImageGetEntryPoint(image);
+    return entry ? entry(1, NULL) : -1;
+}
+
+static void TestMissing(void) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/missing", g_dir);
+    HIAH_CHECK(HIAHImageCacheAcquire(path, kEntryNames) == NULL);
+    HIAH_CHECK(HIAHImageCacheAcquire(NULL, kEntryNames) == NULL);
+    HIAHImageCacheRelease(NULL);
+}
+
+static void TestReuse(void) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/reuse", g_dir);
+    InstallGuest(path, 1);
+
+    HIAHImage *first = HIAHImageCacheAcquire(path, kEntryNames);
+    HIAH_CHECK(first && Run(first) == 101);
+    HIAHImage *second = HIAHImageCacheAcquire(path, kEntryNames);
+    HIAH_CHECK(second == first);
+    HIAHImageCacheRelease(second);
+    HIAHImageCacheRelease(first);
+
+    // Idle images stay loaded for the next spawn
+    HIAHImage *again = HIAHImageCacheAcquire(path, kEntryNames);
+    HIAH_CHECK(again == first);
+    HIAHImageCacheRelease(again);
+}
+
+static void TestEntryNames(void) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/names", g_dir);
+    InstallGuest(path, 1);
+
+    static const char *const none[] = { "ssh_main", "waypipe_main", NULL };
+    HIAHImage *image = HIAHImageCacheAcquire(path, none);
+    HIAH_CHECK(image && HIAHImageGetEntryPoint(image) == NULL);
+    HIAHImageCacheRelease(image);
+    HIAH_CHECK(HIAHImageGetEntryPoint(NULL) == NULL);
+}
+
+static void TestReplacedWhileIdle(void) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/idle", g_dir);
+    InstallGuest(path, 1);
+    HIAHImage *old = HIAHImageCacheAcquire(path, kEntryNames);
+    HIAH_CHECK(Run(old) == 101);
+    HIAHImageCacheRelease(old);
+
+    InstallGuest(path, 2);
+    HIAHImage *image = HIAHImageCacheAcquire(path, kEntryNames);
+    HIAH_CHECK(image && Run(image) == 201);
+    HIAHImageCacheRelease(image);
+}
+
+static void TestReplacedWhileRunning(void) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/running", g_dir);
+    InstallGuest(path, 1);
+    HIAHImage *running = HIAHImageCacheAcquire(path, kEntryNames);
+    HIAH_CHECK(Run(running) == 101);
+
+    // The loader hands back the old image while it is still loaded: the
+    // spawn runs it, but it must not be cached as the new file
+    InstallGuest(path, 2);
+    HIAHImage *interim = HIAHImageCacheAcquire(path, kEntryNames);
+    HIAH_CHECK(interim && interim != running && Run(interim) == 101);
+    HIAHImageCacheRelease(interim);
+    HIAHImageCacheRelease(running);
+
+    // Once the old image's last user is gone the new file loads
+    HIAHImage *image = HIAHImageCacheAcquire(path, kEntryNames);
+    HIAH_CHECK(image && Run(image) == 201);
+    HIAHImage *cached = HIAHImageCacheAcquire(path, kEntryNames);
+    HIAH_CHECK(cached == image);
+    HIAHImageCacheRelease(cached);
+    HIAHImageCacheRelease(image);
+}
+
+int main(void) {
+    HIAH_CHECK(mkdtemp(g_dir) != NULL);
+    TestMissing();
+    TestReuse();
+    TestEntryNames();
+    TestReplacedWhileIdle();
+    TestReplacedWhileRunning();
+
+    const char *names[] = { "reuse", "names", "idle", "running" };
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        char path[PATH_MAX];
+        snprintf(path, sizeof(path), "%s/%s", g_dir, names[i]);
+        unlink(path);
+    }
+    rmdir(g_dir);
+    return HIAHTestFinish("HIAHImageCacheTests");
+}
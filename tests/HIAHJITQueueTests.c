@@ -0,0 +1,246 @@
+/**
+ * HIAHJITQueueTests.c
+ * HIAH LoginWindow - JIT Enablement Work Queue tests
+ *
+ * Drives HIAHJITQueue against the stand-in attach service: success,
+ * coalescing, the concurrency limit, backoff between retries, giving up,
+ * processes exiting, cancellation and shutdown.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under AGPLv3
+ */
+
+#include "HIAHAttachStandIn.h"
+#include "HIAHJITQueue.h"
+#include "HIAHTest.h"
+#include <pthread.h>
+#include <unistd.h>
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    unsigned results[HIAHJITResultCancelled + 1];
+    unsigned total;
+    uint64_t lastNs;
+} Completions;
+
+static void CompletionsInit(Completions *c) {
+    *c = (Completions){0};
+    pthread_mutex_init(&c->lock, NULL);
+    pthread_cond_init(&c->cond, NULL);
+}
+
+static void Record(pid_t pid, HIAHJITResult result, void *context) {
+    (void)pid;
+    Completions *c = context;
+    pthread_mutex_lock(&c->lock);
+    c->results[result]++;
+    c->total++;
+    c->lastNs = HIAHTestNowNs();
+    pthread_cond_broadcast(&c->cond);
+    pthread_mutex_unlock(&c->lock);
+}
+
+// Waits up to 5 s for `count` completions in total
+static bool WaitFor(Completions *c, unsigned count) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += 5;
+    pthread_mutex_lock(&c->lock);
+    while (c->total < count) {
+        if (pthread_cond_timedwait(&c->cond, &c->lock, &deadline) != 0) break;
+    }
+    bool reached = c->total >= count;
+    pthread_mutex_unlock(&c->lock);
+    return reached;
+}
+
+static HIAHJITQueue *CreateQueue(HIAHAttachStandIn *service, unsigned maxConcurrent,
+                                 unsigned maxAttempts, uint32_t baseDelayMs) {
+    HIAHJITQueueConfig config = {
+        .maxConcurrent = maxConcurrent,
+        .maxAttempts = maxAttempts,
+        .baseDelayMs = baseDelayMs,
+        .maxDelayMs = baseDelayMs * 8,
+        .attach = HIAHAttachStandInAttach,
+        .isAlive = HIAHAttachStandInIsAlive,
+        .context = service,
+    };
+    return HIAHJITQueueCreate(&config);
+}
+
+static void TestEnable(void) {
+    HIAHAttachStandIn *service = HIAHAttachStandInCreate();
+    HIAHAttachStandInSpawn(service, 101, 0, 1);
+    HIAHJITQueue *queue = CreateQueue(service, 2, 3, 10);
+    Completions c;
+    CompletionsInit(&c);
+
+    HIAH_CHECK(HIAHJITQueueSubmit(queue, 101, Record, &c));
+    HIAH_CHECK(WaitFor(&c, 1));
+    HIAH_CHECK(c.results[HIAHJITResultEnabled] == 1);
+    HIAH_CHECK(HIAHAttachStandInAttempts(service, 101) == 1);
+
+    HIAHJITQueueMetrics metrics;
+    HIAHJITQueueGetMetrics(queue, &metrics);
+    HIAH_CHECK(metrics.submitted == 1 && metrics.enabled == 1 && metrics.attempts == 1);
+    HIAH_CHECK(metrics.depth == 0 && metrics.inFlight == 0);
+
+    HIAHJITQueueDestroy(queue);
+    HIAHAttachStandInDestroy(service);
+}
+
+static void TestCoalescing(void) {
+    HIAHAttachStandIn *service = HIAHAttachStandInCreate();
+    HIAHAttachStandInSpawn(service, 102, 0, 50);
+    HIAHJITQueue *queue = CreateQueue(service, 2, 3, 10);
+    Completions c;
+    CompletionsInit(&c);
+
+    HIAH_CHECK(HIAHJITQueueSubmit(queue, 102, Record, &c));
+    for (int i = 0; i < 4; i++) {
+        HIAH_CHECK(!HIAHJITQueueSubmit(queue, 102, Record, &c));
+    }
+    HIAH_CHECK(WaitFor(&c, 5));
+    // Every submitter hears about the one attach
+    HIAH_CHECK(c.results[HIAHJITResultEnabled] == 5);
+    HIAH_CHECK(HIAHAttachStandInAttempts(service, 102) == 1);
+
+    HIAHJITQueueMetrics metrics;
+    HIAHJITQueueGetMetrics(queue, &metrics);
+    HIAH_CHECK(metrics.coalesced == 4);
+
+    HIAHJITQueueDestroy(queue);
+    HIAHAttachStandInDestroy(service);
+}
+
+static void TestConcurrencyLimit(void) {
+    HIAHAttachStandIn *service = HIAHAttachStandInCreate();
+    for (pid_t pid = 200; pid < 212; pid++) {
+        HIAHAttachStandInSpawn(service, pid, pid % 2, 10);
+    }
+    HIAHJITQueue *queue = CreateQueue(service, 3, 4, 5);
+    Completions c;
+    CompletionsInit(&c);
+
+    for (pid_t pid = 200; pid < 212; pid++) {
+        HIAHJITQueueSubmit(queue, pid, Record, &c);
+    }
+    HIAH_CHECK(WaitFor(&c, 12));
+    HIAH_CHECK(c.results[HIAHJITResultEnabled] == 12);
+    HIAH_CHECK(HIAHAttachStandInPeakConcurrency(service) <= 3);
+    HIAH_CHECK(HIAHAttachStandInPeakConcurrency(service) >= 2);
+    HIAH_CHECK(!HIAHAttachStandInSawOverlap(service));
+
+    HIAHJITQueueDestroy(queue);
+    HIAHAttachStandInDestroy(service);
+}
+
+static void TestBackoff(void) {
+    HIAHAttachStandIn *service = HIAHAttachStandInCreate();
+    HIAHAttachStandInSpawn(service, 103, 2, 0);
+    HIAHJITQueue *queue = CreateQueue(service, 1, 5, 40);
+    Completions c;
+    CompletionsInit(&c);
+
+    uint64_t start = HIAHTestNowNs();
+    HIAHJITQueueSubmit(queue, 103, Record, &c);
+    HIAH_CHECK(WaitFor(&c, 1));
+    HIAH_CHECK(c.results[HIAHJITResultEnabled] == 1);
+    HIAH_CHECK(HIAHAttachStandInAttempts(service, 103) == 3);
+    // Equal jitter: at least half of 40 ms, then half of 80 ms
+    HIAH_CHECK(c.lastNs - start >= 60 * 1000000ull);
+
+    HIAHJITQueueDestroy(queue);
+    HIAHAttachStandInDestroy(service);
+}
+
+static void TestGivesUp(void) {
+    HIAHAttachStandIn *service = HIAHAttachStandInCreate();
+    HIAHAttachStandInSpawn(service, 104, UINT32_MAX, 0);
+    HIAHJITQueue *queue = CreateQueue(service, 1, 3, 2);
+    Completions c;
+    CompletionsInit(&c);
+
+    HIAHJITQueueSubmit(queue, 104, Record, &c);
+    HIAH_CHECK(WaitFor(&c, 1));
+    HIAH_CHECK(c.results[HIAHJITResultFailed] == 1);
+    HIAH_CHECK(HIAHAttachStandInAttempts(service, 104) == 3);
+
+    HIAHJITQueueDestroy(queue);
+    HIAHAttachStandInDestroy(service);
+}
+
+static void TestProcessExit(void) {
+    HIAHAttachStandIn *service = HIAHAttachStandInCreate();
+    HIAHAttachStandInSpawn(service, 105, UINT32_MAX, 0);
+    HIAHJITQueue *queue = CreateQueue(service, 1, 10, 50);
+    Completions c;
+    CompletionsInit(&c);
+
+    HIAHJITQueueSubmit(queue, 105, Record, &c);
+    // Exits while backing off after the first failure
+    usleep(10 * 1000);
+    HIAHAttachStandInExit(service, 105);
+    HIAH_CHECK(WaitFor(&c, 1));
+    HIAH_CHECK(c.results[HIAHJITResultProcessExited] == 1);
+    HIAH_CHECK(HIAHAttachStandInAttempts(service, 105) == 1);
+
+    HIAHJITQueueDestroy(queue);
+    HIAHAttachStandInDestroy(service);
+}
+
+static void TestCancel(void) {
+    HIAHAttachStandIn *service = HIAHAttachStandInCreate();
+    HIAHAttachStandInSpawn(service, 106, UINT32_MAX, 0);
+    HIAHAttachStandInSpawn(service, 107, UINT32_MAX, 100);
+    HIAHJITQueue *queue = CreateQueue(service, 2, 10, 200);
+    Completions c;
+    CompletionsInit(&c);
+
+    HIAHJITQueueSubmit(queue, 106, Record, &c);
+    HIAHJITQueueSubmit(queue, 107, Record, &c);
+    usleep(20 * 1000);
+    // 106 is backing off and ends at once; 107 is mid-attach and ends
+    // after it, without a retry
+    HIAHJITQueueCancel(queue, 106);
+    HIAHJITQueueCancel(queue, 107);
+    HIAH_CHECK(WaitFor(&c, 2));
+    HIAH_CHECK(c.results[HIAHJITResultCancelled] == 2);
+    HIAH_CHECK(HIAHAttachStandInAttempts(service, 106) == 1);
+    HIAH_CHECK(HIAHAttachStandInAttempts(service, 107) == 1);
+
+    HIAHJITQueueDestroy(queue);
+    HIAHAttachStandInDestroy(service);
+}
+
+static void TestDestroyCancelsOutstanding(void) {
+    HIAHAttachStandIn *service = HIAHAttachStandInCreate();
+    for (pid_t pid = 300; pid < 304; pid++) {
+        HIAHAttachStandInSpawn(service, pid, UINT32_MAX, 0);
+    }
+    HIAHJITQueue *queue = CreateQueue(service, 1, 10, 1000);
+    Completions c;
+    CompletionsInit(&c);
+
+    for (pid_t pid = 300; pid < 304; pid++) {
+        HIAHJITQueueSubmit(queue, pid, Record, &c);
+    }
+    usleep(20 * 1000);
+    HIAHJITQueueDestroy(queue);
+    HIAH_CHECK(c.total == 4);
+    HIAH_CHECK(c.results[HIAHJITResultCancelled] == 4);
+    HIAHAttachStandInDestroy(service);
+}
+
+int main(void) {
+    TestEnable();
+    TestCoalescing();
+    TestConcurrencyLimit();
+    TestBackoff();
+    TestGivesUp();
+    TestProcessExit();
+    TestCancel();
+    TestDestroyCancelsOutstanding();
+    return HIAHTestFinish("HIAHJITQueueTests");
+}
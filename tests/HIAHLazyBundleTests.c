@@ -0,0 +1,99 @@
+/**
+ * HIAHLazyBundleTests.c
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Lazy installs of a fixture app: what is extracted at install time, the
+ * placeholders left for the rest, and stat and fill through a mount,
+ * checked against a full extraction of the same archive.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#include "HIAHLazyBundle.h"
+#include "HIAHTest.h"
+#include <errno.h>
+#include <limits.h>
+#include <sys/stat.h>
+
+#define HIAH_FIXTURES "fixtures/"
+
+static char g_root[] = "/tmp/hiah-lazy-XXXXXX";
+
+static bool SameFile(const char *a, const char *b) {
+    FILE *fileA = fopen(a, "rb"), *fileB = fopen(b, "rb");
+    bool same = fileA && fileB;
+    while (same) {
+        int byteA = fgetc(fileA), byteB = fgetc(fileB);
+        same = byteA == byteB;
+        if (byteA == EOF) break;
+    }
+    if (fileA) fclose(fileA);
+    if (fileB) fclose(fileB);
+    return same;
+}
+
+static off_t Size(const char *bundle, const char *name) {
+    char path[PATH_MAX];
+    struct stat st;
+    snprintf(path, sizeof(path), "%s/%s", bundle, name);
+    return lstat(path, &st) == 0 ? st.st_size : -1;
+}
+
+int main(void) {
+    HIAH_CHECK(mkdtemp(g_root) != NULL);
+    char applications[PATH_MAX], full[PATH_MAX], bundle[PATH_MAX], path[PATH_MAX], reference[PATH_MAX];
+    snprintf(applications, sizeof(applications), "%s/Applications", g_root);
+    snprintf(full, sizeof(full), "%s/full", g_root);
+    mkdir(applications, 0755);
+    HIAH_CHECK(HIAHZipExtract(HIAH_FIXTURES "A-v1.ipa", full, 1, NULL, NULL) == 0);
+
+    HIAHLazyInstallStats stats;
+    HIAH_CHECK(HIAHLazyBundleInstall(HIAH_FIXTURES "Info.bplist", applications, NULL, bundle,
+                                     sizeof(bundle), &stats) == EILSEQ);
+    HIAH_CHECK(HIAHLazyBundleInstall(HIAH_FIXTURES "A-v1.ipa", applications, NULL, bundle, sizeof(bundle),
+                                     &stats) == 0);
+    snprintf(path, sizeof(path), "%s/A.app", applications);
+    HIAH_CHECK(strcmp(bundle, path) == 0);
+
+    // The executable, Info.plist, framework and symlink are written out;
+    // resources are placeholders
+    HIAH_CHECK(stats.eagerFiles == 4 && stats.lazyFiles == 3);
+    HIAH_CHECK(stats.lazyBytes == 16384 + 4 + 1);
+    HIAH_CHECK(Size(bundle, "A") == 4000 && Size(bundle, "Info.plist") == 16);
+    HIAH_CHECK(Size(bundle, "Frameworks/F.framework/F") == 900);
+    HIAH_CHECK(Size(bundle, "res/keep.png") == 0 && Size(bundle, "old/x") == 0);
+    struct stat st;
+    snprintf(path, sizeof(path), "%s/A", bundle);
+    HIAH_CHECK(stat(path, &st) == 0 && (st.st_mode & 0111));
+    char target[PATH_MAX] = {0};
+    snprintf(path, sizeof(path), "%s/link", bundle);
+    HIAH_CHECK(readlink(path, target, sizeof(target) - 1) == 12 && strcmp(target, "res/keep.png") == 0);
+    snprintf(path, sizeof(path), "%s/A", bundle);
+    snprintf(reference, sizeof(reference), "%s/Payload/A.app/A", full);
+    HIAH_CHECK(SameFile(path, reference));
+
+    // Through a mount: full sizes before filling, contents after
+    snprintf(path, sizeof(path), "%s/res/keep.png", bundle);
+    HIAH_CHECK(!HIAHLazyBundleStat(path, &st));
+    HIAH_CHECK(HIAHLazyBundleMount(bundle));
+    HIAH_CHECK(HIAHLazyBundleMount(bundle));
+    HIAH_CHECK(HIAHLazyBundleStat(path, &st) && st.st_size == 16384);
+    HIAH_CHECK(HIAHLazyBundleFill(path) == 0);
+    snprintf(reference, sizeof(reference), "%s/Payload/A.app/res/keep.png", full);
+    HIAH_CHECK(SameFile(path, reference));
+    HIAH_CHECK(HIAHLazyBundleFill(path) == 0);
+    HIAH_CHECK(SameFile(path, reference));
+
+    // Eager files and paths outside the bundle aren't served from the archive
+    snprintf(path, sizeof(path), "%s/A", bundle);
+    HIAH_CHECK(!HIAHLazyBundleStat(path, &st));
+    HIAH_CHECK(HIAHLazyBundleFill(path) == 0);
+    HIAH_CHECK(HIAHLazyBundleFill("/etc/hostname") == 0);
+
+    snprintf(path, sizeof(path), "%s/old/x", bundle);
+    HIAH_CHECK(HIAHLazyBundleFill(path) == 0 && HIAHTestFileEquals(path, "x", 1));
+
+    HIAHTestRemoveTree(g_root);
+    return HIAHTestFinish("HIAHLazyBundleTests");
+}
@@ -0,0 +1,95 @@
+/**
+ * HIAHLoggingTests.c
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Checks that deferred records render exactly like printf, that errors
+ * reach the sink before the logging call returns, and that a sink which
+ * logs does not deadlock the drain.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#include "HIAHLogging.h"
+#include "HIAHTest.h"
+#include <string.h>
+
+static char g_last[4096];
+static HIAHLogLevel g_lastLevel;
+static int g_delivered;
+
+static void CaptureSink(void *context, const HIAHLogEntry *entry) {
+    (void)context;
+    if (!entry) return;
+    size_t length = MIN(entry->length, sizeof(g_last) - 1);
+    memcpy(g_last, entry->message, length);
+    g_last[length] = '\0';
+    g_lastLevel = entry->level;
+    g_delivered++;
+}
+
+// Records `fmt` through the logger and through snprintf and compares
+#define CHECK_RENDERS_LIKE_PRINTF(fmt, ...)                                     \
+    do {                                                                        \
+        char expected[512];                                                     \
+        snprintf(expected, sizeof(expected), fmt, __VA_ARGS__);                 \
+        _HIAHLogRecord("test", HIAHLogLevelInfo, fmt, __VA_ARGS__);             \
+        HIAHLogFlush();                                                         \
+        HIAH_CHECK(strcmp(g_last, expected) == 0);                              \
+    } while (0)
+
+static void TestRendering(void) {
+    CHECK_RENDERS_LIKE_PRINTF("hello %s %d %lu", "world", 42, (unsigned long)7);
+    CHECK_RENDERS_LIKE_PRINTF("%5.2f|%-6lld|%zu|%c|%%", 3.14159, -12ll, (size_t)9, 'A');
+    CHECK_RENDERS_LIKE_PRINTF("%#08x %.*s %*d", 0xbeef, 3, "abcdef", 6, -5);
+    CHECK_RENDERS_LIKE_PRINTF("%hhd %hu %jd %td", (char)300, (unsigned short)70000,
+                              (intmax_t)-1, (ptrdiff_t)12);
+    CHECK_RENDERS_LIKE_PRINTF("%p %g %e", (void *)0x1234, 1e10, 2.5);
+    // Wide strings can't be deferred and are formatted on the spot
+    CHECK_RENDERS_LIKE_PRINTF("wide %ls end", L"xx");
+}
+
+static void TestErrorsAreSynchronous(void) {
+    HIAHLogFlush();
+    int before = g_delivered;
+    HIAHLogInfo(HIAHLogKernel, "deferred %d", 1);
+    HIAH_CHECK(g_delivered == before);
+
+    // The error drains everything recorded so far, in order
+    HIAHLogError(HIAHLogKernel, "failed: %s", "boom");
+    HIAH_CHECK(g_delivered == before + 2);
+    HIAH_CHECK(g_lastLevel == HIAHLogLevelError);
+    HIAH_CHECK(strcmp(g_last, "failed: boom") == 0);
+
+    HIAHLogFault(HIAHLogKernel, "fault %d", 2);
+    HIAH_CHECK(g_delivered == before + 3);
+}
+
+static int g_nested;
+
+static void LoggingSink(void *context, const HIAHLogEntry *entry) {
+    CaptureSink(context, entry);
+    if (entry && !g_nested) {
+        g_nested = 1;
+        HIAHLogError(HIAHLogKernel, "logged from a sink");
+    }
+}
+
+static void TestErrorFromSink(void) {
+    HIAHLogSetSink(LoggingSink, NULL);
+    HIAHLogError(HIAHLogKernel, "outer");
+    HIAH_CHECK(strcmp(g_last, "outer") == 0);
+    // The nested error waits for the next drain instead of deadlocking
+    HIAHLogFlush();
+    HIAH_CHECK(strcmp(g_last, "logged from a sink") == 0);
+    HIAHLogSetSink(CaptureSink, NULL);
+}
+
+int main(void) {
+    HIAHLogSetSink(CaptureSink, NULL);
+    TestRendering();
+    TestErrorsAreSynchronous();
+    TestErrorFromSink();
+    HIAH_CHECK(HIAHLogDroppedCount() == 0);
+    return HIAHTestFinish("HIAHLoggingTests");
+}
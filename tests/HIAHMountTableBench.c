@@ -0,0 +1,104 @@
+/**
+ * HIAHMountTableBench.c
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Read resolutions per second through the mount table and the cache's hit
+ * rate, for a hot set of tools, libraries and config files and for a
+ * shell-like mix that also searches PATH for missing names.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#include "HIAHMountTable.h"
+#include "HIAHTest.h"
+#include <limits.h>
+#include <sys/stat.h>
+
+enum { HOT = 48, TAIL = 4096, ROUNDS = 1000000 };
+
+static char g_root[] = "/tmp/hiah-mount-bench-XXXXXX";
+static char g_hot[HOT][64];
+static char g_tail[TAIL][64];
+
+static void Make(const char *format, int index) {
+    char name[64], path[PATH_MAX];
+    snprintf(name, sizeof(name), format, index);
+    snprintf(path, sizeof(path), "%s%s", g_root, name);
+    HIAHTestWriteFile(path, "x", 1, 0755);
+}
+
+static void MakeDirectory(const char *name) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s%s", g_root, name);
+    mkdir(path, 0755);
+}
+
+static void Mount(const char *virtualPath, const char *backing, const char *lower) {
+    char backingPath[PATH_MAX], lowerPath[PATH_MAX];
+    snprintf(backingPath, sizeof(backingPath), "%s%s", g_root, backing);
+    snprintf(lowerPath, sizeof(lowerPath), "%s%s", g_root, lower ? lower : "");
+    HIAH_CHECK(HIAHMountAdd(virtualPath, backingPath, lower ? lowerPath : NULL, 0) == 0);
+}
+
+// `hotShare` of 1000 lookups go to the hot set, the rest to the tail.
+// Writes resolve without the cache, so they give the uncached cost of the
+// same paths (all of which are in backing directories).
+static void Run(const char *label, unsigned hotShare, uint32_t flags) {
+    HIAHMountStats before, after;
+    HIAHMountGetStats(&before);
+    char resolved[PATH_MAX];
+    unsigned seed = 1;
+    uint64_t begin = HIAHTestNowNs();
+    for (int i = 0; i < ROUNDS; i++) {
+        seed = seed * 1103515245 + 12345;
+        unsigned pick = (seed >> 8) % 1000;
+        const char *path = pick < hotShare ? g_hot[(seed >> 4) % HOT] : g_tail[(seed >> 4) % TAIL];
+        HIAHMountResolve(path, flags, resolved, sizeof(resolved));
+    }
+    double seconds = (double)(HIAHTestNowNs() - begin) / 1e9;
+    HIAHMountGetStats(&after);
+    printf("%-36s %6.2f M resolutions/s", label, ROUNDS / seconds / 1e6);
+    uint64_t lookups = after.lookups - before.lookups;
+    if (lookups) printf(", hit rate %.1f%%", 100.0 * (double)(after.hits - before.hits) / (double)lookups);
+    printf("\n");
+}
+
+int main(void) {
+    HIAH_CHECK(mkdtemp(g_root) != NULL);
+    const char *directories[] = {"/docs", "/docs/bin", "/docs/usr", "/docs/usr/bin", "/docs/usr/local",
+                                 "/docs/usr/local/bin", "/docs/etc", "/docs/home", "/docs/home/u", "/host",
+                                 "/host/usr", "/host/usr/bin", "/host/usr/lib", "/host/etc"};
+    for (size_t i = 0; i < sizeof(directories) / sizeof(directories[0]); i++) MakeDirectory(directories[i]);
+    Mount("/bin", "/docs/bin", NULL);
+    Mount("/usr", "/docs/usr", "/host/usr");
+    Mount("/etc", "/docs/etc", "/host/etc");
+    Mount("/home", "/docs/home", NULL);
+
+    // Hot set: tools, config and home files in backing directories
+    const char *hotFormats[] = {"/bin/tool%d", "/usr/local/bin/tool%d", "/etc/conf%d", "/home/u/file%d"};
+    for (int i = 0; i < HOT; i++) {
+        const char *format = hotFormats[i % 4];
+        snprintf(g_hot[i], sizeof(g_hot[i]), format, i);
+        char backing[64];
+        snprintf(backing, sizeof(backing), "/docs%s", format);
+        Make(backing, i);
+    }
+
+    // Tail: PATH and library searches, mostly for names that don't exist,
+    // and host paths under no mount
+    const char *tailFormats[] = {"/usr/bin/cmd%d", "/bin/cmd%d", "/usr/lib/lib%d.dylib", "/etc/file%d",
+                                 "/home/u/doc%d", "/usr/local/bin/cmd%d", "/var/mobile/Library/item%d",
+                                 "/System/Library/Frameworks/F%d.framework"};
+    for (int i = 0; i < TAIL; i++) snprintf(g_tail[i], sizeof(g_tail[i]), tailFormats[i % 8], i);
+    for (int i = 0; i < TAIL; i += 16) Make("/host/usr/lib/lib%d.dylib", i);
+
+    Run("hot set, uncached (write lookups)", 1000, HIAHMountResolveWrite);
+    Run("hot set, cached", 1000, 0);
+    Run("shell mix (80% hot), cached", 800, 0);
+    Run("tail only, cached", 0, 0);
+
+    HIAHMountRemoveAll();
+    HIAHTestRemoveTree(g_root);
+    return HIAHTestFinish("HIAHMountTableBench");
+}
@@ -0,0 +1,193 @@
+/**
+ * HIAHMountTableTests.c
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Path translation through the mount table: deepest mounts, overlays,
+ * read-only mounts, symlinks, normalization, and which resolutions the
+ * cache may answer once files come and go.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#include "HIAHMountTable.h"
+#include "HIAHTest.h"
+#include <errno.h>
+#include <limits.h>
+#include <sys/stat.h>
+
+static char g_root[] = "/tmp/hiah-mount-XXXXXX";
+
+// "(none)" if not virtual, "E<errno>" on failure, else the translation
+// with the test root cut off
+static const char *Resolve(const char *path, uint32_t flags) {
+    static char result[PATH_MAX];
+    char resolved[PATH_MAX];
+    int translated = HIAHMountResolve(path, flags, resolved, sizeof(resolved));
+    size_t rootLength = strlen(g_root);
+    if (translated == 0) snprintf(result, sizeof(result), "(none)");
+    else if (translated < 0) snprintf(result, sizeof(result), "E%d", errno);
+    else if (strncmp(resolved, g_root, rootLength) == 0) snprintf(result, sizeof(result), "%s", resolved + rootLength);
+    else snprintf(result, sizeof(result), "%s", resolved);
+    return result;
+}
+
+static void Make(const char *name) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s%s", g_root, name);
+    HIAHTestWriteFile(path, "x", 1, 0644);
+}
+
+static void Remove(const char *name) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s%s", g_root, name);
+    unlink(path);
+}
+
+static void Link(const char *target, const char *name) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s%s", g_root, name);
+    unlink(path);
+    HIAH_CHECK(symlink(target, path) == 0);
+}
+
+static int Mount(const char *virtualPath, const char *backing, const char *lower, uint32_t flags) {
+    char backingPath[PATH_MAX], lowerPath[PATH_MAX];
+    snprintf(backingPath, sizeof(backingPath), "%s%s", g_root, backing);
+    snprintf(lowerPath, sizeof(lowerPath), "%s%s", g_root, lower ? lower : "");
+    return HIAHMountAdd(virtualPath, backingPath, lower ? lowerPath : NULL, flags);
+}
+
+static uint64_t Hits(void) {
+    HIAHMountStats stats;
+    HIAHMountGetStats(&stats);
+    return stats.hits;
+}
+
+#define EXPECT(path, flags, want) HIAH_CHECK(strcmp(Resolve(path, flags), want) == 0)
+
+int main(void) {
+    HIAH_CHECK(mkdtemp(g_root) != NULL);
+    const char *directories[] = {"/docs/usr/bin", "/docs/usr/local/bin", "/host/usr/bin", "/host/usr/lib",
+                                 "/docs/etc", "/host/etc", "/docs/home/u", "/ro/share", "/docs/bin"};
+    for (size_t i = 0; i < sizeof(directories) / sizeof(directories[0]); i++) {
+        char path[PATH_MAX];
+        snprintf(path, sizeof(path), "%s%s/.keep", g_root, directories[i]);
+        for (char *slash = path + strlen(g_root) + 1; (slash = strchr(slash, '/')); slash++) {
+            *slash = '\0';
+            mkdir(path, 0755);
+            *slash = '/';
+        }
+        HIAHTestWriteFile(path, "", 0, 0644);
+    }
+    Make("/docs/usr/bin/ls");
+    Make("/host/usr/bin/ls");
+    Make("/host/usr/bin/env");
+    Make("/host/usr/lib/libz.dylib");
+    Make("/docs/usr/local/bin/tool");
+    Make("/host/etc/hosts");
+    Make("/docs/etc/profile");
+    Make("/ro/share/data");
+    Make("/docs/bin/bash");
+    Link("/bin/bash", "/docs/bin/sh");
+    Link("bash", "/docs/bin/rbash");
+    Link("/usr/lib", "/docs/home/u/lib");
+    Link("loop2", "/docs/home/u/loop1");
+    Link("loop1", "/docs/home/u/loop2");
+
+    HIAHMountStats stats;
+    HIAHMountGetStats(&stats);
+    HIAH_CHECK(stats.mounts == 0);
+    EXPECT("/usr/bin/ls", 0, "(none)");
+    HIAH_CHECK(HIAHMountAdd("usr", "/x", NULL, 0) == EINVAL);
+    HIAH_CHECK(Mount("/usr", "/docs/usr", "/host/usr", 0) == 0);
+    HIAH_CHECK(Mount("/etc", "/docs/etc", "/host/etc", 0) == 0);
+    HIAH_CHECK(Mount("/bin", "/docs/bin", NULL, 0) == 0);
+    HIAH_CHECK(Mount("/home/", "/docs/home", NULL, 0) == 0);
+    HIAH_CHECK(Mount("/usr/share", "/ro/share", NULL, HIAHMountReadOnly) == 0);
+    HIAH_CHECK(Mount("/var/db", "/docs/var/db", NULL, 0) == 0);
+    HIAHMountGetStats(&stats);
+    HIAH_CHECK(stats.mounts == 6);
+
+    // The second pass is answered from the cache where it may be
+    for (int pass = 0; pass < 2; pass++) {
+        EXPECT("/usr/bin/ls", 0, "/docs/usr/bin/ls");
+        EXPECT("/usr/bin/env", 0, "/host/usr/bin/env");
+        EXPECT("/usr//bin/./../bin/env", 0, "/host/usr/bin/env");
+        EXPECT("/usr/bin/new", 0, "/docs/usr/bin/new");
+        EXPECT("/usr/local/bin/tool", 0, "/docs/usr/local/bin/tool");
+        EXPECT("/etc/hosts", 0, "/host/etc/hosts");
+        EXPECT("/usr/share/data", 0, "/ro/share/data");
+        EXPECT("/usrx/foo", 0, "(none)");
+        EXPECT("/var/mobile/Containers", 0, "(none)");
+        EXPECT("/var/db/x", 0, "/docs/var/db/x");
+        EXPECT("relative", 0, "(none)");
+        EXPECT("/bin/sh", 0, "/docs/bin/bash");
+        EXPECT("/bin/sh", HIAHMountResolveNoFollow, "/docs/bin/sh");
+        EXPECT("/bin/rbash", 0, "/docs/bin/bash");
+        EXPECT("/home/u/lib/libz.dylib", 0, "/host/usr/lib/libz.dylib");
+        EXPECT("/home/u/loop1", 0, "E40");
+        EXPECT("/home/u/..", 0, "/docs/home");
+    }
+
+    // Writes go to the backing directory, never to a lower or read-only one
+    EXPECT("/usr/bin/env", HIAHMountResolveWrite, "E30");
+    EXPECT("/usr/bin/ls", HIAHMountResolveWrite, "/docs/usr/bin/ls");
+    EXPECT("/usr/bin/new", HIAHMountResolveWrite, "/docs/usr/bin/new");
+    EXPECT("/usr/share/data", HIAHMountResolveWrite, "E30");
+    EXPECT("/usr/share/new", HIAHMountResolveWrite, "E30");
+
+    // Backing-directory and unmounted paths are cached; lower-layer,
+    // missing overlay and symlinked paths are looked up again
+    uint64_t hits = Hits();
+    EXPECT("/usr/bin/ls", 0, "/docs/usr/bin/ls");
+    EXPECT("/usrx/foo", 0, "(none)");
+    HIAH_CHECK(Hits() == hits + 2);
+    hits = Hits();
+    EXPECT("/usr/bin/env", 0, "/host/usr/bin/env");
+    EXPECT("/usr/bin/new", 0, "/docs/usr/bin/new");
+    EXPECT("/bin/sh", 0, "/docs/bin/bash");
+    HIAH_CHECK(Hits() == hits);
+
+    // So files coming and going need no invalidation
+    Make("/docs/usr/bin/env");
+    EXPECT("/usr/bin/env", 0, "/docs/usr/bin/env");
+    Make("/host/usr/bin/new");
+    EXPECT("/usr/bin/new", 0, "/host/usr/bin/new");
+    Make("/docs/bin/zsh");
+    Link("zsh", "/docs/bin/sh");
+    EXPECT("/bin/sh", 0, "/docs/bin/zsh");
+    EXPECT("/usr/bin/other", 0, "/docs/usr/bin/other");
+    Make("/docs/usr/bin/other");
+    EXPECT("/usr/bin/other", 0, "/docs/usr/bin/other");
+
+    // Removing a cached backing file uncovers the lower one only after an
+    // invalidation
+    Remove("/docs/usr/bin/ls");
+    EXPECT("/usr/bin/ls", 0, "/docs/usr/bin/ls");
+    HIAHMountInvalidateCache();
+    EXPECT("/usr/bin/ls", 0, "/host/usr/bin/ls");
+
+    // Remounting invalidates cached answers
+    EXPECT("/usr/bin/.keep", 0, "/docs/usr/bin/.keep");
+    HIAH_CHECK(Mount("/usr/bin", "/docs/bin", NULL, 0) == 0);
+    EXPECT("/usr/bin/.keep", 0, "/docs/bin/.keep");
+    EXPECT("/usr/bin/ls", 0, "/docs/bin/ls");
+    EXPECT("/usr/lib/libz.dylib", 0, "/host/usr/lib/libz.dylib");
+
+    // Saved tables load back; mounts that can't be reached are skipped
+    char saved[PATH_MAX];
+    snprintf(saved, sizeof(saved), "%s/%s", g_root, HIAH_MOUNT_TABLE_FILE);
+    HIAH_CHECK(HIAHMountSave(saved) == 0);
+    HIAHMountRemoveAll();
+    EXPECT("/usr/lib/libz.dylib", 0, "(none)");
+    HIAH_CHECK(HIAHMountLoad(saved) == 0);
+    HIAHMountGetStats(&stats);
+    HIAH_CHECK(stats.mounts == 6);
+    EXPECT("/usr/lib/libz.dylib", 0, "/host/usr/lib/libz.dylib");
+    EXPECT("/var/db/x", 0, "(none)");
+
+    HIAHMountRemoveAll();
+    HIAHTestRemoveTree(g_root);
+    return HIAHTestFinish("HIAHMountTableTests");
+}
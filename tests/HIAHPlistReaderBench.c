@@ -0,0 +1,250 @@
+/**
+ * HIAHPlistReaderBench.c
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Reading three Info.plist keys with HIAHPlistReader, against decoding the
+ * whole plist into a tree first and looking the keys up in it.
+ *
+ * CFPropertyList and libplist are not available on Linux, so the full
+ * decode is the bplist00 decoder below. Like them it allocates a node per
+ * object and converts UTF-16 strings, which is the work the reader skips.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#include "HIAHPlistReader.h"
+#include "HIAHTest.h"
+#include <string.h>
+
+#ifndef HIAH_FIXTURES
+#define HIAH_FIXTURES "fixtures/"
+#endif
+
+#define ITERATIONS 200000
+
+static const char *const kKeys[] = { "CFBundleExecutable", "CFBundleIdentifier", "NSPrincipalClass" };
+
+#pragma mark - Full Decode
+
+typedef struct Node {
+    uint8_t marker;               // High nibble of the bplist object marker
+    size_t count;                 // Array elements, dict entries, string bytes
+    char *string;                 // Strings (as UTF-8) and data
+    int64_t integer;
+    struct Node **children;       // Dicts: keys, then values
+} Node;
+
+typedef struct {
+    const uint8_t *bytes;
+    size_t length;
+    uint8_t offsetSize;
+    uint8_t refSize;
+    uint64_t objectCount;
+    uint64_t offsetTable;
+} Decoder;
+
+static uint64_t ReadBE(const uint8_t *p, size_t size) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < size; i++) value = value << 8 | p[i];
+    return value;
+}
+
+static Node *DecodeObject(const Decoder *d, uint64_t ref, int depth);
+
+// Length that follows a marker whose low nibble is 0xF
+static size_t DecodeCount(const Decoder *d, const uint8_t **p, uint8_t low) {
+    if (low != 0xF) return low;
+    uint8_t size = (uint8_t)(1u << (**p & 0xF));
+    uint64_t count = ReadBE(*p + 1, size);
+    *p += 1 + size;
+    return (size_t)count;
+}
+
+static Node *DecodeObject(const Decoder *d, uint64_t ref, int depth) {
+    if (ref >= d->objectCount || depth > 32) return NULL;
+    const uint8_t *p = d->bytes + ReadBE(d->bytes + d->offsetTable + ref * d->offsetSize, d->offsetSize);
+    Node *node = calloc(1, sizeof(Node));
+    uint8_t marker = *p++;
+    node->marker = marker >> 4;
+    uint8_t low = marker & 0xF;
+
+    switch (node->marker) {
+        case 0x1:
+            node->integer = (int64_t)ReadBE(p, (size_t)1 << low);
+            break;
+        case 0x4:
+        case 0x5: {
+            node->count = DecodeCount(d, &p, low);
+            node->string = malloc(node->count + 1);
+            memcpy(node->string, p, node->count);
+            node->string[node->count] = '\0';
+            break;
+        }
+        case 0x6: {
+            size_t units = DecodeCount(d, &p, low);
+            node->string = malloc(units * 4 + 1);
+            size_t used = 0;
+            for (size_t i = 0; i < units; i++) {
+                uint32_t c = (uint32_t)ReadBE(p + i * 2, 2);
+                if (c >= 0xD800 && c < 0xDC00 && i + 1 < units) {
+                    c = 0x10000 + ((c - 0xD800) << 10) + ((uint32_t)ReadBE(p + ++i * 2, 2) - 0xDC00);
+                }
+                if (c < 0x80) {
+                    node->string[used++] = (char)c;
+                } else if (c < 0x800) {
+                    node->string[used++] = (char)(0xC0 | c >> 6);
+                    node->string[used++] = (char)(0x80 | (c & 0x3F));
+                } else if (c < 0x10000) {
+                    node->string[used++] = (char)(0xE0 | c >> 12);
+                    node->string[used++] = (char)(0x80 | (c >> 6 & 0x3F));
+                    node->string[used++] = (char)(0x80 | (c & 0x3F));
+                } else {
+                    node->string[used++] = (char)(0xF0 | c >> 18);
+                    node->string[used++] = (char)(0x80 | (c >> 12 & 0x3F));
+                    node->string[used++] = (char)(0x80 | (c >> 6 & 0x3F));
+                    node->string[used++] = (char)(0x80 | (c & 0x3F));
+                }
+            }
+            node->string[used] = '\0';
+            node->count = used;
+            node->marker = 0x5;
+            break;
+        }
+        case 0xA:
+        case 0xD: {
+            node->count = DecodeCount(d, &p, low);
+            size_t refs = node->marker == 0xD ? node->count * 2 : node->count;
+            node->children = calloc(refs ? refs : 1, sizeof(Node *));
+            for (size_t i = 0; i < refs; i++) {
+                node->children[i] = DecodeObject(d, ReadBE(p + i * d->refSize, d->refSize), depth + 1);
+            }
+            break;
+        }
+        default:                  // Bools, reals, dates: nothing to keep
+            break;
+    }
+    return node;
+}
+
+static void FreeNode(Node *node) {
+    if (!node) return;
+    size_t refs = node->marker == 0xD ? node->count * 2 : node->marker == 0xA ? node->count : 0;
+    for (size_t i = 0; i < refs; i++) FreeNode(node->children[i]);
+    free(node->children);
+    free(node->string);
+    free(node);
+}
+
+static Node *DecodeAll(const uint8_t *bytes, size_t length) {
+    if (length < 40 || memcmp(bytes, "bplist00", 8) != 0) return NULL;
+    const uint8_t *trailer = bytes + length - 32;
+    Decoder d = {
+        .bytes = bytes,
+        .length = length,
+        .offsetSize = trailer[6],
+        .refSize = trailer[7],
+        .objectCount = ReadBE(trailer + 8, 8),
+        .offsetTable = ReadBE(trailer + 24, 8),
+    };
+    return DecodeObject(&d, ReadBE(trailer + 16, 8), 0);
+}
+
+static const Node *DictLookup(const Node *dict, const char *key) {
+    for (size_t i = 0; dict && i < dict->count; i++) {
+        const Node *k = dict->children[i];
+        if (k && k->string && strcmp(k->string, key) == 0) return dict->children[dict->count + i];
+    }
+    return NULL;
+}
+
+#pragma mark - Benchmark
+
+static void *ReadFile(const char *path, size_t *length) {
+    FILE *file = fopen(path, "rb");
+    if (!file) return NULL;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    void *bytes = malloc((size_t)size);
+    if (bytes && fread(bytes, 1, (size_t)size, file) != (size_t)size) {
+        free(bytes);
+        bytes = NULL;
+    }
+    fclose(file);
+    *length = (size_t)size;
+    return bytes;
+}
+
+int main(void) {
+    const char *path = HIAH_FIXTURES "Info.bplist";
+    size_t length = 0;
+    uint8_t *bytes = ReadFile(path, &length);
+    if (!bytes) {
+        fprintf(stderr, "cannot read %s\n", path);
+        return 1;
+    }
+
+    // Both must agree before their speed means anything
+    Node *tree = DecodeAll(bytes, length);
+    HIAHPlist *plist = HIAHPlistOpenBytes(bytes, length);
+    for (size_t i = 0; i < 3; i++) {
+        HIAHPlistValue value;
+        char copy[128];
+        HIAHPlistGet(plist, kKeys[i], &value);
+        HIAHPlistStringCopy(&value, copy, sizeof(copy));
+        const Node *node = DictLookup(tree, kKeys[i]);
+        if (!node || strcmp(node->string, copy) != 0) {
+            fprintf(stderr, "decoders disagree on %s\n", kKeys[i]);
+            return 1;
+        }
+    }
+    HIAHPlistClose(plist);
+    FreeNode(tree);
+
+    volatile size_t sink = 0;
+    uint64_t begin = HIAHTestNowNs();
+    for (int i = 0; i < ITERATIONS; i++) {
+        HIAHPlist *reader = HIAHPlistOpenBytes(bytes, length);
+        HIAHPlistValue values[3];
+        sink += HIAHPlistGetKeys(reader, kKeys, values, 3);
+        HIAHPlistClose(reader);
+    }
+    double readerNs = (double)(HIAHTestNowNs() - begin) / ITERATIONS;
+
+    begin = HIAHTestNowNs();
+    for (int i = 0; i < ITERATIONS; i++) {
+        Node *root = DecodeAll(bytes, length);
+        for (size_t k = 0; k < 3; k++) sink += DictLookup(root, kKeys[k]) != NULL;
+        FreeNode(root);
+    }
+    double fullNs = (double)(HIAHTestNowNs() - begin) / ITERATIONS;
+
+    begin = HIAHTestNowNs();
+    for (int i = 0; i < ITERATIONS / 10; i++) {
+        HIAHPlist *reader = HIAHPlistOpen(path);
+        HIAHPlistValue values[3];
+        sink += HIAHPlistGetKeys(reader, kKeys, values, 3);
+        HIAHPlistClose(reader);
+    }
+    double readerFileNs = (double)(HIAHTestNowNs() - begin) / (ITERATIONS / 10);
+
+    begin = HIAHTestNowNs();
+    for (int i = 0; i < ITERATIONS / 10; i++) {
+        size_t fileLength = 0;
+        uint8_t *file = ReadFile(path, &fileLength);
+        Node *root = DecodeAll(file, fileLength);
+        for (size_t k = 0; k < 3; k++) sink += DictLookup(root, kKeys[k]) != NULL;
+        FreeNode(root);
+        free(file);
+    }
+    double fullFileNs = (double)(HIAHTestNowNs() - begin) / (ITERATIONS / 10);
+
+    printf("%s (%zu bytes), 3 keys:\n", path, length);
+    printf("  in memory: reader %.0f ns, full decode %.0f ns (%.1fx)\n", readerNs, fullNs,
+           fullNs / readerNs);
+    printf("  from file: reader %.0f ns, read + full decode %.0f ns (%.1fx)\n", readerFileNs,
+           fullFileNs, fullFileNs / readerFileNs);
+    free(bytes);
+    return sink == 0;
+}
@@ -0,0 +1,209 @@
+/**
+ * HIAHPlistReaderTests.c
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Checks HIAHPlistReader against the same Info.plist as bplist00 and XML
+ * (fixtures/gen_plists.py), then feeds it truncated, corrupted and
+ * self-referencing input. Run under ASan so any read outside the input
+ * fails the test.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#include "HIAHPlistReader.h"
+#include "HIAHTest.h"
+#include <string.h>
+
+#ifndef HIAH_FIXTURES
+#define HIAH_FIXTURES "fixtures/"
+#endif
+
+static const char *const kKeys[] = {
+    "CFBundleExecutable", "CFBundleIdentifier", "NSPrincipalClass", "CFBundleName",
+    "Num", "Neg", "Big", "Flag", "Off", "Blob", "Ratio", "Built", "Empty", "EmptyArr",
+    "CFBundleIcons", "Key39", "Missing",
+};
+#define KEY_COUNT (sizeof(kKeys) / sizeof(kKeys[0]))
+
+static void *ReadFile(const char *path, size_t *length) {
+    FILE *file = fopen(path, "rb");
+    if (!file) return NULL;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    void *bytes = malloc((size_t)size);
+    if (bytes && fread(bytes, 1, (size_t)size, file) != (size_t)size) {
+        free(bytes);
+        bytes = NULL;
+    }
+    fclose(file);
+    *length = (size_t)size;
+    return bytes;
+}
+
+static bool StringIs(const HIAHPlistValue *value, const char *expected) {
+    char buffer[128];
+    size_t length = HIAHPlistStringCopy(value, buffer, sizeof(buffer));
+    return length == strlen(expected) && strcmp(buffer, expected) == 0 &&
+           HIAHPlistStringEquals(value, expected);
+}
+
+static void CheckInfoPlist(const char *path, bool binary) {
+    HIAHPlist *plist = HIAHPlistOpen(path);
+    HIAH_CHECK(plist != NULL);
+    if (!plist) return;
+
+    HIAHPlistValue v[KEY_COUNT];
+    HIAH_CHECK(HIAHPlistGetKeys(plist, kKeys, v, KEY_COUNT) == KEY_COUNT - 1);
+
+    HIAH_CHECK(StringIs(&v[0], "MyApp"));
+    HIAH_CHECK(StringIs(&v[1], "com.example.myapp"));
+    HIAH_CHECK(StringIs(&v[2], "Prinç<&>"));
+    HIAH_CHECK(v[2].text == (binary ? HIAHPlistTextUTF16BE : HIAHPlistTextXMLEscaped));
+    HIAH_CHECK(StringIs(&v[3], "Ünïcödé 😀"));
+    HIAH_CHECK(!HIAHPlistStringEquals(&v[0], "MyAp"));
+
+    HIAH_CHECK(v[4].type == HIAHPlistTypeInteger && v[4].integer == 42);
+    HIAH_CHECK(v[5].type == HIAHPlistTypeInteger && v[5].integer == -7);
+    HIAH_CHECK(v[6].type == HIAHPlistTypeInteger && v[6].integer == (int64_t)1 << 40);
+    HIAH_CHECK(v[7].type == HIAHPlistTypeBool && v[7].boolean);
+    HIAH_CHECK(v[8].type == HIAHPlistTypeBool && !v[8].boolean);
+
+    HIAH_CHECK(v[9].type == HIAHPlistTypeData);
+    if (binary) {
+        HIAH_CHECK(v[9].length == 8 && memcmp(v[9].bytes, "\x00\x01\x02hello", 8) == 0);
+    } else {
+        HIAH_CHECK(v[9].text == HIAHPlistTextBase64);
+    }
+    HIAH_CHECK(v[10].type == HIAHPlistTypeOther);
+    HIAH_CHECK(v[11].type == HIAHPlistTypeOther);
+    HIAH_CHECK(v[12].type == HIAHPlistTypeString && v[12].length == 0);
+    HIAH_CHECK(v[13].type == HIAHPlistTypeArray && v[13].count == 0);
+    HIAH_CHECK(v[15].type == HIAHPlistTypeInteger && v[15].integer == 39);
+    HIAH_CHECK(v[16].type == HIAHPlistTypeNone);
+
+    // Single lookups agree with the batched one
+    HIAHPlistValue single;
+    HIAH_CHECK(HIAHPlistGet(plist, "Key39", &single) && single.integer == 39);
+    HIAH_CHECK(!HIAHPlistGet(plist, "Missing", &single) && single.type == HIAHPlistTypeNone);
+
+    // Nested containers
+    HIAHPlistValue primary, files, file;
+    HIAH_CHECK(v[14].type == HIAHPlistTypeDict && v[14].count == 1);
+    HIAH_CHECK(HIAHPlistDictGet(plist, &v[14], "CFBundlePrimaryIcon", &primary));
+    HIAH_CHECK(HIAHPlistDictGet(plist, &primary, "CFBundleIconFiles", &files));
+    HIAH_CHECK(files.type == HIAHPlistTypeArray && files.count == 2);
+    HIAH_CHECK(HIAHPlistArrayGet(plist, &files, 1, &file) && StringIs(&file, "Icon76"));
+    HIAH_CHECK(!HIAHPlistArrayGet(plist, &files, 2, &file));
+    HIAH_CHECK(!HIAHPlistDictGet(plist, &v[4], "CFBundlePrimaryIcon", &primary));
+
+    // Stepping down in place, with the output aliasing the container
+    HIAHPlistValue cursor = v[14];
+    HIAH_CHECK(HIAHPlistDictGet(plist, &cursor, "CFBundlePrimaryIcon", &cursor));
+    HIAH_CHECK(HIAHPlistDictGet(plist, &cursor, "CFBundleIconFiles", &cursor));
+    HIAH_CHECK(HIAHPlistArrayGet(plist, &cursor, 0, &cursor) && StringIs(&cursor, "Icon60"));
+
+    // Copies truncate like strlcpy and report the full length
+    char small[4];
+    HIAH_CHECK(HIAHPlistStringCopy(&v[1], small, sizeof(small)) == 17 && strcmp(small, "com") == 0);
+    HIAH_CHECK(HIAHPlistStringCopy(&v[4], small, sizeof(small)) == 0 && small[0] == '\0');
+
+    HIAHPlistClose(plist);
+}
+
+// Looks up everything the fixtures contain, including inside containers
+static void Exercise(const void *bytes, size_t length) {
+    // An exact-size copy, so ASan sees any read past the end
+    void *copy = malloc(length ? length : 1);
+    memcpy(copy, bytes, length);
+    HIAHPlist *plist = HIAHPlistOpenBytes(copy, length);
+    if (plist) {
+        HIAHPlistValue v[KEY_COUNT];
+        HIAHPlistGetKeys(plist, kKeys, v, KEY_COUNT);
+        for (size_t i = 0; i < KEY_COUNT; i++) {
+            char buffer[64];
+            HIAHPlistStringCopy(&v[i], buffer, sizeof(buffer));
+            HIAHPlistStringEquals(&v[i], "MyApp");
+            HIAHPlistValue inner, element;
+            if (v[i].type == HIAHPlistTypeDict &&
+                HIAHPlistDictGet(plist, &v[i], "CFBundlePrimaryIcon", &inner) &&
+                HIAHPlistDictGet(plist, &inner, "CFBundleIconFiles", &inner)) {
+                for (size_t j = 0; j < 4; j++) HIAHPlistArrayGet(plist, &inner, j, &element);
+            }
+            if (v[i].type == HIAHPlistTypeArray) HIAHPlistArrayGet(plist, &v[i], 0, &element);
+        }
+        HIAHPlistClose(plist);
+    }
+    free(copy);
+}
+
+static void CheckMalformed(const char *path) {
+    size_t length = 0;
+    unsigned char *bytes = ReadFile(path, &length);
+    HIAH_CHECK(bytes != NULL);
+    if (!bytes) return;
+
+    // Every truncation
+    for (size_t cut = 0; cut < length; cut++) Exercise(bytes, cut);
+
+    // Random corruption (fixed seed, so failures reproduce)
+    unsigned char *mutated = malloc(length);
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    for (int round = 0; round < 20000; round++) {
+        memcpy(mutated, bytes, length);
+        int flips = 1 + round % 4;
+        for (int f = 0; f < flips; f++) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            mutated[(state >> 8) % length] = (unsigned char)state;
+        }
+        Exercise(mutated, length);
+    }
+    free(mutated);
+    free(bytes);
+}
+
+static void CheckRejected(void) {
+    HIAH_CHECK(HIAHPlistOpenBytes("", 0) == NULL);
+    HIAH_CHECK(HIAHPlistOpenBytes("not a plist at all", 18) == NULL);
+    HIAH_CHECK(HIAHPlistOpenBytes("<plist><array/></plist>", 23) == NULL);
+    static const char shortBinary[] = "bplist00xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx";
+    HIAH_CHECK(HIAHPlistOpenBytes(shortBinary, sizeof(shortBinary) - 1) == NULL);
+    HIAH_CHECK(HIAHPlistOpen(HIAH_FIXTURES "does-not-exist.plist") == NULL);
+}
+
+// A dict whose only value is the dict itself: lookups must not loop
+static void CheckCycle(void) {
+    static const unsigned char cyclic[] = {
+        'b', 'p', 'l', 'i', 's', 't', '0', '0',
+        0xD1, 0x01, 0x00,                       // 8: dict { ref 1 : ref 0 }
+        0x51, 'a',                              // 11: "a"
+        0x08, 0x0B,                             // 13: offset table
+        0, 0, 0, 0, 0, 0, 1, 1,                 // trailer: 1-byte offsets and refs
+        0, 0, 0, 0, 0, 0, 0, 2,                 // 2 objects
+        0, 0, 0, 0, 0, 0, 0, 0,                 // top object 0
+        0, 0, 0, 0, 0, 0, 0, 13,                // offset table at 13
+    };
+    HIAHPlist *plist = HIAHPlistOpenBytes(cyclic, sizeof(cyclic));
+    HIAH_CHECK(plist != NULL);
+    if (!plist) return;
+    HIAHPlistValue value;
+    HIAH_CHECK(HIAHPlistGet(plist, "a", &value) && value.type == HIAHPlistTypeDict);
+    for (int depth = 0; depth < 100; depth++) {
+        HIAH_CHECK(HIAHPlistDictGet(plist, &value, "a", &value) && value.type == HIAHPlistTypeDict);
+    }
+    HIAH_CHECK(!HIAHPlistGet(plist, "b", &value));
+    HIAHPlistClose(plist);
+}
+
+int main(void) {
+    CheckInfoPlist(HIAH_FIXTURES "Info.bplist", true);
+    CheckInfoPlist(HIAH_FIXTURES "Info.xml", false);
+    CheckRejected();
+    CheckCycle();
+    CheckMalformed(HIAH_FIXTURES "Info.bplist");
+    CheckMalformed(HIAH_FIXTURES "Info.xml");
+    return HIAHTestFinish("HIAHPlistReaderTests");
+}
@@ -0,0 +1,140 @@
+/**
+ * HIAHStagingTests.c
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Incremental staging: first sync, unchanged resyncs, changed, replaced
+ * and removed files, symlinks, and syncs of separate trees running at the
+ * same time.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#include "HIAHStaging.h"
+#include "HIAHTest.h"
+#include <limits.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+static char g_root[] = "/tmp/hiah-staging-XXXXXX";
+
+// A bundle-like tree with `files` files spread over nested directories,
+// named so they don't arrive from readdir in sorted order
+static void MakeSource(const char *source, int files) {
+    char path[PATH_MAX];
+    mkdir(source, 0755);
+    for (int d = 0; d < 8; d++) {
+        snprintf(path, sizeof(path), "%s/dir%d", source, (d * 5) % 8);
+        mkdir(path, 0755);
+        snprintf(path, sizeof(path), "%s/dir%d/nested", source, (d * 5) % 8);
+        mkdir(path, 0755);
+    }
+    for (int i = 0; i < files; i++) {
+        int d = (i * 5) % 8;
+        snprintf(path, sizeof(path), "%s/dir%d/%s%x", source, d, i % 2 ? "nested/f" : "F", i * 2654435761u);
+        HIAHTestWriteFile(path, path, strlen(path), 0644);
+    }
+    snprintf(path, sizeof(path), "%s/link", source);
+    symlink("dir0", path);
+}
+
+static void TestSync(void) {
+    char source[PATH_MAX], destination[PATH_MAX], path[PATH_MAX];
+    snprintf(source, sizeof(source), "%s/source", g_root);
+    snprintf(destination, sizeof(destination), "%s/staged/App.app", g_root);
+    MakeSource(source, 200);
+
+    HIAHStagingStats stats;
+    HIAH_CHECK(HIAHStagingSync(source, destination, true, &stats) == 0);
+    HIAH_CHECK(stats.files == 201 && stats.unchanged == 0);
+    HIAH_CHECK(stats.cloned + stats.linked + stats.copied == 200);
+
+    char target[PATH_MAX] = {0};
+    snprintf(path, sizeof(path), "%s/link", destination);
+    HIAH_CHECK(readlink(path, target, sizeof(target) - 1) == 4 && strcmp(target, "dir0") == 0);
+
+    // Every file is found in the saved manifest
+    HIAH_CHECK(HIAHStagingSync(source, destination, true, &stats) == 0);
+    HIAH_CHECK(stats.files == 201 && stats.unchanged == 201);
+
+    // Changed and removed files; a file created in the staged tree stays
+    snprintf(path, sizeof(path), "%s/dir0/changed", source);
+    HIAHTestWriteFile(path, "one", 3, 0644);
+    HIAH_CHECK(HIAHStagingSync(source, destination, true, NULL) == 0);
+    snprintf(path, sizeof(path), "%s/dir0/changed.new", source);
+    HIAHTestWriteFile(path, "two!", 4, 0644);
+    char changed[PATH_MAX];
+    snprintf(changed, sizeof(changed), "%s/dir0/changed", source);
+    HIAH_CHECK(rename(path, changed) == 0);
+    snprintf(path, sizeof(path), "%s/dir0/F0", source);
+    HIAH_CHECK(unlink(path) == 0);
+    snprintf(path, sizeof(path), "%s/App.prefetch", destination);
+    HIAHTestWriteFile(path, "p", 1, 0644);
+
+    HIAH_CHECK(HIAHStagingSync(source, destination, true, &stats) == 0);
+    HIAH_CHECK(stats.files == 201 && stats.unchanged == 200 && stats.removed == 1);
+    snprintf(path, sizeof(path), "%s/dir0/changed", destination);
+    HIAH_CHECK(HIAHTestFileEquals(path, "two!", 4));
+    snprintf(path, sizeof(path), "%s/dir0/F0", destination);
+    HIAH_CHECK(access(path, F_OK) != 0);
+    snprintf(path, sizeof(path), "%s/App.prefetch", destination);
+    HIAH_CHECK(access(path, F_OK) == 0);
+
+    // A file replaced by a directory
+    snprintf(path, sizeof(path), "%s/dir0/changed", source);
+    unlink(path);
+    mkdir(path, 0755);
+    snprintf(path, sizeof(path), "%s/dir0/changed/inner", source);
+    HIAHTestWriteFile(path, "in", 2, 0644);
+    HIAH_CHECK(HIAHStagingSync(source, destination, true, &stats) == 0);
+    snprintf(path, sizeof(path), "%s/dir0/changed/inner", destination);
+    HIAH_CHECK(HIAHTestFileEquals(path, "in", 2));
+}
+
+typedef struct {
+    char source[PATH_MAX];
+    char destination[PATH_MAX];
+    int failures;
+} SyncJob;
+
+static void *SyncMain(void *data) {
+    SyncJob *job = data;
+    for (int round = 0; round < 20; round++) {
+        // Staged again from scratch, so every round saves a full manifest
+        HIAHTestRemoveTree(job->destination);
+        HIAHStagingStats stats;
+        if (HIAHStagingSync(job->source, job->destination, true, &stats) != 0) job->failures++;
+        if (HIAHStagingSync(job->source, job->destination, true, &stats) != 0 ||
+            stats.unchanged != stats.files) {
+            job->failures++;
+        }
+    }
+    return NULL;
+}
+
+// Separate trees may be synced at once (the delta updater syncs from a
+// background queue); each manifest must still come out sorted
+static void TestConcurrentTrees(void) {
+    enum { JOBS = 4 };
+    SyncJob jobs[JOBS];
+    pthread_t threads[JOBS];
+    for (int i = 0; i < JOBS; i++) {
+        memset(&jobs[i], 0, sizeof(jobs[i]));
+        snprintf(jobs[i].source, sizeof(jobs[i].source), "%s/concurrent%d", g_root, i);
+        snprintf(jobs[i].destination, sizeof(jobs[i].destination), "%s/concurrent%d.staged", g_root, i);
+        MakeSource(jobs[i].source, 300 + i * 50);
+    }
+    for (int i = 0; i < JOBS; i++) pthread_create(&threads[i], NULL, SyncMain, &jobs[i]);
+    for (int i = 0; i < JOBS; i++) {
+        pthread_join(threads[i], NULL);
+        HIAH_CHECK(jobs[i].failures == 0);
+    }
+}
+
+int main(void) {
+    HIAH_CHECK(mkdtemp(g_root) != NULL);
+    TestSync();
+    TestConcurrentTrees();
+    HIAHTestRemoveTree(g_root);
+    return HIAHTestFinish("HIAHStagingTests");
+}
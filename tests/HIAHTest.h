@@ -0,0 +1,104 @@
+/**
+ * HIAHTest.h
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * Minimal assertion and timing helpers shared by the portable tests and
+ * benchmarks in this directory.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#ifndef HIAH_TEST_H
+#define HIAH_TEST_H
+
+#include <fcntl.h>
+#include <ftw.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static int g_testFailures = 0;
+
+/**
+ * Records a failure (with its location) and keeps going, so one run
+ * reports every broken check.
+ */
+#define HIAH_CHECK(cond)                                                        \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__,    \
+                    #cond);                                                     \
+            g_testFailures++;                                                   \
+        }                                                                       \
+    } while (0)
+
+/**
+ * Ends a test program: prints the verdict and returns its exit status.
+ */
+static inline int HIAHTestFinish(const char *name) {
+    if (g_testFailures) {
+        fprintf(stderr, "%s: %d check(s) failed\n", name, g_testFailures);
+        return 1;
+    }
+    printf("%s: ok\n", name);
+    return 0;
+}
+
+static inline uint64_t HIAHTestNowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * CPU time consumed by the calling thread.
+ */
+static inline uint64_t HIAHTestThreadCPUNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+#pragma mark - Files
+
+static int HIAHTestRemoveItem(const char *path, const struct stat *st, int type, struct FTW *ftw) {
+    (void)st;
+    (void)ftw;
+    return type == FTW_DP ? rmdir(path) : unlink(path);
+}
+
+/**
+ * rm -rf
+ */
+static inline void HIAHTestRemoveTree(const char *path) {
+    nftw(path, HIAHTestRemoveItem, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+/**
+ * Creates (or truncates) `path` holding `length` bytes of `data`.
+ */
+static inline void HIAHTestWriteFile(const char *path, const void *data, size_t length, mode_t mode) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, mode);
+    HIAH_CHECK(fd >= 0 && write(fd, data, length) == (ssize_t)length);
+    if (fd >= 0) close(fd);
+}
+
+/**
+ * Whether the file at `path` holds exactly `length` bytes of `data`.
+ */
+static inline int HIAHTestFileEquals(const char *path, const void *data, size_t length) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 0;
+    char *contents = malloc(length + 1);
+    ssize_t got = read(fd, contents, length + 1);
+    close(fd);
+    int equal = got == (ssize_t)length && memcmp(contents, data, length) == 0;
+    free(contents);
+    return equal;
+}
+
+#endif /* HIAH_TEST_H */
@@ -0,0 +1,16 @@
+/**
+ * HIAHGuestImage.c
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * A stand-in guest binary for the image cache tests and benchmark, built
+ * as a shared library once per HIAH_GUEST_VERSION so a test can replace
+ * one version with another on disk.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+int hello_entry(int argc, char **argv) {
+    (void)argv;
+    return HIAH_GUEST_VERSION * 100 + argc;
+}
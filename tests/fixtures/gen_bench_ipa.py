@@ -0,0 +1,35 @@
+#!/usr/bin/env python3
+# Writes the .ipa HIAHZipArchiveBench installs (to the path given, under
+# build/): a game-like app with one 96 MB asset and 3000 small resources,
+# partly compressible, in a few hundred directories.
+import random
+import stat
+import sys
+import zipfile
+
+
+def add(archive, name, data, mode):
+    info = zipfile.ZipInfo(name, date_time=(2025, 1, 1, 0, 0, 0))
+    info.external_attr = (mode | (0o755 if name.endswith("/") else 0o644)) << 16
+    info.compress_type = zipfile.ZIP_DEFLATED
+    archive.writestr(info, data)
+
+
+rng = random.Random("bench")
+root = "Payload/Bench.app/"
+with zipfile.ZipFile(sys.argv[1], "w", zipfile.ZIP_DEFLATED, compresslevel=6) as archive:
+    add(archive, root, b"", stat.S_IFDIR)
+    # Half noise, half runs, so inflate does real work on both kinds of data
+    asset = bytearray()
+    while len(asset) < 96 * 1024 * 1024:
+        asset += rng.randbytes(32 * 1024)
+        asset += bytes([rng.randrange(256)]) * (32 * 1024)
+    add(archive, root + "Assets/world.pak", bytes(asset), stat.S_IFREG)
+    words = [rng.randbytes(rng.randrange(3, 9)).hex().encode() for _ in range(512)]
+    for i in range(3000):
+        size = int(rng.expovariate(1 / 12000)) + 256
+        if i % 3 == 0:
+            data = rng.randbytes(size)
+        else:
+            data = b" ".join(rng.choice(words) for _ in range(size // 8))[:size]
+        add(archive, root + "Resources/%02d/%03d/item%d.dat" % (i % 20, i % 300, i), data, stat.S_IFREG)
@@ -0,0 +1,54 @@
+#!/usr/bin/env python3
+# Regenerates the .ipa fixtures used by HIAHDeltaUpdateTests: two versions
+# each of two small apps. From v1 to v2 the executable and a symlink change,
+# one resource is added, and a resource and a whole directory go away.
+import random
+import stat
+import zipfile
+
+
+def write_ipa(path, entries):
+    with zipfile.ZipFile(path, "w", zipfile.ZIP_DEFLATED) as archive:
+        for name, data in entries:
+            info = zipfile.ZipInfo(name, date_time=(2025, 1, 1, 0, 0, 0))
+            if name.endswith("/"):
+                info.external_attr = (stat.S_IFDIR | 0o755) << 16
+                archive.writestr(info, b"")
+            elif isinstance(data, tuple):
+                # Symlinks are stored, with the target as their data
+                info.external_attr = (stat.S_IFLNK | 0o777) << 16
+                info.compress_type = zipfile.ZIP_STORED
+                archive.writestr(info, data[0])
+            else:
+                # The executable is the extensionless file at the bundle root
+                base = name[len("Payload/"):].split("/")
+                mode = 0o755 if len(base) == 2 and "." not in base[1] else 0o644
+                info.external_attr = (stat.S_IFREG | mode) << 16
+                info.compress_type = zipfile.ZIP_DEFLATED
+                archive.writestr(info, data)
+
+
+for app in ("A", "B"):
+    rng = random.Random(app)
+    asset = bytes(rng.getrandbits(8) for _ in range(16 * 1024))
+    root = "Payload/%s.app/" % app
+    common = [
+        (root, None),
+        (root + "Info.plist", b"<plist>" + app.encode() + b"</plist>"),
+        (root + "res/", None),
+        (root + "res/keep.png", asset),
+        (root + "Frameworks/F.framework/", None),
+        (root + "Frameworks/F.framework/F", b"framework" * 100),
+    ]
+    write_ipa("%s-v1.ipa" % app, common + [
+        (root + app, b"exe1" * 1000),
+        (root + "res/gone.png", b"gone"),
+        (root + "old/", None),
+        (root + "old/x", b"x"),
+        (root + "link", ("res/keep.png",)),
+    ])
+    write_ipa("%s-v2.ipa" % app, common + [
+        (root + app, b"exe2" * 1000),
+        (root + "res/new.png", b"new"),
+        (root + "link", ("Info.plist",)),
+    ])
@@ -0,0 +1,35 @@
+#!/usr/bin/env python3
+# Regenerates the Info.plist fixtures used by HIAHPlistReaderTests and
+# HIAHPlistReaderBench: the same dictionary as bplist00 and as XML.
+import datetime
+import plistlib
+
+info = {
+    "CFBundleExecutable": "MyApp",
+    "CFBundleIdentifier": "com.example.myapp",
+    "NSPrincipalClass": "Prinç<&>",            # Entities in XML
+    "CFBundleName": "Ünïcödé 😀",               # UTF-16 in bplist
+    "Num": 42,
+    "Neg": -7,
+    "Big": 1 << 40,
+    "Flag": True,
+    "Off": False,
+    "Blob": b"\x00\x01\x02hello",
+    "Ratio": 3.5,
+    "Built": datetime.datetime(2025, 1, 2, 3, 4, 5),
+    "Empty": "",
+    "EmptyArr": [],
+    "CFBundleIcons": {
+        "CFBundlePrimaryIcon": {
+            "CFBundleIconFiles": ["Icon60", "Icon76"],
+        },
+    },
+}
+# More than 15 entries forces the long count encoding in bplist
+for i in range(40):
+    info["Key%02d" % i] = i
+
+with open("Info.bplist", "wb") as f:
+    f.write(plistlib.dumps(info, fmt=plistlib.FMT_BINARY, sort_keys=False))
+with open("Info.xml", "wb") as f:
+    f.write(plistlib.dumps(info, fmt=plistlib.FMT_XML, sort_keys=False))
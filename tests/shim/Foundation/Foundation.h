@@ -0,0 +1,57 @@
+/**
+ * Foundation.h (test shim)
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * The few Foundation and Darwin names the C parts of HIAHLogging.m use, so
+ * it builds as C on Linux. Objective-C-only code in the sources is guarded
+ * by __OBJC__ and drops out.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#pragma once
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef signed char BOOL;
+#define YES 1
+#define NO 0
+typedef long NSInteger;
+
+#define NS_ENUM(type, name) type name; enum name##_
+#define NS_ASSUME_NONNULL_BEGIN
+#define NS_ASSUME_NONNULL_END
+#define _Nullable
+#define _Nonnull
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#define NSEC_PER_MSEC 1000000ull
+
+#define QOS_CLASS_UTILITY 0
+static inline int pthread_attr_set_qos_class_np(pthread_attr_t *attr, int qos, int priority) {
+    (void)attr;
+    (void)qos;
+    (void)priority;
+    return 0;
+}
+#define pthread_setname_np(name) pthread_setname_np(pthread_self(), (name))
+
+#if !defined(__GLIBC__) || !__GLIBC_PREREQ(2, 38)
+static inline size_t strlcpy(char *dst, const char *src, size_t size) {
+    size_t length = strlen(src);
+    if (size) {
+        size_t copy = length < size - 1 ? length : size - 1;
+        memcpy(dst, src, copy);
+        dst[copy] = '\0';
+    }
+    return length;
+}
+#endif
@@ -0,0 +1,52 @@
+/**
+ * dispatch.h (test shim)
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * dispatch semaphores on top of POSIX semaphores, for the Linux builds in
+ * tests/. Only relative timeouts from DISPATCH_TIME_NOW are supported.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#pragma once
+
+#include <semaphore.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef sem_t *dispatch_semaphore_t;
+typedef uint64_t dispatch_time_t;
+
+#define DISPATCH_TIME_NOW 0ull
+#define DISPATCH_TIME_FOREVER (~0ull)
+
+static inline dispatch_semaphore_t dispatch_semaphore_create(long value) {
+    sem_t *semaphore = malloc(sizeof(sem_t));
+    if (semaphore) sem_init(semaphore, 0, (unsigned)value);
+    return semaphore;
+}
+
+static inline long dispatch_semaphore_signal(dispatch_semaphore_t semaphore) {
+    sem_post(semaphore);
+    return 0;
+}
+
+static inline dispatch_time_t dispatch_time(dispatch_time_t when, int64_t deltaNs) {
+    (void)when;
+    return (dispatch_time_t)deltaNs;
+}
+
+static inline long dispatch_semaphore_wait(dispatch_semaphore_t semaphore, dispatch_time_t timeout) {
+    if (timeout == DISPATCH_TIME_FOREVER) return sem_wait(semaphore);
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += (time_t)(timeout / 1000000000ull);
+    deadline.tv_nsec += (long)(timeout % 1000000000ull);
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    return sem_timedwait(semaphore, &deadline);
+}
@@ -0,0 +1,32 @@
+/**
+ * mach_time.h (test shim)
+ * HIAHKernel – House in a House Virtual Kernel (for iOS)
+ *
+ * mach_absolute_time in nanoseconds (timebase 1/1), for the Linux builds in
+ * tests/.
+ *
+ * Copyright (c) 2025 Alex Spaulding
+ * Licensed under MIT License
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+
+typedef struct {
+    uint32_t numer;
+    uint32_t denom;
+} mach_timebase_info_data_t;
+
+static inline int mach_timebase_info(mach_timebase_info_data_t *info) {
+    info->numer = 1;
+    info->denom = 1;
+    return 0;
+}
+
+static inline uint64_t mach_absolute_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}